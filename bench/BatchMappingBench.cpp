@@ -0,0 +1,99 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/BatchMapping.h"
+
+#include <cstring>
+#include <string>
+
+static Bench::Register sBatchMapping("batch-mapping", []
+{
+    using BatchMapping::Isa;
+
+    const auto& tables = MappingTables::defaults();
+    const auto states  = Bench::makeStates(4096, 99);
+
+    for (size_t pads : { 1, 4, 8, 64 })
+    {
+        N64StateBatch batch;
+        batch.resize(pads);
+        for (size_t i = 0; i < pads; i++)
+            batch.set(i, states[i]);
+
+        std::vector<XusbReport> expected(pads);
+        for (size_t i = 0; i < pads; i++)
+            tables.convert(states[i], expected[i]);
+
+        const uint64_t iterations = (1 << 20) / pads;
+
+        // Baseline: one scalar call per pad, as each pad thread does today
+        Bench::report("scalar calls x" + std::to_string(pads), Bench::nsPerOp(iterations, [&](uint64_t n)
+        {
+            XusbReport report;
+            for (uint64_t it = 0; it < n; it++)
+            {
+                for (size_t i = 0; i < pads; i++)
+                {
+                    tables.convert(states[i], report);
+                    Bench::doNotOptimize(report);
+                }
+            }
+        }));
+
+        for (Isa isa : { Isa::Scalar, Isa::Sse2, Isa::Avx2 })
+        {
+            if (!BatchMapping::isSupported(isa))
+                continue;
+
+            std::vector<XusbReport> reports(pads);
+            BatchMapping::convert(isa, tables, batch, reports.data());
+            Bench::check(memcmp(reports.data(), expected.data(), pads * sizeof(XusbReport)) == 0,
+                         std::string("batch ") + BatchMapping::isaName(isa) + " matches MappingTables");
+
+            Bench::report(std::string("batch ") + BatchMapping::isaName(isa) + " x" + std::to_string(pads), Bench::nsPerOp(iterations, [&](uint64_t n)
+            {
+                for (uint64_t it = 0; it < n; it++)
+                {
+                    BatchMapping::convert(isa, tables, batch, reports.data());
+                    Bench::doNotOptimize(reports[0]);
+                }
+            }));
+        }
+    }
+});
+
+// Every kernel against the scalar path on a large randomized batch
+static Bench::Register sBatchMappingVerify("batch-mapping-verify", []
+{
+    using BatchMapping::Isa;
+
+    const auto& tables = MappingTables::defaults();
+    auto states = Bench::makeStates(1 << 16, 7);
+
+    // Include out-of-range axis values and odd POV angles
+    for (size_t i = 0; i < states.size(); i += 7)
+    {
+        states[i].xAxis = static_cast<int32_t>(i * 2654435761u);
+        states[i].yAxis = -states[i].xAxis;
+        states[i].dpad  = static_cast<int32_t>(i % 36001);
+    }
+
+    N64StateBatch batch;
+    batch.resize(states.size() + 3); // odd length exercises the tail path
+    for (size_t i = 0; i < batch.size(); i++)
+        batch.set(i, states[i % states.size()]);
+
+    std::vector<XusbReport> expected(batch.size());
+    BatchMapping::convert(Isa::Scalar, tables, batch, expected.data());
+
+    for (Isa isa : { Isa::Sse2, Isa::Avx2 })
+    {
+        if (!BatchMapping::isSupported(isa))
+            continue;
+        std::vector<XusbReport> reports(batch.size());
+        BatchMapping::convert(isa, tables, batch, reports.data());
+        Bench::check(memcmp(reports.data(), expected.data(), reports.size() * sizeof(XusbReport)) == 0,
+                     std::string("batch ") + BatchMapping::isaName(isa) + " matches scalar on randomized states");
+    }
+    printf("detected kernel: %s\n", BatchMapping::isaName(BatchMapping::detectIsa()));
+});
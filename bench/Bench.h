@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Minimal benchmark harness
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Bench
+{
+
+// Keeps the optimizer from discarding a computed value
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// Runs fn(iterations) a few times and returns the best ns per iteration
+template <typename Fn>
+double nsPerOp(uint64_t iterations, Fn&& fn)
+{
+    using Clock = std::chrono::steady_clock;
+
+    double best = 0.0;
+    for (int run = 0; run < 5; run++)
+    {
+        const auto start = Clock::now();
+        fn(iterations);
+        const auto end = Clock::now();
+
+        const double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+        if (run == 0 || ns < best)
+            best = ns;
+    }
+    return best;
+}
+
+// Every reported number, kept for --json
+struct Result
+{
+    std::string benchCase;
+    std::string name;
+    double      nsPerOp;   // report()
+    double      p50Us;     // reportLatency()
+    double      p99Us;
+    double      maxUs;
+    bool        latency;
+};
+
+std::vector<Result>& results();
+
+// Name of the case running now, set by main
+std::string& currentCase();
+
+inline void report(const std::string& name, double nsPerOp)
+{
+    printf("%-48s %10.2f ns/op\n", name.c_str(), nsPerOp);
+    results().push_back({ currentCase(), name, nsPerOp, 0.0, 0.0, 0.0, false });
+}
+
+// Prints percentiles of a set of latency samples (sorts them in place)
+inline void reportLatency(const std::string& name, std::vector<double>& samplesNs)
+{
+    if (samplesNs.empty())
+        return;
+    std::sort(samplesNs.begin(), samplesNs.end());
+    auto percentile = [&](double p)
+    {
+        return samplesNs[std::min(samplesNs.size() - 1, static_cast<size_t>(p * samplesNs.size()))] / 1000.0;
+    };
+    printf("%-48s p50 %9.1f us  p99 %9.1f us  max %9.1f us\n", name.c_str(), percentile(0.50), percentile(0.99), samplesNs.back() / 1000.0);
+    results().push_back({ currentCase(), name, 0.0, percentile(0.50), percentile(0.99), samplesNs.back() / 1000.0, true });
+}
+
+// Reports a failed sanity check; n64-bench exits non zero at the end
+inline int& failures()
+{
+    static int count = 0;
+    return count;
+}
+
+struct CheckResult
+{
+    std::string benchCase;
+    std::string what;
+    bool        passed;
+};
+
+std::vector<CheckResult>& checks();
+
+inline void check(bool condition, const std::string& what)
+{
+    checks().push_back({ currentCase(), what, condition });
+    if (condition)
+        return;
+    printf("CHECK FAILED: %s\n", what.c_str());
+    failures()++;
+}
+
+struct Case
+{
+    std::string           name;
+    std::function<void()> run;
+    bool                  slow;
+};
+
+std::vector<Case>& registry();
+
+// Tag for cases that only run when selected by an exact name
+struct SlowTag {};
+static constexpr SlowTag Slow{};
+
+struct Register
+{
+    Register(const char* name, std::function<void()> run)
+    {
+        registry().push_back({ name, std::move(run), false });
+    }
+
+    Register(const char* name, SlowTag, std::function<void()> run)
+    {
+        registry().push_back({ name, std::move(run), true });
+    }
+};
+
+}
@@ -0,0 +1,155 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/Clock.h"
+#include "core/Controller.h"
+#include "core/EventReplay.h"
+#include "core/FakeBackends.h"
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+constexpr uint32_t kButtonA = offsetof(N64ControllerState, buttons) + N64Button::A;
+constexpr uint32_t kButtonB = offsetof(N64ControllerState, buttons) + N64Button::B;
+constexpr uint32_t kXAxis   = offsetof(N64ControllerState, xAxis);
+constexpr uint32_t kYAxis   = offsetof(N64ControllerState, yAxis);
+
+// Counts presses seen by the virtual pad: reports where some button goes
+// down after none were
+struct PressCounter
+{
+    std::atomic<uint32_t> presses { 0 };
+    std::atomic<uint16_t> last { 0 };
+
+    FakeSinkBackend::SubmitCallback callback()
+    {
+        return [this](uint32_t, const XusbReport& report)
+        {
+            if (report.wButtons != 0 && last == 0)
+                presses++;
+            last = report.wButtons;
+        };
+    }
+};
+
+struct TapResult
+{
+    uint32_t presses;
+    uint64_t overflows;
+};
+
+// A fake pad tapping A every 500us, each press and release landing between
+// two reads (a 200us tap against a reader that wakes less often)
+TapResult tap(size_t bufferSize, uint32_t taps)
+{
+    FakeInputBackend inputs;
+    FakeSinkBackend  sinks;
+    PressCounter     counter;
+    sinks.setSubmitCallback(counter.callback());
+
+    const auto id = Bench::makeGuid(bufferSize > 0 ? 1 : 2);
+    inputs.plug(id);
+    inputs.setBufferSize(id, bufferSize);
+    Controller controller;
+    controller.open(inputs, sinks, id);
+
+    uint32_t sequence = 0;
+    for (uint32_t i = 0; i < taps; i++)
+    {
+        const InputEvent events[] = { { kButtonA, 0x80, sequence + 1 }, { kButtonA, 0, sequence + 2 } };
+        sequence += 2;
+        inputs.pushEvents(id, events, 2);
+        Bench::spinFor(500000);
+    }
+
+    // Let the last taps drain
+    const auto deadlineNs = Clock::nowNs() + 1000000000ll;
+    while (counter.last != 0 && Clock::nowNs() < deadlineNs)
+        std::this_thread::yield();
+    Bench::spinFor(5000000);
+
+    TapResult result = { counter.presses.load(), controller.stats().counters.bufferOverflows.load() };
+    controller.close();
+    return result;
+}
+
+}
+
+static Bench::Register sBufferedInput("buffered-input", []
+{
+    // Replay: transitions keep their own state, axes merge
+    {
+        EventReplay replay;
+        N64ControllerState out[8];
+
+        replay.reset(Bench::neutral());
+        const InputEvent tapEvents[] = { { kButtonA, 0x80, 1 }, { kButtonA, 0, 2 } };
+        size_t count = replay.replay(tapEvents, 2, out);
+        Bench::check(count == 2 && out[0].buttons[N64Button::A] == 0x80 && out[1].buttons[N64Button::A] == 0,
+                     "a tap inside one read replays as press then release");
+
+        replay.reset(Bench::neutral());
+        const InputEvent axisEvents[] = { { kXAxis, 100, 1 }, { kXAxis, 200, 2 }, { kYAxis, 300, 3 }, { kXAxis, 400, 4 } };
+        count = replay.replay(axisEvents, 4, out);
+        Bench::check(count == 1 && out[0].xAxis == 400 && out[0].yAxis == 300, "axis-only events merge into one state");
+
+        replay.reset(Bench::neutral());
+        const InputEvent mixed[] = { { kXAxis, 100, 1 }, { kButtonA, 0x80, 2 }, { kXAxis, 200, 3 }, { kYAxis, 50, 4 }, { kButtonA, 0, 5 }, { kXAxis, 300, 6 } };
+        count = replay.replay(mixed, 6, out);
+        Bench::check(count == 2 && out[0].buttons[N64Button::A] == 0x80 && out[1].buttons[N64Button::A] == 0 &&
+                     out[1].xAxis == 300 && out[1].yAxis == 50,
+                     "axes between transitions fold into the next state");
+
+        replay.reset(Bench::neutral());
+        const InputEvent together[] = { { kButtonA, 0x80, 7 }, { kButtonB, 0x80, 7 } };
+        count = replay.replay(together, 2, out);
+        Bench::check(count == 1 && out[0].buttons[N64Button::A] == 0x80 && out[0].buttons[N64Button::B] == 0x80,
+                     "events sharing a sequence number go out together");
+
+        replay.reset(Bench::neutral());
+        const InputEvent noop[] = { { kButtonA, 0, 1 }, { kXAxis, 32767, 2 }, { 3, 1, 3 } };
+        Bench::check(replay.replay(noop, 3, out) == 0, "events that change nothing produce no state");
+    }
+
+    // Overflow: what was queued replays, then the pad resyncs to the current state
+    {
+        FakeInputBackend inputs;
+        FakeSinkBackend  sinks;
+        PressCounter     counter;
+        sinks.setSubmitCallback(counter.callback());
+
+        const auto id = Bench::makeGuid(3);
+        inputs.plug(id);
+        inputs.setBufferSize(id, 4);
+        Controller controller;
+        controller.open(inputs, sinks, id);
+
+        std::vector<InputEvent> events;
+        for (uint32_t i = 0; i < 10; i++)
+            events.push_back({ kButtonA, i % 2 == 0 ? 0x80 : 0, i + 1 });
+        events.push_back({ kButtonB, 0x80, 11 });
+        inputs.pushEvents(id, events.data(), events.size());
+
+        const auto deadlineNs = Clock::nowNs() + 1000000000ll;
+        while (controller.stats().counters.bufferOverflows == 0 && Clock::nowNs() < deadlineNs)
+            std::this_thread::yield();
+        Bench::spinFor(2000000);
+        Bench::check(controller.stats().counters.bufferOverflows == 1, "overflow is counted");
+        Bench::check(counter.presses == 3 && counter.last != 0, "queued taps replay, then the pad resyncs to B held");
+        controller.close();
+    }
+
+    // Sub-millisecond taps: snapshot reads versus buffered replay
+    static constexpr uint32_t kTaps = 400;
+    const auto snapshot = tap(0, kTaps);
+    const auto buffered = tap(256, kTaps);
+    std::cout << "  taps between reads seen, snapshot reads:  " << snapshot.presses << " / " << kTaps << std::endl;
+    std::cout << "  taps between reads seen, buffered replay: " << buffered.presses << " / " << kTaps << std::endl;
+    Bench::check(buffered.presses == kTaps && buffered.overflows == 0, "buffered mode delivers every tap");
+});
@@ -0,0 +1,168 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/Capture.h"
+#include "core/ReportPipeline.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// A live stream: sticks drift a little per read and a button or the dpad
+// flips now and then, like a pad being played rather than random noise
+std::vector<N64ControllerState> makeStream(size_t count)
+{
+    auto states = Bench::makeStates(count, 77);
+    std::mt19937 rng(9);
+    std::uniform_int_distribution<int32_t> step(-300, 300);
+    std::bernoulli_distribution flip(0.05);
+    for (size_t i = 1; i < count; i++)
+    {
+        auto& state = states[i];
+        state = states[i - 1];
+        state.xAxis = (std::max)(0, (std::min)(65535, state.xAxis + step(rng)));
+        state.yAxis = (std::max)(0, (std::min)(65535, state.yAxis + step(rng)));
+        if (flip(rng))
+            state.buttons[rng() % 16] ^= 0x80;
+        if (flip(rng))
+            state.dpad = states[rng() % count].dpad;
+    }
+    return states;
+}
+
+long fileSize(const std::string& path)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return -1;
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+}
+
+static Bench::Register sCapture("capture", []
+{
+    static constexpr size_t  kRecords = 1 << 18;
+    static constexpr uint8_t kPads    = 4;
+
+    const auto stream = makeStream(kRecords);
+    const std::string path = "n64-bench-capture.tmp";
+
+    for (bool delta : { false, true })
+    {
+        const std::string mode = delta ? "delta" : "full";
+
+        CaptureWriter writer;
+        Bench::check(writer.open(path, delta), "open capture for writing (" + mode + ")");
+
+        uint8_t ids[kPads];
+        for (uint8_t pad = 0; pad < kPads; pad++)
+        {
+            uint8_t guid[16] = { pad, 0x7e, 0x05, 0x19, 0x20 };
+            ids[pad] = writer.addDevice(guid);
+        }
+
+        // ~1 ms apart, pads interleaved
+        const double writeNs = Bench::nsPerOp(kRecords, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations && i < kRecords; i++)
+                writer.append(ids[i % kPads], static_cast<int64_t>(i) * 1000000 + static_cast<int64_t>(i % 97), stream[i]);
+        });
+        writer.close();
+        Bench::report("CaptureWriter::append (" + mode + ")", writeNs);
+
+        // nsPerOp runs the body more than once; rewrite a single pass so the
+        // file holds exactly the stream
+        writer.open(path, delta);
+        for (uint8_t pad = 0; pad < kPads; pad++)
+        {
+            uint8_t guid[16] = { pad, 0x7e, 0x05, 0x19, 0x20 };
+            writer.addDevice(guid);
+        }
+        for (size_t i = 0; i < kRecords; i++)
+            writer.append(ids[i % kPads], static_cast<int64_t>(i) * 1000000 + static_cast<int64_t>(i % 97), stream[i]);
+        writer.close();
+
+        const long size = fileSize(path);
+        std::cout << "  capture bytes/record (" << mode << "): " << static_cast<double>(size) / kRecords << std::endl;
+
+        // Round trip: every state and timestamp comes back bit for bit
+        CaptureReader reader;
+        Bench::check(reader.open(path), "open capture for reading (" + mode + ")");
+
+        size_t states = 0;
+        size_t devices = 0;
+        bool matches = true;
+        CaptureRecord record;
+        while (reader.next(record))
+        {
+            if (record.type == Capture::DEVICE)
+            {
+                devices++;
+                continue;
+            }
+            const auto expectedNs = static_cast<int64_t>(states) * 1000000 + static_cast<int64_t>(states % 97);
+            if (states >= kRecords ||
+                record.controllerId != ids[states % kPads] ||
+                record.timestampNs != expectedNs ||
+                memcmp(&record.state, &stream[states], sizeof(N64ControllerState)) != 0)
+                matches = false;
+            states++;
+        }
+        Bench::check(devices == kPads && states == kRecords && matches && !reader.truncated(), "capture round trip is exact (" + mode + ")");
+
+        // Replay throughput through the same pipeline the controllers use
+        ReportPipeline pipelines[kPads];
+        const double replayNs = Bench::nsPerOp(kRecords, [&](uint64_t iterations)
+        {
+            uint64_t done = 0;
+            while (done < iterations)
+            {
+                reader.rewind();
+                while (done < iterations && reader.next(record))
+                {
+                    if (record.type == Capture::DEVICE)
+                        continue;
+                    XusbReport report;
+                    if (pipelines[record.controllerId % kPads].process(record.state, report))
+                        Bench::doNotOptimize(report);
+                    done++;
+                }
+            }
+        });
+        Bench::report("replay read + convert (" + mode + ")", replayNs);
+    }
+
+    // A capture cut mid-record reads cleanly up to the last complete one
+    {
+        const long size = fileSize(path);
+        std::vector<char> bytes(static_cast<size_t>(size));
+        FILE* file = fopen(path.c_str(), "rb");
+        const size_t read = fread(bytes.data(), 1, bytes.size(), file);
+        fclose(file);
+
+        file = fopen(path.c_str(), "wb");
+        fwrite(bytes.data(), 1, read - 3, file);
+        fclose(file);
+
+        CaptureReader reader;
+        Bench::check(reader.open(path), "open truncated capture");
+        size_t states = 0;
+        CaptureRecord record;
+        while (reader.next(record))
+            if (record.type != Capture::DEVICE)
+                states++;
+        Bench::check(reader.truncated() && states == kRecords - 1, "truncated capture stops at the last complete record");
+    }
+
+    std::remove(path.c_str());
+});
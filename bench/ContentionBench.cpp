@@ -0,0 +1,110 @@
+#include "Bench.h"
+
+#include "core/DeviceLocks.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+// Stand-in for DirectInput + ViGEm: every call holds the wrapper lock for the
+// duration of a blocking "IOCTL"
+struct FakeBackend
+{
+    enum class Locking
+    {
+        Global,     // one process wide mutex, as the wrappers used to do
+        PerDevice   // DeviceLocks stripes, as the wrappers do now
+    };
+
+    Locking     locking;
+    std::mutex  globalMutex;
+    DeviceLocks locks;
+
+    std::chrono::microseconds ioctlTime { 20 };
+
+    std::mutex& lockFor(const void* device)
+    {
+        return locking == Locking::Global ? globalMutex : locks.forDevice(device);
+    }
+
+    void getDeviceState(const void* device)
+    {
+        std::lock_guard<std::mutex> lock(lockFor(device));
+        std::this_thread::sleep_for(ioctlTime);
+    }
+
+    void targetUpdate(const void* target)
+    {
+        std::lock_guard<std::mutex> lock(lockFor(target));
+        std::this_thread::sleep_for(ioctlTime);
+    }
+};
+
+// Each simulated pad produces a report every millisecond; latency is from
+// the report being due to the virtual pad update returning
+std::vector<double> simulate(FakeBackend& backend, size_t pads, int reportsPerPad)
+{
+    struct Pad
+    {
+        int device;
+        int target;
+        std::vector<double> latencies;
+    };
+
+    std::vector<std::unique_ptr<Pad>> state;
+    for (size_t i = 0; i < pads; i++)
+        state.push_back(std::make_unique<Pad>());
+
+    const auto start = Clock::now() + std::chrono::milliseconds(5);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < pads; i++)
+    {
+        threads.emplace_back([&, i]
+        {
+            auto& pad = *state[i];
+            pad.latencies.reserve(reportsPerPad);
+            const auto phase = std::chrono::microseconds((i * 997) % 1000);
+            for (int report = 0; report < reportsPerPad; report++)
+            {
+                const auto due = start + phase + std::chrono::milliseconds(report);
+                std::this_thread::sleep_until(due);
+
+                backend.getDeviceState(&pad.device);
+                backend.targetUpdate(&pad.target);
+
+                pad.latencies.push_back(std::chrono::duration<double, std::nano>(Clock::now() - due).count());
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    std::vector<double> latencies;
+    for (const auto& pad : state)
+        latencies.insert(latencies.end(), pad->latencies.begin(), pad->latencies.end());
+    return latencies;
+}
+
+}
+
+static Bench::Register sContention("wrapper-contention", []
+{
+    for (size_t pads : { 1, 2, 4, 8, 16, 32, 64 })
+    {
+        for (auto locking : { FakeBackend::Locking::Global, FakeBackend::Locking::PerDevice })
+        {
+            FakeBackend backend;
+            backend.locking = locking;
+
+            auto latencies = simulate(backend, pads, 100);
+            Bench::reportLatency(std::string(locking == FakeBackend::Locking::Global ? "global lock" : "per-device locks") +
+                                 " x" + std::to_string(pads), latencies);
+        }
+    }
+});
@@ -0,0 +1,154 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/Clock.h"
+#include "core/Controller.h"
+#include "core/DeviceDescriptors.h"
+#include "core/FakeBackends.h"
+#include "core/ProfileStore.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// A stickless pad reading with one slot pressed; the axes hold what a
+// driver leaves in objects the pad doesn't have
+XusbReport press(const DeviceType& type, uint32_t slot)
+{
+    N64ControllerState state {};
+    state.dpad = -1;
+    state.buttons[slot] = 0x80;
+    XusbReport report;
+    type.convert(type.defaultTables(), state, report);
+    return report;
+}
+
+bool rests(const XusbReport& report)
+{
+    return report.sThumbLX == 0 && report.sThumbLY == 0 && report.sThumbRX == 0 && report.sThumbRY == 0;
+}
+
+}
+
+static Bench::Register sDevices("devices", []
+{
+    const auto* n64     = DeviceTypes::find(kNintendoVendorId, N64Pad::kProductId);
+    const auto* snes    = DeviceTypes::find(kNintendoVendorId, SnesPad::kProductId);
+    const auto* genesis = DeviceTypes::find(kNintendoVendorId, GenesisPad::kProductId);
+
+    // Matching
+    {
+        Bench::check(n64 == &DeviceTypes::n64() && snes && genesis && std::string(snes->name) == "SNES" && std::string(genesis->name) == "Genesis",
+                     "every descriptor is found by vendor and product id");
+        Bench::check(DeviceTypes::find(snes->productGuid) == snes && snes->productGuid.toString() == "2017057e-0000-0000-0000-504944564944",
+                     "and by DirectInput product GUID");
+        Bench::check(!DeviceTypes::find(kNintendoVendorId, 0x2009) && !DeviceTypes::find(0x045e, N64Pad::kProductId) && !DeviceTypes::find(Bench::makeGuid(0)),
+                     "other devices match nothing");
+    }
+
+    // The N64 routine is the table conversion
+    {
+        auto states = Bench::makeStates(4096);
+        bool identical = true;
+        for (auto& state : states)
+        {
+            // Slots the N64 pad doesn't have
+            state.buttons[11] = state.buttons[14] = state.buttons[15] = 0;
+
+            XusbReport expected, actual;
+            MappingTables::defaults().convert(state, expected);
+            n64->convert(n64->defaultTables(), state, actual);
+            identical = identical && memcmp(&expected, &actual, sizeof(expected)) == 0;
+        }
+        Bench::check(identical, "the N64 pad converts exactly as the built in mapping");
+    }
+
+    // Stickless pads
+    {
+        const auto y = press(*snes, SnesButton::Y);
+        const auto zr = press(*snes, SnesButton::ZR);
+        Bench::check(y.wButtons == Xusb::X && press(*snes, SnesButton::B).wButtons == Xusb::A && press(*snes, SnesButton::SELECT).wButtons == Xusb::BACK,
+                     "SNES buttons map by position");
+        Bench::check(zr.bRightTrigger == 0xFF && zr.wButtons == 0 && press(*snes, SnesButton::ZL).bLeftTrigger == 0xFF, "SNES ZL / ZR pull the triggers");
+        Bench::check(press(*genesis, GenesisButton::A).wButtons == Xusb::X && press(*genesis, GenesisButton::C).wButtons == Xusb::B &&
+                     press(*genesis, GenesisButton::Z).wButtons == Xusb::RIGHT_SHOULDER,
+                     "Genesis buttons map by position");
+        Bench::check(rests(y) && rests(press(*genesis, GenesisButton::START)), "pads without sticks leave both sticks at rest");
+        Bench::check(press(*genesis, 6).wButtons == 0 && press(*genesis, 6).bLeftTrigger == 0 && press(*snes, 10).wButtons == 0,
+                     "slots a pad doesn't report press nothing");
+    }
+
+    // Cost per report of each pad's routine
+    {
+        const auto states = Bench::makeStates(4096);
+        for (const auto& type : DeviceTypes::kAll)
+        {
+            const auto& tables = type.defaultTables();
+            const auto  convert = type.convert;
+            char name[64];
+            snprintf(name, sizeof(name), "convert, %s pad", type.name);
+            Bench::report(name, Bench::nsPerOp(1 << 22, [&](uint64_t iterations)
+            {
+                XusbReport report;
+                for (uint64_t i = 0; i < iterations; i++)
+                {
+                    convert(tables, states[i & 4095], report);
+                    Bench::doNotOptimize(report);
+                }
+            }));
+        }
+    }
+
+    // End to end: a SNES pad next to an N64 pad, a profile attached to both
+    {
+        FakeInputBackend inputs;
+        FakeSinkBackend  sinks;
+        std::mutex              mutex;
+        std::vector<XusbReport> reports[2];
+        sinks.setSubmitCallback([&](uint32_t sink, const XusbReport& report)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            reports[sink].push_back(report);
+        });
+        auto received = [&](uint32_t sink)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return reports[sink].size();
+        };
+
+        // A presses Y
+        Profile remapped = Profile::defaults();
+        remapped.buttons[N64Button::A] = Xusb::Y;
+        auto store = ProfileStore::create(std::make_unique<MappingTables>(remapped));
+
+        ControllerContext context;
+        context.profiles = store.get();
+        inputs.plug(Bench::makeGuid(1), DeviceTypes::n64());
+        inputs.plug(Bench::makeGuid(2), *snes);
+        Controller pads[2];
+        const bool opened = pads[0].open(inputs, sinks, Bench::makeGuid(1), context) && pads[1].open(inputs, sinks, Bench::makeGuid(2), context);
+        Bench::check(opened && pads[0].deviceType().productId == N64Pad::kProductId && pads[1].deviceType().productId == SnesPad::kProductId,
+                     "each pad opens as its own type");
+
+        auto state = Bench::neutral();
+        state.buttons[N64Button::A] = 0x80;     // SnesButton::A too
+        state.xAxis = 0;
+        inputs.push(Bench::makeGuid(1), state);
+        inputs.push(Bench::makeGuid(2), state);
+        Bench::check(Bench::waitFor([&] { return received(0) == 2 && received(1) == 2; }), "both pads report");
+
+        pads[0].close();
+        pads[1].close();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        Bench::check(reports[0].size() >= 2 && reports[0][1].wButtons == Xusb::Y && reports[0][1].sThumbLX < 0, "the N64 pad converts with the profile");
+        Bench::check(reports[1].size() >= 2 && reports[1][1].wButtons == Xusb::B && rests(reports[1][1]), "the SNES pad keeps its own mapping");
+    }
+});
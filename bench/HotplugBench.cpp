@@ -0,0 +1,210 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/Clock.h"
+#include "core/FakeDeviceSource.h"
+#include "core/HotplugDetector.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// Runs a detector on its own thread and lets the bench wait for events
+class DetectorHarness
+{
+public:
+    DetectorHarness(FakeDeviceSource& source, uint32_t fallbackPollMs)
+    {
+        detector_.setAddedCallback([this](const DeviceGuid&){ event(added_); });
+        detector_.setRemovedCallback([this](const DeviceGuid&){ event(removed_); });
+        thread_ = std::thread([this, &source, fallbackPollMs]{ detector_.run(source, fallbackPollMs); });
+    }
+
+    ~DetectorHarness()
+    {
+        detector_.stop();
+        thread_.join();
+    }
+
+    // Returns the time of the event, or -1 after a second without one
+    int64_t waitAdded(uint64_t count)   { return wait(added_, count); }
+    int64_t waitRemoved(uint64_t count) { return wait(removed_, count); }
+
+    const HotplugDetector& detector() const { return detector_; }
+
+private:
+    struct Events
+    {
+        uint64_t count { 0 };
+        int64_t  lastNs { 0 };
+    };
+
+    void event(Events& events)
+    {
+        const auto nowNs = Clock::nowNs();
+        std::lock_guard<std::mutex> lock(mutex_);
+        events.count++;
+        events.lastNs = nowNs;
+        cvar_.notify_all();
+    }
+
+    int64_t wait(Events& events, uint64_t count)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!cvar_.wait_for(lock, std::chrono::seconds(1), [&]{ return events.count >= count; }))
+            return -1;
+        return events.lastNs;
+    }
+
+    HotplugDetector         detector_;
+    std::thread             thread_;
+    std::mutex              mutex_;
+    std::condition_variable cvar_;
+    Events                  added_;
+    Events                  removed_;
+};
+
+// Plug / unplug one pad `samples` times and return the detection latencies
+std::vector<double> timeToDetect(FakeDeviceSource& source, DetectorHarness& harness, int samples, bool notify)
+{
+    std::vector<double> latencies;
+    const auto id = Bench::makeGuid(100);
+    for (int i = 0; i < samples; i++)
+    {
+        // Unaligned with any poll period
+        std::this_thread::sleep_for(std::chrono::microseconds(1000 + (i * 7919) % 5000));
+
+        const auto pluggedNs = Clock::nowNs();
+        source.plug(id, notify);
+        const auto addedNs = harness.waitAdded(i + 1);
+        if (addedNs < 0)
+            return {};
+        latencies.push_back(static_cast<double>(addedNs - pluggedNs));
+
+        source.unplug(id, notify);
+        if (harness.waitRemoved(i + 1) < 0)
+            return {};
+    }
+    return latencies;
+}
+
+}
+
+static Bench::Register sHotplug("hotplug", []
+{
+    // Merge walk diff against std::set_difference on random sorted sets
+    {
+        std::mt19937 rng(17);
+        std::bernoulli_distribution present(0.3);
+        bool matches = true;
+        std::vector<DeviceGuid> before, after, added, removed, expectedAdded, expectedRemoved;
+        for (int trial = 0; trial < 20000 && matches; trial++)
+        {
+            before.clear();
+            after.clear();
+            for (uint32_t i = 0; i < 24; i++)
+            {
+                if (present(rng))
+                    before.push_back(Bench::makeGuid(i));
+                if (present(rng))
+                    after.push_back(Bench::makeGuid(i));
+            }
+            std::sort(before.begin(), before.end());
+            std::sort(after.begin(), after.end());
+
+            added.clear();
+            removed.clear();
+            Hotplug::diffSorted(before, after,
+                [&](const DeviceGuid& id){ added.push_back(id); },
+                [&](const DeviceGuid& id){ removed.push_back(id); });
+
+            expectedAdded.clear();
+            expectedRemoved.clear();
+            std::set_difference(after.begin(), after.end(), before.begin(), before.end(), std::back_inserter(expectedAdded));
+            std::set_difference(before.begin(), before.end(), after.begin(), after.end(), std::back_inserter(expectedRemoved));
+            matches = added == expectedAdded && removed == expectedRemoved;
+        }
+        Bench::check(matches, "diffSorted matches set_difference");
+    }
+
+    // Steady state diff with one device swapped out, up to far more devices
+    // than a real machine enumerates
+    for (uint32_t count : { 8, 64, 256, 1024 })
+    {
+        std::vector<DeviceGuid> before, after;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            before.push_back(Bench::makeGuid(i));
+            after.push_back(Bench::makeGuid(i == 3 ? count + 50 : i));
+        }
+        std::sort(before.begin(), before.end());
+        std::sort(after.begin(), after.end());
+
+        uint64_t changes = 0;
+        Bench::report("diffSorted (" + std::to_string(count) + " pads, 1 swapped)", Bench::nsPerOp((1 << 23) / count, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; i++)
+                Hotplug::diffSorted(before, after,
+                    [&](const DeviceGuid&){ changes++; },
+                    [&](const DeviceGuid&){ changes++; });
+        }));
+        Bench::doNotOptimize(changes);
+    }
+
+    // Enumeration order must not matter: pads showing up in descending order
+    // and rescanned constantly are reported once and never removed
+    {
+        FakeDeviceSource source;
+        for (uint32_t i = 8; i-- > 0;)
+            source.plug(Bench::makeGuid(i), false);
+
+        {
+            DetectorHarness harness(source, 1);
+            harness.waitAdded(8);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            const auto& counters = harness.detector().counters();
+            Bench::check(counters.scans > 10 && counters.added == 8 && counters.removed == 0, "no spurious add/remove across rescans");
+        }
+    }
+
+    // Time to detect with arrival notifications (fallback poll 500 ms, as
+    // main.cpp configures it) versus polling alone
+    {
+        FakeDeviceSource source;
+        DetectorHarness harness(source, 500);
+        auto latencies = timeToDetect(source, harness, 200, true);
+        Bench::check(latencies.size() == 200, "every notified plug detected");
+        if (!latencies.empty())
+            Bench::reportLatency("time to detect, notified", latencies);
+    }
+    {
+        FakeDeviceSource source;
+        DetectorHarness harness(source, 20);
+        auto latencies = timeToDetect(source, harness, 50, false);
+        Bench::check(latencies.size() == 50, "every unnotified plug detected by the fallback poll");
+        if (!latencies.empty())
+            Bench::reportLatency("time to detect, 20 ms poll only", latencies);
+    }
+
+    // Enumeration lagging the notification: the settle rescans pick the pad
+    // up well before the 500 ms fallback poll would
+    {
+        FakeDeviceSource source;
+        source.setVisibilityDelayNs(30 * 1000 * 1000);
+        DetectorHarness harness(source, 500);
+        auto latencies = timeToDetect(source, harness, 10, true);
+        Bench::check(latencies.size() == 10, "every lagging plug detected");
+        if (!latencies.empty())
+        {
+            Bench::check(*std::max_element(latencies.begin(), latencies.end()) < 100e6, "lagging enumeration detected by settle rescans");
+            Bench::reportLatency("time to detect, enumeration lags 30 ms", latencies);
+        }
+    }
+});
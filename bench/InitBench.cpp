@@ -0,0 +1,177 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/Clock.h"
+#include "core/Controller.h"
+#include "core/FakeBackends.h"
+#include "core/InitPipeline.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// Roughly CreateDevice .. Acquire and target_add on a cold bus
+static constexpr uint32_t kOpenDelayMs = 20;
+static constexpr uint32_t kPlugDelayMs = 20;
+static constexpr uint32_t kWorkers     = 4;
+
+std::vector<InitPipeline::Step> openSteps(Controller& controller, InputBackend& inputs, SinkBackend& sinks,
+                                          const DeviceGuid& id, const ControllerContext& context)
+{
+    std::vector<InitPipeline::Step> steps;
+    for (uint8_t step = Controller::BEGIN; step < Controller::OPEN_STEPS; step++)
+    {
+        steps.push_back([&controller, &inputs, &sinks, id, context, step]
+        {
+            return controller.openStep(static_cast<Controller::OpenStep>(step), inputs, sinks, id, context);
+        });
+    }
+    return steps;
+}
+
+struct Startup
+{
+    double              totalMs { 0 };
+    std::vector<double> firstReportNs;
+};
+
+// Every pad detected at once, opened one after another on one thread (the
+// way the detector callback used to) or through the pipeline
+Startup startup(uint32_t pads, bool pipelined)
+{
+    FakeInputBackend inputs;
+    FakeSinkBackend  sinks;
+    inputs.setOpenDelayMs(kOpenDelayMs);
+    sinks.setPlugDelayMs(kPlugDelayMs);
+    for (uint32_t i = 0; i < pads; i++)
+        inputs.plug(Bench::makeGuid(i));
+
+    std::vector<Controller> controllers(pads);
+    ControllerContext context;
+    context.detectedNs = Clock::nowNs();
+
+    Startup result;
+    if (pipelined)
+    {
+        auto pipeline = InitPipeline::create(kWorkers);
+        for (uint32_t i = 0; i < pads; i++)
+            pipeline->start(Bench::makeGuid(i), openSteps(controllers[i], inputs, sinks, Bench::makeGuid(i), context), nullptr);
+        pipeline->drain();
+    }
+    else
+    {
+        for (uint32_t i = 0; i < pads; i++)
+            controllers[i].open(inputs, sinks, Bench::makeGuid(i), context);
+    }
+    result.totalMs = (Clock::nowNs() - context.detectedNs) / 1e6;
+
+    for (auto& controller : controllers)
+    {
+        const auto firstNs = controller.stats().timeToFirstReportNs();
+        if (controller.isReady() && firstNs >= 0)
+            result.firstReportNs.push_back(static_cast<double>(firstNs));
+        controller.close();
+    }
+    return result;
+}
+
+}
+
+static Bench::Register sInit("init", []
+{
+    // Startup time against pad count
+    {
+        static constexpr uint32_t kCounts[] = { 1, 2, 4, 8 };
+        double sequentialMs[4] {};
+        double pipelinedMs[4] {};
+        bool   allReported = true;
+
+        printf("  %4s %14s %14s   (open %u ms + plug %u ms per pad, %u init threads)\n",
+               "pads", "sequential ms", "pipelined ms", kOpenDelayMs, kPlugDelayMs, kWorkers);
+        for (size_t i = 0; i < 4; i++)
+        {
+            const auto sequential = startup(kCounts[i], false);
+            auto       pipelined  = startup(kCounts[i], true);
+            sequentialMs[i] = sequential.totalMs;
+            pipelinedMs[i]  = pipelined.totalMs;
+            allReported = allReported && pipelined.firstReportNs.size() == kCounts[i];
+            printf("  %4u %14.1f %14.1f\n", kCounts[i], sequentialMs[i], pipelinedMs[i]);
+            if (kCounts[i] == 8 && !pipelined.firstReportNs.empty())
+            {
+                // Sorted by reportLatency; the first pads don't wait for the last
+                Bench::reportLatency("time to first report, 8 pads pipelined", pipelined.firstReportNs);
+                printf("  first pad's first report after %.1f ms\n", pipelined.firstReportNs.front() / 1e6);
+            }
+        }
+
+        Bench::check(allReported, "every pad opened through the pipeline gets its first report out");
+        Bench::check(pipelinedMs[2] < 2 * pipelinedMs[0], "opening 4 pads takes well under 4 times as long as opening 1");
+        Bench::check(pipelinedMs[3] < 0.5 * sequentialMs[3], "the pipeline opens 8 pads in under half the sequential time");
+    }
+
+    // A pad removed while it's opening
+    {
+        FakeInputBackend inputs;
+        FakeSinkBackend  sinks;
+        inputs.setOpenDelayMs(50);
+        const auto id = Bench::makeGuid(0x10);
+        inputs.plug(id);
+
+        Controller controller;
+        auto pipeline = InitPipeline::create(kWorkers);
+        std::atomic<int> outcome { -1 };
+        pipeline->start(id, openSteps(controller, inputs, sinks, id, {}), [&](InitPipeline::Result result, int64_t)
+        {
+            outcome = result;
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        const bool cancelled = pipeline->cancel(id);
+        Bench::check(cancelled && !controller.isReady(), "cancel() stops a pad in the middle of opening");
+        pipeline->drain();
+        Bench::check(outcome == InitPipeline::CANCELLED && sinks.plugged() == 0, "its later steps never run");
+        controller.close();
+        Bench::check(!controller.isOpen() && sinks.live() == 0 && !pipeline->cancel(id), "and it closes like a failed open");
+    }
+
+    // Queued jobs, failures and shutdown
+    {
+        auto pipeline = InitPipeline::create(1);
+        std::atomic<int> stepsRun { 0 };
+        std::atomic<int> outcomes[3] {};
+        auto slowSteps = [&](uint32_t count)
+        {
+            std::vector<InitPipeline::Step> steps;
+            for (uint32_t i = 0; i < count; i++)
+                steps.push_back([&]{ std::this_thread::sleep_for(std::chrono::milliseconds(5)); stepsRun++; return true; });
+            return steps;
+        };
+        auto count = [&](InitPipeline::Result result, int64_t) { outcomes[result]++; };
+
+        pipeline->start(Bench::makeGuid(1), slowSteps(2), count);
+        pipeline->start(Bench::makeGuid(2), slowSteps(2), count);
+        pipeline->cancel(Bench::makeGuid(2));
+        pipeline->drain();
+        Bench::check(stepsRun == 2 && outcomes[InitPipeline::READY] == 1 && outcomes[InitPipeline::CANCELLED] == 1,
+                     "a job cancelled before its first step never runs");
+
+        std::vector<InitPipeline::Step> failing;
+        failing.push_back([]{ return false; });
+        failing.push_back([&]{ stepsRun++; return true; });
+        pipeline->start(Bench::makeGuid(3), std::move(failing), count);
+        pipeline->drain();
+        Bench::check(stepsRun == 2 && outcomes[InitPipeline::FAILED] == 1, "a failed step ends its job");
+
+        // Destroying the pipeline cancels what's queued and reports it
+        for (uint32_t i = 0; i < 4; i++)
+            pipeline->start(Bench::makeGuid(4 + i), slowSteps(4), count);
+        pipeline.reset();
+        Bench::check(outcomes[InitPipeline::READY] + outcomes[InitPipeline::CANCELLED] == 6 && stepsRun < 2 + 16,
+                     "shutdown finishes every job, cancelling the rest");
+    }
+});
@@ -0,0 +1,137 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/Clock.h"
+#include "core/Controller.h"
+#include "core/FakeBackends.h"
+#include "core/ThreadTuning.h"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// Push to virtual pad update, one state at a time with idle gaps between
+// them the way a person presses buttons
+void measure(EventLoop::WaitMode mode, const char* name)
+{
+    static constexpr int kPresses = 400;
+
+    FakeInputBackend      inputs;
+    FakeSinkBackend       sinks;
+    std::atomic<int64_t>  submittedNs { 0 };
+    std::atomic<int>      submitted { 0 };
+    sinks.setSubmitCallback([&](uint32_t, const XusbReport&)
+    {
+        submittedNs.store(Clock::nowNs());
+        submitted++;
+    });
+
+    const auto id = Bench::makeGuid(mode);
+    inputs.plug(id);
+
+    ControllerContext context;
+    context.input.mode   = mode;
+    context.input.spinNs = 200000;
+    Controller controller;
+    if (!controller.open(inputs, sinks, id, context))
+    {
+        Bench::check(false, std::string(name) + ": controller opens");
+        return;
+    }
+
+    auto state = Bench::neutral();
+    std::vector<double> samples;
+    samples.reserve(kPresses);
+    for (int i = 0; i < kPresses; i++)
+    {
+        // 50us to 1ms apart: some presses land inside the hybrid spin,
+        // some after it gave up
+        std::this_thread::sleep_for(std::chrono::microseconds(50 + (i * 379) % 950));
+
+        state.buttons[N64Button::A] = (i & 1) ? 0x80 : 0;
+        const int before   = submitted.load();
+        const auto pushNs  = Clock::nowNs();
+        inputs.push(id, state);
+
+        const auto giveUpNs = pushNs + 100 * 1000000ll;
+        while (submitted.load() == before && Clock::nowNs() < giveUpNs)
+            std::this_thread::yield();
+        if (submitted.load() != before)
+            samples.push_back(static_cast<double>(submittedNs.load() - pushNs));
+    }
+
+    const auto& total = controller.stats().stages[ControllerStats::TOTAL];
+    const auto  p50   = static_cast<double>(total.percentile(0.50));
+    printf("  %-8s wake to submit jitter: p99-p50 %.1f us  p999-p50 %.1f us\n",
+           name, (total.percentile(0.99) - p50) / 1000.0, (total.percentile(0.999) - p50) / 1000.0);
+
+    Bench::check(samples.size() == kPresses, std::string(name) + ": every press reaches the virtual pad");
+    Bench::check(std::string(controller.stats().inputMode) == EventLoop::modeName(mode), std::string(name) + ": stats name the input mode");
+    Bench::reportLatency(std::string("push -> submit, ") + name, samples);
+
+    // A polling loop still hears stop()
+    controller.close();
+}
+
+}
+
+static Bench::Register sInputModes("input-modes", []
+{
+    measure(EventLoop::EVENT, "event");
+    measure(EventLoop::HYBRID, "hybrid");
+    measure(EventLoop::BUSY_POLL, "poll");
+
+    // Reactor threads wait with the reactor's strategy
+    {
+        EventLoop::Strategy strategy;
+        strategy.mode = EventLoop::HYBRID;
+        Reactor reactor(1, strategy);
+
+        FakeInputBackend inputs;
+        FakeSinkBackend  sinks;
+        std::atomic<int> submitted { 0 };
+        sinks.setSubmitCallback([&](uint32_t, const XusbReport&) { submitted++; });
+
+        const auto id = Bench::makeGuid(16);
+        inputs.plug(id);
+        ControllerContext context;
+        context.reactor = &reactor;
+        Controller controller;
+        const bool opened = controller.open(inputs, sinks, id, context);
+
+        auto state = Bench::neutral();
+        state.buttons[N64Button::B] = 0x80;
+        inputs.push(id, state);
+        const auto giveUpNs = Clock::nowNs() + 100 * 1000000ll;
+        while (submitted.load() == 0 && Clock::nowNs() < giveUpNs)
+            std::this_thread::yield();
+
+        Bench::check(opened && submitted.load() == 1 && std::string(controller.stats().inputMode) == "hybrid",
+                     "a reactor pad is serviced with the reactor's strategy");
+        controller.close();
+    }
+
+    // Pinning is allowed for anyone; priorities may need privileges
+    {
+        bool pinned   = false;
+        bool realtime = false;
+        std::thread([&]
+        {
+            ThreadSettings settings;
+            settings.cpu = 0;
+            pinned = ThreadTuning::apply(settings);
+
+            settings.cpu      = -1;
+            settings.priority = ThreadSettings::REALTIME;
+            realtime = ThreadTuning::apply(settings);
+        }).join();
+
+        printf("  realtime priority %s\n", realtime ? "granted" : "refused (needs privileges)");
+        Bench::check(pinned, "a thread can be pinned to CPU 0");
+    }
+});
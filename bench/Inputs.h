@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Bench.h"
+
+#include "core/Clock.h"
+#include "core/DeviceGuid.h"
+#include "core/N64ControllerState.h"
+#include "core/Profile.h"
+
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Bench
+{
+
+// Plausible pad states: sticks across the calibrated range, sparse buttons
+// (DirectInput reports 0x80 for pressed) and a centered or 8-way dpad.
+inline std::vector<N64ControllerState> makeStates(size_t count, uint32_t seed = 1234)
+{
+    static constexpr int32_t kDpad[] = { -1, 0, 4500, 9000, 13500, 18000, 22500, 27000, 31500 };
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int32_t> axis(0, 65535);
+    std::uniform_int_distribution<int> dpad(0, 8);
+    std::bernoulli_distribution pressed(0.15);
+
+    std::vector<N64ControllerState> states(count);
+    for (auto& state : states)
+    {
+        memset(&state, 0, sizeof(state));
+        state.xAxis = axis(rng);
+        state.yAxis = axis(rng);
+        state.dpad  = kDpad[dpad(rng)];
+        for (auto& button : state.buttons)
+            button = pressed(rng) ? 0x80 : 0;
+    }
+    return states;
+}
+
+// A pad at rest: sticks centered, nothing pressed
+inline N64ControllerState neutral()
+{
+    N64ControllerState state {};
+    state.dpad  = -1;
+    state.xAxis = 32767;
+    state.yAxis = 32767;
+    return state;
+}
+
+// Instance GUIDs for fake pads; like real DirectInput instance ids they
+// differ across Data1
+inline DeviceGuid makeGuid(uint32_t index)
+{
+    DeviceGuid id = { 0x51d0c300u ^ (index * 0x9E3779B1u), static_cast<uint16_t>(index), 0x11ef, { 0x80, 0x00, 0x44, 0x45, 0x53, 0x54, 0x00, 0x00 } };
+    return id;
+}
+
+// Yields until done() or the timeout; false on timeout
+inline bool waitFor(const std::function<bool()>& done, int64_t timeoutNs = 2000000000)
+{
+    const auto giveUpNs = Clock::nowNs() + timeoutNs;
+    while (!done())
+    {
+        if (Clock::nowNs() > giveUpNs)
+            return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+// Yields while waiting so the controller thread runs even on one core
+inline void spinFor(int64_t ns)
+{
+    const auto untilNs = Clock::nowNs() + ns;
+    while (Clock::nowNs() < untilNs)
+        std::this_thread::yield();
+}
+
+// The first profile of a profile file's text; a failed check and the
+// defaults if it doesn't parse
+inline Profile parseOne(const std::string& text)
+{
+    std::vector<Profile> profiles;
+    std::string error;
+    if (!Profile::parse(text, profiles, error))
+    {
+        Bench::check(false, "profile parses: " + error);
+        return Profile::defaults();
+    }
+    return profiles.front();
+}
+
+}
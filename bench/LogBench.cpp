@@ -0,0 +1,217 @@
+#include "Bench.h"
+
+#include "core/Clock.h"
+#include "core/Log.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+std::vector<std::string> readLines(const std::string& path)
+{
+    std::vector<std::string> lines;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line))
+        lines.push_back(line);
+    return lines;
+}
+
+void removeLogs(const std::string& path)
+{
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    for (int i = 1; i <= 4; i++)
+        std::filesystem::remove(path + "." + std::to_string(i), error);
+}
+
+Log::Config fileConfig(const std::string& path, uint32_t rate)
+{
+    Log::Config config;
+    config.console       = false;
+    config.filePath      = path;
+    config.ratePerSecond = rate;
+    config.maxFileBytes  = 64 << 20;
+    return config;
+}
+
+}
+
+static Bench::Register sLog("log", []
+{
+    const auto path = (std::filesystem::temp_directory_path() / "n64-bench.log").string();
+
+    // Cost to the calling thread: a ring push versus a flushed stream write
+    {
+        removeLogs(path);
+        Log::start(fileConfig(path, 0));
+        const auto before = Log::counters();
+
+        static constexpr int kRounds = 50;
+        static constexpr int kBatch  = 200;
+        std::vector<double> samples;
+        samples.reserve(kRounds * kBatch);
+        for (int round = 0; round < kRounds; round++)
+        {
+            for (int i = 0; i < kBatch; i++)
+            {
+                const auto startNs = Clock::nowNs();
+                Log::error("Failed to read device state: pad %d error %d", i & 3, round);
+                samples.push_back(static_cast<double>(Clock::nowNs() - startNs));
+            }
+            Log::flush();
+        }
+        const auto after = Log::counters();
+        Log::stop();
+
+        double total = 0;
+        for (const auto sample : samples)
+            total += sample;
+        Bench::report("Log::error (async)", total / samples.size());
+        Bench::reportLatency("Log::error (async) per call", samples);
+        Bench::check(after.written - before.written == kRounds * kBatch && after.dropped == before.dropped, "every message reaches the file");
+        Bench::check(readLines(path).size() == kRounds * kBatch, "the file holds one line per message");
+
+        std::ofstream stream(path + ".sync", std::ios::trunc);
+        Bench::report("std::ofstream << ... << std::endl", Bench::nsPerOp(2000, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; i++)
+                stream << "Failed to read device state: pad " << (i & 3) << " error " << i << std::endl;
+        }));
+        stream.close();
+        std::error_code error;
+        std::filesystem::remove(path + ".sync", error);
+    }
+
+    // A thread's first message, with its ring set up as the thread starts or
+    // on the message itself
+    {
+        removeLogs(path);
+        Log::start(fileConfig(path, 0));
+        std::vector<double> attached, unattached;
+        for (int i = 0; i < 40; i++)
+        {
+            const bool attach = i & 1;
+            double firstNs = 0;
+            std::thread thread([&]
+            {
+                if (attach)
+                    Log::attachThread();
+                const auto startNs = Clock::nowNs();
+                Log::error("Failed to read device state: pad %d error %d", i, 0);
+                firstNs = static_cast<double>(Clock::nowNs() - startNs);
+            });
+            thread.join();
+            (attach ? attached : unattached).push_back(firstNs);
+        }
+        Log::flush();
+        Log::stop();
+        Bench::reportLatency("first Log::error on a thread, attached", attached);
+        Bench::reportLatency("first Log::error on a thread, not attached", unattached);
+    }
+
+    // A flood never blocks the caller; what doesn't fit the ring is counted
+    {
+        removeLogs(path);
+        Log::start(fileConfig(path, 0));
+        const auto before = Log::counters();
+        double worstNs = 0;
+        for (int i = 0; i < 20000; i++)
+        {
+            const auto startNs = Clock::nowNs();
+            Log::error("flood %d", i);
+            worstNs = (std::max)(worstNs, static_cast<double>(Clock::nowNs() - startNs));
+        }
+        Log::flush();
+        const auto after = Log::counters();
+        Log::stop();
+
+        const auto dropped = after.dropped - before.dropped;
+        const auto written = after.written - before.written;
+        printf("  flood of 20000: %llu written, %llu dropped, slowest call %.1f us\n",
+               static_cast<unsigned long long>(written), static_cast<unsigned long long>(dropped), worstNs / 1000.0);
+        Bench::check(written + dropped == 20000, "a flood is written or counted as dropped, never lost silently");
+    }
+
+    // Rate limit per call site, with a summary once the site logs again
+    {
+        removeLogs(path);
+        Log::start(fileConfig(path, 5));
+        const auto before = Log::counters();
+        for (int i = 0; i < 1000; i++)
+            Log::error("Failed to read device state: DIERR_INPUTLOST (%d)", i);
+        Log::info("another site still gets through");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        Log::error("Failed to read device state: DIERR_INPUTLOST (%d)", 1000);
+        Log::stop();
+
+        const auto after = Log::counters();
+        const auto lines = readLines(path);
+        const bool summary = std::any_of(lines.begin(), lines.end(), [](const std::string& line)
+        {
+            return line.find("(995 similar messages suppressed)") != std::string::npos;
+        });
+        Bench::check(after.suppressed - before.suppressed == 995 && lines.size() == 8, "a repeated message is capped at the rate");
+        Bench::check(summary, "the suppressed count is logged when the site logs again");
+    }
+
+    // Rotation
+    {
+        removeLogs(path);
+        auto config = fileConfig(path, 0);
+        config.maxFileBytes = 4096;
+        config.keepFiles    = 2;
+        Log::start(config);
+        for (int i = 0; i < 500; i++)
+        {
+            Log::info("rotation line %d", i);
+            if (i % 100 == 99)
+                Log::flush();
+        }
+        Log::stop();
+
+        namespace fs = std::filesystem;
+        std::error_code error;
+        const bool sized = fs::file_size(path, error) <= 4096 && fs::file_size(path + ".1", error) <= 4096 && fs::file_size(path + ".2", error) <= 4096;
+        Bench::check(fs::exists(path) && fs::exists(path + ".1") && fs::exists(path + ".2") && !fs::exists(path + ".3") && sized,
+                     "the file rotates at its size limit and keeps two old files");
+        const auto lines = readLines(path);
+        Bench::check(!lines.empty() && lines.back().find("rotation line 499") != std::string::npos, "the newest lines are in the live file");
+    }
+
+    // Several threads: the file comes out in time order
+    {
+        removeLogs(path);
+        Log::start(fileConfig(path, 0));
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++)
+        {
+            threads.emplace_back([t]
+            {
+                for (int i = 0; i < 50; i++)
+                {
+                    Log::info("thread %d line %d", t, i);
+                    std::this_thread::yield();
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        Log::stop();
+
+        const auto lines = readLines(path);
+        bool ordered = lines.size() == 200;
+        for (size_t i = 1; ordered && i < lines.size(); i++)
+            ordered = lines[i - 1].substr(0, 23) <= lines[i].substr(0, 23);
+        Bench::check(ordered, "records from several threads come out in time order");
+    }
+
+    removeLogs(path);
+});
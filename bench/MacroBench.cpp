@@ -0,0 +1,382 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/Clock.h"
+#include "core/Controller.h"
+#include "core/FakeBackends.h"
+#include "core/MacroEngine.h"
+#include "core/MappingTables.h"
+#include "core/ProfileStore.h"
+#include "core/TimerWheel.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// What every sink sent, in order, with the time it was sent
+struct Recorder
+{
+    struct Sample
+    {
+        int64_t    timeNs;
+        XusbReport report;
+    };
+
+    std::mutex                        mutex;
+    std::vector<std::vector<Sample>> sinks;
+
+    explicit Recorder(size_t count) : sinks(count) {}
+
+    void record(uint32_t sink, const XusbReport& report)
+    {
+        const auto nowNs = Clock::nowNs();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (sink < sinks.size())
+            sinks[sink].push_back({ nowNs, report });
+    }
+
+    std::vector<Sample> snapshot(uint32_t sink)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sinks[sink];
+    }
+};
+
+// Times at which the masked buttons changed
+std::vector<int64_t> edges(const std::vector<Recorder::Sample>& samples, uint16_t mask)
+{
+    std::vector<int64_t> times;
+    for (size_t i = 1; i < samples.size(); i++)
+        if ((samples[i].report.wButtons ^ samples[i - 1].report.wButtons) & mask)
+            times.push_back(samples[i].timeNs);
+    return times;
+}
+
+const char kProfile[] =
+    "[profile macros]\n"
+    "CIRCLE   = Y\n"
+    "macro-Y  = B 30, none 20, LB+RT 30\n"
+    "turbo    = A\n"
+    "turbo-hz = 20\n";
+
+// Holds turbo A on every pad for `seconds` and compares every edge against
+// the ideal grid from the first one; lateness that accumulates shows up as
+// a trend between the first and last tenth of the run
+void drift(double seconds, int pads)
+{
+    auto profile = Bench::parseOne("[profile drift]\nturbo = A\nturbo-hz = 60\n");
+    auto store   = ProfileStore::create(std::make_unique<MappingTables>(profile));
+    auto engine  = MacroEngine::create();
+    if (!engine)
+    {
+        Bench::check(false, "the macro engine starts");
+        return;
+    }
+
+    FakeInputBackend inputs;
+    FakeSinkBackend  sinks;
+    Recorder         recorder(pads);
+    sinks.setSubmitCallback([&](uint32_t sink, const XusbReport& report) { recorder.record(sink, report); });
+
+    ControllerContext context;
+    context.profiles = store.get();
+    context.macros   = engine.get();
+
+    std::vector<Controller> controllers(pads);
+    auto held = Bench::neutral();
+    held.buttons[N64Button::A] = 0x80;
+    for (int i = 0; i < pads; i++)
+    {
+        inputs.plug(Bench::makeGuid(0x100 + i));
+        if (!controllers[i].open(inputs, sinks, Bench::makeGuid(0x100 + i), context))
+        {
+            Bench::check(false, "drift controllers open");
+            return;
+        }
+        inputs.push(Bench::makeGuid(0x100 + i), held);
+    }
+    std::this_thread::sleep_for(std::chrono::nanoseconds(static_cast<int64_t>(seconds * 1e9)));
+    for (auto& controller : controllers)
+        controller.close();
+
+    const int64_t halfNs = 500000000 / 60;
+    std::vector<double> errors;
+    double early = 0, late = 0;
+    bool   steady = true;
+    for (int i = 0; i < pads; i++)
+    {
+        const auto times = edges(recorder.snapshot(i), Xusb::A);
+        if (times.size() < 20)
+        {
+            steady = false;
+            continue;
+        }
+
+        // The grid runs through the least late of the first edges; each edge
+        // is measured against its nearest grid point, so a phase the pad
+        // thread coalesced under load doesn't read as drift
+        const size_t tenth  = times.size() / 10;
+        int64_t      anchor = times[0];
+        for (size_t k = 1; k < tenth; k++)
+            anchor = (std::min)(anchor, times[0] + (times[k] - times[0]) % halfNs);
+
+        std::vector<double> first, last;
+        for (size_t k = 0; k < times.size(); k++)
+        {
+            const int64_t phase = (times[k] - anchor + halfNs / 4) / halfNs;
+            const double  error = static_cast<double>(times[k] - (anchor + phase * halfNs));
+            errors.push_back(error < 0 ? -error : error);
+            if (k < tenth)
+                first.push_back(error);
+            if (k >= times.size() - tenth)
+                last.push_back(error);
+        }
+        std::sort(first.begin(), first.end());
+        std::sort(last.begin(), last.end());
+        early += first[first.size() / 2];
+        late  += last[last.size() / 2];
+        steady = steady && times.size() >= static_cast<size_t>(seconds * 120 * 0.95);
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "turbo edge vs grid (%d pads, %.0f s)", pads, seconds);
+    if (!errors.empty())
+        Bench::reportLatency(name, errors);
+    const auto& lateness = engine->lateness();
+    printf("  timer lateness p50 %.1f us  p99 %.1f us  max %.1f us, %llu fired\n",
+           lateness.percentile(0.50) / 1000.0, lateness.percentile(0.99) / 1000.0, lateness.maxValue() / 1000.0,
+           static_cast<unsigned long long>(engine->counters().fired.load()));
+    const double trendNs = (late - early) / pads;
+    printf("  median error trend, first to last tenth: %.1f us\n", trendNs / 1000.0);
+
+    Bench::check(steady, "every pad fires about 120 turbo edges a second");
+    Bench::check(trendNs < 1000000.0 && trendNs > -1000000.0, "turbo phases don't drift (trend under 1 ms)");
+}
+
+}
+
+static Bench::Register sMacros("macros", []
+{
+    // Timer wheel: every timer fires once, never early, in deadline order,
+    // including deadlines several turns out
+    {
+        static constexpr int kTimers = 5000;
+        TimerWheel wheel(250000, 64);
+        std::vector<TimerWheel::Timer> timers(kTimers);
+        std::vector<int64_t> deadlines(kTimers);
+        std::vector<int>     fired(kTimers, 0);
+        std::vector<int64_t> order;
+        int64_t nowNs = 0;
+        bool early = false;
+
+        std::mt19937_64 random(19);
+        for (int i = 0; i < kTimers; i++)
+        {
+            deadlines[i] = static_cast<int64_t>(random() % 200000000);
+            timers[i].callback = [&, i](int64_t deadlineNs)
+            {
+                fired[i]++;
+                early = early || nowNs < deadlineNs || deadlineNs != deadlines[i];
+                order.push_back(deadlineNs);
+            };
+            wheel.schedule(timers[i], deadlines[i]);
+        }
+
+        // Every third timer is cancelled, every fifth moved
+        int cancelled = 0;
+        for (int i = 0; i < kTimers; i += 3)
+        {
+            wheel.cancel(timers[i]);
+            cancelled++;
+        }
+        for (int i = 1; i < kTimers; i += 5)
+        {
+            if (i % 3 == 0)
+                continue;
+            deadlines[i] += 50000000;
+            wheel.schedule(timers[i], deadlines[i]);
+        }
+
+        while (wheel.size())
+        {
+            nowNs += static_cast<int64_t>(random() % 700000);
+            wheel.advance(nowNs);
+        }
+
+        bool once = true;
+        for (int i = 0; i < kTimers; i++)
+            once = once && fired[i] == (i % 3 == 0 ? 0 : 1);
+        Bench::check(once && static_cast<int>(order.size()) == kTimers - cancelled, "every live timer fires exactly once");
+        Bench::check(!early, "no timer fires before its deadline");
+        Bench::check(std::is_sorted(order.begin(), order.end()), "timers fire in deadline order");
+        Bench::check(wheel.nextDeadlineNs() == -1, "an empty wheel has no next deadline");
+
+        // A timer that reschedules itself a period on, from its deadline
+        TimerWheel::Timer periodic;
+        int64_t lastDeadline = -1;
+        int     ticks = 0;
+        periodic.callback = [&](int64_t deadlineNs)
+        {
+            lastDeadline = deadlineNs;
+            if (++ticks < 100)
+                wheel.schedule(periodic, deadlineNs + 3333333);
+        };
+        wheel.schedule(periodic, nowNs + 3333333);
+        const int64_t startNs = nowNs;
+        while (periodic.pending())
+        {
+            nowNs += 5000000;
+            wheel.advance(nowNs);
+        }
+        Bench::check(ticks == 100 && lastDeadline == startNs + 100 * 3333333ll, "periodic timers keep their grid however late advance runs");
+
+        TimerWheel::Timer timer;
+        timer.callback = [](int64_t) {};
+        int64_t deadline = nowNs;
+        Bench::report("schedule + cancel", Bench::nsPerOp(1000000, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                wheel.schedule(timer, deadline + static_cast<int64_t>(i & 4095) * 250000);
+                wheel.cancel(timer);
+            }
+        }));
+    }
+
+    // Parsing and compiling
+    {
+        const auto profile = Bench::parseOne(kProfile);
+        const MappingTables tables(profile);
+        const auto& macros = tables.macros();
+        const auto& y      = macros.sequences[15];
+        Bench::check(macros.slots == Xusb::Y && macros.turbo == Xusb::A && macros.turboHalfPeriodNs == 25000000,
+                     "the profile compiles its macro slot and turbo buttons");
+        Bench::check(y.count == 3 && y.steps[0].buttons == Xusb::B && y.steps[0].durationMs == 30 &&
+                     y.steps[1].buttons == 0 && y.steps[1].durationMs == 20 &&
+                     y.steps[2].buttons == Xusb::LEFT_SHOULDER && y.steps[2].triggers == 2 && y.steps[2].durationMs == 30,
+                     "macro steps compile in order");
+        Bench::check(MappingTables(Profile::defaults()).macros().empty(), "the defaults have no turbo or macros");
+
+        std::vector<Profile> profiles;
+        std::string error;
+        Bench::check(!Profile::parse("[profile bad]\nmacro-Y = A\n", profiles, error) &&
+                     !Profile::parse("[profile bad]\nmacro-Y = A 0\n", profiles, error) &&
+                     !Profile::parse("[profile bad]\nturbo-hz = 0\n", profiles, error) &&
+                     !Profile::parse("[profile bad]\nmacro-Q = A 10\n", profiles, error),
+                     "bad macro and turbo lines are rejected");
+    }
+
+    // End to end: turbo, a macro and live input on one pad
+    {
+        auto store  = ProfileStore::create(std::make_unique<MappingTables>(Bench::parseOne(kProfile)));
+        auto engine = MacroEngine::create();
+        Bench::check(engine != nullptr, "the macro engine starts");
+        if (!engine)
+            return;
+
+        FakeInputBackend inputs;
+        FakeSinkBackend  sinks;
+        Recorder         recorder(1);
+        sinks.setSubmitCallback([&](uint32_t sink, const XusbReport& report) { recorder.record(sink, report); });
+
+        ControllerContext context;
+        context.profiles = store.get();
+        context.macros   = engine.get();
+
+        const auto id = Bench::makeGuid(0);
+        inputs.plug(id);
+        Controller controller;
+        if (!controller.open(inputs, sinks, id, context))
+        {
+            Bench::check(false, "controller opens");
+            return;
+        }
+
+        // Turbo A at 20 Hz for half a second
+        auto state = Bench::neutral();
+        state.buttons[N64Button::A] = 0x80;
+        inputs.push(id, state);
+        std::this_thread::sleep_for(std::chrono::nanoseconds(500000000));
+        state.buttons[N64Button::A] = 0;
+        inputs.push(id, state);
+        std::this_thread::sleep_for(std::chrono::nanoseconds(100000000));
+
+        auto samples = recorder.snapshot(0);
+        const auto turbo = edges(samples, Xusb::A);
+        bool steady = turbo.size() >= 18 && turbo.size() <= 22;
+        for (size_t i = 1; steady && i + 1 < turbo.size(); i++)
+        {
+            const auto gapNs = turbo[i] - turbo[i - 1];
+            steady = gapNs > 15000000 && gapNs < 35000000;
+        }
+        Bench::check(steady, "held turbo A toggles every 25 ms");
+        Bench::check(!samples.empty() && !(samples.back().report.wButtons & Xusb::A), "releasing turbo A leaves it released");
+
+        // CIRCLE plays the macro while ZR is held live; Y never goes out
+        const size_t before = samples.size();
+        state.buttons[N64Button::ZR]     = 0x80;
+        state.buttons[N64Button::CIRCLE] = 0x80;
+        inputs.push(id, state);
+        std::this_thread::sleep_for(std::chrono::nanoseconds(150000000));
+        state.buttons[N64Button::CIRCLE] = 0;
+        inputs.push(id, state);
+        std::this_thread::sleep_for(std::chrono::nanoseconds(50000000));
+
+        samples = recorder.snapshot(0);
+        std::vector<uint16_t> seen;
+        bool sentY = false, liveHeld = true, pulled = false;
+        for (size_t i = before; i < samples.size(); i++)
+        {
+            const auto& report = samples[i].report;
+            const auto macro = static_cast<uint16_t>(report.wButtons & (Xusb::B | Xusb::LEFT_SHOULDER));
+            // The live press may go out before the first step does
+            if ((seen.empty() && macro != 0) || (!seen.empty() && seen.back() != macro))
+                seen.push_back(macro);
+            sentY    = sentY || (report.wButtons & Xusb::Y);
+            liveHeld = liveHeld && (report.wButtons & Xusb::X);
+            pulled   = pulled || (report.wButtons & Xusb::LEFT_SHOULDER && report.bRightTrigger == 255);
+        }
+        const std::vector<uint16_t> expected = { Xusb::B, 0, Xusb::LEFT_SHOULDER, 0 };
+        Bench::check(seen == expected, "the macro plays B, nothing, LB + RT and ends");
+        Bench::check(pulled, "macro steps pull triggers");
+        Bench::check(!sentY, "the macro slot button is never sent");
+        Bench::check(liveHeld, "live input is merged with macro output");
+        Bench::check(engine->counters().macros.load() == 1, "one press starts one macro");
+
+        controller.close();
+    }
+
+    // The pad thread's side: every report an edge the engine has to hear about
+    {
+        auto engine = MacroEngine::create();
+        auto pad    = engine ? engine->addPad() : nullptr;
+        if (pad)
+        {
+            const MappingTables tables(Bench::parseOne(kProfile));
+            Bench::report("Pad::merge, turbo edge per report", Bench::nsPerOp(1 << 18, [&](uint64_t iterations)
+            {
+                XusbReport report {};
+                for (uint64_t i = 0; i < iterations; i++)
+                {
+                    report.wButtons = (i & 1) ? Xusb::A : 0;
+                    pad->merge(tables.macros(), report);
+                }
+                Bench::doNotOptimize(report);
+            }));
+        }
+    }
+
+    drift(2.0, 4);
+});
+
+// Linux drift harness: a minute of 60 Hz turbo on a full bridge
+static Bench::Register sMacroDrift("macro-drift", Bench::Slow, []
+{
+    drift(60.0, 16);
+});
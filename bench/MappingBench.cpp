@@ -0,0 +1,136 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/Mapping.h"
+#include "core/MappingTables.h"
+#include "core/ReportPipeline.h"
+
+#include <limits>
+
+static Bench::Register sMapping("mapping", []
+{
+    const auto states = Bench::makeStates(4096);
+    const auto& tables = MappingTables::defaults();
+
+    Bench::report("Mapping::convert (float)", Bench::nsPerOp(1 << 22, [&](uint64_t iterations)
+    {
+        XusbReport report;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            auto state = states[i & 4095];
+            Mapping::applyDeadzones(state);
+            Mapping::convert(state, report);
+            Bench::doNotOptimize(report);
+        }
+    }));
+
+    Bench::report("MappingTables::convert", Bench::nsPerOp(1 << 22, [&](uint64_t iterations)
+    {
+        XusbReport report;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            tables.convert(states[i & 4095], report);
+            Bench::doNotOptimize(report);
+        }
+    }));
+
+    Bench::report("Mapping::convertAnalog", Bench::nsPerOp(1 << 22, [&](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+            Bench::doNotOptimize(Mapping::convertAnalog(states[i & 4095].xAxis, Mapping::X_MIN, Mapping::X_MAX));
+    }));
+
+    Bench::report("Mapping C-buttons (float)", Bench::nsPerOp(1 << 22, [&](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            const auto& buttons = states[i & 4095].buttons;
+            const auto x = Mapping::convertCButtonToAnalog(buttons[N64Button::C_LEFT] != 0, buttons[N64Button::C_RIGHT] != 0);
+            const auto y = Mapping::convertCButtonToAnalog(buttons[N64Button::C_DOWN] != 0, buttons[N64Button::C_UP] != 0);
+            Bench::doNotOptimize(Mapping::normalizedCButtonVector(x, y));
+        }
+    }));
+
+    Bench::report("MappingTables C-buttons", Bench::nsPerOp(1 << 22, [&](uint64_t iterations)
+    {
+        const auto layout = tables.layout();
+        for (uint64_t i = 0; i < iterations; i++)
+            Bench::doNotOptimize(layout.cStick[MappingTables::cButtonIndex(MappingTables::pressedMask(states[i & 4095]))]);
+    }));
+
+    // Dedupe: the same state again (dropped) versus a new state every time
+    Bench::report("ReportPipeline::process (repeat, deduped)", Bench::nsPerOp(1 << 22, [&](uint64_t iterations)
+    {
+        ReportPipeline pipeline;
+        XusbReport report;
+        for (uint64_t i = 0; i < iterations; i++)
+            Bench::doNotOptimize(pipeline.process(states[(i >> 10) & 4095], report));
+    }));
+
+    Bench::report("ReportPipeline::process (changed, sent)", Bench::nsPerOp(1 << 22, [&](uint64_t iterations)
+    {
+        ReportPipeline pipeline;
+        XusbReport report;
+        for (uint64_t i = 0; i < iterations; i++)
+            Bench::doNotOptimize(pipeline.process(states[i & 4095], report));
+    }));
+});
+
+// Exhaustively checks that the table kernel matches the float reference.
+// Takes a few minutes, so it only runs when asked for by name.
+static Bench::Register sMappingVerify("mapping-verify", Bench::Slow, []
+{
+    const auto& tables = MappingTables::defaults();
+
+    auto reference = [](N64ControllerState state)
+    {
+        XusbReport report;
+        Mapping::applyDeadzones(state);
+        Mapping::convert(state, report);
+        return report;
+    };
+
+    N64ControllerState state{};
+    state.dpad = -1;
+
+    // Every LONG value on both axes
+    uint64_t axisMismatches = 0;
+    for (int64_t value = std::numeric_limits<int32_t>::min(); value <= std::numeric_limits<int32_t>::max(); value++)
+    {
+        N64ControllerState raw = state;
+        raw.xAxis = static_cast<int32_t>(value);
+        raw.yAxis = static_cast<int32_t>(value);
+
+        N64ControllerState snapped = raw;
+        Mapping::applyDeadzones(snapped);
+
+        const int16_t expectedX = Mapping::convertAnalog(snapped.xAxis, Mapping::X_MIN, Mapping::X_MAX);
+        const int16_t expectedY = static_cast<int16_t>(-Mapping::convertAnalog(snapped.yAxis, Mapping::Y_MIN, Mapping::Y_MAX));
+
+        XusbReport report;
+        tables.convert(raw, report);
+        axisMismatches += (report.sThumbLX != expectedX) + (report.sThumbLY != expectedY);
+    }
+    Bench::check(axisMismatches == 0, "axis tables match float path over the full LONG range");
+
+    // Every button combination (covers all C-button vectors) with each POV value
+    uint64_t buttonMismatches = 0;
+    for (int32_t dpad = -1; dpad <= 36000; dpad++)
+    {
+        state.dpad = dpad;
+        const uint32_t maskStep = (dpad % 4500 == 0 || dpad == -1) ? 1 : 4099;
+        for (uint32_t mask = 0; mask < 65536; mask += maskStep)
+        {
+            for (uint32_t i = 0; i < 16; i++)
+                state.buttons[i] = (mask & (1u << i)) ? static_cast<uint8_t>(1 + (i * 37 + dpad) % 255) : 0;
+
+            XusbReport report;
+            tables.convert(state, report);
+            const auto expected = reference(state);
+            buttonMismatches += memcmp(&report, &expected, sizeof(XusbReport)) != 0;
+        }
+    }
+    Bench::check(buttonMismatches == 0, "buttons, C-buttons and dpad match float path");
+
+    printf("verified %s\n", axisMismatches + buttonMismatches == 0 ? "ok" : "with mismatches");
+});
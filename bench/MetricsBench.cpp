@@ -0,0 +1,234 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/Clock.h"
+#include "core/Controller.h"
+#include "core/FakeBackends.h"
+#include "core/MetricsServer.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// Whole response of one GET, headers included; empty on failure
+std::string fetch(uint16_t port, const char* path)
+{
+#if defined(_WIN32)
+    using Socket = SOCKET;
+    auto closeSocket = [](Socket socket) { closesocket(socket); };
+    const Socket kNoSocket = INVALID_SOCKET;
+#else
+    using Socket = int;
+    auto closeSocket = [](Socket socket) { close(socket); };
+    const Socket kNoSocket = -1;
+#endif
+
+    const Socket socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (socket == kNoSocket)
+        return std::string();
+
+    sockaddr_in address{};
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port        = htons(port);
+    if (connect(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        closeSocket(socket);
+        return std::string();
+    }
+
+    const std::string request = std::string("GET ") + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+    send(socket, request.data(), static_cast<int>(request.size()), 0);
+
+    std::string response;
+    char buffer[4096];
+    for (;;)
+    {
+        const auto received = recv(socket, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+            break;
+        response.append(buffer, static_cast<size_t>(received));
+    }
+    closeSocket(socket);
+    return response;
+}
+
+std::string body(const std::string& response)
+{
+    const auto end = response.find("\r\n\r\n");
+    return end == std::string::npos ? std::string() : response.substr(end + 4);
+}
+
+// Every line a comment or `name{labels} value`, every sample under a TYPE
+bool wellFormed(const std::string& text)
+{
+    std::istringstream lines(text);
+    std::string line;
+    std::string family;
+    while (std::getline(lines, line))
+    {
+        if (line.rfind("# HELP ", 0) == 0)
+            continue;
+        if (line.rfind("# TYPE ", 0) == 0)
+        {
+            family = line.substr(7, line.find(' ', 7) - 7);
+            continue;
+        }
+        const auto space = line.rfind(' ');
+        if (space == std::string::npos || family.empty() || line.compare(0, family.size(), family) != 0)
+            return false;
+        char* end = nullptr;
+        strtod(line.c_str() + space + 1, &end);
+        if (*end != '\0')
+            return false;
+    }
+    return !family.empty();
+}
+
+}
+
+static Bench::Register sMetrics("metrics", []
+{
+    static constexpr int kPads = 4;
+
+    FakeInputBackend inputs;
+    FakeSinkBackend  sinks;
+    std::atomic<int> submitted { 0 };
+    sinks.setSubmitCallback([&](uint32_t, const XusbReport&) { submitted++; });
+
+    Controller controllers[kPads];
+    std::vector<Metrics::Pad> pads;
+    for (int i = 0; i < kPads; i++)
+    {
+        const auto id = Bench::makeGuid(i);
+        inputs.plug(id);
+        if (!controllers[i].open(inputs, sinks, id))
+        {
+            Bench::check(false, "controllers open");
+            return;
+        }
+        pads.push_back({ "player=\"" + std::to_string(i + 1) + "\",guid=\"" + MetricsText::labelValue(id.toString()) + "\"",
+                         &controllers[i].stats() });
+    }
+
+    // Ten changes and two repeats on player 1
+    auto state = Bench::neutral();
+    const auto id = Bench::makeGuid(0);
+    for (int i = 0; i < 12; i++)
+    {
+        if (i < 10)
+            state.buttons[N64Button::A] = (i & 1) ? 0 : 0x80;
+        inputs.push(id, state);
+        const auto giveUpNs = Clock::nowNs() + 100 * 1000000ll;
+        while (controllers[0].stats().counters.reportsRead.load() < static_cast<uint64_t>(i + 1) && Clock::nowNs() < giveUpNs)
+            std::this_thread::yield();
+    }
+
+    HotplugDetector   detector;
+    Metrics::PadRates rates;
+    auto render = [&](MetricsText& text)
+    {
+        Metrics::writePads(text, pads, rates, Clock::nowNs());
+        Metrics::writeDetector(text, detector);
+        Metrics::writeLog(text);
+    };
+
+    auto server = MetricsServer::create(0, render);
+    Bench::check(server != nullptr, "the server listens on a loopback port");
+    if (!server)
+        return;
+
+    const auto response = fetch(server->port(), "/metrics");
+    const auto text     = body(response);
+    const auto labels   = "{player=\"1\",guid=\"" + id.toString() + "\"}";
+    Bench::check(response.rfind("HTTP/1.1 200 OK\r\n", 0) == 0 && response.find("text/plain; version=0.0.4") != std::string::npos,
+                 "GET /metrics answers 200 in the Prometheus text format");
+    Bench::check(wellFormed(text), "every sample follows its family's TYPE line");
+    Bench::check(text.find("n64_pad_reports_read_total" + labels + " 12\n") != std::string::npos &&
+                 text.find("n64_pad_reports_submitted_total" + labels + " 10\n") != std::string::npos &&
+                 text.find("n64_pads_connected 4\n") != std::string::npos,
+                 "pad counters come through per player");
+    Bench::check(text.find("n64_pad_submit_latency_seconds_count" + labels + " 10\n") != std::string::npos,
+                 "submit latency is a summary with a count");
+    Bench::check(fetch(server->port(), "/").rfind("HTTP/1.1 404", 0) == 0, "other paths answer 404");
+    Bench::check(server->scrapes() == 1, "only /metrics counts as a scrape");
+
+    // Render cost for a full bridge, and a scrape round trip
+    {
+        std::vector<Metrics::Pad> many;
+        for (int i = 0; i < 16; i++)
+            many.push_back({ pads[i % kPads].labels + ",slot=\"" + std::to_string(i) + "\"", pads[i % kPads].stats });
+        MetricsText scratch;
+        Metrics::PadRates scratchRates;
+        Bench::report("render 16 pads", Bench::nsPerOp(2000, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                scratch.clear();
+                Metrics::writePads(scratch, many, scratchRates, Clock::nowNs());
+                Bench::doNotOptimize(scratch.text().size());
+            }
+        }));
+
+        std::vector<double> samples;
+        for (int i = 0; i < 200; i++)
+        {
+            const auto startNs = Clock::nowNs();
+            Bench::doNotOptimize(fetch(server->port(), "/metrics").size());
+            samples.push_back(static_cast<double>(Clock::nowNs() - startNs));
+        }
+        Bench::reportLatency("scrape round trip (4 pads)", samples);
+    }
+
+    // What a pad thread pays to record while a scraper reads the same stats
+    {
+        ControllerStats stats;
+        auto record = [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                ControllerStats::increment(stats.counters.reportsRead);
+                stats.recordReport(0, 1000, 1500, 9000 + static_cast<int64_t>(i & 1023));
+            }
+        };
+        Bench::report("record, no scraper", Bench::nsPerOp(200000, record));
+
+        std::atomic_bool scraping { true };
+        std::vector<Metrics::Pad> one = { { "player=\"1\"", &stats } };
+        std::thread scraper([&]
+        {
+            MetricsText scratch;
+            Metrics::PadRates scratchRates;
+            while (scraping)
+            {
+                scratch.clear();
+                Metrics::writePads(scratch, one, scratchRates, Clock::nowNs());
+                std::this_thread::yield();
+            }
+        });
+        Bench::report("record, scraper reading", Bench::nsPerOp(200000, record));
+        scraping = false;
+        scraper.join();
+    }
+
+    server.reset();
+    for (auto& controller : controllers)
+        controller.close();
+});
@@ -0,0 +1,163 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/Clock.h"
+#include "core/Controller.h"
+#include "core/FakeBackends.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// Counts what reaches the fake sinks and when the last report landed
+struct Receiver
+{
+    std::atomic<uint64_t> reports { 0 };
+    std::atomic<int64_t>  lastNs { 0 };
+    std::atomic<uint16_t> lastButtons { 0 };
+
+    FakeSinkBackend::SubmitCallback callback()
+    {
+        return [this](uint32_t, const XusbReport& report)
+        {
+            lastButtons.store(report.wButtons, std::memory_order_relaxed);
+            lastNs.store(Clock::nowNs(), std::memory_order_relaxed);
+            reports.fetch_add(1, std::memory_order_release);
+        };
+    }
+
+    // Yields rather than sleeps: the bench may share a single core
+    bool waitFor(uint64_t count) const
+    {
+        const auto deadlineNs = Clock::nowNs() + 1000000000ll;
+        while (reports.load(std::memory_order_acquire) < count)
+        {
+            if (Clock::nowNs() > deadlineNs)
+                return false;
+            std::this_thread::yield();
+        }
+        return true;
+    }
+};
+
+N64ControllerState makeState(bool pressed)
+{
+    N64ControllerState state {};
+    state.dpad   = -1;
+    state.xAxis  = 32767;
+    state.yAxis  = 32767;
+    state.buttons[N64Button::A] = pressed ? 0x80 : 0;
+    return state;
+}
+
+// Pushes alternating states one at a time and times push -> sink submit
+void measure(const char* name, const ControllerContext& context)
+{
+    static constexpr int kReports = 2000;
+
+    FakeInputBackend inputs;
+    FakeSinkBackend  sinks;
+    Receiver         receiver;
+    sinks.setSubmitCallback(receiver.callback());
+
+    const auto id = Bench::makeGuid(1);
+    inputs.plug(id);
+    Controller controller;
+    if (!controller.open(inputs, sinks, id, context))
+    {
+        Bench::check(false, std::string(name) + ": controller opens on the fake backends");
+        return;
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve(kReports);
+    bool delivered = true;
+    for (int i = 0; i < kReports && delivered; i++)
+    {
+        const auto pushedNs = Clock::nowNs();
+        inputs.push(id, makeState(i % 2 == 0));
+        delivered = receiver.waitFor(i + 1);
+        latencies.push_back(static_cast<double>(receiver.lastNs.load() - pushedNs));
+    }
+    Bench::check(delivered && receiver.reports == kReports, std::string(name) + ": every distinct state reaches the sink");
+    Bench::reportLatency(std::string(name) + ": push -> sink submit", latencies);
+
+    controller.close();
+    Bench::check(sinks.live() == 0, std::string(name) + ": close unplugs the virtual pad");
+}
+
+}
+
+static Bench::Register sPipeline("pipeline", []
+{
+    // Unchanged states are deduped, read failures are counted
+    {
+        FakeInputBackend inputs;
+        FakeSinkBackend  sinks;
+        Receiver         receiver;
+        sinks.setSubmitCallback(receiver.callback());
+
+        const auto id = Bench::makeGuid(2);
+        inputs.plug(id);
+        Controller controller;
+        Bench::check(controller.open(inputs, sinks, id) && sinks.live() == 1, "open plugs one virtual pad");
+
+        inputs.push(id, makeState(true));
+        receiver.waitFor(1);
+        inputs.push(id, makeState(true));
+        inputs.push(id, makeState(false));
+        receiver.waitFor(2);
+        Bench::check(receiver.reports == 2 && receiver.lastButtons == 0, "repeated states are not resubmitted");
+
+        inputs.setReadFailure(id, true);
+        const auto deadlineNs = Clock::nowNs() + 1000000000ll;
+        while (controller.stats().counters.readErrors == 0 && Clock::nowNs() < deadlineNs)
+            std::this_thread::yield();
+        Bench::check(controller.stats().counters.readErrors > 0, "failed reads are counted, not submitted");
+
+        controller.close();
+        Bench::check(!controller.isOpen() && sinks.live() == 0, "close unplugs the virtual pad");
+    }
+
+    // Pooled sinks: a reconnect rebinds the parked fake pad
+    {
+        FakeInputBackend inputs;
+        FakeSinkBackend  sinks;
+        TargetPool::Callbacks callbacks;
+        callbacks.create  = [&]() -> void* { return sinks.plug().release(); };
+        callbacks.neutral = [](void* target)
+        {
+            XusbReport report;
+            Xusb::initReport(report);
+            static_cast<PadSink*>(target)->submit(report);
+        };
+        callbacks.destroy = [](void* target) { delete static_cast<PadSink*>(target); };
+        {
+            TargetPool pool(callbacks, 0, 1000);
+            ControllerContext context;
+            context.targets = &pool;
+
+            const auto id = Bench::makeGuid(3);
+            inputs.plug(id);
+            Controller controller;
+            controller.open(inputs, sinks, id, context);
+            controller.close();
+            Bench::check(sinks.live() == 1, "closing parks the pooled pad");
+            controller.open(inputs, sinks, id, context);
+            Bench::check(sinks.plugged() == 1 && pool.counters().rebound == 1, "reconnect rebinds the parked pad");
+            controller.close();
+        }
+        Bench::check(sinks.live() == 0, "pool unplugs its fake pads");
+    }
+
+    measure("thread", {});
+
+    Reactor reactor(1);
+    ControllerContext context;
+    context.reactor = &reactor;
+    measure("reactor", context);
+});
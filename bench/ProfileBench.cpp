@@ -0,0 +1,252 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/Clock.h"
+#include "core/Controller.h"
+#include "core/FakeBackends.h"
+#include "core/MappingTables.h"
+#include "core/ProfileStore.h"
+#include "core/ReportPipeline.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace
+{
+
+bool sameReport(const XusbReport& a, const XusbReport& b)
+{
+    return memcmp(&a, &b, sizeof(XusbReport)) == 0;
+}
+
+// Every axis value and every pressed mask through both tables
+bool identical(const MappingTables& a, const MappingTables& b)
+{
+    XusbReport left, right;
+    for (int32_t value = 0; value <= 65535; value++)
+    {
+        a.convert(value, value, -1, 0, left);
+        b.convert(value, value, -1, 0, right);
+        if (!sameReport(left, right))
+            return false;
+    }
+    for (uint32_t pressed = 0; pressed < 65536; pressed++)
+    {
+        a.convert(32767, 32767, 9000, static_cast<uint16_t>(pressed), left);
+        b.convert(32767, 32767, 9000, static_cast<uint16_t>(pressed), right);
+        if (!sameReport(left, right))
+            return false;
+    }
+    return true;
+}
+
+void writeFile(const std::string& path, const std::string& text)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << text;
+}
+
+}
+
+static Bench::Register sProfiles("profiles", []
+{
+    // Parsing
+    {
+        std::vector<Profile> profiles;
+        std::string error;
+        const bool ok = Profile::parse(
+            "# two profiles\n"
+            "[profile first]\n"
+            "\n"
+            "[profile second]\n"
+            "  Z = RT LB   # comment\n"
+            "A = none\n"
+            "c-buttons = buttons\n"
+            "x-range = 1000 60000\n"
+            "deadzone-shape = scaled\n"
+            "curve = 2\n"
+            "invert-y = no\n", profiles, error);
+        Bench::check(ok && profiles.size() == 2 && profiles[0].name == "first" && profiles[1].name == "second", "sections parse");
+        if (ok && profiles.size() == 2)
+        {
+            const auto& second = profiles[1];
+            const uint16_t z = 1u << N64Button::Z;
+            Bench::check(second.buttons[N64Button::Z] == Xusb::LEFT_SHOULDER && second.rightTrigger == z && second.leftTrigger == 0,
+                         "a binding replaces the default, several targets allowed");
+            Bench::check(second.buttons[N64Button::A] == 0 && second.buttons[N64Button::B] == Xusb::B, "none unbinds, the rest keep their defaults");
+            Bench::check(!second.cStick && second.xAxis.min == 1000 && second.xAxis.max == 60000 &&
+                         second.xAxis.deadzone == DeadzoneShape::SCALED && second.yAxis.curve == 2.0f && !second.yAxis.invert,
+                         "stick settings parse");
+        }
+
+        const char* bad[] =
+        {
+            "A = A\n",                                 // outside a section
+            "[profile x]\nA = TURBO\n",                // unknown target
+            "[profile x]\nQ = A\n",                    // unknown button
+            "[profile x]\nx-range = 500 100\n",        // empty range
+            "[profile x]\nx-deadzone = 100 200\n",     // deadzone outside the range
+            "[profile x]\ncurve = 0\n",
+            "[profile]\n",
+            "",
+        };
+        bool rejected = true;
+        for (const auto* text : bad)
+            rejected &= !Profile::parse(text, profiles, error);
+        Bench::check(rejected, "bad files are rejected");
+    }
+
+    // The built in profile compiles to the same tables as before
+    MappingTables parsedDefaults(Bench::parseOne("[profile d]\n"));
+    Bench::check(identical(parsedDefaults, MappingTables::defaults()), "an empty profile is bit-identical to the built in mapping");
+
+    // Remap, triggers and C-buttons as buttons
+    {
+        MappingTables tables(Bench::parseOne(
+            "[profile p]\n"
+            "A = B\nB = A\nZ = RT\nR = LT\nc-buttons = buttons\nC_UP = Y\nC_DOWN = A\n"));
+        XusbReport report;
+        tables.convert(32767, 32767, -1, (1u << N64Button::A) | (1u << N64Button::Z) | (1u << N64Button::C_UP), report);
+        Bench::check(report.wButtons == (Xusb::B | Xusb::Y) && report.bRightTrigger == 0xFF && report.bLeftTrigger == 0 &&
+                     report.sThumbRX == 0 && report.sThumbRY == 0,
+                     "remapped buttons, triggers and C-buttons as buttons");
+        tables.convert(32767, 32767, -1, 1u << N64Button::RIGHT_BUMPER, report);
+        Bench::check(report.bLeftTrigger == 0xFF && report.wButtons == 0, "a shoulder bound to a trigger");
+    }
+
+    // Scaled deadzone and curve
+    {
+        MappingTables tables(Bench::parseOne(
+            "[profile p]\nx-range = 0 2000\nx-deadzone = 900 1100\ndeadzone-shape = scaled\ncurve = 2\n"));
+        XusbReport rest, edge, half, full, low;
+        tables.convert(1050, 32767, -1, 0, rest);
+        tables.convert(1101, 32767, -1, 0, edge);
+        tables.convert(1550, 32767, -1, 0, half);
+        tables.convert(5000, 32767, -1, 0, full);
+        tables.convert(-5000, 32767, -1, 0, low);
+        Bench::check(rest.sThumbLX == 0 && edge.sThumbLX >= 0 && edge.sThumbLX < 10, "scaled deadzone ramps from zero at its edge");
+        Bench::check(half.sThumbLX > 8000 && half.sThumbLX < 8400, "curve 2 turns half deflection into a quarter");
+        Bench::check(full.sThumbLX == 32767 && low.sThumbLX == -32767, "full deflection saturates");
+    }
+
+    // Cost per report: the compiled profile does the same loads as the
+    // hard coded tables, reading through the store adds one relaxed load
+    {
+        const auto states = Bench::makeStates(4096);
+        const auto& builtIn = MappingTables::defaults();
+        MappingTables custom(Bench::parseOne(
+            "[profile p]\nA = B\nB = A\nZ = RT LB\ndeadzone-shape = scaled\ncurve = 1.7\nc-buttons = buttons\nC_UP = Y\n"));
+        auto store = ProfileStore::create(std::make_unique<MappingTables>(Bench::parseOne("[profile p]\ncurve = 1.7\n")));
+        ProfileStore::Reader reader(*store);
+
+        auto run = [&](const char* name, auto&& convert)
+        {
+            const double ns = Bench::nsPerOp(1 << 22, [&](uint64_t iterations)
+            {
+                XusbReport report;
+                for (uint64_t i = 0; i < iterations; i++)
+                {
+                    convert(states[i & 4095], report);
+                    Bench::doNotOptimize(report);
+                }
+            });
+            Bench::report(name, ns);
+            return ns;
+        };
+
+        const double builtInNs = run("built in tables", [&](const N64ControllerState& state, XusbReport& report) { builtIn.convert(state, report); });
+        const double customNs  = run("compiled profile", [&](const N64ControllerState& state, XusbReport& report) { custom.convert(state, report); });
+        const double storeNs   = run("compiled profile via ProfileStore::Reader", [&](const N64ControllerState& state, XusbReport& report) { reader.tables().convert(state, report); });
+        Bench::check(customNs < builtInNs * 1.5 + 1.0 && storeNs < builtInNs * 1.5 + 1.0, "a compiled profile costs what the built in tables do");
+    }
+
+    // Hot swap under a reader: every report comes from one whole profile and
+    // replaced tables are freed once the reader has moved on
+    {
+        auto store = ProfileStore::create(std::make_unique<MappingTables>(Bench::parseOne("[profile a]\n")));
+        std::atomic<bool> stop { false };
+        std::atomic<uint64_t> torn { 0 };
+        std::atomic<uint64_t> converted { 0 };
+
+        std::thread pad([&]
+        {
+            ProfileStore::Reader reader(*store);
+            XusbReport report;
+            while (!stop)
+            {
+                reader.tables().convert(32767, 32767, -1, (1u << N64Button::A) | (1u << N64Button::Z), report);
+                const bool a = report.wButtons == Xusb::A && report.bLeftTrigger == 0xFF && report.bRightTrigger == 0;
+                const bool b = report.wButtons == Xusb::B && report.bLeftTrigger == 0 && report.bRightTrigger == 0xFF;
+                if (!a && !b)
+                    torn++;
+                converted++;
+            }
+        });
+
+        const auto profileA = Bench::parseOne("[profile a]\n");
+        const auto profileB = Bench::parseOne("[profile b]\nA = B\nZ = RT\n");
+        static constexpr int kSwaps = 2000;
+        for (int i = 0; i < kSwaps; i++)
+        {
+            store->publish(std::make_unique<MappingTables>(i % 2 ? profileA : profileB));
+            std::this_thread::yield();
+        }
+        stop = true;
+        pad.join();
+
+        printf("  %d swaps under %llu conversions, %zu tables still retired\n",
+               kSwaps, static_cast<unsigned long long>(converted.load()), store->retired());
+        Bench::check(torn == 0, "no report mixes two profiles");
+        Bench::check(store->retired() == 0, "replaced tables are freed once no reader holds them");
+    }
+
+    // File reload, including a live pad picking up the edit
+    {
+        const auto path = (std::filesystem::temp_directory_path() / "n64-bench-profiles.ini").string();
+        writeFile(path, "[profile other]\nA = X\n[profile main]\nA = A\n");
+        auto store = ProfileStore::create(path, "main");
+        Bench::check(store != nullptr, "profile file loads");
+        if (store)
+        {
+            FakeInputBackend inputs;
+            FakeSinkBackend  sinks;
+            std::atomic<uint16_t> buttons { 0 };
+            sinks.setSubmitCallback([&](uint32_t, const XusbReport& report) { buttons = report.wButtons; });
+
+            const auto id = Bench::makeGuid(1);
+            inputs.plug(id);
+            ControllerContext context;
+            context.profiles = store.get();
+            Controller controller;
+            controller.open(inputs, sinks, id, context);
+
+            auto waitFor = [&](uint16_t expected)
+            {
+                const auto deadlineNs = Clock::nowNs() + 1000000000ll;
+                while (buttons != expected && Clock::nowNs() < deadlineNs)
+                    std::this_thread::yield();
+                return buttons == expected;
+            };
+
+            auto state = Bench::neutral();
+            state.buttons[N64Button::A] = 0x80;
+            inputs.push(id, state);
+            Bench::check(waitFor(Xusb::A), "a live pad converts with the named profile");
+
+            writeFile(path, "[profile main]\nA = Y\n");
+            Bench::check(store->reload() && store->generation() == 2, "an edited file reloads");
+            inputs.push(id, state);
+            Bench::check(waitFor(Xusb::Y), "the running pad picks up the edit without reopening");
+
+            writeFile(path, "[profile main]\nA = ???\n");
+            Bench::check(!store->reload() && store->generation() == 2, "a broken edit keeps the running profile");
+            controller.close();
+        }
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+});
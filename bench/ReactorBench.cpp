@@ -0,0 +1,242 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/EventLoop.h"
+#include "core/MappingTables.h"
+
+#if defined(__linux__)
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace
+{
+
+using SteadyClock = std::chrono::steady_clock;
+
+int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(SteadyClock::now().time_since_epoch()).count();
+}
+
+// A simulated pad: an eventfd that "the driver" signals, plus the time it
+// was signaled so the consumer can measure wake-to-convert latency
+struct FakePad
+{
+    int                  fd { eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK) };
+    std::atomic<int64_t> signaledAt { 0 };
+    N64ControllerState   state {};
+    std::vector<double>  latencies;
+    std::atomic<bool>    removed { false };
+    std::atomic<int>     callsAfterRemove { 0 };
+
+    ~FakePad() { close(fd); }
+
+    void signal()
+    {
+        signaledAt.store(nowNs(), std::memory_order_release);
+        const uint64_t one = 1;
+        (void)!write(fd, &one, sizeof(one));
+    }
+
+    bool drain()
+    {
+        uint64_t value;
+        return read(fd, &value, sizeof(value)) == sizeof(value);
+    }
+
+    void process(const MappingTables& tables)
+    {
+        if (removed.load(std::memory_order_acquire))
+            callsAfterRemove++;
+
+        XusbReport report;
+        tables.convert(state, report);
+        Bench::doNotOptimize(report);
+        latencies.push_back(static_cast<double>(nowNs() - signaledAt.load(std::memory_order_acquire)));
+    }
+};
+
+std::vector<std::unique_ptr<FakePad>> makePads(size_t count)
+{
+    const auto states = Bench::makeStates(count);
+    std::vector<std::unique_ptr<FakePad>> pads;
+    for (size_t i = 0; i < count; i++)
+    {
+        pads.push_back(std::make_unique<FakePad>());
+        pads.back()->state = states[i];
+    }
+    return pads;
+}
+
+// Signals every pad once per millisecond, spread across the tick
+void drive(std::vector<std::unique_ptr<FakePad>>& pads, int ticks)
+{
+    const auto start = SteadyClock::now();
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        for (size_t i = 0; i < pads.size(); i++)
+        {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(tick * 1000 + (i * 1000) / pads.size()));
+            pads[i]->signal();
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+}
+
+std::vector<double> collect(std::vector<std::unique_ptr<FakePad>>& pads)
+{
+    std::vector<double> latencies;
+    for (auto& pad : pads)
+        latencies.insert(latencies.end(), pad->latencies.begin(), pad->latencies.end());
+    return latencies;
+}
+
+}
+
+static Bench::Register sReactor("reactor", []
+{
+    const auto& tables = MappingTables::defaults();
+    const int ticks = 200;
+
+    for (size_t count : { 1, 8, 64 })
+    {
+        // Baseline: one blocking thread per pad
+        {
+            auto pads = makePads(count);
+            std::atomic<bool> running { true };
+            std::vector<std::thread> threads;
+            for (auto& pad : pads)
+            {
+                // Blocking reads need a blocking descriptor
+                close(pad->fd);
+                pad->fd = eventfd(0, EFD_CLOEXEC);
+                threads.emplace_back([&, raw = pad.get()]
+                {
+                    while (raw->drain() && running)
+                        raw->process(tables);
+                });
+            }
+
+            drive(pads, ticks);
+            running = false;
+            for (auto& pad : pads)
+                pad->signal();
+            for (auto& thread : threads)
+                thread.join();
+
+            auto latencies = collect(pads);
+            Bench::reportLatency("thread per pad x" + std::to_string(count), latencies);
+        }
+
+        for (size_t loops : { 1, 2 })
+        {
+            auto pads = makePads(count);
+            {
+                Reactor reactor(loops);
+                for (auto& pad : pads)
+                    reactor.add(pad->fd, [&tables, raw = pad.get()]{ if (raw->drain()) raw->process(tables); });
+
+                drive(pads, ticks);
+
+                for (auto& pad : pads)
+                    reactor.remove(pad->fd);
+            }
+
+            auto latencies = collect(pads);
+            Bench::reportLatency("reactor " + std::to_string(loops) + " loop(s) x" + std::to_string(count), latencies);
+        }
+    }
+});
+
+// Pads are removed and re-added while the loop is dispatching them; no
+// callback may run after remove() has returned
+static Bench::Register sReactorChurn("reactor-churn", []
+{
+    const auto& tables = MappingTables::defaults();
+    auto pads = makePads(16);
+
+    Reactor reactor(2);
+    for (auto& pad : pads)
+        reactor.add(pad->fd, [&tables, raw = pad.get()]{ if (raw->drain()) raw->process(tables); });
+
+    std::atomic<bool> driving { true };
+    std::thread driver([&]
+    {
+        while (driving)
+        {
+            for (auto& pad : pads)
+                pad->signal();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+
+    int churns = 0;
+    const auto start = SteadyClock::now();
+    std::vector<double> removeTimes;
+    while (SteadyClock::now() - start < std::chrono::milliseconds(500))
+    {
+        auto& pad = *pads[churns % pads.size()];
+
+        const auto before = SteadyClock::now();
+        reactor.remove(pad.fd);
+        removeTimes.push_back(std::chrono::duration<double, std::nano>(SteadyClock::now() - before).count());
+
+        pad.removed = true;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        pad.removed = false;
+
+        reactor.add(pad.fd, [&tables, raw = &pad]{ if (raw->drain()) raw->process(tables); });
+        churns++;
+    }
+
+    driving = false;
+    driver.join();
+    for (auto& pad : pads)
+        reactor.remove(pad->fd);
+
+    int violations = 0;
+    for (auto& pad : pads)
+        violations += pad->callsAfterRemove;
+
+    Bench::check(violations == 0, "no callbacks after remove() returned");
+    Bench::reportLatency("remove() while running (" + std::to_string(churns) + " churns)", removeTimes);
+});
+
+// A descriptor that hangs up for good, like an unplugged evdev node: its
+// callback can never drain it, yet must not run on every wait
+static Bench::Register sReactorHangup("reactor-hangup", []
+{
+    int ends[2];
+    if (pipe(ends) != 0)
+    {
+        Bench::check(false, "pipe");
+        return;
+    }
+    close(ends[1]);
+
+    auto loop = EventLoop::create();
+    std::atomic<int> calls { 0 };
+    loop->add(ends[0], [&]{ calls++; });
+    std::thread thread([&]{ loop->run(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const int hungUp = calls.load();
+
+    // Added again, it is dispatched again
+    loop->remove(ends[0]);
+    loop->add(ends[0], [&]{ calls++; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    loop->stop();
+    thread.join();
+    close(ends[0]);
+
+    printf("  hung up descriptor: %d callbacks in 50 ms\n", hungUp);
+    Bench::check(hungUp == 1, "a hung up descriptor is dispatched once, not on every wait");
+    Bench::check(calls.load() == 2, "and once more when added again");
+});
+
+#endif
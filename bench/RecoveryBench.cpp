@@ -0,0 +1,229 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/Clock.h"
+#include "core/Controller.h"
+#include "core/DeviceRecovery.h"
+#include "core/FakeBackends.h"
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// CPU time of the whole process so far; -1 where not measured
+int64_t processCpuNs()
+{
+#if defined(__linux__)
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return (static_cast<int64_t>(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000000000 +
+           (static_cast<int64_t>(usage.ru_utime.tv_usec) + usage.ru_stime.tv_usec) * 1000;
+#else
+    return -1;
+#endif
+}
+
+// Every report the virtual pads get, and which one got it
+struct Recorder
+{
+    struct Entry
+    {
+        uint32_t   sink;
+        XusbReport report;
+    };
+
+    std::mutex         mutex;
+    std::vector<Entry> entries;
+
+    FakeSinkBackend::SubmitCallback callback()
+    {
+        return [this](uint32_t sink, const XusbReport& report)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            entries.push_back({ sink, report });
+        };
+    }
+
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+    Entry at(size_t index)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries[index];
+    }
+};
+
+bool isNeutral(const XusbReport& report)
+{
+    XusbReport rest;
+    Xusb::initReport(rest);
+    return memcmp(&report, &rest, sizeof(report)) == 0;
+}
+
+// A pad holding A and the stick loses its device and gets it back
+void lossAndRecovery(const char* name, Reactor* reactor)
+{
+    FakeInputBackend inputs;
+    FakeSinkBackend  sinks;
+    Recorder         recorder;
+    sinks.setSubmitCallback(recorder.callback());
+
+    ControllerContext context;
+    context.reactor = reactor;
+    const auto id = Bench::makeGuid(reactor ? 1 : 0);
+    inputs.plug(id);
+    Controller controller;
+    if (!controller.open(inputs, sinks, id, context))
+    {
+        Bench::check(false, "controller opens");
+        return;
+    }
+    const auto& counters = controller.stats().counters;
+
+    auto held = Bench::neutral();
+    held.buttons[N64Button::A] = 0x80;
+    held.xAxis = 60000;
+    inputs.push(id, held);
+    Bench::check(Bench::waitFor([&] { return recorder.size() == 2; }), "the held state reaches the virtual pad");
+
+    // Gone for the immediate attempt and three retries
+    inputs.loseDevice(id, 3);
+    Bench::check(Bench::waitFor([&] { return counters.recoveries.load() == 1 && recorder.size() >= 4; }), "a lost device comes back");
+
+    const auto lost = recorder.at(2);
+    const auto back = recorder.at(3);
+    Bench::check(isNeutral(lost.report), "the virtual pad goes neutral while the device is lost");
+    Bench::check(back.sink == 0 && lost.sink == 0 && sinks.plugged() == 1 && (back.report.wButtons & Xusb::A) && back.report.sThumbLX > 0,
+                 "it resumes the held state on the same virtual pad");
+    Bench::check(counters.deviceLosses.load() == 1 && counters.recoveryAttempts.load() == 4, "one loss, the immediate attempt and three retries");
+
+    const auto& times = controller.stats().recoveryTimes;
+    printf("  %-9s lost -> back after 3 failed retries: %.1f ms (backoff alone is %.0f..%.0f ms)\n", name,
+           times.maxValue() / 1e6, (DeviceRecovery::kFirstRetryNs * 7 / 2) / 1e6, (DeviceRecovery::kFirstRetryNs * 7) / 1e6);
+
+    // Reads work again, and so does input
+    held.buttons[N64Button::A] = 0;
+    inputs.push(id, held);
+    Bench::check(Bench::waitFor([&] { return recorder.size() >= 5; }) && !(recorder.at(4).report.wButtons & Xusb::A), "input flows after recovery");
+    controller.close();
+}
+
+}
+
+static Bench::Register sRecovery("recovery", []
+{
+    // Backoff timing
+    {
+        DeviceRecovery recovery(7);
+        const bool immediate = recovery.lost(0);
+        bool   withinBounds = true;
+        auto   intervalNs   = DeviceRecovery::kFirstRetryNs;
+        for (int i = 0; i < 20; i++)
+        {
+            const auto delayNs = recovery.failed();
+            withinBounds = withinBounds && delayNs >= intervalNs / 2 && delayNs <= intervalNs;
+            intervalNs = (std::min)(intervalNs * 2, DeviceRecovery::kMaxRetryNs);
+        }
+        Bench::check(immediate && withinBounds, "first attempt right away, then doubling intervals with jitter, capped");
+        Bench::check(recovery.failures() == 20 && recovery.recovered(5000) == 5000 && !recovery.recovering(), "failures and time lost are kept");
+
+        // Pads lost at the same moment spread their retries
+        DeviceRecovery a(1), b(2);
+        a.lost(0);
+        b.lost(0);
+        int same = 0;
+        for (int i = 0; i < 8; i++)
+            same += a.failed() == b.failed();
+        Bench::check(same < 2, "jitter spreads retries of pads lost together");
+
+        // Lost again right after coming back: no immediate attempt, the
+        // interval keeps growing
+        const bool flapImmediate = recovery.lost(5000 + DeviceRecovery::kSettleNs / 2);
+        const auto flapDelayNs   = recovery.failed();
+        Bench::check(!flapImmediate && flapDelayNs >= DeviceRecovery::kMaxRetryNs / 2, "a flapping device keeps backing off");
+        recovery.recovered(DeviceRecovery::kSettleNs);
+        Bench::check(recovery.lost(DeviceRecovery::kSettleNs * 3), "a device that stayed up starts over");
+    }
+
+    // End to end, dedicated thread and reactor
+    lossAndRecovery("thread", nullptr);
+    {
+        Reactor reactor(1);
+        lossAndRecovery("reactor", &reactor);
+    }
+
+    // Back on the immediate attempt
+    {
+        FakeInputBackend inputs;
+        FakeSinkBackend  sinks;
+        const auto id = Bench::makeGuid(2);
+        inputs.plug(id);
+        Controller controller;
+        controller.open(inputs, sinks, id);
+        const auto& counters = controller.stats().counters;
+
+        // Spaced past the settle time, so none of them counts as flapping
+        static constexpr uint64_t kLosses = 10;
+        for (uint64_t i = 1; i <= kLosses; i++)
+        {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(DeviceRecovery::kSettleNs + 10000000));
+            inputs.loseDevice(id, 0);
+            if (!Bench::waitFor([&] { return counters.recoveries.load() == i; }))
+                break;
+        }
+        const auto& times = controller.stats().recoveryTimes;
+        Bench::check(counters.recoveries.load() == kLosses && counters.recoveryAttempts.load() == kLosses, "every loss recovers on its immediate attempt");
+        printf("  immediate reacquire: p50 %.1f us, max %.1f us over %llu losses\n",
+               times.percentile(0.50) / 1e3, times.maxValue() / 1e3, static_cast<unsigned long long>(kLosses));
+        controller.close();
+    }
+
+    // A device that stays lost is retried less and less often
+    {
+        FakeInputBackend inputs;
+        FakeSinkBackend  sinks;
+        const auto id = Bench::makeGuid(3);
+        inputs.plug(id);
+        Controller controller;
+        controller.open(inputs, sinks, id);
+        const auto& counters = controller.stats().counters;
+
+        inputs.setReadFailure(id, true);
+        Bench::waitFor([&] { return counters.deviceLosses.load() == 1; });
+
+        // The lost device's handle keeps firing; only the backoff retries,
+        // and the pad's thread sleeps in between
+        const auto cpuBeforeNs = processCpuNs();
+        const auto stopNs = Clock::nowNs() + 300000000;
+        while (Clock::nowNs() < stopNs)
+        {
+            inputs.push(id, Bench::neutral());
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const auto cpuNs    = processCpuNs() - cpuBeforeNs;
+        const auto attempts = counters.recoveryAttempts.load();
+        printf("  %llu attempts in the first 300 ms of a loss, %.0f ms of CPU\n", static_cast<unsigned long long>(attempts), cpuNs / 1e6);
+        Bench::check(attempts >= 4 && attempts <= 12, "retries back off exponentially");
+        Bench::check(counters.readErrors.load() == 1, "wakes from the lost device don't read it again");
+        Bench::check(cpuNs < 60000000, "a lost device's handle doesn't keep its thread busy");
+
+        inputs.setReadFailure(id, false);
+        Bench::check(Bench::waitFor([&] { return counters.recoveries.load() == 1; }), "and pick the device up once it's back");
+        controller.close();
+    }
+});
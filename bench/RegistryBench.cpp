@@ -0,0 +1,213 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/DeviceDescriptors.h"
+#include "core/SlotRegistry.h"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+
+// Stand-in for a pooled Controller
+struct Pad
+{
+    uint64_t reports { 0 };
+    uint8_t  state[56] {};
+};
+
+}
+
+static Bench::Register sRegistry("registry", []
+{
+    // Player slots stay put across reconnects
+    {
+        SlotRegistry<Pad, 4> registry;
+        const auto a = registry.add(Bench::makeGuid(0));
+        const auto b = registry.add(Bench::makeGuid(1));
+        const auto c = registry.add(Bench::makeGuid(2));
+        Bench::check(a.index == 0 && b.index == 1 && c.index == 2, "slots fill in player order");
+
+        registry.remove(b);
+        const auto d = registry.add(Bench::makeGuid(3));
+        Bench::check(d.index == 3, "new pads prefer never used slots over a departed pad's slot");
+
+        const auto b2 = registry.add(Bench::makeGuid(1));
+        Bench::check(b2.index == 1, "reconnecting pad gets its previous slot back");
+
+        Bench::check(!registry.add(Bench::makeGuid(4)).valid(), "add fails when full");
+        Bench::check(!registry.add(Bench::makeGuid(0)).valid(), "add fails for a GUID already present");
+
+        registry.remove(a);
+        registry.remove(c);
+        const auto e = registry.add(Bench::makeGuid(4));
+        Bench::check(e.index == 0, "full of departed slots: least recently released is reused");
+    }
+
+    // Generations reject stale handles
+    {
+        SlotRegistry<Pad, 4> registry;
+        const auto first = registry.add(Bench::makeGuid(7));
+        registry.get(first)->reports = 42;
+        Bench::check(registry.remove(first), "remove live handle");
+        Bench::check(registry.get(first) == nullptr && !registry.remove(first), "handle is stale after remove");
+
+        const auto second = registry.add(Bench::makeGuid(7));
+        Bench::check(second.index == first.index && second.generation != first.generation, "same slot, new generation");
+        Bench::check(registry.get(first) == nullptr && registry.get(second) != nullptr, "old handle can't reach the new owner");
+        Bench::check(registry.get(second)->reports == 42, "pooled value is reused, not reconstructed");
+    }
+
+    // Random churn against a hash map model
+    {
+        static constexpr size_t   kCapacity = 64;
+        static constexpr uint32_t kIds      = 160;
+        auto registry = std::make_unique<SlotRegistry<Pad, kCapacity>>();
+
+        std::unordered_map<uint32_t, SlotHandle> present;
+        std::unordered_map<uint32_t, uint16_t>   lastSlot;
+        std::unordered_map<uint16_t, uint32_t>   slotOwner;   // last id to hold each slot
+        std::mt19937 rng(3);
+        bool consistent = true;
+        bool stable     = true;
+        for (int op = 0; op < 200000 && consistent; op++)
+        {
+            const uint32_t index = rng() % kIds;
+            const auto id = Bench::makeGuid(index);
+            auto it = present.find(index);
+            if (it != present.end())
+            {
+                consistent &= registry->remove(id);
+                present.erase(it);
+                continue;
+            }
+
+            // Nobody used this id's previous slot since it left
+            auto last = lastSlot.find(index);
+            const bool previousFree = last != lastSlot.end() && slotOwner[last->second] == index;
+
+            const auto handle = registry->add(id);
+            if (present.size() == kCapacity)
+            {
+                consistent &= !handle.valid();
+                continue;
+            }
+            consistent &= handle.valid() && registry->guid(handle) && *registry->guid(handle) == id;
+            if (previousFree)
+                stable &= handle.index == last->second;
+            present[index]  = handle;
+            lastSlot[index] = handle.index;
+            slotOwner[handle.index] = index;
+        }
+        for (uint32_t index = 0; index < kIds && consistent; index++)
+        {
+            const auto handle = registry->find(Bench::makeGuid(index));
+            auto it = present.find(index);
+            consistent &= it == present.end() ? !handle.valid() : handle.index == it->second.index && handle.generation == it->second.generation;
+        }
+        consistent &= registry->size() == present.size();
+        Bench::check(consistent, "registry matches a hash map model under churn");
+        Bench::check(stable, "untouched previous slots are always handed back under churn");
+    }
+
+    // Churn with many pads: the old string keyed map (format + parse the
+    // GUID, shared_ptr per pad) versus the slot registry
+    static constexpr size_t   kPads   = 256;
+    static constexpr uint32_t kIds    = 512;
+    static constexpr size_t   kScript = 1 << 16;
+
+    std::vector<uint32_t> script(kScript);
+    std::mt19937 rng(11);
+    for (auto& index : script)
+        index = rng() % kIds;
+    std::vector<DeviceGuid> ids;
+    for (uint32_t i = 0; i < kIds; i++)
+        ids.push_back(Bench::makeGuid(i));
+
+    {
+        std::unordered_map<std::string, std::shared_ptr<Pad>> pads;
+        uint64_t cursor = 0;
+        Bench::report("churn: string map + shared_ptr (256 pads)", Bench::nsPerOp(kScript, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; i++, cursor++)
+            {
+                const auto key = ids[script[cursor % kScript]].toString();
+                auto it = pads.find(key);
+                if (it != pads.end())
+                    pads.erase(it);
+                else if (pads.size() < kPads)
+                {
+                    DeviceGuid parsed;
+                    DeviceGuid::fromString(key.c_str(), parsed);
+                    Bench::doNotOptimize(parsed);
+                    pads.emplace(key, std::make_shared<Pad>());
+                }
+            }
+        }));
+    }
+    {
+        auto registry = std::make_unique<SlotRegistry<Pad, kPads>>();
+        uint64_t cursor = 0;
+        Bench::report("churn: slot registry (256 pads)", Bench::nsPerOp(kScript, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; i++, cursor++)
+            {
+                const auto& id = ids[script[cursor % kScript]];
+                if (!registry->remove(id))
+                    registry->add(id);
+            }
+        }));
+
+        Bench::report("lookup: slot registry find + get", Bench::nsPerOp(1 << 20, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; i++)
+                Bench::doNotOptimize(registry->get(registry->find(ids[i % kIds])));
+        }));
+    }
+});
+
+// Text form used in logs, captures and the device source
+static Bench::Register sGuid("guid", []
+{
+    std::vector<DeviceGuid> ids;
+    std::vector<std::string> texts;
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        ids.push_back(Bench::makeGuid(i));
+        texts.push_back(ids.back().toString());
+    }
+
+    bool roundTrips = true;
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        DeviceGuid parsed;
+        roundTrips &= DeviceGuid::fromString(texts[i].c_str(), parsed) && parsed == ids[i];
+    }
+    Bench::check(roundTrips, "toString / fromString round trip");
+    Bench::check(DeviceTypes::n64().productGuid.toString() == "2019057e-0000-0000-0000-504944564944", "product GUID text form");
+
+    DeviceGuid parsed;
+    Bench::check(!DeviceGuid::fromString("2019057e-0000-0000-0000-50494456494", parsed) &&
+                 !DeviceGuid::fromString("2019057e-0000-0000-0000-50494456494g", parsed),
+                 "malformed GUIDs are rejected");
+
+    Bench::report("DeviceGuid::toString", Bench::nsPerOp(1 << 18, [&](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+            Bench::doNotOptimize(ids[i & 255].toString());
+    }));
+
+    Bench::report("DeviceGuid::fromString", Bench::nsPerOp(1 << 18, [&](uint64_t iterations)
+    {
+        DeviceGuid id;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            DeviceGuid::fromString(texts[i & 255].c_str(), id);
+            Bench::doNotOptimize(id);
+        }
+    }));
+});
@@ -0,0 +1,163 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/Clock.h"
+#include "core/Controller.h"
+#include "core/FakeBackends.h"
+#include "core/ReportPipeline.h"
+#include "core/ReportScheduler.h"
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+namespace
+{
+
+constexpr int64_t kMs = 1000000;
+
+XusbReport makeReport(int16_t x)
+{
+    XusbReport report {};
+    report.sThumbLX = x;
+    return report;
+}
+
+// A stick sweeping continuously for a while: one new state every 100us
+void stream(ReportScheduler::Mode mode, uint32_t hz, const char* name)
+{
+    static constexpr int     kStates  = 3000;
+    static constexpr int64_t kStepNs  = 100000;
+
+    FakeInputBackend       inputs;
+    FakeSinkBackend        sinks;
+    std::atomic<uint64_t>  updates { 0 };
+    sinks.setSubmitCallback([&](uint32_t, const XusbReport&) { updates++; });
+
+    const auto id = Bench::makeGuid(static_cast<uint32_t>(mode));
+    inputs.plug(id);
+
+    ControllerContext context;
+    context.outputMode = mode;
+    context.outputHz   = hz;
+    Controller controller;
+    if (!controller.open(inputs, sinks, id, context))
+    {
+        Bench::check(false, std::string(name) + ": controller opens");
+        return;
+    }
+
+    auto state = Bench::neutral();
+    const auto startNs = Clock::nowNs();
+    for (int i = 0; i < kStates; i++)
+    {
+        state.xAxis = 10000 + (i * 97) % 44000;
+        inputs.push(id, state);
+        Bench::spinFor(kStepNs);
+    }
+    const double seconds = static_cast<double>(Clock::nowNs() - startNs) / 1e9;
+    Bench::spinFor(20 * kMs);
+
+    const auto& stats    = controller.stats();
+    const auto& total    = stats.stages[ControllerStats::TOTAL];
+    const double perSec  = static_cast<double>(updates.load()) / seconds;
+    printf("%-24s reads %6llu  updates/s %7.0f  saved %6llu  total p50 %7.1f us  p99 %7.1f us\n",
+           name,
+           static_cast<unsigned long long>(stats.counters.reportsRead.load()),
+           perSec,
+           static_cast<unsigned long long>(stats.updatesSaved()),
+           total.percentile(0.50) / 1000.0,
+           total.percentile(0.99) / 1000.0);
+
+    if (mode == ReportScheduler::COALESCE)
+        Bench::check(perSec <= hz * 1.1, std::string(name) + ": updates stay under the cap");
+    if (mode == ReportScheduler::FIXED_RATE)
+        Bench::check(perSec <= hz * 1.1 && perSec >= hz * 0.5, std::string(name) + ": updates follow the fixed rate");
+    controller.close();
+}
+
+}
+
+static Bench::Register sScheduler("scheduler", []
+{
+    // Dedupe runs on the converted report
+    {
+        ReportPipeline pipeline;
+        XusbReport report;
+        auto state = Bench::neutral();
+        pipeline.process(state, report);
+
+        state.data[3] = 0x5a;
+        Bench::check(!pipeline.process(state, report), "unused data[] bytes don't produce a report");
+
+        state.xAxis = 31750;
+        pipeline.process(state, report);
+        state.xAxis = 31950;
+        Bench::check(!pipeline.process(state, report), "noise inside the deadzone doesn't produce a report");
+
+        state.buttons[N64Button::A] = 0x80;
+        Bench::check(pipeline.process(state, report), "a real change does");
+    }
+
+    // Immediate
+    {
+        ReportScheduler scheduler;
+        scheduler.configure(ReportScheduler::IMMEDIATE, 0);
+        scheduler.reset(0);
+        Bench::check(scheduler.offer(makeReport(1), 0) == ReportScheduler::SEND, "immediate: first report goes out");
+        scheduler.sent(makeReport(1), 0);
+        Bench::check(scheduler.offer(makeReport(1), 1) == ReportScheduler::DUPLICATE, "immediate: resending what the pad shows is dropped");
+        Bench::check(scheduler.deadlineNs() < 0, "immediate: never needs the timer");
+    }
+
+    // Coalesce at 100 Hz
+    {
+        ReportScheduler scheduler;
+        scheduler.configure(ReportScheduler::COALESCE, 100);
+        scheduler.reset(0);
+        XusbReport out;
+
+        bool ok = scheduler.offer(makeReport(1), 0) == ReportScheduler::SEND;
+        scheduler.sent(makeReport(1), 0);
+        ok &= scheduler.offer(makeReport(2), 1 * kMs) == ReportScheduler::HELD;
+        ok &= scheduler.offer(makeReport(3), 2 * kMs) == ReportScheduler::SUPERSEDED;
+        ok &= scheduler.deadlineNs() == 10 * kMs;
+        ok &= scheduler.expire(5 * kMs, out) == ReportScheduler::NONE;
+        ok &= scheduler.expire(10 * kMs, out) == ReportScheduler::SEND && out.sThumbLX == 3;
+        Bench::check(ok, "coalesce: changes inside the window collapse to the latest");
+        scheduler.sent(out, 10 * kMs);
+
+        ok  = scheduler.offer(makeReport(4), 12 * kMs) == ReportScheduler::HELD;
+        ok &= scheduler.offer(makeReport(3), 13 * kMs) == ReportScheduler::SUPERSEDED;
+        ok &= scheduler.deadlineNs() < 0;
+        Bench::check(ok, "coalesce: a change reverted inside the window is never sent");
+
+        Bench::check(scheduler.offer(makeReport(5), 25 * kMs) == ReportScheduler::SEND, "coalesce: a change after an idle window goes out at once");
+    }
+
+    // Fixed rate at 100 Hz
+    {
+        ReportScheduler scheduler;
+        scheduler.configure(ReportScheduler::FIXED_RATE, 100);
+        scheduler.reset(0);
+        XusbReport out;
+
+        bool ok = scheduler.expire(10 * kMs, out) == ReportScheduler::NONE;
+        ok &= scheduler.offer(makeReport(1), 11 * kMs) == ReportScheduler::HELD;
+        ok &= scheduler.expire(20 * kMs, out) == ReportScheduler::SEND && out.sThumbLX == 1;
+        scheduler.sent(out, 20 * kMs);
+        ok &= scheduler.expire(30 * kMs, out) == ReportScheduler::RESEND && out.sThumbLX == 1;
+        scheduler.sent(out, 30 * kMs);
+        Bench::check(ok, "fixed: the latest report goes out on every tick, resent when unchanged");
+
+        ok  = scheduler.expire(75 * kMs, out) == ReportScheduler::RESEND;
+        ok &= scheduler.deadlineNs() == 85 * kMs;
+        Bench::check(ok, "fixed: missed ticks are skipped, not replayed in a burst");
+    }
+
+    // Update volume versus latency on a continuously moving stick
+    stream(ReportScheduler::IMMEDIATE, 0, "immediate");
+    stream(ReportScheduler::COALESCE, 250, "coalesce 250 Hz");
+    stream(ReportScheduler::COALESCE, 125, "coalesce 125 Hz");
+    stream(ReportScheduler::FIXED_RATE, 125, "fixed 125 Hz");
+});
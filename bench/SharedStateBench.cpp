@@ -0,0 +1,244 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/Clock.h"
+#include "core/Controller.h"
+#include "core/FakeBackends.h"
+#include "core/SharedState.h"
+#include "core/SharedStateReader.h"
+
+#if !defined(_WIN32)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// Unique per run, so parallel runs don't share a region
+std::string regionName(const char* what)
+{
+    return std::string("n64-bench-") + what + "-" + std::to_string(static_cast<unsigned long long>(Clock::nowNs()));
+}
+
+// Every field derived from one counter, so a torn read can't look whole
+void stamp(uint32_t value, N64ControllerState& raw, XusbReport& report)
+{
+    memset(&raw, static_cast<int>(value & 0xFF), sizeof(raw));
+    raw.xAxis = static_cast<int32_t>(value);
+    raw.yAxis = static_cast<int32_t>(~value);
+    report = XusbReport{};
+    report.wButtons = static_cast<uint16_t>(value);
+    report.sThumbLX = static_cast<int16_t>(value >> 16);
+    report.sThumbRY = static_cast<int16_t>(~value >> 16);
+}
+
+bool whole(const SharedStateReader::Pad& pad)
+{
+    const auto value = static_cast<uint32_t>(pad.raw.xAxis);
+    N64ControllerState raw;
+    XusbReport report;
+    stamp(value, raw, report);
+    return memcmp(&raw, &pad.raw, sizeof(raw)) == 0 && memcmp(&report, &pad.report, sizeof(report)) == 0;
+}
+
+// Reads one slot until it sees `last`; false on a torn or backwards read
+bool readUntil(const SharedStateReader& reader, uint32_t slot, uint32_t last)
+{
+    SharedStateReader::Pad pad;
+    uint64_t previous = 0;
+    for (;;)
+    {
+        // Connected but nothing published yet reads as all zero
+        if (!reader.read(slot, pad) || pad.updates == 0)
+            continue;
+        if (!whole(pad) || pad.updates < previous)
+            return false;
+        previous = pad.updates;
+        if (static_cast<uint32_t>(pad.raw.xAxis) == last)
+            return true;
+    }
+}
+
+}
+
+static Bench::Register sSharedState("shared-state", []
+{
+    const auto name  = regionName("state");
+    auto       state = SharedState::create(name);
+    Bench::check(state != nullptr, "the bridge creates the shared state region");
+    if (!state)
+        return;
+
+    auto reader = SharedStateReader::open(name);
+    Bench::check(reader != nullptr && reader->slotCount() == SharedStateLayout::kMaxPads, "a reader maps the region by name");
+    Bench::check(SharedStateReader::open(name + "-missing") == nullptr, "a name nobody publishes doesn't open");
+    if (!reader)
+        return;
+
+    // Connect, publish, disconnect
+    {
+        N64ControllerState raw;
+        XusbReport report;
+        stamp(1234, raw, report);
+        SharedStateReader::Pad pad;
+        Bench::check(!reader->read(5, pad), "an unused slot reads as disconnected");
+
+        const auto id = Bench::makeGuid(0);
+        state->connect(5, id);
+        state->publish(5, raw, report, 42);
+        const bool read = reader->read(5, pad);
+        Bench::check(read && whole(pad) && pad.updates == 1 && pad.timeNs == 42 && memcmp(pad.guid, &id, sizeof(pad.guid)) == 0,
+                     "a published state reads back whole");
+
+        const auto before = reader->sequence(5);
+        state->disconnect(5);
+        Bench::check(!reader->read(5, pad) && reader->sequence(5) != before, "a disconnect shows up in the slot");
+    }
+
+    // Many readers, one writer per slot
+    {
+        static constexpr uint32_t kUpdates = 200000;
+        static constexpr int      kSlots   = 4;
+        static constexpr int      kReaders = 8;
+
+        for (int slot = 0; slot < kSlots; slot++)
+            state->connect(slot, Bench::makeGuid(1 + slot));
+
+        std::atomic<int>  torn { 0 };
+        std::atomic<bool> go { false };
+        std::vector<std::thread> readers;
+        for (int r = 0; r < kReaders; r++)
+        {
+            readers.emplace_back([&, r]
+            {
+                while (!go)
+                    std::this_thread::yield();
+                if (!readUntil(*reader, r % kSlots, kUpdates))
+                    torn++;
+            });
+        }
+
+        // The child processes map their own view, like an overlay would
+        std::vector<int> children;
+#if !defined(_WIN32)
+        for (int c = 0; c < kReaders; c++)
+        {
+            const pid_t pid = fork();
+            if (pid == 0)
+            {
+                auto own = SharedStateReader::open(name);
+                _exit(!own ? 2 : readUntil(*own, c % kSlots, kUpdates) ? 0 : 1);
+            }
+            if (pid > 0)
+                children.push_back(static_cast<int>(pid));
+        }
+#endif
+
+        go = true;
+        std::vector<std::thread> writers;
+        std::vector<double> nsPerPublish(kSlots);
+        for (int slot = 0; slot < kSlots; slot++)
+        {
+            writers.emplace_back([&, slot]
+            {
+                N64ControllerState raw;
+                XusbReport report;
+                const auto startNs = Clock::nowNs();
+                for (uint32_t i = 1; i <= kUpdates; i++)
+                {
+                    stamp(i, raw, report);
+                    state->publish(slot, raw, report, Clock::nowNs());
+                    if ((i & 1023) == 0)
+                        std::this_thread::yield();
+                }
+                nsPerPublish[slot] = static_cast<double>(Clock::nowNs() - startNs) / kUpdates;
+            });
+        }
+        for (auto& writer : writers)
+            writer.join();
+        for (auto& thread : readers)
+            thread.join();
+
+        int childFailures = 0;
+#if !defined(_WIN32)
+        for (const int pid : children)
+        {
+            int status = 0;
+            if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                childFailures++;
+        }
+#endif
+
+        double total = 0;
+        for (const auto ns : nsPerPublish)
+            total += ns;
+        Bench::report("publish, 4 writers + 8 threads + 8 processes reading", total / kSlots);
+        printf("  %zu reader processes, %llu reader retries\n", children.size(), static_cast<unsigned long long>(reader->retries()));
+        Bench::check(torn == 0, "reader threads never see a torn or stale-after-newer state");
+        Bench::check(childFailures == 0, "reader processes never see a torn state");
+
+        for (int slot = 0; slot < kSlots; slot++)
+            state->disconnect(slot);
+    }
+
+    // Uncontended costs
+    {
+        N64ControllerState raw;
+        XusbReport report;
+        stamp(7, raw, report);
+        state->connect(9, Bench::makeGuid(9));
+        Bench::report("publish, no readers", Bench::nsPerOp(1000000, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; i++)
+                state->publish(9, raw, report, static_cast<int64_t>(i));
+        }));
+        SharedStateReader::Pad pad;
+        Bench::report("read", Bench::nsPerOp(1000000, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; i++)
+                Bench::doNotOptimize(reader->read(9, pad));
+        }));
+        state->disconnect(9);
+    }
+
+    // End to end: a pad's thread publishes what it reads and converts
+    {
+        FakeInputBackend inputs;
+        FakeSinkBackend  sinks;
+        ControllerContext context;
+        context.shared     = state.get();
+        context.sharedSlot = 3;
+
+        const auto id = Bench::makeGuid(0x10);
+        inputs.plug(id);
+        Controller controller;
+        if (!controller.open(inputs, sinks, id, context))
+        {
+            Bench::check(false, "controller opens");
+            return;
+        }
+
+        auto raw = Bench::neutral();
+        raw.buttons[N64Button::A] = 0x80;
+        raw.xAxis = 50000;
+        inputs.push(id, raw);
+        const auto giveUpNs = Clock::nowNs() + 1000000000ll;
+        SharedStateReader::Pad pad {};
+        while (Clock::nowNs() < giveUpNs && !(reader->read(3, pad) && memcmp(&pad.raw, &raw, sizeof(raw)) == 0))
+            std::this_thread::yield();
+
+        // The first update is the state read when the pad opened
+        Bench::check(pad.updates == 2 && memcmp(&pad.raw, &raw, sizeof(raw)) == 0, "the pad thread publishes the raw state it read");
+        Bench::check((pad.report.wButtons & Xusb::A) && pad.report.sThumbLX > 0, "and the report it converted");
+        controller.close();
+        Bench::check(!reader->read(3, pad), "closing the pad disconnects its slot");
+    }
+});
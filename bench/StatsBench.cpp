@@ -0,0 +1,59 @@
+#include "Bench.h"
+
+#include "core/Clock.h"
+#include "core/ControllerStats.h"
+
+#include <iostream>
+#include <memory>
+#include <random>
+
+static Bench::Register sStats("stats", []
+{
+    auto stats = std::make_unique<ControllerStats>();
+
+    Bench::report("Clock::nowNs", Bench::nsPerOp(1 << 20, [&](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+            Bench::doNotOptimize(Clock::nowNs());
+    }));
+
+    Bench::report("LatencyHistogram::record", Bench::nsPerOp(1 << 22, [&](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+            stats->stages[ControllerStats::READ].record(static_cast<int64_t>(i * 7919 % 2000000));
+    }));
+
+    Bench::report("instrumented report (4 stamps + record)", Bench::nsPerOp(1 << 20, [&](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            const auto woke = Clock::nowNs();
+            const auto read = Clock::nowNs();
+            const auto converted = Clock::nowNs();
+            const auto submitted = Clock::nowNs();
+            ControllerStats::increment(stats->counters.reportsSubmitted);
+            stats->recordReport(woke, read, converted, submitted);
+        }
+    }));
+
+    // Percentiles must land within one sub-bucket (~6%) of the exact value
+    LatencyHistogram histogram;
+    std::vector<double> exact;
+    std::mt19937 rng(5);
+    std::lognormal_distribution<double> latency(10.0, 1.5);
+    for (int i = 0; i < 200000; i++)
+    {
+        const auto value = static_cast<int64_t>(latency(rng));
+        histogram.record(value);
+        exact.push_back(static_cast<double>(value));
+    }
+    std::sort(exact.begin(), exact.end());
+    for (double quantile : { 0.5, 0.99, 0.999 })
+    {
+        const double expected = exact[static_cast<size_t>(quantile * exact.size())];
+        const double measured = static_cast<double>(histogram.percentile(quantile));
+        Bench::check(measured >= expected && measured <= expected * 1.07 + 1, "histogram p" + std::to_string(quantile) + " within one sub-bucket");
+    }
+
+    stats->print(std::cout, "bench");
+});
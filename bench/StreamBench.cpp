@@ -0,0 +1,289 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/Clock.h"
+#include "core/Controller.h"
+#include "core/FakeBackends.h"
+#include "core/Stream.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+bool sameReport(const XusbReport& a, const XusbReport& b)
+{
+    return memcmp(&a, &b, sizeof(XusbReport)) == 0;
+}
+
+// Mostly one stick moving, now and then a button: what a pad sends
+XusbReport playReport(uint32_t i)
+{
+    XusbReport report {};
+    report.sThumbLX = static_cast<int16_t>((i * 97) & 0x7FFF);
+    report.sThumbLY = static_cast<int16_t>(-static_cast<int32_t>((i * 31) & 0x3FFF));
+    report.wButtons = (i / 50) & 1 ? Xusb::A : 0;
+    return report;
+}
+
+// One datagram to a loopback port, from a socket of its own: a sender the
+// receiver only ever hears what the bench lets through of
+void sendDatagram(uint16_t port, const uint8_t* data, size_t size)
+{
+#if defined(_WIN32)
+    using Socket = SOCKET;
+    auto closeSocket = [](Socket socket) { closesocket(socket); };
+    const Socket kNoSocket = INVALID_SOCKET;
+#else
+    using Socket = int;
+    auto closeSocket = [](Socket socket) { close(socket); };
+    const Socket kNoSocket = -1;
+#endif
+
+    const Socket socket = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (socket == kNoSocket)
+        return;
+
+    sockaddr_in address{};
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port        = htons(port);
+    sendto(socket, reinterpret_cast<const char*>(data), static_cast<int>(size), 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    closeSocket(socket);
+}
+
+}
+
+static Bench::Register sStream("stream", []
+{
+    // Protocol: keyframes, deltas, out of order, loss
+    {
+        Stream::Encoder encoder(7, 3, 100000000);
+        Stream::Decoder decoder;
+        uint8_t datagram[Stream::kMaxPacket];
+        Stream::Packet packet;
+        XusbReport out {};
+
+        bool roundTrip = true;
+        size_t bytes = 0, keyframes = 0;
+        std::mt19937 random(21);
+        XusbReport report {};
+        for (uint32_t i = 0; i < 10000; i++)
+        {
+            // Every so often a different subset of fields changes
+            if (random() % 4 == 0)
+                report.wButtons ^= static_cast<uint16_t>(1u << (random() % 16));
+            report.sThumbLX = static_cast<int16_t>(random());
+            if (random() % 3 == 0)
+                report.bRightTrigger = static_cast<uint8_t>(random());
+            const auto size = encoder.encode(report, static_cast<int64_t>(i) * 4000000, datagram);
+            bytes += size;
+            keyframes += encoder.lastWasKeyframe();
+            roundTrip = roundTrip && Stream::parse(datagram, size, packet) && packet.session == 7 && packet.pad == 3 &&
+                        decoder.apply(packet, out) == Stream::Decoder::APPLIED && sameReport(out, report);
+        }
+        Bench::check(roundTrip, "every datagram decodes back to the report sent");
+        Bench::check(keyframes >= 390 && keyframes <= 410, "a keyframe goes out every keyframe interval");
+        printf("  %.1f bytes per datagram (a keyframe is %zu)\n", static_cast<double>(bytes) / 10000, Stream::kMaxPacket);
+
+        // Reordered: the late one is dropped, the gap counted once
+        Stream::Encoder ordered(9, 0, 100000000);
+        Stream::Decoder reordered;
+        uint8_t first[Stream::kMaxPacket], second[Stream::kMaxPacket];
+        const auto keySize    = ordered.encode(playReport(0), 0, first);
+        const bool keyed      = Stream::parse(first, keySize, packet) && reordered.apply(packet, out) == Stream::Decoder::APPLIED;
+        const auto firstSize  = ordered.encode(playReport(1), 1000000, first);
+        const auto secondSize = ordered.encode(playReport(2), 2000000, second);
+        Stream::Packet late;
+        const bool parsed = keyed && Stream::parse(second, secondSize, packet) && Stream::parse(first, firstSize, late);
+        Bench::check(parsed && reordered.apply(packet, out) == Stream::Decoder::APPLIED && sameReport(out, playReport(2)) &&
+                     reordered.apply(late, out) == Stream::Decoder::STALE && reordered.lost() == 1,
+                     "an out of order datagram is dropped and counted as lost");
+        Bench::check(reordered.apply(packet, out) == Stream::Decoder::STALE, "a repeated datagram is dropped");
+
+        // A lost keyframe: deltas wait for the next one
+        Stream::Encoder resync(8, 0, 100000000);
+        Stream::Decoder fresh;
+        resync.encode(playReport(10), 0, first);
+        const auto deltaSize = resync.encode(playReport(11), 1000000, second);
+        const bool waits = Stream::parse(second, deltaSize, packet) && fresh.apply(packet, out) == Stream::Decoder::NO_BASE;
+        const auto nextSize = resync.encode(playReport(12), 200000000, second);
+        Bench::check(waits && resync.lastWasKeyframe() && Stream::parse(second, nextSize, packet) &&
+                     fresh.apply(packet, out) == Stream::Decoder::APPLIED && sameReport(out, playReport(12)),
+                     "a receiver that missed the keyframe resyncs at the next one");
+
+        Bench::check(!Stream::parse(second, nextSize - 1, packet) && !Stream::parse(second, 3, packet), "truncated datagrams are rejected");
+
+        Bench::report("encode + parse + apply", Bench::nsPerOp(1000000, [&](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                const auto size = encoder.encode(playReport(static_cast<uint32_t>(i)), 50000000000ll + static_cast<int64_t>(i), datagram);
+                Stream::parse(datagram, size, packet);
+                Bench::doNotOptimize(decoder.apply(packet, out));
+            }
+        }));
+    }
+
+    // Loopback: added latency and loss between two bridges
+    {
+        static constexpr uint32_t kReports = 20000;
+
+        FakeSinkBackend remoteSinks;
+        std::vector<int64_t> sentNs(kReports, 0);
+        std::vector<double>  samples;
+        samples.reserve(kReports);
+        std::atomic<uint32_t> arrived { 0 };
+        remoteSinks.setSubmitCallback([&](uint32_t, const XusbReport& report)
+        {
+            // The report's left stick and buttons give away which one it was
+            const auto nowNs = Clock::nowNs();
+            for (uint32_t i = arrived.load(); i < kReports; i++)
+            {
+                if (sameReport(report, playReport(i)))
+                {
+                    samples.push_back(static_cast<double>(nowNs - sentNs[i]));
+                    break;
+                }
+            }
+            arrived++;
+        });
+
+        auto receiver = StreamReceiver::create(0, remoteSinks, 100);
+        Bench::check(receiver != nullptr, "the receiver binds a UDP port");
+        if (!receiver)
+            return;
+        auto sender = StreamSender::create("127.0.0.1:" + std::to_string(receiver->port()), 100);
+        Bench::check(sender != nullptr, "the sender resolves its target");
+        if (!sender)
+            return;
+
+        auto sink = sender->plug();
+        for (uint32_t i = 0; i < kReports; i++)
+        {
+            sentNs[i] = Clock::nowNs();
+            sink->submit(playReport(i));
+            // About a 2 kHz pad, so the receiver keeps up on one core
+            if ((i & 7) == 7)
+                std::this_thread::yield();
+        }
+        Bench::waitFor([&] { return receiver->counters().datagrams.load() >= sender->counters().datagrams.load(); });
+
+        const auto& counters = receiver->counters();
+        const auto  applied  = counters.applied.load();
+        const auto  lost     = counters.lost.load();
+        printf("  %llu sent, %llu applied, %llu lost, %llu stale, %llu waiting for a keyframe, %llu keyframes\n",
+               static_cast<unsigned long long>(sender->counters().datagrams.load()), static_cast<unsigned long long>(applied),
+               static_cast<unsigned long long>(lost), static_cast<unsigned long long>(counters.stale.load()),
+               static_cast<unsigned long long>(counters.noBase.load()), static_cast<unsigned long long>(sender->counters().keyframes.load()));
+        if (!samples.empty())
+            Bench::reportLatency("loopback send to virtual pad submit", samples);
+        Bench::check(remoteSinks.live() == 1, "the receiver plugs one virtual pad per remote pad");
+        Bench::check(applied + lost + counters.noBase.load() >= kReports * 99 / 100 && applied >= kReports * 9 / 10,
+                     "loopback delivers the stream (every datagram applied or counted)");
+
+        sink.reset();
+        Bench::check(Bench::waitFor([&] { return remoteSinks.live() == 0; }), "the remote pad unplugs when the sender's pad goes away");
+    }
+
+    // End to end: a Controller whose virtual pad is a remote one
+    {
+        FakeInputBackend  inputs;
+        FakeSinkBackend   remoteSinks;
+        std::atomic<bool> pressed { false };
+        remoteSinks.setSubmitCallback([&](uint32_t, const XusbReport& report)
+        {
+            if ((report.wButtons & Xusb::A) && report.sThumbLX > 0)
+                pressed = true;
+        });
+
+        auto receiver = StreamReceiver::create(0, remoteSinks, 100);
+        auto sender   = receiver ? StreamSender::create("localhost:" + std::to_string(receiver->port()), 100) : nullptr;
+        Bench::check(sender != nullptr, "sender and receiver start");
+        if (!sender)
+            return;
+
+        const auto id = Bench::makeGuid(0);
+        inputs.plug(id);
+        Controller controller;
+        if (!controller.open(inputs, *sender, id))
+        {
+            Bench::check(false, "controller opens");
+            return;
+        }
+        auto state = Bench::neutral();
+        state.buttons[N64Button::A] = 0x80;
+        state.xAxis = 60000;
+        inputs.push(id, state);
+        Bench::check(Bench::waitFor([&] { return pressed.load(); }), "a press on the sending bridge reaches the receiving bridge's virtual pad");
+        controller.close();
+        Bench::check(Bench::waitFor([&] { return remoteSinks.live() == 0; }), "closing the pad unplugs its remote virtual pad");
+    }
+
+    // An idle pad: the last report keeps going out as a keyframe
+    {
+        FakeSinkBackend       remoteSinks;
+        std::atomic<uint32_t> submitted { 0 };
+        remoteSinks.setSubmitCallback([&](uint32_t, const XusbReport&) { submitted++; });
+
+        auto receiver = StreamReceiver::create(0, remoteSinks, 20);
+        auto sender   = receiver ? StreamSender::create("127.0.0.1:" + std::to_string(receiver->port()), 20) : nullptr;
+        Bench::check(sender != nullptr, "sender and receiver start");
+        if (!sender)
+            return;
+
+        auto sink = sender->plug();
+        sink->submit(playReport(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        const auto keyframes = sender->counters().keyframes.load();
+        printf("  idle for 200 ms at a 20 ms keyframe interval: %llu keyframes, %u applied\n",
+               static_cast<unsigned long long>(keyframes), submitted.load());
+        Bench::check(keyframes >= 5 && submitted.load() >= 5, "an idle pad still resyncs the receiver every keyframe interval");
+        sink.reset();
+    }
+
+    // A sender that goes away without its BYE arriving
+    {
+        FakeSinkBackend       remoteSinks;
+        std::atomic<uint16_t> buttons { 0 };
+        remoteSinks.setSubmitCallback([&](uint32_t, const XusbReport& report) { buttons = report.wButtons; });
+
+        auto receiver = StreamReceiver::create(0, remoteSinks, 20);
+        Bench::check(receiver != nullptr, "the receiver binds a UDP port");
+        if (!receiver)
+            return;
+
+        // Holding A, then nothing: the BYE is dropped
+        Stream::Encoder encoder(0x5113e7, 0, 20000000);
+        uint8_t datagram[Stream::kMaxPacket];
+        const auto size = encoder.encode(playReport(50), Clock::nowNs(), datagram);
+        sendDatagram(receiver->port(), datagram, size);
+        const bool held = Bench::waitFor([&] { return remoteSinks.live() == 1 && buttons.load() == Xusb::A; });
+
+        const auto silentNs = static_cast<int64_t>(StreamReceiver::kSilentKeyframes) * 20000000;
+        const auto startNs  = Clock::nowNs();
+        const bool evicted  = Bench::waitFor([&] { return remoteSinks.live() == 0; });
+        const auto tookNs   = Clock::nowNs() - startNs;
+        printf("  silent pad unplugged after %.0f ms (timeout %.0f ms)\n", tookNs / 1e6, silentNs / 1e6);
+        Bench::check(held && evicted && receiver->counters().timedOut.load() == 1 && receiver->counters().pads.load() == 0,
+                     "a remote pad that goes silent is unplugged and its slot freed");
+        Bench::check(buttons.load() == 0, "and its virtual pad is neutralised first");
+    }
+});
@@ -0,0 +1,224 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/Clock.h"
+#include "core/Controller.h"
+#include "core/FakeBackends.h"
+#include "core/ReportMailbox.h"
+#include "core/SubmitThread.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// Roughly a ViGEm update stuck behind another client's
+static constexpr int64_t kSlowSubmitUs = 2000;
+static constexpr int64_t kPushEveryUs  = 250;
+static constexpr int32_t kPushes       = 400;
+
+// A virtual pad whose updates take a while
+class SlowSink : public PadSink
+{
+public:
+    void submit(const XusbReport& report) override
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(kSlowSubmitUs));
+        lastX = report.sThumbLX;
+        count++;
+    }
+
+    std::atomic<uint64_t> count { 0 };
+    std::atomic<int16_t>  lastX { 0 };
+};
+
+struct Run
+{
+    uint64_t read { 0 };
+    uint64_t superseded { 0 };
+    double   stalenessP50Us { 0 };
+    bool     sawLast { false };
+};
+
+// A pad moving its stick every kPushEveryUs into a slow virtual pad
+Run movingStick(SubmitThread* submitter)
+{
+    FakeInputBackend inputs;
+    FakeSinkBackend  sinks;
+    std::atomic<int32_t> lastX { 0 };
+    sinks.setSubmitCallback([&](uint32_t, const XusbReport& report)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(kSlowSubmitUs));
+        lastX = report.sThumbLX;
+    });
+
+    ControllerContext context;
+    context.submitter = submitter;
+    const auto id = Bench::makeGuid(submitter ? 1 : 0);
+    inputs.plug(id);
+    Controller controller;
+    Run run;
+    if (!controller.open(inputs, sinks, id, context))
+    {
+        Bench::check(false, "controller opens");
+        return run;
+    }
+
+    auto state = Bench::neutral();
+    for (int32_t i = 0; i < kPushes; i++)
+    {
+        state.xAxis = 12000 + (i % 2) * 40000;
+        inputs.push(id, state);
+        std::this_thread::sleep_for(std::chrono::microseconds(kPushEveryUs));
+    }
+    const int32_t lastSent = state.xAxis > 32767 ? 1 : -1;
+    run.sawLast = Bench::waitFor([&] { return lastX.load() * lastSent > 0; });
+
+    const auto& stats = controller.stats();
+    run.read           = stats.counters.reportsRead.load();
+    run.superseded     = stats.submit.reportsSuperseded.load();
+    run.stalenessP50Us = stats.submit.staleness.percentile(0.50) / 1e3;
+    controller.close();
+    return run;
+}
+
+}
+
+static Bench::Register sSubmit("submit", []
+{
+    // Mailbox semantics
+    {
+        ReportMailbox mailbox;
+        ReportMailbox::Entry entry;
+        const bool empty = !mailbox.take(entry);
+        XusbReport report {};
+        for (int16_t i = 1; i <= 3; i++)
+        {
+            report.sThumbLX = i;
+            mailbox.post(report, i * 100);
+        }
+        const bool newest = mailbox.take(entry) && entry.sequence == 3 && entry.report.sThumbLX == 3 && entry.readNs == 300;
+        Bench::check(empty && newest && !mailbox.take(entry), "take() returns the newest report once");
+    }
+
+    // One producer and one consumer going flat out
+    {
+        static constexpr uint64_t kPosts = 1 << 20;
+        ReportMailbox mailbox;
+        std::atomic<bool> done { false };
+        std::thread producer([&]
+        {
+            XusbReport report {};
+            for (uint64_t i = 1; i <= kPosts; i++)
+            {
+                report.sThumbLX = static_cast<int16_t>(i & 0x7FFF);
+                report.sThumbRX = static_cast<int16_t>((i >> 15) & 0x7FFF);
+                mailbox.post(report, static_cast<int64_t>(i));
+            }
+            done = true;
+        });
+
+        ReportMailbox::Entry entry;
+        uint64_t taken = 0, last = 0;
+        bool consistent = true;
+        for (;;)
+        {
+            // Checked before the take, so the producer's last post is seen
+            const bool finished = done.load();
+            if (!mailbox.take(entry))
+            {
+                if (finished)
+                    break;
+                continue;
+            }
+            const auto sequence = static_cast<uint64_t>(entry.readNs);
+            consistent = consistent && entry.sequence == sequence && sequence > last &&
+                         entry.report.sThumbLX == static_cast<int16_t>(sequence & 0x7FFF) &&
+                         entry.report.sThumbRX == static_cast<int16_t>((sequence >> 15) & 0x7FFF);
+            last = sequence;
+            taken++;
+        }
+        producer.join();
+        Bench::check(consistent && last == kPosts, "reports are never torn or out of order, and the last one arrives");
+        printf("  %llu of %llu posts taken, the rest superseded\n",
+               static_cast<unsigned long long>(taken), static_cast<unsigned long long>(kPosts));
+    }
+
+    Bench::report("ReportMailbox::post", Bench::nsPerOp(1 << 22, [](uint64_t iterations)
+    {
+        ReportMailbox mailbox;
+        XusbReport report {};
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            report.sThumbLX = static_cast<int16_t>(i);
+            mailbox.post(report, static_cast<int64_t>(i));
+        }
+        Bench::doNotOptimize(mailbox);
+    }));
+
+    // Every pad with a fresh report goes out in one batch
+    {
+        auto submitter = SubmitThread::create();
+        static constexpr uint32_t kPads = 4;
+        SlowSink        sinks[kPads];
+        ControllerStats stats[kPads];
+        std::vector<std::unique_ptr<SubmitThread::Pad>> pads;
+        for (uint32_t i = 0; i < kPads; i++)
+            pads.push_back(submitter->addPad(sinks[i], stats[i]));
+
+        // The first update keeps the thread busy while the others post
+        XusbReport report {};
+        pads[0]->post(report, Clock::nowNs());
+        std::this_thread::sleep_for(std::chrono::microseconds(kSlowSubmitUs / 4));
+        for (int16_t round = 1; round <= 3; round++)
+        {
+            report.sThumbLX = round;
+            for (auto& pad : pads)
+                pad->post(report, Clock::nowNs());
+        }
+        const bool delivered = Bench::waitFor([&]
+        {
+            for (const auto& sink : sinks)
+            {
+                if (sink.lastX.load() != 3)
+                    return false;
+            }
+            return true;
+        });
+        std::this_thread::sleep_for(std::chrono::microseconds(kSlowSubmitUs * 2));
+
+        const auto& counters = submitter->counters();
+        Bench::check(delivered && submitter->batchSizes().maxValue() == kPads, "one wake up submits every pad with a fresh report");
+        Bench::check(counters.superseded.load() == stats[0].submit.reportsSuperseded.load() + stats[1].submit.reportsSuperseded.load() +
+                                                   stats[2].submit.reportsSuperseded.load() + stats[3].submit.reportsSuperseded.load() &&
+                     stats[1].submit.reportsSuperseded.load() == 2 && sinks[1].count.load() == 1,
+                     "replaced reports are counted as superseded, per pad");
+        Bench::check(stats[0].submit.staleness.count() == sinks[0].count.load() && stats[0].submit.staleness.percentile(0.50) >= kSlowSubmitUs * 900,
+                     "staleness covers the update itself");
+
+        // Removing a pad with a report pending
+        pads[2]->post(report, Clock::nowNs());
+        pads[2].reset();
+        pads.clear();
+    }
+
+    // A pad moving its stick into a slow virtual pad
+    {
+        const auto inline_  = movingStick(nullptr);
+        auto       submitter = SubmitThread::create();
+        const auto threaded = movingStick(submitter.get());
+        printf("  %d states pushed every %lld us, updates take %lld us\n", kPushes,
+               static_cast<long long>(kPushEveryUs), static_cast<long long>(kSlowSubmitUs));
+        printf("  inline:        %llu read\n", static_cast<unsigned long long>(inline_.read));
+        printf("  submit thread: %llu read, %llu superseded, staleness p50 %.0f us\n",
+               static_cast<unsigned long long>(threaded.read), static_cast<unsigned long long>(threaded.superseded), threaded.stalenessP50Us);
+        Bench::check(inline_.sawLast && threaded.sawLast, "both end on the last state");
+        Bench::check(threaded.read > 2 * inline_.read, "with a submit thread, slow updates no longer hold up reads");
+        Bench::check(threaded.superseded > 0, "reads that outrun the updates are superseded");
+    }
+});
@@ -0,0 +1,117 @@
+#include "Bench.h"
+#include "Inputs.h"
+
+#include "core/Clock.h"
+#include "core/TargetPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// Fake bus: plugging in or out takes about as long as a ViGEm round trip
+struct FakeBus
+{
+    static constexpr auto kPlugTime = std::chrono::milliseconds(2);
+
+    std::atomic<int> plugged { 0 };
+    std::atomic<int> neutrals { 0 };
+    std::atomic<int> nextTarget { 1 };
+
+    TargetPool::Callbacks callbacks()
+    {
+        TargetPool::Callbacks callbacks;
+        callbacks.create = [this]() -> void*
+        {
+            std::this_thread::sleep_for(kPlugTime);
+            plugged++;
+            return reinterpret_cast<void*>(static_cast<intptr_t>(nextTarget++));
+        };
+        callbacks.neutral = [this](void*){ neutrals++; };
+        callbacks.destroy = [this](void*)
+        {
+            std::this_thread::sleep_for(kPlugTime);
+            plugged--;
+        };
+        return callbacks;
+    }
+};
+
+}
+
+static Bench::Register sTargetPool("target-pool", []
+{
+    // Rebinding within the grace period
+    {
+        FakeBus bus;
+        TargetPool pool(bus.callbacks(), 0, 1000);
+        void* first = pool.acquire(Bench::makeGuid(1));
+        pool.release(Bench::makeGuid(1), first);
+        Bench::check(bus.neutrals == 1, "released target gets a neutral report");
+
+        void* other = pool.acquire(Bench::makeGuid(2));
+        Bench::check(other != first, "another pad doesn't take a parked target");
+
+        void* again = pool.acquire(Bench::makeGuid(1));
+        Bench::check(again == first && pool.counters().rebound == 1, "same GUID gets its parked target back");
+        Bench::check(bus.plugged == 2, "rebinding plugs nothing in");
+    }
+
+    // Grace expiry and pre-warm
+    {
+        FakeBus bus;
+        {
+            TargetPool pool(bus.callbacks(), 2, 20);
+            Bench::check(pool.prewarm() == 2 && bus.plugged == 2, "pre-warm plugs targets in up front");
+
+            void* a = pool.acquire(Bench::makeGuid(1));
+            void* b = pool.acquire(Bench::makeGuid(2));
+            void* c = pool.acquire(Bench::makeGuid(3));
+            Bench::check(pool.counters().reused == 2 && pool.counters().created == 3, "pads take warm targets before creating");
+
+            pool.release(Bench::makeGuid(1), a);
+            pool.release(Bench::makeGuid(2), b);
+            pool.release(Bench::makeGuid(3), c);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            const auto counters = pool.counters();
+            Bench::check(counters.parked == 0 && counters.idle == 2 && counters.destroyed == 1 && bus.plugged == 2,
+                         "expired targets refill the warm set, the rest are unplugged");
+        }
+        Bench::check(bus.plugged == 0, "pool unplugs everything on destruction");
+    }
+
+    // Reconnect latency: unplug + plug versus rebinding a parked target
+    {
+        FakeBus bus;
+        auto callbacks = bus.callbacks();
+        std::vector<double> cold;
+        for (int i = 0; i < 50; i++)
+        {
+            void* target = callbacks.create();
+            const auto startNs = Clock::nowNs();
+            callbacks.destroy(target);
+            target = callbacks.create();
+            cold.push_back(static_cast<double>(Clock::nowNs() - startNs));
+            callbacks.destroy(target);
+        }
+        Bench::reportLatency("reconnect, replug target", cold);
+
+        TargetPool pool(callbacks, 0, 1000);
+        std::vector<double> warm;
+        void* target = pool.acquire(Bench::makeGuid(1));
+        for (int i = 0; i < 1000; i++)
+        {
+            const auto startNs = Clock::nowNs();
+            pool.release(Bench::makeGuid(1), target);
+            target = pool.acquire(Bench::makeGuid(1));
+            warm.push_back(static_cast<double>(Clock::nowNs() - startNs));
+        }
+        Bench::reportLatency("reconnect, pooled rebind", warm);
+        Bench::check(bus.plugged == 1, "rebinding never replugs");
+        pool.release(Bench::makeGuid(1), target);
+    }
+});
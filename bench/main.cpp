@@ -0,0 +1,175 @@
+#include "Bench.h"
+
+#include "core/BatchMapping.h"
+
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <thread>
+
+std::vector<Bench::Case>& Bench::registry()
+{
+    static std::vector<Case> cases;
+    return cases;
+}
+
+std::vector<Bench::Result>& Bench::results()
+{
+    static std::vector<Result> results;
+    return results;
+}
+
+std::vector<Bench::CheckResult>& Bench::checks()
+{
+    static std::vector<CheckResult> checks;
+    return checks;
+}
+
+std::string& Bench::currentCase()
+{
+    static std::string name;
+    return name;
+}
+
+namespace
+{
+
+std::string quoted(const std::string& text)
+{
+    std::string out = "\"";
+    for (const char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        }
+        else
+            out += c;
+    }
+    return out + "\"";
+}
+
+std::string number(double value)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "%.3f", value);
+    return text;
+}
+
+const char* compiler()
+{
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc";
+#else
+    return "unknown";
+#endif
+}
+
+// One object per run: what ran where, every number and every check, so runs
+// from different releases can be diffed
+bool writeJson(const char* path, const std::vector<const Bench::Case*>& ran)
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+        return false;
+
+    char stamp[32];
+    const time_t now = time(nullptr);
+    struct tm utc;
+#if defined(_WIN32)
+    gmtime_s(&utc, &now);
+#else
+    gmtime_r(&now, &utc);
+#endif
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", &utc);
+
+    file << "{\n";
+    file << "  \"timestamp\": " << quoted(stamp) << ",\n";
+    file << "  \"compiler\": " << quoted(compiler()) << ",\n";
+    file << "  \"isa\": " << quoted(BatchMapping::isaName(BatchMapping::detectIsa())) << ",\n";
+    file << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+    file << "  \"failures\": " << Bench::failures() << ",\n";
+    file << "  \"cases\": [";
+
+    for (size_t c = 0; c < ran.size(); c++)
+    {
+        const auto& name = ran[c]->name;
+        file << (c ? ",\n" : "\n") << "    {\n      \"name\": " << quoted(name) << ",\n      \"results\": [";
+
+        bool first = true;
+        for (const auto& result : Bench::results())
+        {
+            if (result.benchCase != name)
+                continue;
+            file << (first ? "\n" : ",\n") << "        { \"name\": " << quoted(result.name);
+            if (result.latency)
+                file << ", \"p50_us\": " << number(result.p50Us) << ", \"p99_us\": " << number(result.p99Us) << ", \"max_us\": " << number(result.maxUs);
+            else
+                file << ", \"ns_per_op\": " << number(result.nsPerOp);
+            file << " }";
+            first = false;
+        }
+        file << (first ? "],\n" : "\n      ],\n") << "      \"checks\": [";
+
+        first = true;
+        for (const auto& check : Bench::checks())
+        {
+            if (check.benchCase != name)
+                continue;
+            file << (first ? "\n" : ",\n") << "        { \"name\": " << quoted(check.what) << ", \"passed\": " << (check.passed ? "true" : "false") << " }";
+            first = false;
+        }
+        file << (first ? "]\n" : "\n      ]\n") << "    }";
+    }
+    file << (ran.empty() ? "]\n" : "\n  ]\n") << "}\n";
+    return static_cast<bool>(file);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    // n64-bench [--json <file>] [filter]
+    // Optional substring filter on case names. Slow cases need an exact match.
+    const char* filter   = nullptr;
+    const char* jsonPath = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+            filter = argv[i];
+    }
+
+    std::vector<const Bench::Case*> ran;
+    for (const auto& benchCase : Bench::registry())
+    {
+        if (filter && !strstr(benchCase.name.c_str(), filter))
+            continue;
+        if (benchCase.slow && (!filter || benchCase.name != filter))
+            continue;
+        printf("== %s\n", benchCase.name.c_str());
+        Bench::currentCase() = benchCase.name;
+        benchCase.run();
+        ran.push_back(&benchCase);
+    }
+
+    if (jsonPath && !writeJson(jsonPath, ran))
+    {
+        printf("Failed to write %s\n", jsonPath);
+        return 1;
+    }
+
+    return Bench::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,342 @@
+#include "DInputBackend.h"
+#include "core/DeviceDescriptors.h"
+#include "core/EventReplay.h"
+#include "core/Log.h"
+#include "DInputDeviceSource.h"
+#include "DInputWrapper.h"
+#include "Utils.h"
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Custom data formats
+//
+//  One per supported pad, generated from its descriptor: the hat, the four
+//  axes for pads with sticks, and 16 buttons with the slots the pad doesn't
+//  report marked optional, all at their N64ControllerState offsets.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+template <typename Pad>
+struct PadFormat
+{
+    static constexpr DWORD kObjects = 1 + (Pad::kSticks ? 4 : 0) + 16;
+
+    static constexpr std::array<DIOBJECTDATAFORMAT, kObjects> objects()
+    {
+        std::array<DIOBJECTDATAFORMAT, kObjects> out {};
+        size_t next = 0;
+        out[next++] = { &GUID_POV, static_cast<DWORD>(offsetof(N64ControllerState, dpad)), DIDFT_POV | DIDFT_ANYINSTANCE, 0 };
+        if constexpr (Pad::kSticks)
+        {
+            out[next++] = { &GUID_XAxis,  static_cast<DWORD>(offsetof(N64ControllerState, xAxis)),     DIDFT_ABSAXIS | DIDFT_ANYINSTANCE, 0 };
+            out[next++] = { &GUID_YAxis,  static_cast<DWORD>(offsetof(N64ControllerState, yAxis)),     DIDFT_ABSAXIS | DIDFT_ANYINSTANCE, 0 };
+            out[next++] = { &GUID_RxAxis, static_cast<DWORD>(offsetof(N64ControllerState, xRotation)), DIDFT_ABSAXIS | DIDFT_ANYINSTANCE, 0 };
+            out[next++] = { &GUID_RyAxis, static_cast<DWORD>(offsetof(N64ControllerState, yRotation)), DIDFT_ABSAXIS | DIDFT_ANYINSTANCE, 0 };
+        }
+        for (DWORD i = 0; i < 16; i++)
+        {
+            const DWORD optional = (Pad::kButtons & (1u << i)) ? 0 : DIDFT_OPTIONAL;
+            out[next++] = { nullptr, static_cast<DWORD>(offsetof(N64ControllerState, buttons) + i), DIDFT_PSHBUTTON | DIDFT_ANYINSTANCE | optional, 0 };
+        }
+        return out;
+    }
+
+    // DIDATAFORMAT points at mutable objects
+    static inline std::array<DIOBJECTDATAFORMAT, kObjects> sObjects = objects();
+    static inline DIDATAFORMAT sFormat =
+    {
+        sizeof(DIDATAFORMAT),
+        sizeof(DIOBJECTDATAFORMAT),
+        DIDF_ABSAXIS,
+        sizeof(N64ControllerState),
+        kObjects,
+        sObjects.data()
+    };
+};
+
+template <typename... Pads>
+LPCDIDATAFORMAT dataFormat(const DeviceType& type, PadList<Pads...>)
+{
+    LPCDIDATAFORMAT format = nullptr;
+    ((format = (!format && type.productId == Pads::kProductId) ? &PadFormat<Pads>::sFormat : format), ...);
+    return format;
+}
+
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Source
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+class DInputSource : public InputSource
+{
+public:
+    ~DInputSource() override
+    {
+        if (device_)
+        {
+            DInput::DeviceUnacquire(device_);
+            DInput::DeviceRelease(device_);
+        }
+        if (dataAvailableEvent_)
+            CloseHandle(dataAvailableEvent_);
+    }
+
+    bool init(LPDIRECTINPUT8 dinput, const GUID& id, uint32_t bufferSize)
+    {
+        auto checkDeviceOp = [](HRESULT hr) -> bool
+        {
+            if (hr == DI_OK)
+                return true;
+            Log::error("Error: %s", Utils::ErrToString(hr).c_str());
+            return false;
+        };
+
+        if (DInput::CreateDevice(dinput, id, &device_, nullptr) != DI_OK)
+        {
+            device_ = nullptr;
+            return false;
+        }
+
+        // Which pad it is decides the data format
+        DIDEVICEINSTANCEA instance {};
+        instance.dwSize = sizeof(instance);
+        if (!checkDeviceOp(DInput::DeviceGetDeviceInfo(device_, &instance)))
+            return false;
+        DeviceGuid product;
+        memcpy(&product, &instance.guidProduct, sizeof(product));
+        if (const auto type = DeviceTypes::find(product))
+            type_ = type;
+
+        if (!checkDeviceOp(DInput::DeviceSetDataFormat(device_, dataFormat(*type_, SupportedPads{}))))
+            return false;
+
+        dataAvailableEvent_ = CreateEvent(
+            nullptr, // default security attributes
+            false,   // automatically reset event
+            false,   // initial state is nonsignaled
+            nullptr  // object name
+        );
+
+        if (!checkDeviceOp(DInput::DeviceSetEventNotification(device_, dataAvailableEvent_)))
+            return false;
+
+        if (bufferSize > 0)
+        {
+            DIPROPDWORD property;
+            property.diph.dwSize       = sizeof(DIPROPDWORD);
+            property.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+            property.diph.dwObj        = 0;
+            property.diph.dwHow        = DIPH_DEVICE;
+            property.dwData            = bufferSize;
+            if (!checkDeviceOp(DInput::DeviceSetProperty(device_, DIPROP_BUFFERSIZE, &property.diph)))
+                return false;
+            buffered_ = true;
+        }
+
+        if (!checkDeviceOp(DInput::DeviceAcquire(device_)))
+            return false;
+
+        // Replay starts from the state the pad is in when the queue starts
+        if (buffered_)
+            resync();
+        return true;
+    }
+
+    EventHandle handle() const override
+    {
+        return reinterpret_cast<EventHandle>(dataAvailableEvent_);
+    }
+
+    const DeviceType& type() const override
+    {
+        return *type_;
+    }
+
+    bool read(N64ControllerState& state) override
+    {
+        HRESULT hr = DInput::DeviceGetDeviceState(device_, sizeof(N64ControllerState), &state);
+        if (reacquire(hr))
+            hr = DInput::DeviceGetDeviceState(device_, sizeof(N64ControllerState), &state);
+        if (hr == DI_OK)
+            return true;
+
+        Log::error("Failed to read device state: %s", Utils::ErrToString(hr).c_str());
+        return false;
+    }
+
+    bool readBatch(InputBatch& batch) override
+    {
+        if (!buffered_)
+        {
+            const bool result = InputSource::readBatch(batch);
+            batch.reacquired |= std::exchange(reacquired_, false);
+            return result;
+        }
+
+        // One state is kept free for the resync after an overflow
+        static constexpr DWORD kEvents = InputBatch::kCapacity - 1;
+        DIDEVICEOBJECTDATA data[kEvents];
+        DWORD count = kEvents;
+        HRESULT hr = DInput::DeviceGetDeviceData(device_, sizeof(DIDEVICEOBJECTDATA), data, &count, 0);
+
+        // The queue didn't survive losing the device; continue from a
+        // snapshot like after an overflow
+        if (reacquire(hr))
+        {
+            count = 0;
+            hr    = DI_BUFFEROVERFLOW;
+            batch.reacquired = true;
+            reacquired_      = false;
+        }
+        if (hr != DI_OK && hr != DI_BUFFEROVERFLOW)
+        {
+            Log::error("Failed to read device data: %s", Utils::ErrToString(hr).c_str());
+            return false;
+        }
+
+        InputEvent events[kEvents];
+        for (DWORD i = 0; i < count; i++)
+            events[i] = { data[i].dwOfs, static_cast<int32_t>(data[i].dwData), data[i].dwSequence };
+        batch.count = replay_.replay(events, count, batch.states);
+        batch.more  = count == kEvents;
+
+        // Input was lost: drop the rest of the queue and continue from a snapshot
+        batch.overflowed = hr == DI_BUFFEROVERFLOW;
+        if (batch.overflowed)
+        {
+            DWORD flush = INFINITE;
+            DInput::DeviceGetDeviceData(device_, sizeof(DIDEVICEOBJECTDATA), nullptr, &flush, 0);
+            if (!resync())
+                return false;
+            batch.states[batch.count++] = replay_.state();
+            batch.more = false;
+        }
+        return true;
+    }
+
+    bool recover() override
+    {
+        // S_FALSE: still acquired, the failure was something else
+        if (FAILED(DInput::DeviceAcquire(device_)))
+            return false;
+
+        // The queue didn't survive; continue from a snapshot
+        if (buffered_)
+        {
+            DWORD flush = INFINITE;
+            DInput::DeviceGetDeviceData(device_, sizeof(DIDEVICEOBJECTDATA), nullptr, &flush, 0);
+        }
+        N64ControllerState state;
+        if (DInput::DeviceGetDeviceState(device_, sizeof(N64ControllerState), &state) != DI_OK)
+            return false;
+        replay_.reset(state);
+        reacquired_ = false;
+        return true;
+    }
+
+private:
+    // Another app or a focus change took the device away; take it back
+    bool reacquire(HRESULT hr)
+    {
+        if (hr != DIERR_INPUTLOST && hr != DIERR_NOTACQUIRED)
+            return false;
+        if (DInput::DeviceAcquire(device_) != DI_OK)
+            return false;
+        reacquired_ = true;
+        return true;
+    }
+
+    bool resync()
+    {
+        N64ControllerState state;
+        if (!read(state))
+            return false;
+        replay_.reset(state);
+        return true;
+    }
+
+private:
+    LPDIRECTINPUTDEVICE8A device_ { nullptr };
+    const DeviceType*     type_ { &DeviceTypes::n64() };
+    HANDLE                dataAvailableEvent_ { nullptr };
+    bool                  buffered_ { false };
+    bool                  reacquired_ { false };
+    EventReplay           replay_;
+};
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Backend
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct DInputBackend::Impl
+{
+    LPDIRECTINPUT8                      dinput { nullptr };
+    std::unique_ptr<DInputDeviceSource> devices;
+    uint32_t                            bufferSize { 0 };
+};
+
+DInputBackend::DInputBackend()
+    : impl_(new Impl)
+{   }
+
+DInputBackend::~DInputBackend()
+{
+    impl_->devices.reset();
+    if (impl_->dinput)
+        DInput::Release(impl_->dinput);
+}
+
+std::unique_ptr<DInputBackend> DInputBackend::create(uint32_t bufferSize)
+{
+    std::unique_ptr<DInputBackend> backend(new DInputBackend());
+    if (!backend->init(bufferSize))
+        return nullptr;
+    return backend;
+}
+
+bool DInputBackend::init(uint32_t bufferSize)
+{
+    impl_->bufferSize = bufferSize;
+    if (DInput::Create(GetModuleHandle(0), DIRECTINPUT_VERSION, IID_IDirectInput8A, reinterpret_cast<LPVOID*>(&impl_->dinput), nullptr) != DI_OK)
+    {
+        impl_->dinput = nullptr;
+        Log::error("Failed to create direct input interface");
+        return false;
+    }
+
+    impl_->devices = std::make_unique<DInputDeviceSource>(impl_->dinput);
+    return true;
+}
+
+DeviceSource& DInputBackend::devices()
+{
+    return *impl_->devices;
+}
+
+std::unique_ptr<InputSource> DInputBackend::open(const DeviceGuid& id)
+{
+    std::unique_ptr<DInputSource> source(new DInputSource());
+    if (!source->init(impl_->dinput, Utils::ToGuid(id), impl_->bufferSize))
+        return nullptr;
+    return source;
+}
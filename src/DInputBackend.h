@@ -0,0 +1,42 @@
+#pragma once
+
+#include "core/InputSource.h"
+
+#include <cstdint>
+#include <memory>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  DirectInput input backend
+//
+//  Wireless N64 pads through DirectInput, with hotplug from device interface
+//  notifications (DInputDeviceSource). Each source reads with
+//  GetDeviceState into the custom N64ControllerState data format and is
+//  woken by DirectInput's event notification.
+//
+//  With a buffer size, sources instead drain the device's event queue with
+//  GetDeviceData and replay every transition (EventReplay), so taps shorter
+//  than a wakeup still reach the virtual pad.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class DInputBackend : public InputBackend
+{
+public:
+    ~DInputBackend() override;
+
+    // nullptr when DirectInput can't be created. bufferSize is the number
+    // of events each device queues between reads, 0 = snapshot reads.
+    static std::unique_ptr<DInputBackend> create(uint32_t bufferSize = 0);
+
+    DeviceSource& devices() override;
+    std::unique_ptr<InputSource> open(const DeviceGuid& id) override;
+
+private:
+    DInputBackend();
+    bool init(uint32_t bufferSize);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
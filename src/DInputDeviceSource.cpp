@@ -0,0 +1,180 @@
+#include "DInputDeviceSource.h"
+#include "core/DeviceDescriptors.h"
+#include "core/Log.h"
+#include "DInputWrapper.h"
+
+#include <Windows.h>
+#include <Dbt.h>
+
+#include <algorithm>
+#include <future>
+#include <thread>
+
+namespace
+{
+
+// {4D1E55B2-F16F-11CF-88CB-001111000030}, from hidclass.h
+const GUID kHidInterfaceClass = { 0x4d1e55b2, 0xf16f, 0x11cf, { 0x88, 0xcb, 0x00, 0x11, 0x11, 0x00, 0x00, 0x30 } };
+
+const wchar_t* kWindowClass = L"N64DeviceNotifications";
+
+BOOL CALLBACK enumerateDevice(LPCDIDEVICEINSTANCE device, LPVOID pvRef)
+{
+    // Skip controllers that aren't one of the supported pads
+    DeviceGuid product;
+    memcpy(&product, &device->guidProduct, sizeof(product));
+    if (!DeviceTypes::find(product))
+        return DIENUM_CONTINUE;
+
+    DeviceGuid id;
+    memcpy(&id, &device->guidInstance, sizeof(id));
+    reinterpret_cast<std::vector<DeviceGuid>*>(pvRef)->push_back(id);
+    return DIENUM_CONTINUE;
+}
+
+}
+
+struct DInputDeviceSource::Impl
+{
+    LPDIRECTINPUT8 dinput;
+    HANDLE         changeEvent { nullptr };
+    HANDLE         wakeEvent { nullptr };
+    HWND           window { nullptr };
+    std::thread    windowThread;
+
+    ~Impl();
+    void init();
+    void runWindow(std::promise<HWND>& ready);
+
+    static LRESULT CALLBACK windowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+};
+
+DInputDeviceSource::Impl::~Impl()
+{
+    if (window)
+        PostMessageW(window, WM_CLOSE, 0, 0);
+    if (windowThread.joinable())
+        windowThread.join();
+    if (changeEvent)
+        CloseHandle(changeEvent);
+    if (wakeEvent)
+        CloseHandle(wakeEvent);
+}
+
+void DInputDeviceSource::Impl::init()
+{
+    changeEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    wakeEvent   = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (!changeEvent || !wakeEvent)
+        return;
+
+    std::promise<HWND> ready;
+    auto created = ready.get_future();
+    windowThread = std::thread([this, &ready]{ runWindow(ready); });
+    window = created.get();
+    if (!window)
+    {
+        windowThread.join();
+        Log::warning("Device notifications unavailable, polling only");
+    }
+}
+
+void DInputDeviceSource::Impl::runWindow(std::promise<HWND>& ready)
+{
+    const auto instance = GetModuleHandleW(nullptr);
+
+    WNDCLASSEXW windowClass = {};
+    windowClass.cbSize        = sizeof(windowClass);
+    windowClass.lpfnWndProc   = windowProc;
+    windowClass.hInstance     = instance;
+    windowClass.lpszClassName = kWindowClass;
+    RegisterClassExW(&windowClass);
+
+    HWND hwnd = CreateWindowExW(0, kWindowClass, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, instance, nullptr);
+    if (!hwnd)
+    {
+        ready.set_value(nullptr);
+        return;
+    }
+    SetWindowLongPtrW(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+
+    DEV_BROADCAST_DEVICEINTERFACE_W filter = {};
+    filter.dbcc_size       = sizeof(filter);
+    filter.dbcc_devicetype = DBT_DEVTYP_DEVICEINTERFACE;
+    filter.dbcc_classguid  = kHidInterfaceClass;
+    const auto notification = RegisterDeviceNotificationW(hwnd, &filter, DEVICE_NOTIFY_WINDOW_HANDLE);
+    if (!notification)
+    {
+        DestroyWindow(hwnd);
+        ready.set_value(nullptr);
+        return;
+    }
+    ready.set_value(hwnd);
+
+    MSG msg;
+    while (GetMessageW(&msg, nullptr, 0, 0) > 0)
+    {
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
+    }
+
+    UnregisterDeviceNotification(notification);
+}
+
+LRESULT CALLBACK DInputDeviceSource::Impl::windowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+    auto impl = reinterpret_cast<Impl*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+    switch (msg)
+    {
+    case WM_DEVICECHANGE:
+        if (impl && (wParam == DBT_DEVICEARRIVAL || wParam == DBT_DEVICEREMOVECOMPLETE || wParam == DBT_DEVNODES_CHANGED))
+            SetEvent(impl->changeEvent);
+        return TRUE;
+    case WM_CLOSE:
+        DestroyWindow(hwnd);
+        return 0;
+    case WM_DESTROY:
+        PostQuitMessage(0);
+        return 0;
+    }
+    return DefWindowProcW(hwnd, msg, wParam, lParam);
+}
+
+/////////////////////////////////////////////////////////////////////
+
+DInputDeviceSource::DInputDeviceSource(LPDIRECTINPUT8 dinput)
+    : impl_(new Impl)
+{
+    impl_->dinput = dinput;
+    impl_->init();
+}
+
+DInputDeviceSource::~DInputDeviceSource() = default;
+
+bool DInputDeviceSource::notificationsEnabled() const
+{
+    return impl_->window != nullptr;
+}
+
+void DInputDeviceSource::enumerate(std::vector<DeviceGuid>& out)
+{
+    DInput::EnumDevices(impl_->dinput, DI8DEVCLASS_GAMECTRL, enumerateDevice, &out, DIEDFL_ATTACHEDONLY);
+}
+
+bool DInputDeviceSource::waitForChange(uint32_t timeoutMs)
+{
+    if (!impl_->changeEvent || !impl_->wakeEvent)
+    {
+        Sleep((std::min)(timeoutMs, 100u));
+        return false;
+    }
+
+    const HANDLE handles[] = { impl_->changeEvent, impl_->wakeEvent };
+    return WaitForMultipleObjects(2, handles, FALSE, timeoutMs == kWaitForever ? INFINITE : timeoutMs) == WAIT_OBJECT_0;
+}
+
+void DInputDeviceSource::wake()
+{
+    if (impl_->wakeEvent)
+        SetEvent(impl_->wakeEvent);
+}
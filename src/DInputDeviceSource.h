@@ -0,0 +1,37 @@
+#pragma once
+
+#define DIRECTINPUT_VERSION 0x0800
+#include <dinput.h>
+
+#include "core/DeviceSource.h"
+
+#include <memory>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  DirectInput device source
+//
+//  Enumerates attached wireless N64 pads and signals changes from HID device
+//  interface arrival / removal notifications, received on a message-only
+//  window serviced by its own thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class DInputDeviceSource : public DeviceSource
+{
+public:
+    explicit DInputDeviceSource(LPDIRECTINPUT8 dinput);
+    ~DInputDeviceSource() override;
+
+    // False when the notification window could not be set up; the detector
+    // then only has its fallback poll
+    bool notificationsEnabled() const;
+
+    void enumerate(std::vector<DeviceGuid>& out) override;
+    bool waitForChange(uint32_t timeoutMs) override;
+    void wake() override;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
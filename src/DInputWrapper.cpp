@@ -1,6 +1,6 @@
 #include "DInputWrapper.h"
 
-std::mutex DInput::sMutex;
+DeviceLocks DInput::sLocks;
 
 HRESULT DInput::Create(
         HINSTANCE hinst,
@@ -10,54 +10,80 @@ HRESULT DInput::Create(
         LPUNKNOWN pUnkOuter
     )
 {
-    std::lock_guard<std::mutex> lock(sMutex);
+    std::lock_guard<std::mutex> lock(sLocks.global());
     return DirectInput8Create(hinst, dwVersion, riidltf, ppvOut, pUnkOuter);
 }
 
 HRESULT DInput::Release(LPDIRECTINPUT8 dinput)
 {
-    std::lock_guard<std::mutex> lock(sMutex);
+    std::lock_guard<std::mutex> lock(sLocks.global());
     return dinput->Release();
 }
 
+HRESULT DInput::EnumDevices(LPDIRECTINPUT8 dinput, DWORD dwDevType, LPDIENUMDEVICESCALLBACK lpCallback, LPVOID pvRef, DWORD dwFlags)
+{
+    std::lock_guard<std::mutex> lock(sLocks.global());
+    return dinput->EnumDevices(dwDevType, lpCallback, pvRef, dwFlags);
+}
+
 HRESULT DInput::CreateDevice(LPDIRECTINPUT8 dinput, REFGUID rguid, LPDIRECTINPUTDEVICE8A* lplpDirectInputDevice, LPUNKNOWN pUnkOuter)
 {
-    std::lock_guard<std::mutex> lock(sMutex);
+    std::lock_guard<std::mutex> lock(sLocks.global());
     return dinput->CreateDevice(rguid, lplpDirectInputDevice, pUnkOuter);
 }
 
+HRESULT DInput::DeviceGetDeviceInfo(LPDIRECTINPUTDEVICE8A device, LPDIDEVICEINSTANCEA pdidi)
+{
+    LifecycleLock lock(sLocks, device);
+    return device->GetDeviceInfo(pdidi);
+}
+
 HRESULT DInput::DeviceSetDataFormat(LPDIRECTINPUTDEVICE8A device, LPCDIDATAFORMAT lpdf)
 {
-    std::lock_guard<std::mutex> lock(sMutex);
+    LifecycleLock lock(sLocks, device);
     return device->SetDataFormat(lpdf);
 }
 
 HRESULT DInput::DeviceSetEventNotification(LPDIRECTINPUTDEVICE8A device, HANDLE hEvent)
 {
-    std::lock_guard<std::mutex> lock(sMutex);
+    LifecycleLock lock(sLocks, device);
     return device->SetEventNotification(hEvent);
 }
 
+HRESULT DInput::DeviceSetProperty(LPDIRECTINPUTDEVICE8A device, REFGUID rguidProp, LPCDIPROPHEADER pdiph)
+{
+    LifecycleLock lock(sLocks, device);
+    return device->SetProperty(rguidProp, pdiph);
+}
+
 HRESULT DInput::DeviceGetDeviceState(LPDIRECTINPUTDEVICE8A device, DWORD cbData, LPVOID lpvData)
 {
-    std::lock_guard<std::mutex> lock(sMutex);
+    // Hot path: only this device's lock
+    std::lock_guard<std::mutex> lock(sLocks.forDevice(device));
     return device->GetDeviceState(cbData, lpvData);
 }
 
+HRESULT DInput::DeviceGetDeviceData(LPDIRECTINPUTDEVICE8A device, DWORD cbObjectData, LPDIDEVICEOBJECTDATA rgdod, LPDWORD pdwInOut, DWORD dwFlags)
+{
+    // Hot path: only this device's lock
+    std::lock_guard<std::mutex> lock(sLocks.forDevice(device));
+    return device->GetDeviceData(cbObjectData, rgdod, pdwInOut, dwFlags);
+}
+
 HRESULT DInput::DeviceAcquire(LPDIRECTINPUTDEVICE8A device)
 {
-    std::lock_guard<std::mutex> lock(sMutex);
+    LifecycleLock lock(sLocks, device);
     return device->Acquire();
 }
 
 HRESULT DInput::DeviceUnacquire(LPDIRECTINPUTDEVICE8A device)
 {
-    std::lock_guard<std::mutex> lock(sMutex);
+    LifecycleLock lock(sLocks, device);
     return device->Unacquire();
 }
 
 HRESULT DInput::DeviceRelease(LPDIRECTINPUTDEVICE8A device)
 {
-    std::lock_guard<std::mutex> lock(sMutex);
+    LifecycleLock lock(sLocks, device);
     return device->Release();
 }
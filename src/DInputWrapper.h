@@ -3,7 +3,7 @@
 #define DIRECTINPUT_VERSION 0x0800
 #include <dinput.h>
 
-#include <mutex>
+#include "core/DeviceLocks.h"
 
 class DInput
 {
@@ -17,14 +17,18 @@ public:
     );
     static HRESULT Release(LPDIRECTINPUT8 dinput);
 
+    static HRESULT EnumDevices(LPDIRECTINPUT8 dinput, DWORD dwDevType, LPDIENUMDEVICESCALLBACK lpCallback, LPVOID pvRef, DWORD dwFlags);
     static HRESULT CreateDevice(LPDIRECTINPUT8 dinput, REFGUID rguid, LPDIRECTINPUTDEVICE8A* lplpDirectInputDevice, LPUNKNOWN pUnkOuter);
+    static HRESULT DeviceGetDeviceInfo(LPDIRECTINPUTDEVICE8A device, LPDIDEVICEINSTANCEA pdidi);
     static HRESULT DeviceSetDataFormat(LPDIRECTINPUTDEVICE8A device, LPCDIDATAFORMAT lpdf);
     static HRESULT DeviceSetEventNotification(LPDIRECTINPUTDEVICE8A device, HANDLE hEvent);
+    static HRESULT DeviceSetProperty(LPDIRECTINPUTDEVICE8A device, REFGUID rguidProp, LPCDIPROPHEADER pdiph);
     static HRESULT DeviceGetDeviceState(LPDIRECTINPUTDEVICE8A device, DWORD cbData, LPVOID lpvData);
+    static HRESULT DeviceGetDeviceData(LPDIRECTINPUTDEVICE8A device, DWORD cbObjectData, LPDIDEVICEOBJECTDATA rgdod, LPDWORD pdwInOut, DWORD dwFlags);
     static HRESULT DeviceAcquire(LPDIRECTINPUTDEVICE8A device);
     static HRESULT DeviceUnacquire(LPDIRECTINPUTDEVICE8A device);
     static HRESULT DeviceRelease(LPDIRECTINPUTDEVICE8A device);
 
 private:
-    static std::mutex sMutex;
+    static DeviceLocks sLocks;
 };
\ No newline at end of file
@@ -3,30 +3,26 @@
 #include <comdef.h>
 #include <atlstr.h>
 
+#include <cstring>
+
+static_assert(sizeof(GUID) == sizeof(DeviceGuid), "DeviceGuid must mirror GUID");
+
 std::string Utils::ErrToString(HRESULT hr)
 {
     _com_error err(hr);
     return std::string(CT2A(err.ErrorMessage()));
 }
 
-GUID Utils::StringToGuid(const std::string& str)
+GUID Utils::ToGuid(const DeviceGuid& id)
 {
     GUID guid;
-    sscanf(str.c_str(),
-           "%8x-%4hx-%4hx-%2hhx%2hhx-%2hhx%2hhx%2hhx%2hhx%2hhx%2hhx",
-           &guid.Data1, &guid.Data2, &guid.Data3,
-           &guid.Data4[0], &guid.Data4[1], &guid.Data4[2], &guid.Data4[3],
-           &guid.Data4[4], &guid.Data4[5], &guid.Data4[6], &guid.Data4[7] );
+    memcpy(&guid, &id, sizeof(guid));
     return guid;
 }
 
-std::string Utils::GuidToString(GUID guid)
+DeviceGuid Utils::FromGuid(const GUID& guid)
 {
-    char guid_cstr[39];
-    snprintf(guid_cstr, sizeof(guid_cstr),
-             "%08x-%04x-%04x-%02x%02x-%02x%02x%02x%02x%02x%02x",
-             guid.Data1, guid.Data2, guid.Data3,
-             guid.Data4[0], guid.Data4[1], guid.Data4[2], guid.Data4[3],
-             guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7]);
-    return std::string(guid_cstr);
+    DeviceGuid id;
+    memcpy(&id, &guid, sizeof(id));
+    return id;
 }
@@ -3,13 +3,15 @@
 #include <Guiddef.h>
 #include <Winerror.h>
 
+#include "core/DeviceGuid.h"
+
 #include <string>
 
 namespace Utils
 {
 
 std::string ErrToString(HRESULT hr);
-GUID        StringToGuid(const std::string& str);
-std::string GuidToString(GUID guid);
+GUID        ToGuid(const DeviceGuid& id);
+DeviceGuid  FromGuid(const GUID& guid);
 
 };
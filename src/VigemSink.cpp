@@ -0,0 +1,104 @@
+#include "VigemSink.h"
+#include "VigemWrapper.h"
+#include "core/Log.h"
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+static_assert(sizeof(XUSB_REPORT) == sizeof(XusbReport), "XusbReport must mirror XUSB_REPORT");
+
+namespace
+{
+
+class VigemPadSink : public PadSink
+{
+public:
+    VigemPadSink(PVIGEM_CLIENT client, PVIGEM_TARGET pad)
+        : client_(client)
+        , pad_(pad)
+    {   }
+
+    ~VigemPadSink() override
+    {
+        Vigem::target_remove(client_, pad_);
+        Vigem::target_free(pad_);
+    }
+
+    void submit(const XusbReport& report) override
+    {
+        XUSB_REPORT x360Report;
+        std::memcpy(&x360Report, &report, sizeof(XUSB_REPORT));
+        Vigem::target_x360_update(client_, pad_, x360Report);
+    }
+
+private:
+    PVIGEM_CLIENT client_;
+    PVIGEM_TARGET pad_;
+};
+
+}
+
+struct VigemSinkBackend::Impl
+{
+    std::vector<PVIGEM_CLIENT> clients;
+    std::atomic<size_t>        nextClient { 0 };
+};
+
+VigemSinkBackend::VigemSinkBackend()
+    : impl_(new Impl)
+{   }
+
+VigemSinkBackend::~VigemSinkBackend()
+{
+    for (const auto client : impl_->clients)
+    {
+        Vigem::disconnect(client);
+        Vigem::free(client);
+    }
+}
+
+std::unique_ptr<VigemSinkBackend> VigemSinkBackend::create(uint32_t connections)
+{
+    std::unique_ptr<VigemSinkBackend> backend(new VigemSinkBackend());
+    if (!backend->init(connections))
+        return nullptr;
+    return backend;
+}
+
+bool VigemSinkBackend::init(uint32_t connections)
+{
+    for (uint32_t i = 0; i < connections; i++)
+    {
+        const auto client = Vigem::alloc();
+        if (client == nullptr)
+        {
+            Log::error("Unable to allocate vigem client");
+            return false;
+        }
+
+        const auto connectResult = Vigem::connect(client);
+        if (!VIGEM_SUCCESS(connectResult))
+        {
+            Log::error("ViGEm Bus connection failed with error code: 0x%x", static_cast<unsigned>(connectResult));
+            Vigem::free(client);
+            return false;
+        }
+        impl_->clients.push_back(client);
+    }
+    return true;
+}
+
+std::unique_ptr<PadSink> VigemSinkBackend::plug()
+{
+    const auto client = impl_->clients[impl_->nextClient++ % impl_->clients.size()];
+    const auto pad    = Vigem::target_x360_alloc();
+    const auto pir    = Vigem::target_add(client, pad);
+    if (!VIGEM_SUCCESS(pir))
+    {
+        Log::error("Target plugin failed with error code: 0x%x", static_cast<unsigned>(pir));
+        Vigem::target_free(pad);
+        return nullptr;
+    }
+    return std::unique_ptr<PadSink>(new VigemPadSink(client, pad));
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "core/PadSink.h"
+
+#include <cstdint>
+#include <memory>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  ViGEm sink backend
+//
+//  Virtual X360 pads on the ViGEm bus. Pads are spread round robin over
+//  several bus connections, since each connection serializes its own IOCTLs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class VigemSinkBackend : public SinkBackend
+{
+public:
+    ~VigemSinkBackend() override;
+
+    // nullptr when a bus connection fails
+    static std::unique_ptr<VigemSinkBackend> create(uint32_t connections);
+
+    std::unique_ptr<PadSink> plug() override;
+
+private:
+    VigemSinkBackend();
+    bool init(uint32_t connections);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
@@ -5,7 +5,7 @@
 
 #include <ViGEm/Client.h>
 
-#include <mutex>
+#include "core/DeviceLocks.h"
 
 class Vigem
 {
@@ -22,5 +22,5 @@ public:
     static VIGEM_ERROR   target_x360_update(PVIGEM_CLIENT vigem, PVIGEM_TARGET target, XUSB_REPORT report);
 
 private:
-    static std::mutex sMutex;
+    static DeviceLocks sLocks;
 };
\ No newline at end of file
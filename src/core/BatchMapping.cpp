@@ -0,0 +1,94 @@
+#include "BatchMapping.h"
+
+#if N64_BATCH_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+
+#if N64_BATCH_X86
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    // AVX2 also needs the OS to save the upper YMM state
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx     = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+using Kernel = void (*)(const MappingTables&, const N64StateBatch&, size_t, size_t, XusbReport*);
+
+Kernel kernelFor(BatchMapping::Isa isa)
+{
+    switch (isa)
+    {
+#if N64_BATCH_X86
+    case BatchMapping::Isa::Avx2: return BatchMapping::convertAvx2;
+    case BatchMapping::Isa::Sse2: return BatchMapping::convertSse2;
+#endif
+    default:                      return BatchMapping::convertScalar;
+    }
+}
+
+}
+
+const char* BatchMapping::isaName(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::Avx2: return "avx2";
+    case Isa::Sse2: return "sse2";
+    default:        return "scalar";
+    }
+}
+
+BatchMapping::Isa BatchMapping::detectIsa()
+{
+    static const Isa isa = []
+    {
+#if N64_BATCH_X86
+        return cpuHasAvx2() ? Isa::Avx2 : Isa::Sse2;
+#else
+        return Isa::Scalar;
+#endif
+    }();
+    return isa;
+}
+
+bool BatchMapping::isSupported(Isa isa)
+{
+    return static_cast<int>(isa) <= static_cast<int>(detectIsa());
+}
+
+void BatchMapping::convert(const MappingTables& tables, const N64StateBatch& batch, XusbReport* reports)
+{
+    static const Kernel kernel = kernelFor(detectIsa());
+    kernel(tables, batch, 0, batch.size(), reports);
+}
+
+void BatchMapping::convert(Isa isa, const MappingTables& tables, const N64StateBatch& batch, XusbReport* reports)
+{
+    kernelFor(isa)(tables, batch, 0, batch.size(), reports);
+}
+
+void BatchMapping::convertScalar(const MappingTables& tables, const N64StateBatch& batch, size_t begin, size_t end, XusbReport* reports)
+{
+    for (size_t i = begin; i < end; i++)
+        tables.convert(batch.xAxis[i], batch.yAxis[i], batch.dpad[i], batch.pressed[i], reports[i]);
+}
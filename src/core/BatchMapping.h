@@ -0,0 +1,73 @@
+#pragma once
+
+#include "MappingTables.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Batched conversion
+//
+//  Converts many pad states in one pass. States are kept as structure of
+//  arrays so the SIMD kernels can load 4 (SSE2) or 8 (AVX2) pads per
+//  instruction. The kernel is picked once at runtime from the CPU features;
+//  every kernel produces the same reports as MappingTables::convert.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct N64StateBatch
+{
+    std::vector<int32_t>  xAxis;
+    std::vector<int32_t>  yAxis;
+    std::vector<int32_t>  dpad;
+    std::vector<uint16_t> pressed; // MappingTables::pressedMask of each state
+
+    size_t size() const { return xAxis.size(); }
+
+    void resize(size_t count)
+    {
+        xAxis.resize(count);
+        yAxis.resize(count);
+        dpad.resize(count);
+        pressed.resize(count);
+    }
+
+    void set(size_t index, const N64ControllerState& state)
+    {
+        xAxis[index]   = state.xAxis;
+        yAxis[index]   = state.yAxis;
+        dpad[index]    = state.dpad;
+        pressed[index] = MappingTables::pressedMask(state);
+    }
+};
+
+namespace BatchMapping
+{
+
+enum class Isa
+{
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+const char* isaName(Isa isa);
+
+// Best kernel supported by this CPU (and this build)
+Isa detectIsa();
+bool isSupported(Isa isa);
+
+// Converts batch.size() states into reports[0..size) with the detected kernel
+void convert(const MappingTables& tables, const N64StateBatch& batch, XusbReport* reports);
+
+// Same with an explicit kernel; isa must be supported
+void convert(Isa isa, const MappingTables& tables, const N64StateBatch& batch, XusbReport* reports);
+
+// Kernels, exposed for the dispatcher. Each converts [begin, end).
+void convertScalar(const MappingTables& tables, const N64StateBatch& batch, size_t begin, size_t end, XusbReport* reports);
+void convertSse2(const MappingTables& tables, const N64StateBatch& batch, size_t begin, size_t end, XusbReport* reports);
+void convertAvx2(const MappingTables& tables, const N64StateBatch& batch, size_t begin, size_t end, XusbReport* reports);
+
+}
@@ -0,0 +1,88 @@
+#include "BatchMapping.h"
+
+#include <immintrin.h>
+
+#include <cstring>
+
+// Built with AVX2 code generation enabled; only called after detectIsa()
+void BatchMapping::convertAvx2(const MappingTables& tables, const N64StateBatch& batch, size_t begin, size_t end, XusbReport* reports)
+{
+    const auto t = tables.layout();
+
+    const __m256i xMin   = _mm256_set1_epi32(t.xMin);
+    const __m256i xMax   = _mm256_set1_epi32(t.xMax);
+    const __m256i yMin   = _mm256_set1_epi32(t.yMin);
+    const __m256i yMax   = _mm256_set1_epi32(t.yMax);
+    const __m256i one    = _mm256_set1_epi32(1);
+    const __m256i low8   = _mm256_set1_epi32(0xFF);
+    const __m256i low16  = _mm256_set1_epi32(0xFFFF);
+    const __m256i zero   = _mm256_setzero_si256();
+    const __m256i leftTrigger  = _mm256_set1_epi32(t.leftTrigger);
+    const __m256i rightTrigger = _mm256_set1_epi32(t.rightTrigger);
+
+    __m256i povAngles[8];
+    __m256i povButtons[8];
+    for (int32_t octant = 0; octant < 8; octant++)
+    {
+        povAngles[octant]  = _mm256_set1_epi32(octant * 4500);
+        povButtons[octant] = _mm256_set1_epi32(MappingTables::kDpadButtons[octant]);
+    }
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8)
+    {
+        // Sticks: clamp to the table range and gather (16 bit entries, so
+        // keep the low half of each 32 bit load)
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&batch.xAxis[i]));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&batch.yAxis[i]));
+        x = _mm256_sub_epi32(_mm256_min_epi32(_mm256_max_epi32(x, xMin), xMax), xMin);
+        y = _mm256_sub_epi32(_mm256_min_epi32(_mm256_max_epi32(y, yMin), yMax), yMin);
+        const __m256i lx = _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(t.xAxis), x, 2), low16);
+        const __m256i ly = _mm256_i32gather_epi32(reinterpret_cast<const int*>(t.yAxis), y, 2);
+        const __m256i sticks = _mm256_or_si256(lx, _mm256_slli_epi32(ly, 16));
+
+        // Buttons
+        const __m256i pressed = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&batch.pressed[i])));
+        const __m256i lo = _mm256_i32gather_epi32(reinterpret_cast<const int*>(t.buttonsLo), _mm256_and_si256(pressed, low8), 2);
+        const __m256i hi = _mm256_i32gather_epi32(reinterpret_cast<const int*>(t.buttonsHi), _mm256_srli_epi32(pressed, 8), 2);
+        __m256i buttons = _mm256_and_si256(_mm256_or_si256(lo, hi), low16);
+
+        const __m256i pov = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&batch.dpad[i]));
+        for (int octant = 0; octant < 8; octant++)
+            buttons = _mm256_or_si256(buttons, _mm256_and_si256(_mm256_cmpeq_epi32(pov, povAngles[octant]), povButtons[octant]));
+
+        // A trigger is 0xFF when any of its bound buttons is down
+        const __m256i left   = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_and_si256(pressed, leftTrigger), zero), low8);
+        const __m256i right  = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_and_si256(pressed, rightTrigger), zero), low8);
+        const __m256i header = _mm256_or_si256(buttons, _mm256_or_si256(_mm256_slli_epi32(left, 16), _mm256_slli_epi32(right, 24)));
+
+        // C-stick
+        const __m256i cIndex = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_and_si256(_mm256_srli_epi32(pressed, N64Button::C_LEFT), one),
+                _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(pressed, N64Button::C_RIGHT), one), 1)),
+            _mm256_or_si256(
+                _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(pressed, N64Button::C_DOWN), one), 2),
+                _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(pressed, N64Button::C_UP), one), 3)));
+        const __m256i cStick = _mm256_i32gather_epi32(reinterpret_cast<const int*>(t.cStick), cIndex, 4);
+
+        // Interleave into 8 x 12 byte reports
+        alignas(32) uint32_t headers[8];
+        alignas(32) uint32_t stickWords[8];
+        alignas(32) uint32_t cStickWords[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(headers), header);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(stickWords), sticks);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(cStickWords), cStick);
+
+        uint32_t words[24];
+        for (int lane = 0; lane < 8; lane++)
+        {
+            words[lane * 3 + 0] = headers[lane];
+            words[lane * 3 + 1] = stickWords[lane];
+            words[lane * 3 + 2] = cStickWords[lane];
+        }
+        memcpy(&reports[i], words, sizeof(words));
+    }
+
+    convertScalar(tables, batch, i, end, reports);
+}
@@ -0,0 +1,74 @@
+#include "BatchMapping.h"
+
+#include <emmintrin.h>
+
+#include <cstring>
+
+namespace
+{
+
+// SSE2 has no 32 bit min/max, so clamp with compare + select
+inline __m128i clamp(__m128i value, __m128i lo, __m128i hi)
+{
+    const __m128i below = _mm_cmplt_epi32(value, lo);
+    value = _mm_or_si128(_mm_and_si128(below, lo), _mm_andnot_si128(below, value));
+    const __m128i above = _mm_cmpgt_epi32(value, hi);
+    return _mm_or_si128(_mm_and_si128(above, hi), _mm_andnot_si128(above, value));
+}
+
+}
+
+void BatchMapping::convertSse2(const MappingTables& tables, const N64StateBatch& batch, size_t begin, size_t end, XusbReport* reports)
+{
+    const auto t = tables.layout();
+
+    const __m128i xMin = _mm_set1_epi32(t.xMin);
+    const __m128i xMax = _mm_set1_epi32(t.xMax);
+    const __m128i yMin = _mm_set1_epi32(t.yMin);
+    const __m128i yMax = _mm_set1_epi32(t.yMax);
+
+    __m128i povAngles[8];
+    __m128i povButtons[8];
+    for (int32_t octant = 0; octant < 8; octant++)
+    {
+        povAngles[octant]  = _mm_set1_epi32(octant * 4500);
+        povButtons[octant] = _mm_set1_epi32(MappingTables::kDpadButtons[octant]);
+    }
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4)
+    {
+        alignas(16) int32_t  xIndex[4];
+        alignas(16) int32_t  yIndex[4];
+        alignas(16) uint32_t dpad[4];
+
+        const __m128i x = clamp(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&batch.xAxis[i])), xMin, xMax);
+        const __m128i y = clamp(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&batch.yAxis[i])), yMin, yMax);
+        _mm_store_si128(reinterpret_cast<__m128i*>(xIndex), _mm_sub_epi32(x, xMin));
+        _mm_store_si128(reinterpret_cast<__m128i*>(yIndex), _mm_sub_epi32(y, yMin));
+
+        // One compare per POV direction; anything else (centered) stays 0
+        const __m128i pov = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&batch.dpad[i]));
+        __m128i dpadButtons = _mm_setzero_si128();
+        for (int octant = 0; octant < 8; octant++)
+            dpadButtons = _mm_or_si128(dpadButtons, _mm_and_si128(_mm_cmpeq_epi32(pov, povAngles[octant]), povButtons[octant]));
+        _mm_store_si128(reinterpret_cast<__m128i*>(dpad), dpadButtons);
+
+        // No gathers in SSE2; the remaining lookups are per lane
+        uint32_t words[12];
+        for (int lane = 0; lane < 4; lane++)
+        {
+            const uint16_t pressed = batch.pressed[i + lane];
+            const uint32_t buttons = t.buttonsLo[pressed & 0xFF] | t.buttonsHi[pressed >> 8] | dpad[lane];
+            const uint32_t left    = (0u - ((pressed & t.leftTrigger) != 0)) & 0xFF;
+            const uint32_t right   = (0u - ((pressed & t.rightTrigger) != 0)) & 0xFF;
+
+            words[lane * 3 + 0] = buttons | (left << 16) | (right << 24);
+            words[lane * 3 + 1] = static_cast<uint16_t>(t.xAxis[xIndex[lane]]) | (static_cast<uint32_t>(static_cast<uint16_t>(t.yAxis[yIndex[lane]])) << 16);
+            words[lane * 3 + 2] = t.cStick[MappingTables::cButtonIndex(pressed)];
+        }
+        memcpy(&reports[i], words, sizeof(words));
+    }
+
+    convertScalar(tables, batch, i, end, reports);
+}
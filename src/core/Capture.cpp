@@ -0,0 +1,285 @@
+#include "Capture.h"
+#include "Clock.h"
+
+#include <cstring>
+
+namespace
+{
+
+static constexpr size_t kStateWords = sizeof(N64ControllerState) / sizeof(uint32_t);
+static_assert(kStateWords <= 16, "changed word mask is 16 bits");
+
+size_t writeVarint(uint8_t* out, int64_t value)
+{
+    uint64_t zigzag = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    size_t size = 0;
+    do
+    {
+        uint8_t byte = zigzag & 0x7F;
+        zigzag >>= 7;
+        out[size++] = byte | (zigzag ? 0x80 : 0);
+    } while (zigzag);
+    return size;
+}
+
+bool readVarint(const uint8_t* data, size_t size, size_t& offset, int64_t& value)
+{
+    uint64_t zigzag = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7)
+    {
+        if (offset >= size)
+            return false;
+        const uint8_t byte = data[offset++];
+        zigzag |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            value = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void toWords(const N64ControllerState& state, uint32_t (&words)[kStateWords])
+{
+    memcpy(words, &state, sizeof(state));
+}
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  CaptureWriter
+//
+///////////////////////////////////////////////////////////////////////////////
+
+CaptureWriter::~CaptureWriter()
+{
+    close();
+}
+
+bool CaptureWriter::open(const std::string& path, bool deltaEncoding)
+{
+    close();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_)
+        return false;
+    setvbuf(file_, nullptr, _IOFBF, 1 << 16);
+
+    delta_           = deltaEncoding;
+    lastTimestampNs_ = Clock::nowNs();
+    records_         = 0;
+    devices_.clear();
+    devices_.reserve(Capture::kMaxDevices);
+
+    Capture::FileHeader header{};
+    memcpy(header.magic, Capture::kMagic, sizeof(header.magic));
+    header.version = Capture::kVersion;
+    header.flags   = deltaEncoding ? uint32_t(Capture::DELTA_ENCODED) : 0u;
+    header.startNs = lastTimestampNs_;
+    fwrite(&header, sizeof(header), 1, file_);
+    fflush(file_);
+    return true;
+}
+
+void CaptureWriter::close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_)
+        fclose(file_);
+    file_ = nullptr;
+}
+
+uint8_t CaptureWriter::addDevice(const uint8_t guid[16])
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < devices_.size(); i++)
+        if (memcmp(devices_[i].guid, guid, 16) == 0)
+            return static_cast<uint8_t>(i);
+
+    if (devices_.size() >= Capture::kMaxDevices)
+        return static_cast<uint8_t>(Capture::kMaxDevices - 1);
+
+    Device device{};
+    memcpy(device.guid, guid, 16);
+    device.sinceKeyframe = Capture::kKeyframeInterval;
+    devices_.push_back(device);
+
+    const auto id = static_cast<uint8_t>(devices_.size() - 1);
+    if (file_)
+    {
+        uint8_t record[18] = { Capture::DEVICE, id };
+        memcpy(record + 2, guid, 16);
+        fwrite(record, sizeof(record), 1, file_);
+        fflush(file_);
+    }
+    return id;
+}
+
+void CaptureWriter::append(uint8_t id, int64_t timestampNs, const N64ControllerState& state)
+{
+    uint8_t record[2 + 10 + 2 + sizeof(N64ControllerState)];
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_ || id >= devices_.size())
+        return;
+
+    auto& device = devices_[id];
+    size_t size = 2;
+    size += writeVarint(record + size, timestampNs - lastTimestampNs_);
+    lastTimestampNs_ = timestampNs;
+
+    if (!delta_ || device.sinceKeyframe >= Capture::kKeyframeInterval)
+    {
+        record[0] = Capture::FULL;
+        memcpy(record + size, &state, sizeof(state));
+        size += sizeof(state);
+        device.sinceKeyframe = 0;
+    }
+    else
+    {
+        uint32_t previous[kStateWords];
+        uint32_t current[kStateWords];
+        toWords(device.last, previous);
+        toWords(state, current);
+
+        uint16_t mask = 0;
+        const size_t maskOffset = size;
+        size += 2;
+        for (size_t word = 0; word < kStateWords; word++)
+        {
+            if (current[word] == previous[word])
+                continue;
+            mask |= static_cast<uint16_t>(1u << word);
+            memcpy(record + size, &current[word], sizeof(uint32_t));
+            size += sizeof(uint32_t);
+        }
+        record[0]              = Capture::DELTA;
+        record[maskOffset]     = static_cast<uint8_t>(mask & 0xFF);
+        record[maskOffset + 1] = static_cast<uint8_t>(mask >> 8);
+        device.sinceKeyframe++;
+    }
+    record[1] = id;
+
+    device.last = state;
+    records_++;
+    fwrite(record, size, 1, file_);
+}
+
+uint64_t CaptureWriter::records() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return records_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  CaptureReader
+//
+///////////////////////////////////////////////////////////////////////////////
+
+bool CaptureReader::open(const std::string& path)
+{
+    if (!file_.open(path) || file_.size() < sizeof(Capture::FileHeader))
+        return false;
+
+    memcpy(&header_, file_.data(), sizeof(header_));
+    if (memcmp(header_.magic, Capture::kMagic, sizeof(header_.magic)) != 0 || header_.version != Capture::kVersion)
+        return false;
+
+    rewind();
+    return true;
+}
+
+void CaptureReader::rewind()
+{
+    offset_      = sizeof(Capture::FileHeader);
+    timestampNs_ = header_.startNs;
+    truncated_   = false;
+    memset(states_, 0, sizeof(states_));
+}
+
+bool CaptureReader::next(CaptureRecord& record)
+{
+    const uint8_t* data = file_.data();
+    const size_t   size = file_.size();
+
+    size_t offset = offset_;
+    if (offset + 2 > size)
+    {
+        truncated_ = offset != size;
+        return false;
+    }
+
+    const uint8_t type = data[offset++];
+    const uint8_t id   = data[offset++];
+    record.controllerId = id;
+
+    if (type == Capture::DEVICE)
+    {
+        if (offset + 16 > size)
+        {
+            truncated_ = true;
+            return false;
+        }
+        record.type        = Capture::DEVICE;
+        record.timestampNs = timestampNs_;
+        memcpy(record.guid, data + offset, 16);
+        offset_ = offset + 16;
+        return true;
+    }
+
+    int64_t delta = 0;
+    if ((type != Capture::FULL && type != Capture::DELTA) || !readVarint(data, size, offset, delta))
+    {
+        truncated_ = true;
+        return false;
+    }
+
+    auto& state = states_[id];
+    if (type == Capture::FULL)
+    {
+        if (offset + sizeof(N64ControllerState) > size)
+        {
+            truncated_ = true;
+            return false;
+        }
+        memcpy(&state, data + offset, sizeof(state));
+        offset += sizeof(state);
+    }
+    else
+    {
+        if (offset + 2 > size)
+        {
+            truncated_ = true;
+            return false;
+        }
+        const uint16_t mask = static_cast<uint16_t>(data[offset] | (data[offset + 1] << 8));
+        offset += 2;
+
+        uint32_t words[kStateWords];
+        toWords(state, words);
+        for (size_t word = 0; word < kStateWords; word++)
+        {
+            if (!(mask & (1u << word)))
+                continue;
+            if (offset + sizeof(uint32_t) > size)
+            {
+                truncated_ = true;
+                return false;
+            }
+            memcpy(&words[word], data + offset, sizeof(uint32_t));
+            offset += sizeof(uint32_t);
+        }
+        memcpy(&state, words, sizeof(state));
+    }
+
+    timestampNs_       += delta;
+    record.type         = Capture::FULL;
+    record.timestampNs  = timestampNs_;
+    record.state        = state;
+    offset_             = offset;
+    return true;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "N64ControllerState.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Raw input capture
+//
+//  Append-only binary log of raw N64ControllerState reads. Layout:
+//
+//    FileHeader (32 bytes)
+//    records, back to back:
+//      DEVICE  [type][id][16 byte instance GUID]
+//      FULL    [type][id][dt][56 byte state]
+//      DELTA   [type][id][dt][u16 changed word mask][changed 32 bit words]
+//
+//  `dt` is the zigzag LEB128 varint nanosecond delta to the previous record.
+//  DELTA records are relative to the previous state of the same id; every
+//  id starts with a FULL record and gets a fresh one every kKeyframeInterval
+//  records. All integers are little endian. The reader maps the file, so a
+//  capture that is still being written (or was cut short) can be read up to
+//  its last complete record.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Capture
+{
+
+static constexpr char     kMagic[8]         = { 'N', '6', '4', 'C', 'A', 'P', 0, 0 };
+static constexpr uint32_t kVersion          = 1;
+static constexpr uint32_t kKeyframeInterval = 1024;
+static constexpr size_t   kMaxDevices       = 256;
+
+enum Flags : uint32_t
+{
+    DELTA_ENCODED = 1
+};
+
+enum RecordType : uint8_t
+{
+    DEVICE = 1,
+    FULL   = 2,
+    DELTA  = 3
+};
+
+struct FileHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t flags;
+    int64_t  startNs;  // Clock::nowNs() when the capture was opened
+    uint8_t  reserved[8];
+};
+
+static_assert(sizeof(FileHeader) == 32, "FileHeader is part of the file format");
+
+}
+
+class CaptureWriter
+{
+public:
+    ~CaptureWriter();
+
+    bool open(const std::string& path, bool deltaEncoding);
+    void close();
+    bool isOpen() const { return file_ != nullptr; }
+
+    // Same GUID always maps to the same id within one capture
+    uint8_t addDevice(const uint8_t guid[16]);
+
+    // Thread safe; encodes into a stack buffer and appends under a short lock
+    void append(uint8_t id, int64_t timestampNs, const N64ControllerState& state);
+
+    uint64_t records() const;
+
+private:
+    struct Device
+    {
+        uint8_t            guid[16];
+        N64ControllerState last;
+        uint32_t           sinceKeyframe;
+    };
+
+    mutable std::mutex  mutex_;
+    FILE*               file_ { nullptr };
+    bool                delta_ { false };
+    int64_t             lastTimestampNs_ { 0 };
+    uint64_t            records_ { 0 };
+    std::vector<Device> devices_;
+};
+
+struct CaptureRecord
+{
+    Capture::RecordType type;      // DEVICE or FULL (DELTA records are reconstructed into FULL)
+    uint8_t             controllerId;
+    int64_t             timestampNs;
+    N64ControllerState  state;
+    uint8_t             guid[16];
+};
+
+class CaptureReader
+{
+public:
+    bool open(const std::string& path);
+
+    const Capture::FileHeader& header() const { return header_; }
+
+    // False at the end of the capture or at the first incomplete record
+    bool next(CaptureRecord& record);
+    void rewind();
+
+    // True when reading stopped on a malformed or cut off record
+    bool truncated() const { return truncated_; }
+
+private:
+    MappedFile          file_;
+    Capture::FileHeader header_ {};
+    size_t              offset_ { 0 };
+    int64_t             timestampNs_ { 0 };
+    bool                truncated_ { false };
+    N64ControllerState  states_[Capture::kMaxDevices] {};
+};
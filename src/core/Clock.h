@@ -0,0 +1,15 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace Clock
+{
+
+// Monotonic nanoseconds (QueryPerformanceCounter on Windows, CLOCK_MONOTONIC on Linux)
+inline int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
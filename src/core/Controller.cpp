@@ -0,0 +1,637 @@
+#include "Controller.h"
+#include "DeviceRecovery.h"
+#include "ReportPipeline.h"
+#include "WaitableTimer.h"
+#include "Clock.h"
+#include "Log.h"
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Impl
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct Controller::Impl
+{
+    ~Impl();
+    bool openStep(OpenStep step, InputBackend& inputs, SinkBackend& sinks, const DeviceGuid& id, const ControllerContext& context);
+    bool begin(const DeviceGuid& id, const ControllerContext& context);
+    bool openInput(InputBackend& inputs, const DeviceGuid& id);
+    bool plugSink(SinkBackend& sinks, const DeviceGuid& id);
+    bool start(const ControllerContext& context);
+    void close();
+
+    // Reads the device, converts and hands every changed report to the
+    // output scheduler
+    void processReport();
+
+    // Output scheduler deadline
+    void processTimer();
+
+    // Turbo / macro output changed
+    void processMacro();
+
+    // Device loss: neutral report, then attempts to get the device back on
+    // the recovery timer (see DeviceRecovery)
+    void deviceLost();
+    void attemptRecovery();
+    void deviceRecovered(int64_t nowNs);
+    void processRecovery();
+
+    // Adds the device's handle to the loop servicing the pad, or takes it
+    // out: a lost device's handle can stay ready (level triggered) with
+    // nothing worth reading, and would wake the thread over and over
+    void watchInput(bool watch);
+
+    void deliver(const XusbReport& report, int64_t wokeNs, int64_t readNs, int64_t convertedNs);
+    void submit(const XusbReport& report, int64_t wokeNs, int64_t readNs, int64_t convertedNs);
+
+    // The virtual pad update itself, inline or through the submit thread
+    void send(const XusbReport& report, int64_t readNs);
+    void armTimer();
+
+    bool open_{ false };
+    std::atomic<bool> ready_{ false };
+    DeviceGuid id_{};
+    const DeviceType* type_{ &DeviceTypes::n64() };
+    std::unique_ptr<InputSource> input_;
+    std::unique_ptr<PadSink> ownedSink_;
+    PadSink* sink_{ nullptr };
+    std::unique_ptr<SubmitThread::Pad> submitPad_;
+    TargetPool* targets_{ nullptr };
+    Reactor* reactor_{ nullptr };
+    bool registered_{ false };
+    bool inputWatched_{ false };
+    EventHandle alongside_[3]{};    // registered with the reactor next to the device
+    size_t alongsideCount_{ 0 };
+    std::unique_ptr<EventLoop> loop_;
+    std::thread thread_;
+    CaptureWriter* capture_{ nullptr };
+    uint8_t captureId_{ 0 };
+    SharedState* shared_{ nullptr };
+    uint32_t sharedSlot_{ 0 };
+    N64ControllerState sharedRaw_{};   // last published, for macro updates
+    XusbReport sharedReport_{};
+
+    ControllerStats stats_;
+    ReportPipeline pipeline_;
+    InputBatch batch_;
+
+    // Output scheduling; the timer only exists outside IMMEDIATE mode
+    ReportScheduler scheduler_;
+    std::unique_ptr<WaitableTimer> timer_;
+
+    // Turbo and macros; only with a macro engine
+    std::unique_ptr<MacroEngine::Pad> macroPad_;
+    int64_t armedNs_{ -1 };
+    int64_t heldWokeNs_{ 0 };       // stamps of the held report, for its latency
+    int64_t heldReadNs_{ 0 };
+    int64_t heldConvertedNs_{ 0 };
+
+    DeviceRecovery recovery_;
+    std::unique_ptr<WaitableTimer> recoveryTimer_;
+};
+
+Controller::Impl::~Impl()
+{
+    close();
+}
+
+void Controller::Impl::close()
+{
+    ready_.store(false, std::memory_order_relaxed);
+
+    // Stop listening for events
+    if (registered_)
+        reactor_->remove(input_->handle());
+    for (size_t i = 0; i < alongsideCount_; i++)
+        reactor_->remove(alongside_[i]);
+    registered_     = false;
+    inputWatched_   = false;
+    alongsideCount_ = 0;
+    reactor_        = nullptr;
+
+    if (loop_)
+    {
+        loop_->stop();
+        if (thread_.joinable())
+            thread_.join();
+        loop_.reset();
+    }
+
+    if (shared_)
+        shared_->disconnect(sharedSlot_);
+
+    // Close device
+    input_.reset();
+    timer_.reset();
+    recoveryTimer_.reset();
+    macroPad_.reset();
+    submitPad_.reset();
+    pipeline_.attach(nullptr);
+
+    // Unplug the virtual pad, or park it for a quick reconnect
+    if (sink_ && !ownedSink_)
+        targets_->release(id_, sink_);
+    ownedSink_.reset();
+    sink_     = nullptr;
+    targets_  = nullptr;
+    capture_  = nullptr;
+    shared_   = nullptr;
+    open_     = false;
+}
+
+void Controller::Impl::processReport()
+{
+    // While the device is lost only recoveryTimer_ tries it again, on its
+    // backoff. A wake from the dead device's handle can only come from a
+    // loss found before the handle was registered (start()).
+    if (recovery_.recovering())
+    {
+        watchInput(false);
+        return;
+    }
+
+    do
+    {
+        const auto wokeNs = Clock::nowNs();
+        batch_.reacquired = false;
+        if (!input_->readBatch(batch_))
+        {
+            ControllerStats::increment(stats_.counters.readErrors);
+            deviceLost();
+            return;
+        }
+        const auto readNs = Clock::nowNs();
+        if (batch_.overflowed)
+            ControllerStats::increment(stats_.counters.bufferOverflows);
+        if (batch_.reacquired)
+            ControllerStats::increment(stats_.counters.reacquires);
+
+        // Buffered sources hand over every intermediate state; each one goes
+        // out in order so no transition is lost
+        for (size_t i = 0; i < batch_.count; i++)
+        {
+            const auto& state = batch_.states[i];
+            ControllerStats::increment(stats_.counters.reportsRead);
+
+            if (capture_)
+                capture_->append(captureId_, readNs, state);
+
+            XusbReport report;
+            if (!pipeline_.process(state, report))
+            {
+                ControllerStats::increment(stats_.counters.reportsSkipped);
+                if (shared_)
+                {
+                    sharedRaw_ = state;
+                    shared_->publish(sharedSlot_, state, sharedReport_, readNs);
+                }
+                continue;
+            }
+            if (macroPad_)
+                macroPad_->merge(pipeline_.tables().macros(), report);
+            if (shared_)
+            {
+                sharedRaw_    = state;
+                sharedReport_ = report;
+                shared_->publish(sharedSlot_, state, report, readNs);
+            }
+            deliver(report, wokeNs, readNs, Clock::nowNs());
+        }
+    } while (batch_.more);
+
+    if (timer_)
+        armTimer();
+}
+
+void Controller::Impl::processTimer()
+{
+    timer_->acknowledge();
+    armedNs_ = -1;
+
+    XusbReport report;
+    switch (scheduler_.expire(Clock::nowNs(), report))
+    {
+    case ReportScheduler::SEND:
+        submit(report, heldWokeNs_, heldReadNs_, heldConvertedNs_);
+        break;
+    case ReportScheduler::RESEND:
+        send(report, Clock::nowNs());
+        scheduler_.sent(report, Clock::nowNs());
+        ControllerStats::increment(stats_.counters.reportsSubmitted);
+        ControllerStats::increment(stats_.counters.reportsResent);
+        break;
+    default:
+        break;
+    }
+    armTimer();
+}
+
+void Controller::Impl::processMacro()
+{
+    const auto wokeNs = Clock::nowNs();
+    XusbReport report;
+    macroPad_->remerge(pipeline_.tables().macros(), report);
+    const auto mergedNs = Clock::nowNs();
+    if (shared_)
+    {
+        sharedReport_ = report;
+        shared_->publish(sharedSlot_, sharedRaw_, report, mergedNs);
+    }
+    deliver(report, wokeNs, wokeNs, mergedNs);
+
+    if (timer_)
+        armTimer();
+}
+
+void Controller::Impl::deviceLost()
+{
+    const auto nowNs = Clock::nowNs();
+    const bool now   = recovery_.lost(nowNs);
+    ControllerStats::increment(stats_.counters.deviceLosses);
+    Log::warning("%s: device lost, recovering", id_.toString().c_str());
+    watchInput(false);
+
+    // Nothing stays held or deflected while the pad is gone. Straight to
+    // the virtual pad, past any held report; turbo sees the buttons let go.
+    XusbReport report;
+    Xusb::initReport(report);
+    if (macroPad_)
+        macroPad_->merge(pipeline_.tables().macros(), report);
+    send(report, nowNs);
+    scheduler_.sent(report, Clock::nowNs());
+    ControllerStats::increment(stats_.counters.reportsSubmitted);
+    if (shared_)
+    {
+        sharedReport_ = report;
+        shared_->publish(sharedSlot_, sharedRaw_, report, nowNs);
+    }
+
+    if (now)
+        attemptRecovery();
+    else
+        recoveryTimer_->arm(recovery_.failed());
+}
+
+void Controller::Impl::attemptRecovery()
+{
+    ControllerStats::increment(stats_.counters.recoveryAttempts);
+    if (input_->recover())
+    {
+        deviceRecovered(Clock::nowNs());
+
+        // Whatever the pad holds now goes out on the same virtual pad
+        processReport();
+        return;
+    }
+    recoveryTimer_->arm(recovery_.failed());
+}
+
+void Controller::Impl::deviceRecovered(int64_t nowNs)
+{
+    const auto goneNs = recovery_.recovered(nowNs);
+    stats_.recoveryTimes.record(goneNs);
+    ControllerStats::increment(stats_.counters.recoveries);
+    recoveryTimer_->disarm();
+    watchInput(true);
+
+    // The last report before the loss isn't what the virtual pad shows
+    pipeline_.reset();
+    Log::info("%s: device back after %.1f ms, %u failed attempts", id_.toString().c_str(), goneNs / 1e6, recovery_.failures());
+}
+
+void Controller::Impl::processRecovery()
+{
+    recoveryTimer_->acknowledge();
+    if (recovery_.recovering())
+        attemptRecovery();
+}
+
+void Controller::Impl::watchInput(bool watch)
+{
+    // Before start() registers anything there is nothing to change
+    if (watch == inputWatched_ || (!registered_ && !loop_))
+        return;
+
+    const auto handle = input_->handle();
+    bool watched = false;
+    if (registered_)
+    {
+        // Next to the recovery timer, on the thread servicing the pad
+        if (watch)
+            watched = reactor_->addAlongside(handle, recoveryTimer_->handle(), [this]{ processReport(); });
+        else
+            reactor_->remove(handle);
+    }
+    else
+    {
+        if (watch)
+            watched = loop_->add(handle, [this]{ processReport(); });
+        else
+            loop_->remove(handle);
+    }
+    if (watch && !watched)
+        Log::error("%s: failed to watch the device again", id_.toString().c_str());
+    inputWatched_ = watched;
+}
+
+void Controller::Impl::deliver(const XusbReport& report, int64_t wokeNs, int64_t readNs, int64_t convertedNs)
+{
+    switch (scheduler_.offer(report, convertedNs))
+    {
+    case ReportScheduler::SEND:
+        submit(report, wokeNs, readNs, convertedNs);
+        break;
+    case ReportScheduler::DUPLICATE:
+        ControllerStats::increment(stats_.counters.reportsSkipped);
+        break;
+    case ReportScheduler::SUPERSEDED:
+        ControllerStats::increment(stats_.counters.reportsCoalesced);
+        // fall through
+    case ReportScheduler::HELD:
+        heldWokeNs_      = wokeNs;
+        heldReadNs_      = readNs;
+        heldConvertedNs_ = convertedNs;
+        break;
+    default:
+        break;
+    }
+}
+
+void Controller::Impl::submit(const XusbReport& report, int64_t wokeNs, int64_t readNs, int64_t convertedNs)
+{
+    send(report, readNs);
+    const auto submittedNs = Clock::nowNs();
+    scheduler_.sent(report, submittedNs);
+
+    // Held reports count the hold in the submit stage and the total
+    if (stats_.counters.firstReportNs.load(std::memory_order_relaxed) == 0)
+        stats_.counters.firstReportNs.store(submittedNs, std::memory_order_relaxed);
+    ControllerStats::increment(stats_.counters.reportsSubmitted);
+    stats_.recordReport(wokeNs, readNs, convertedNs, submittedNs);
+}
+
+void Controller::Impl::send(const XusbReport& report, int64_t readNs)
+{
+    if (submitPad_)
+        submitPad_->post(report, readNs);
+    else
+        sink_->submit(report);
+}
+
+void Controller::Impl::armTimer()
+{
+    const auto deadlineNs = scheduler_.deadlineNs();
+    if (deadlineNs < 0 || deadlineNs == armedNs_)
+        return;
+    armedNs_ = deadlineNs;
+    timer_->arm(deadlineNs - Clock::nowNs());
+}
+
+bool Controller::Impl::openStep(OpenStep step, InputBackend& inputs, SinkBackend& sinks, const DeviceGuid& id, const ControllerContext& context)
+{
+    switch (step)
+    {
+    case BEGIN:      return begin(id, context);
+    case OPEN_INPUT: return openInput(inputs, id);
+    case PLUG_SINK:  return plugSink(sinks, id);
+    case START:      return start(context);
+    default:         return false;
+    }
+}
+
+bool Controller::Impl::begin(const DeviceGuid& id, const ControllerContext& context)
+{
+    // Failures leave the controller open; the caller closes it
+    close();
+    open_ = true;
+    stats_.reset();
+    stats_.counters.connectedNs = context.detectedNs ? context.detectedNs : Clock::nowNs();
+    pipeline_.reset();
+
+    id_       = id;
+    armedNs_  = -1;
+    recovery_ = DeviceRecovery(DeviceGuidHash()(id) ^ static_cast<uint64_t>(Clock::nowNs()));
+    reactor_ = context.reactor;
+    capture_ = context.capture;
+    targets_ = context.targets;
+    shared_  = context.shared;
+    pipeline_.attach(context.profiles);
+
+    sharedSlot_   = context.sharedSlot;
+    sharedRaw_    = N64ControllerState{};
+    sharedReport_ = XusbReport{};
+    if (shared_)
+        shared_->connect(sharedSlot_, id);
+
+    if (capture_)
+    {
+        uint8_t guid[16];
+        memcpy(guid, &id, sizeof(guid));
+        captureId_ = capture_->addDevice(guid);
+    }
+    return true;
+}
+
+bool Controller::Impl::openInput(InputBackend& inputs, const DeviceGuid& id)
+{
+    input_ = inputs.open(id);
+    if (!input_)
+        return false;
+
+    // Converted as whatever pad this is from the first report on
+    type_ = &input_->type();
+    pipeline_.setType(*type_);
+    return true;
+}
+
+bool Controller::Impl::plugSink(SinkBackend& sinks, const DeviceGuid& id)
+{
+    if (targets_)
+        sink_ = static_cast<PadSink*>(targets_->acquire(id));
+    else
+    {
+        ownedSink_ = sinks.plug();
+        sink_      = ownedSink_.get();
+    }
+    if (!sink_)
+    {
+        Log::error("No virtual pad available");
+        return false;
+    }
+    return true;
+}
+
+bool Controller::Impl::start(const ControllerContext& context)
+{
+    if (!input_ || !sink_)
+        return false;
+
+    scheduler_.configure(context.outputMode, context.outputHz);
+    scheduler_.reset(Clock::nowNs());
+    if (scheduler_.mode() != ReportScheduler::IMMEDIATE)
+    {
+        timer_ = WaitableTimer::create();
+        if (!timer_)
+        {
+            Log::error("Failed to create the output timer");
+            return false;
+        }
+        armTimer();
+    }
+
+    if (context.macros)
+    {
+        macroPad_ = context.macros->addPad();
+        if (!macroPad_)
+        {
+            Log::error("Failed to create the macro event");
+            return false;
+        }
+    }
+
+    recoveryTimer_ = WaitableTimer::create();
+    if (!recoveryTimer_)
+    {
+        Log::error("Failed to create the recovery timer");
+        return false;
+    }
+
+    if (context.submitter)
+    {
+        submitPad_ = context.submitter->addPad(*sink_, stats_);
+        if (!submitPad_)
+            Log::warning("Submit thread is full, updating the virtual pad inline");
+    }
+
+    // The pad's current state goes out now rather than on its first change;
+    // nothing services the pad yet, so this thread can read it
+    processReport();
+
+    // Serviced on the same thread as the device
+    struct Alongside
+    {
+        EventHandle         handle;
+        EventLoop::Callback callback;
+    };
+    Alongside alongside[3];
+    size_t    count = 0;
+    if (timer_)
+        alongside[count++] = { timer_->handle(), [this]{ processTimer(); } };
+    if (macroPad_)
+        alongside[count++] = { macroPad_->handle(), [this]{ processMacro(); } };
+    alongside[count++] = { recoveryTimer_->handle(), [this]{ processRecovery(); } };
+
+    const auto handle = input_->handle();
+    inputWatched_ = true;
+    if (reactor_)
+    {
+        // Reactor mode: one of the reactor's loop threads services this pad,
+        // its timers and macro event on the same thread
+        registered_ = reactor_->add(handle, [this]{ processReport(); });
+        for (size_t i = 0; registered_ && i < count; i++)
+        {
+            if (reactor_->addAlongside(alongside[i].handle, handle, alongside[i].callback))
+                alongside_[alongsideCount_++] = alongside[i].handle;
+            else
+            {
+                for (size_t j = 0; j < alongsideCount_; j++)
+                    reactor_->remove(alongside_[j]);
+                reactor_->remove(handle);
+                alongsideCount_ = 0;
+                registered_     = false;
+            }
+        }
+        if (registered_)
+            stats_.inputMode = EventLoop::modeName(reactor_->strategy().mode);
+        else
+        {
+            Log::warning("Reactor is full, falling back to a dedicated thread");
+            reactor_ = nullptr;
+        }
+    }
+
+    if (!registered_)
+    {
+        // A single handle loop on a thread of its own
+        loop_ = EventLoop::create();
+        bool added = loop_ && loop_->add(handle, [this]{ processReport(); });
+        for (size_t i = 0; added && i < count; i++)
+            added = loop_->add(alongside[i].handle, alongside[i].callback);
+        if (!added)
+        {
+            Log::error("Failed to set up the device event loop");
+            loop_.reset();
+            return false;
+        }
+        loop_->setStrategy(context.input);
+        stats_.inputMode = EventLoop::modeName(context.input.mode);
+        thread_ = std::thread([this, settings = context.thread]
+        {
+            Log::attachThread();
+            ThreadTuning::apply(settings);
+            loop_->run();
+        });
+    }
+
+    stats_.counters.readyNs.store(Clock::nowNs(), std::memory_order_relaxed);
+    ready_.store(true, std::memory_order_release);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Public interface
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Controller::Controller()
+    : impl_(new Impl)
+{   }
+
+Controller::~Controller() = default;
+
+bool Controller::open(InputBackend& inputs, SinkBackend& sinks, const DeviceGuid& id, const ControllerContext& context)
+{
+    for (uint8_t step = BEGIN; step < OPEN_STEPS; step++)
+    {
+        if (!impl_->openStep(static_cast<OpenStep>(step), inputs, sinks, id, context))
+            return false;
+    }
+    return true;
+}
+
+bool Controller::openStep(OpenStep step, InputBackend& inputs, SinkBackend& sinks, const DeviceGuid& id, const ControllerContext& context)
+{
+    return impl_->openStep(step, inputs, sinks, id, context);
+}
+
+void Controller::close()
+{
+    impl_->close();
+}
+
+bool Controller::isOpen() const
+{
+    return impl_->open_;
+}
+
+bool Controller::isReady() const
+{
+    return impl_->ready_.load(std::memory_order_acquire);
+}
+
+const DeviceType& Controller::deviceType() const
+{
+    return *impl_->type_;
+}
+
+const ControllerStats& Controller::stats() const
+{
+    return impl_->stats_;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Capture.h"
+#include "ControllerStats.h"
+#include "DeviceGuid.h"
+#include "EventLoop.h"
+#include "InputSource.h"
+#include "MacroEngine.h"
+#include "PadSink.h"
+#include "ProfileStore.h"
+#include "ReportScheduler.h"
+#include "SharedState.h"
+#include "SubmitThread.h"
+#include "TargetPool.h"
+
+#include <memory>
+
+// Optional shared services a controller plugs into
+struct ControllerContext
+{
+    Reactor*       reactor { nullptr }; // service the pad from the reactor instead of a dedicated thread
+    CaptureWriter* capture { nullptr }; // append every raw state read to this capture
+    TargetPool*    targets { nullptr }; // take and park PadSinks here instead of plugging in / out
+    ProfileStore*  profiles { nullptr }; // convert with this store's current profile instead of the defaults
+    MacroEngine*   macros { nullptr };   // play the profile's turbo and macros (needs profiles to have any)
+    SharedState*   shared { nullptr };   // publish every state read and its report in this slot
+    SubmitThread*  submitter { nullptr }; // post reports to this thread instead of updating the virtual pad inline
+    uint32_t       sharedSlot { 0 };
+    int64_t        detectedNs { 0 };    // Clock::nowNs() when the pad showed up; 0 = when opening starts
+
+    // When converted reports become virtual pad updates (see ReportScheduler)
+    ReportScheduler::Mode outputMode { ReportScheduler::IMMEDIATE };
+    uint32_t              outputHz { 0 };
+
+    // How a dedicated pad thread waits for input and how it is scheduled;
+    // reactor threads take theirs from the Reactor
+    EventLoop::Strategy input;
+    ThreadSettings      thread;
+};
+
+// Bridges one physical pad to one virtual pad. Controllers are pooled: a
+// closed controller can be opened again for another device.
+class Controller
+{
+public:
+    // open() in the steps InitPipeline runs as separate tasks
+    enum OpenStep : uint8_t
+    {
+        BEGIN,       // reset, shared state slot, capture
+        OPEN_INPUT,  // open the physical pad (CreateDevice .. Acquire / open + EVIOCGRAB)
+        PLUG_SINK,   // plug in or take a virtual pad
+        START,       // output timer, macros, first read, then service the pad
+        OPEN_STEPS
+    };
+
+public:
+    Controller();
+    ~Controller();
+
+    Controller(const Controller&) = delete;
+    Controller& operator=(const Controller&) = delete;
+
+    // With a target pool the virtual pad comes from the pool instead of
+    // being plugged in through sinks
+    bool open(InputBackend& inputs, SinkBackend& sinks, const DeviceGuid& id, const ControllerContext& context = {});
+
+    // One step of open(). Every step from BEGIN to START, in order, with the
+    // same arguments; consecutive steps may run on different threads as long
+    // as they don't overlap. A failed or abandoned open is closed by the
+    // caller like a failed open().
+    bool openStep(OpenStep step, InputBackend& inputs, SinkBackend& sinks, const DeviceGuid& id, const ControllerContext& context = {});
+
+    void close();
+    bool isOpen() const;
+
+    // Open and serviced: START succeeded. Safe from any thread; stats and
+    // the input mode are settled once it's true.
+    bool isReady() const;
+
+    // The kind of pad (DeviceDescriptors.h), once OPEN_INPUT succeeded
+    const DeviceType& deviceType() const;
+
+    // Reset by open()
+    const ControllerStats& stats() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
@@ -0,0 +1,108 @@
+#include "ControllerStats.h"
+
+#include <cstdio>
+
+const char* ControllerStats::stageName(Stage stage)
+{
+    switch (stage)
+    {
+    case READ:    return "read";
+    case CONVERT: return "convert";
+    case SUBMIT:  return "submit";
+    case TOTAL:   return "total";
+    default:      return "?";
+    }
+}
+
+void ControllerStats::reset()
+{
+    counters.reportsRead       = 0;
+    counters.reportsSkipped    = 0;
+    counters.reportsCoalesced  = 0;
+    counters.reportsSubmitted  = 0;
+    counters.reportsResent     = 0;
+    counters.readErrors        = 0;
+    counters.bufferOverflows   = 0;
+    counters.reacquires        = 0;
+    counters.deviceLosses      = 0;
+    counters.recoveryAttempts  = 0;
+    counters.recoveries        = 0;
+    counters.connectedNs       = 0;
+    counters.readyNs           = 0;
+    counters.firstReportNs     = 0;
+    submit.reportsSuperseded   = 0;
+    for (auto& stage : stages)
+        stage.reset();
+    recoveryTimes.reset();
+    submit.staleness.reset();
+}
+
+void ControllerStats::print(std::ostream& out, const std::string& name) const
+{
+    out << "stats " << name << ":"
+        << " read "      << counters.reportsRead.load(std::memory_order_relaxed)
+        << " skipped "   << counters.reportsSkipped.load(std::memory_order_relaxed)
+        << " coalesced " << counters.reportsCoalesced.load(std::memory_order_relaxed)
+        << " submitted " << counters.reportsSubmitted.load(std::memory_order_relaxed)
+        << " resent "    << counters.reportsResent.load(std::memory_order_relaxed)
+        << " saved "     << updatesSaved()
+        << " errors "    << counters.readErrors.load(std::memory_order_relaxed)
+        << " overflows " << counters.bufferOverflows.load(std::memory_order_relaxed)
+        << " reacquired " << counters.reacquires.load(std::memory_order_relaxed)
+        << "\n";
+
+    char line[128];
+    const auto connectedNs = counters.connectedNs.load(std::memory_order_relaxed);
+    const auto readyNs     = counters.readyNs.load(std::memory_order_relaxed);
+    const auto firstNs     = timeToFirstReportNs();
+    if (readyNs && firstNs >= 0)
+        snprintf(line, sizeof(line), "  ready after %.1f ms, first report after %.1f ms\n", (readyNs - connectedNs) / 1e6, firstNs / 1e6);
+    else if (readyNs)
+        snprintf(line, sizeof(line), "  ready after %.1f ms, no report yet\n", (readyNs - connectedNs) / 1e6);
+    if (readyNs)
+        out << line;
+
+    const auto losses = counters.deviceLosses.load(std::memory_order_relaxed);
+    if (losses > 0)
+    {
+        snprintf(line, sizeof(line), "  device lost %llu times, back %llu times after %llu attempts, p50 %.1f ms max %.1f ms\n",
+                 static_cast<unsigned long long>(losses),
+                 static_cast<unsigned long long>(counters.recoveries.load(std::memory_order_relaxed)),
+                 static_cast<unsigned long long>(counters.recoveryAttempts.load(std::memory_order_relaxed)),
+                 recoveryTimes.percentile(0.50) / 1e6, recoveryTimes.maxValue() / 1e6);
+        out << line;
+    }
+
+    // Only with a submit thread
+    if (submit.staleness.count() > 0)
+    {
+        snprintf(line, sizeof(line), "  superseded %llu, staleness p50 %.1f us p99 %.1f us max %.1f us\n",
+                 static_cast<unsigned long long>(submit.reportsSuperseded.load(std::memory_order_relaxed)),
+                 submit.staleness.percentile(0.50) / 1000.0, submit.staleness.percentile(0.99) / 1000.0, submit.staleness.maxValue() / 1000.0);
+        out << line;
+    }
+
+    snprintf(line, sizeof(line), "  %-8s %10s %10s %10s %10s %10s\n", "stage", "count", "p50 us", "p99 us", "p999 us", "max us");
+    out << line;
+
+    for (uint32_t stage = 0; stage < STAGE_COUNT; stage++)
+    {
+        const auto& histogram = stages[stage];
+        snprintf(line, sizeof(line), "  %-8s %10llu %10.1f %10.1f %10.1f %10.1f\n",
+                 stageName(static_cast<Stage>(stage)),
+                 static_cast<unsigned long long>(histogram.count()),
+                 histogram.percentile(0.50) / 1000.0,
+                 histogram.percentile(0.99) / 1000.0,
+                 histogram.percentile(0.999) / 1000.0,
+                 histogram.maxValue() / 1000.0);
+        out << line;
+    }
+
+    // Spread of wake to submit around its median: what the wait strategy
+    // and thread scheduling are meant to keep small
+    const auto& total = stages[TOTAL];
+    const auto  p50   = static_cast<double>(total.percentile(0.50));
+    snprintf(line, sizeof(line), "  jitter (%s): p99-p50 %.1f us, p999-p50 %.1f us\n",
+             inputMode, (total.percentile(0.99) - p50) / 1000.0, (total.percentile(0.999) - p50) / 1000.0);
+    out << line;
+}
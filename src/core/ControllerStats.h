@@ -0,0 +1,101 @@
+#pragma once
+
+#include "LatencyHistogram.h"
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Per controller pipeline statistics
+//
+//  Written only by the thread servicing the pad, except for the submit
+//  thread's fields in submit (see SubmitThread); safe to read from any
+//  thread at any time. Recording never allocates or locks.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct ControllerStats
+{
+    enum Stage : uint32_t
+    {
+        READ,    // wake up -> device state read
+        CONVERT, // device state read -> report converted
+        SUBMIT,  // report converted -> virtual pad update returned (posted, with a SubmitThread)
+        TOTAL,   // wake up -> virtual pad update returned
+        STAGE_COUNT
+    };
+
+    static const char* stageName(Stage stage);
+
+    // Counters sit on their own cache line, away from the histograms
+    struct alignas(64) Counters
+    {
+        std::atomic<uint64_t> reportsRead { 0 };
+        std::atomic<uint64_t> reportsSkipped { 0 };   // unchanged report, dropped by the dedupe
+        std::atomic<uint64_t> reportsCoalesced { 0 }; // held by the output scheduler and replaced before going out
+        std::atomic<uint64_t> reportsSubmitted { 0 };
+        std::atomic<uint64_t> reportsResent { 0 };    // fixed rate resends of an unchanged report (also in submitted)
+        std::atomic<uint64_t> readErrors { 0 };
+        std::atomic<uint64_t> bufferOverflows { 0 };  // buffered input dropped by the device, resynced from a snapshot
+        std::atomic<uint64_t> reacquires { 0 };       // device access lost to another app / focus change and taken back
+        std::atomic<uint64_t> deviceLosses { 0 };     // reads failed and recovery started (see DeviceRecovery)
+        std::atomic<uint64_t> recoveryAttempts { 0 };
+        std::atomic<uint64_t> recoveries { 0 };
+        std::atomic<int64_t>  connectedNs { 0 };      // Clock::nowNs() when the pad was detected
+        std::atomic<int64_t>  readyNs { 0 };          // when opening it finished, 0 until then
+        std::atomic<int64_t>  firstReportNs { 0 };    // when its first report reached the virtual pad, 0 until then
+    };
+
+    // Written by the submit thread, on cache lines of their own so its
+    // writes don't keep pulling the pad thread's counters away
+    struct alignas(64) SubmitSide
+    {
+        // handed to the submit thread and replaced before it sent them (also in submitted)
+        std::atomic<uint64_t> reportsSuperseded { 0 };
+        LatencyHistogram      staleness; // state read -> virtual pad update returned
+    };
+
+    Counters         counters;
+    LatencyHistogram stages[STAGE_COUNT];
+    LatencyHistogram recoveryTimes;         // device lost -> reading again
+    SubmitSide       submit;
+    const char*      inputMode { "event" }; // EventLoop::modeName of the servicing loop, set before it runs
+
+    // Single writer increment without a locked read-modify-write
+    static void increment(std::atomic<uint64_t>& counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Timestamps (Clock::nowNs) taken at each stage of one report
+    void recordReport(int64_t wokeNs, int64_t readNs, int64_t convertedNs, int64_t submittedNs)
+    {
+        stages[READ].record(readNs - wokeNs);
+        stages[CONVERT].record(convertedNs - readNs);
+        stages[SUBMIT].record(submittedNs - convertedNs);
+        stages[TOTAL].record(submittedNs - wokeNs);
+    }
+
+    // Detection to first virtual pad update, -1 before there was one
+    int64_t timeToFirstReportNs() const
+    {
+        const auto firstNs = counters.firstReportNs.load(std::memory_order_relaxed);
+        return firstNs ? firstNs - counters.connectedNs.load(std::memory_order_relaxed) : -1;
+    }
+
+    // Virtual pad updates avoided: deduped, coalesced and superseded reports
+    uint64_t updatesSaved() const
+    {
+        return counters.reportsSkipped.load(std::memory_order_relaxed) + counters.reportsCoalesced.load(std::memory_order_relaxed) +
+               submit.reportsSuperseded.load(std::memory_order_relaxed);
+    }
+
+    // Only while no thread is recording, e.g. before a pooled pad is reused
+    void reset();
+
+    // Counters, p50/p99/p999/max per stage and the wake to submit jitter
+    void print(std::ostream& out, const std::string& name) const;
+};
@@ -0,0 +1,29 @@
+#include "DeviceDescriptors.h"
+
+static_assert(DeviceTypes::kAll[0].productId == N64Pad::kProductId, "n64() is the first entry");
+static_assert(DeviceTypes::kAll[0].productGuid.data1 == 0x2019057e, "the N64 pad's DirectInput product GUID");
+
+const DeviceType* DeviceTypes::find(uint16_t vendorId, uint16_t productId)
+{
+    for (const auto& type : kAll)
+    {
+        if (type.vendorId == vendorId && type.productId == productId)
+            return &type;
+    }
+    return nullptr;
+}
+
+const DeviceType* DeviceTypes::find(const DeviceGuid& productGuid)
+{
+    for (const auto& type : kAll)
+    {
+        if (type.productGuid == productGuid)
+            return &type;
+    }
+    return nullptr;
+}
+
+const DeviceType& DeviceTypes::n64()
+{
+    return kAll[0];
+}
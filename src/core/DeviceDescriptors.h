@@ -0,0 +1,312 @@
+#pragma once
+
+#include "DeviceGuid.h"
+#include "Mapping.h"
+#include "MappingTables.h"
+#include "N64ControllerState.h"
+#include "Profile.h"
+#include "XusbReport.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Device descriptors
+//
+//  The Nintendo Switch Online wireless pads the bridge drives. They all
+//  present the layout of the Switch's simple HID mode (a hat, up to four
+//  axes, 16 buttons), so every backend reads them into N64ControllerState;
+//  what differs per pad is the product id, which of those objects it has
+//  and what its buttons should press.
+//
+//  A descriptor is a struct of constexpr members and SupportedPads lists
+//  them. Everything per pad is generated from the list at compile time:
+//  DeviceType::of<Pad>() is the record the detectors match on,
+//  DeviceTypes::convert<Pad> the pad's conversion routine (a pad without
+//  sticks never touches the axis tables), DInputBackend's data formats. A
+//  pad picks its routine once when it's opened; nothing in the per-report
+//  path branches on the pad type.
+//
+//  Adding a pad: a descriptor below and an entry in SupportedPads.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+static constexpr uint16_t kNintendoVendorId = 0x057e;
+
+// The product GUID DirectInput reports for a HID device:
+// "<product><vendor>-0000-0000-0000-504944564944" ("PIDVID")
+constexpr DeviceGuid productGuid(uint16_t vendorId, uint16_t productId)
+{
+    return { (static_cast<uint32_t>(productId) << 16) | vendorId, 0x0000, 0x0000, { 0x00, 0x00, 0x50, 0x49, 0x44, 0x56, 0x49, 0x44 } };
+}
+
+// Buttons of the SNES and Genesis pads, by the N64ControllerState::buttons
+// slot the Switch layout puts them in
+namespace SnesButton
+{
+enum : uint32_t
+{
+    B       = 0,
+    A       = 1,
+    Y       = 2,
+    X       = 3,
+    L       = 4,
+    R       = 5,
+    ZL      = 6,
+    ZR      = 7,
+    SELECT  = 8,
+    START   = 9,
+    HOME    = 12,
+    CAPTURE = 13
+};
+}
+
+namespace GenesisButton
+{
+enum : uint32_t
+{
+    B       = 0,
+    C       = 1,
+    A       = 2,
+    Y       = 3,
+    X       = 4,
+    Z       = 5,
+    MODE    = 8,
+    START   = 9,
+    HOME    = 12,
+    CAPTURE = 13
+};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Descriptors
+//
+//  kSticks:   the pad has the axes (xAxis/yAxis; xRotation/yRotation)
+//  kButtons:  the buttons[] slots it reports, as a pressed mask
+//  kMapping:  wButtons each slot presses by default
+//  kLeftTrigger / kRightTrigger: slots that pull a trigger fully
+//  kCStick:   the C-buttons drive the right stick
+//  kProfiles: profile files apply; they name N64 buttons, so only the N64
+//             pad takes them and the others keep their default mapping
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct N64Pad
+{
+    static constexpr const char* kName      = "N64";
+    static constexpr uint16_t    kProductId = 0x2019;
+
+    static constexpr bool     kSticks  = true;
+    static constexpr uint16_t kButtons = 0x37FF;
+
+    static constexpr uint16_t kMapping[16] =
+    {
+        Xusb::B,                // B
+        Xusb::A,                // A
+        0,                      // C_UP
+        0,                      // C_LEFT
+        Xusb::LEFT_SHOULDER,    // L
+        Xusb::RIGHT_SHOULDER,   // R
+        0,                      // Z: left trigger
+        0,                      // C_DOWN
+        0,                      // C_RIGHT
+        Xusb::START,            // START
+        Xusb::X,                // ZR
+        0,
+        Xusb::GUIDE,            // HOME
+        Xusb::BACK,             // CIRCLE
+        0,
+        0
+    };
+    static constexpr uint16_t kLeftTrigger  = 1u << N64Button::Z;
+    static constexpr uint16_t kRightTrigger = 0;
+    static constexpr bool     kCStick       = true;
+    static constexpr bool     kProfiles     = true;
+};
+
+// Buttons by position: the SNES diamond onto the Xbox one (B is the bottom
+// face button, so it's Xbox A)
+struct SnesPad
+{
+    static constexpr const char* kName      = "SNES";
+    static constexpr uint16_t    kProductId = 0x2017;
+
+    static constexpr bool     kSticks  = false;
+    static constexpr uint16_t kButtons = 0x33FF;
+
+    static constexpr uint16_t kMapping[16] =
+    {
+        Xusb::A,                // B
+        Xusb::B,                // A
+        Xusb::X,                // Y
+        Xusb::Y,                // X
+        Xusb::LEFT_SHOULDER,    // L
+        Xusb::RIGHT_SHOULDER,   // R
+        0,                      // ZL: left trigger
+        0,                      // ZR: right trigger
+        Xusb::BACK,             // SELECT
+        Xusb::START,            // START
+        0,
+        0,
+        Xusb::GUIDE,            // HOME
+        0,                      // CAPTURE
+        0,
+        0
+    };
+    static constexpr uint16_t kLeftTrigger  = 1u << SnesButton::ZL;
+    static constexpr uint16_t kRightTrigger = 1u << SnesButton::ZR;
+    static constexpr bool     kCStick       = false;
+    static constexpr bool     kProfiles     = false;
+};
+
+// Bottom row A B C onto X A B, top row X Y Z onto LB Y RB
+struct GenesisPad
+{
+    static constexpr const char* kName      = "Genesis";
+    static constexpr uint16_t    kProductId = 0x201e;
+
+    static constexpr bool     kSticks  = false;
+    static constexpr uint16_t kButtons = 0x333F;
+
+    static constexpr uint16_t kMapping[16] =
+    {
+        Xusb::A,                // B
+        Xusb::B,                // C
+        Xusb::X,                // A
+        Xusb::Y,                // Y
+        Xusb::LEFT_SHOULDER,    // X
+        Xusb::RIGHT_SHOULDER,   // Z
+        0,
+        0,
+        Xusb::BACK,             // MODE
+        Xusb::START,            // START
+        0,
+        0,
+        Xusb::GUIDE,            // HOME
+        0,                      // CAPTURE
+        0,
+        0
+    };
+    static constexpr uint16_t kLeftTrigger  = 0;
+    static constexpr uint16_t kRightTrigger = 0;
+    static constexpr bool     kCStick       = false;
+    static constexpr bool     kProfiles     = false;
+};
+
+template <typename... Pads>
+struct PadList
+{
+    static constexpr size_t kCount = sizeof...(Pads);
+};
+
+using SupportedPads = PadList<N64Pad, SnesPad, GenesisPad>;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Generated per pad
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace DeviceTypes
+{
+
+// The pad's default mapping as a profile; calibration is the N64 stick's
+template <typename Pad>
+Profile defaultProfile()
+{
+    Profile profile;
+    profile.name = "default";
+    for (uint32_t i = 0; i < 16; i++)
+        profile.buttons[i] = Pad::kMapping[i];
+    profile.leftTrigger  = Pad::kLeftTrigger;
+    profile.rightTrigger = Pad::kRightTrigger;
+    profile.cStick       = Pad::kCStick;
+
+    profile.xAxis = { Mapping::X_MIN, Mapping::X_MAX, Mapping::X_DEADZONE_START, Mapping::X_DEADZONE_END, DeadzoneShape::SNAP, 1.0f, false };
+    profile.yAxis = { Mapping::Y_MIN, Mapping::Y_MAX, Mapping::Y_DEADZONE_START, Mapping::Y_DEADZONE_END, DeadzoneShape::SNAP, 1.0f, true };
+    return profile;
+}
+
+template <typename Pad>
+const MappingTables& defaultTables()
+{
+    static const MappingTables tables(defaultProfile<Pad>());
+    return tables;
+}
+
+// Profile::defaults() is the N64 pad's
+template <>
+inline const MappingTables& defaultTables<N64Pad>()
+{
+    return MappingTables::defaults();
+}
+
+// The pad's conversion routine. Slots it doesn't have never press anything,
+// whatever the driver leaves in them.
+template <typename Pad>
+void convert(const MappingTables& tables, const N64ControllerState& state, XusbReport& report)
+{
+    const auto pressed = static_cast<uint16_t>(MappingTables::pressedMask(state) & Pad::kButtons);
+    if constexpr (Pad::kSticks)
+        tables.convert(state.xAxis, state.yAxis, state.dpad, pressed, report);
+    else
+        tables.convertButtons(state.dpad, pressed, report);
+}
+
+}
+
+// What the detectors match on and a pad is converted with
+struct DeviceType
+{
+    using Convert = void (*)(const MappingTables& tables, const N64ControllerState& state, XusbReport& report);
+    using Tables  = const MappingTables& (*)();
+
+    const char* name;
+    uint16_t    vendorId;
+    uint16_t    productId;
+    DeviceGuid  productGuid;
+    bool        sticks;
+    uint16_t    buttons;
+    bool        profiles;
+    Convert     convert;
+    Tables      defaultTables;
+
+    template <typename Pad>
+    static constexpr DeviceType of()
+    {
+        return {
+            Pad::kName,
+            kNintendoVendorId,
+            Pad::kProductId,
+            ::productGuid(kNintendoVendorId, Pad::kProductId),
+            Pad::kSticks,
+            Pad::kButtons,
+            Pad::kProfiles,
+            &DeviceTypes::convert<Pad>,
+            &DeviceTypes::defaultTables<Pad>
+        };
+    }
+};
+
+namespace DeviceTypes
+{
+
+template <typename... Pads>
+constexpr std::array<DeviceType, sizeof...(Pads)> describe(PadList<Pads...>)
+{
+    return { { DeviceType::of<Pads>()... } };
+}
+
+inline constexpr auto kAll = describe(SupportedPads{});
+
+// One pass over kAll; nullptr for anything else
+const DeviceType* find(uint16_t vendorId, uint16_t productId);
+const DeviceType* find(const DeviceGuid& productGuid);
+
+// What sources that can't tell report, and what conversion starts with
+const DeviceType& n64();
+
+}
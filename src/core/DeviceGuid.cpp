@@ -0,0 +1,34 @@
+#include "DeviceGuid.h"
+
+#include <cstdio>
+
+std::string DeviceGuid::toString() const
+{
+    char text[37];
+    snprintf(text, sizeof(text),
+             "%08x-%04x-%04x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+             data1, data2, data3,
+             data4[0], data4[1], data4[2], data4[3],
+             data4[4], data4[5], data4[6], data4[7]);
+    return std::string(text);
+}
+
+bool DeviceGuid::fromString(const char* text, DeviceGuid& out)
+{
+    unsigned int fields[11];
+    int consumed = 0;
+    const int parsed = sscanf(text,
+                              "%8x-%4x-%4x-%2x%2x-%2x%2x%2x%2x%2x%2x%n",
+                              &fields[0], &fields[1], &fields[2],
+                              &fields[3], &fields[4], &fields[5], &fields[6],
+                              &fields[7], &fields[8], &fields[9], &fields[10], &consumed);
+    if (parsed != 11 || consumed != 36)
+        return false;
+
+    out.data1 = fields[0];
+    out.data2 = static_cast<uint16_t>(fields[1]);
+    out.data3 = static_cast<uint16_t>(fields[2]);
+    for (int i = 0; i < 8; i++)
+        out.data4[i] = static_cast<uint8_t>(fields[3 + i]);
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Device GUID
+//
+//  Portable 16 byte mirror of the Win32 GUID used for DirectInput product and
+//  instance ids, so matching and diffing never go through strings.
+//  Comparison is bytewise, which is all sorting and lookups need.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct DeviceGuid
+{
+    uint32_t data1;
+    uint16_t data2;
+    uint16_t data3;
+    uint8_t  data4[8];
+
+    bool operator==(const DeviceGuid& other) const { return memcmp(this, &other, sizeof(DeviceGuid)) == 0; }
+    bool operator!=(const DeviceGuid& other) const { return !(*this == other); }
+    bool operator<(const DeviceGuid& other) const  { return memcmp(this, &other, sizeof(DeviceGuid)) < 0; }
+
+    // "2019057e-0000-0000-0000-504944564944"
+    std::string toString() const;
+    static bool fromString(const char* text, DeviceGuid& out);
+};
+
+static_assert(sizeof(DeviceGuid) == 16, "DeviceGuid mirrors GUID");
+
+struct DeviceGuidHash
+{
+    size_t operator()(const DeviceGuid& guid) const
+    {
+        uint64_t words[2];
+        memcpy(words, &guid, sizeof(words));
+        uint64_t hash = words[0] * 0x9E3779B97F4A7C15ull ^ words[1];
+        hash ^= hash >> 29;
+        return static_cast<size_t>(hash * 0xBF58476D1CE4E5B9ull);
+    }
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Lock scopes for the API wrappers
+//
+//  Lifecycle calls (create, enumerate, release, plug in/out) take the global
+//  lock. Per report calls on a single device or target only take that
+//  device's stripe, so one pad's blocking IOCTL never stalls another pad.
+//  Lifecycle calls on a device take both, which keeps them serialized with
+//  that device's hot path.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class DeviceLocks
+{
+public:
+    static constexpr size_t kStripes = 64;
+
+    std::mutex& global()
+    {
+        return global_;
+    }
+
+    std::mutex& forDevice(const void* device)
+    {
+        // Devices are heap objects; drop the alignment bits before mixing
+        auto key = reinterpret_cast<uintptr_t>(device) >> 4;
+        key ^= key >> 17;
+        key *= 0x9E3779B1u;
+        return stripes_[(key >> 7) % kStripes].mutex;
+    }
+
+private:
+    // One cache line each so neighbouring pads don't false share
+    struct alignas(64) Stripe
+    {
+        std::mutex mutex;
+    };
+
+    std::mutex global_;
+    Stripe     stripes_[kStripes];
+};
+
+// Global + device stripe, always acquired in that order
+class LifecycleLock
+{
+public:
+    LifecycleLock(DeviceLocks& locks, const void* device)
+        : global_(locks.global())
+        , device_(locks.forDevice(device))
+    {   }
+
+private:
+    std::lock_guard<std::mutex> global_;
+    std::lock_guard<std::mutex> device_;
+};
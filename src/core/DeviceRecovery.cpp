@@ -0,0 +1,49 @@
+#include "DeviceRecovery.h"
+
+#include <algorithm>
+
+DeviceRecovery::DeviceRecovery(uint64_t seed)
+    : random_(seed ? seed : 1)
+{
+}
+
+bool DeviceRecovery::lost(int64_t nowNs)
+{
+    recovering_ = true;
+    lostNs_     = nowNs;
+    if (hasRecovered_ && nowNs - recoveredNs_ < kSettleNs)
+        return false;
+
+    intervalNs_ = kFirstRetryNs;
+    failures_   = 0;
+    return true;
+}
+
+int64_t DeviceRecovery::failed()
+{
+    failures_++;
+    const auto intervalNs = intervalNs_;
+    intervalNs_ = (std::min)(intervalNs_ * 2, kMaxRetryNs);
+
+    // "Equal jitter": never sooner than half the interval, so the backoff
+    // still backs off
+    const auto half = intervalNs / 2;
+    return half + static_cast<int64_t>(next() % static_cast<uint64_t>(half + 1));
+}
+
+int64_t DeviceRecovery::recovered(int64_t nowNs)
+{
+    recovering_   = false;
+    hasRecovered_ = true;
+    recoveredNs_  = nowNs;
+    return nowNs - lostNs_;
+}
+
+uint64_t DeviceRecovery::next()
+{
+    // xorshift64
+    random_ ^= random_ << 13;
+    random_ ^= random_ >> 7;
+    random_ ^= random_ << 17;
+    return random_;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Device loss recovery
+//
+//  What a pad does when its device stops reading (lost to a focus change
+//  or another app, a radio blip): one attempt to take it back right away,
+//  then attempts at exponentially growing intervals, each cut by a random
+//  jitter so pads lost together don't all retry in the same instant. The
+//  intervals stop growing at kMaxRetryNs; the pad keeps trying until the
+//  device is back or the hotplug detector removes it. A device that fails
+//  again within kSettleNs of coming back picks up the backoff where it left
+//  off, so a flapping device doesn't get retried flat out.
+//
+//  Only the timing lives here; Controller makes the attempts. Single
+//  threaded, owned by the thread servicing the pad.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class DeviceRecovery
+{
+public:
+    static constexpr int64_t kFirstRetryNs = 4000000;     // after the immediate attempt
+    static constexpr int64_t kMaxRetryNs   = 1000000000;
+    static constexpr int64_t kSettleNs     = 100000000;
+
+public:
+    explicit DeviceRecovery(uint64_t seed = 1);
+
+    bool recovering() const { return recovering_; }
+
+    // The device failed a read and recovery starts. True when the first
+    // attempt is due now, false when it's flapping: wait failed() first.
+    bool lost(int64_t nowNs);
+
+    // An attempt failed; returns the delay before the next one, somewhere
+    // between half and all of the current interval
+    int64_t failed();
+
+    // The device is back; returns how long it was gone
+    int64_t recovered(int64_t nowNs);
+
+    // Failed attempts in the current (or last) recovery
+    uint32_t failures() const { return failures_; }
+
+private:
+    uint64_t next();
+
+private:
+    bool     recovering_ { false };
+    bool     hasRecovered_ { false };
+    int64_t  lostNs_ { 0 };
+    int64_t  recoveredNs_ { 0 };
+    int64_t  intervalNs_ { kFirstRetryNs };
+    uint32_t failures_ { 0 };
+    uint64_t random_;
+};
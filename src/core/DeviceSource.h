@@ -0,0 +1,37 @@
+#pragma once
+
+#include "DeviceGuid.h"
+
+#include <cstdint>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Device source
+//
+//  Where the hotplug detector gets pads from: a platform enumeration plus a
+//  change notification (device arrival / removal) to wait on. Sources that
+//  have no notifications just time out and the detector falls back to
+//  polling.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class DeviceSource
+{
+public:
+    static constexpr uint32_t kWaitForever = UINT32_MAX;
+
+public:
+    virtual ~DeviceSource() = default;
+
+    // Appends the instance GUID of every attached pad. `out` is cleared by
+    // the caller and keeps its capacity between scans.
+    virtual void enumerate(std::vector<DeviceGuid>& out) = 0;
+
+    // Blocks until a device change notification, wake() or the timeout.
+    // Returns true when a change was signalled.
+    virtual bool waitForChange(uint32_t timeoutMs) = 0;
+
+    // Makes a blocked (or the next) waitForChange() return; thread safe
+    virtual void wake() = 0;
+};
@@ -0,0 +1,350 @@
+#include "EventLoop.h"
+#include "Clock.h"
+#include "Log.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+
+namespace
+{
+
+// Keeps a polling core from hammering the memory bus (and yields the
+// pipeline to a sibling hyperthread)
+inline void cpuRelax()
+{
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+// Floor of the adaptive hybrid spin
+constexpr int64_t kMinSpinNs = 2000;
+
+}
+
+EventLoop::~EventLoop() = default;
+
+#if !defined(_WIN32) && !defined(__linux__)
+std::unique_ptr<EventLoop> EventLoop::create()
+{
+    return nullptr;
+}
+#endif
+
+const char* EventLoop::modeName(WaitMode mode)
+{
+    switch (mode)
+    {
+    case EVENT:     return "event";
+    case HYBRID:    return "hybrid";
+    case BUSY_POLL: return "poll";
+    default:        return "?";
+    }
+}
+
+void EventLoop::setStrategy(const Strategy& strategy)
+{
+    strategy_ = strategy;
+    spinNs_   = strategy.spinNs;
+}
+
+bool EventLoop::onLoopThread() const
+{
+    return std::this_thread::get_id() == loopThread_;
+}
+
+bool EventLoop::apply(Command& command)
+{
+    if (command.add)
+    {
+        auto it = entries_.find(command.handle);
+        if ((it != entries_.end() && !it->second.removed) || count_ >= capacity())
+            return false;
+        if (!backendAdd(command.handle))
+            return false;
+
+        // A handle removed earlier in the same dispatch batch can come back
+        entries_[command.handle] = Entry{ std::move(command.callback), false };
+        count_++;
+        return true;
+    }
+
+    auto it = entries_.find(command.handle);
+    if (it == entries_.end() || it->second.removed)
+        return false;
+
+    backendRemove(command.handle);
+    count_--;
+
+    // Erasing would destroy the callback if it is the one removing itself;
+    // mark it and let the loop erase it after the dispatch batch
+    if (running_ && onLoopThread())
+        it->second.removed = true;
+    else
+        entries_.erase(it);
+    return true;
+}
+
+void EventLoop::applyPending()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (commands_.empty())
+        return;
+
+    for (auto& command : commands_)
+    {
+        *command.result = apply(command);
+        *command.done   = true;
+    }
+    commands_.clear();
+    commandsDone_.notify_all();
+}
+
+bool EventLoop::add(EventHandle handle, Callback callback)
+{
+    bool result = false;
+    bool done   = false;
+    Command command{ true, handle, std::move(callback), &result, &done };
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_ || onLoopThread())
+        return apply(command);
+
+    commands_.push_back(std::move(command));
+    backendWake();
+    commandsDone_.wait(lock, [&]{ return done; });
+    return result;
+}
+
+void EventLoop::remove(EventHandle handle)
+{
+    bool result = false;
+    bool done   = false;
+    Command command{ false, handle, nullptr, &result, &done };
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_ || onLoopThread())
+    {
+        apply(command);
+        return;
+    }
+
+    // The loop applies commands between dispatch batches, so once this
+    // returns the callback is not running
+    commands_.push_back(std::move(command));
+    backendWake();
+    commandsDone_.wait(lock, [&]{ return done; });
+}
+
+bool EventLoop::wait(std::vector<EventHandle>& ready)
+{
+    bool woken = false;
+    if (strategy_.mode == EVENT)
+        return backendWait(ready, -1, woken);
+
+    // Poll without sleeping; stop() and add() / remove() still get through
+    // since the wake signal ends the spin like any other handle
+    const auto startNs = Clock::nowNs();
+    const bool forever = strategy_.mode == BUSY_POLL;
+    for (;;)
+    {
+        if (!backendWait(ready, 0, woken))
+            return false;
+        if (!ready.empty() || woken)
+        {
+            // Caught while spinning: give the spin back some room
+            if (!forever && !ready.empty())
+                spinNs_ = (std::min)(strategy_.spinNs, spinNs_ * 2);
+            return true;
+        }
+        if (!forever && Clock::nowNs() - startNs >= spinNs_)
+            break;
+        cpuRelax();
+    }
+
+    // The spin missed; input is arriving slower than it spins, so back off
+    spinNs_ = (std::max)(kMinSpinNs, spinNs_ / 2);
+    return backendWait(ready, -1, woken);
+}
+
+void EventLoop::run()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopRequested_)
+        {
+            stopRequested_ = false;
+            return;
+        }
+        running_    = true;
+        loopThread_ = std::this_thread::get_id();
+    }
+
+    std::vector<EventHandle> ready;
+    std::vector<EventHandle> removed;
+    for (;;)
+    {
+        applyPending();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopRequested_)
+                break;
+        }
+
+        ready.clear();
+        if (!wait(ready))
+            break;
+
+        for (const auto handle : ready)
+        {
+            auto it = entries_.find(handle);
+            if (it == entries_.end() || it->second.removed)
+                continue;
+            it->second.callback();
+        }
+
+        // Drop entries whose callbacks removed themselves
+        for (auto it = entries_.begin(); it != entries_.end();)
+        {
+            if (it->second.removed)
+                it = entries_.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    // Complete anything still queued so no caller waits forever
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_       = false;
+    stopRequested_ = false;
+    loopThread_    = std::thread::id();
+    for (auto& command : commands_)
+    {
+        *command.result = apply(command);
+        *command.done   = true;
+    }
+    commands_.clear();
+    commandsDone_.notify_all();
+}
+
+void EventLoop::stop()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopRequested_ = true;
+    backendWake();
+}
+
+size_t EventLoop::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Reactor
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Reactor::Reactor(size_t threads, const EventLoop::Strategy& strategy, const ThreadSettings& settings)
+    : strategy_(strategy)
+{
+    for (size_t i = 0; i < threads; i++)
+    {
+        auto loop = EventLoop::create();
+        if (!loop)
+            break;
+        loop->setStrategy(strategy);
+        loops_.push_back(std::move(loop));
+        load_.push_back(0);
+    }
+
+    for (size_t i = 0; i < loops_.size(); i++)
+    {
+        auto loopSettings = settings;
+        if (settings.cpu >= 0)
+            loopSettings.cpu = settings.cpu + static_cast<int32_t>(i);
+        threads_.emplace_back([this, i, loopSettings]
+        {
+            Log::attachThread();
+            ThreadTuning::apply(loopSettings);
+            loops_[i]->run();
+        });
+    }
+}
+
+Reactor::~Reactor()
+{
+    for (auto& loop : loops_)
+        loop->stop();
+    for (auto& thread : threads_)
+        thread.join();
+}
+
+bool Reactor::add(EventHandle handle, EventLoop::Callback callback)
+{
+    size_t index = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (loops_.empty() || owners_.count(handle))
+            return false;
+
+        for (size_t i = 1; i < loops_.size(); i++)
+            if (load_[i] < load_[index])
+                index = i;
+        if (load_[index] >= loops_[index]->capacity())
+            return false;
+
+        owners_[handle] = index;
+        load_[index]++;
+    }
+    return addTo(index, handle, std::move(callback));
+}
+
+bool Reactor::addAlongside(EventHandle handle, EventHandle alongside, EventLoop::Callback callback)
+{
+    size_t index = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = owners_.find(alongside);
+        if (it == owners_.end() || owners_.count(handle))
+            return false;
+
+        index = it->second;
+        if (load_[index] >= loops_[index]->capacity())
+            return false;
+
+        owners_[handle] = index;
+        load_[index]++;
+    }
+    return addTo(index, handle, std::move(callback));
+}
+
+bool Reactor::addTo(size_t index, EventHandle handle, EventLoop::Callback callback)
+{
+    if (loops_[index]->add(handle, std::move(callback)))
+        return true;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    owners_.erase(handle);
+    load_[index]--;
+    return false;
+}
+
+void Reactor::remove(EventHandle handle)
+{
+    size_t index = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = owners_.find(handle);
+        if (it == owners_.end())
+            return;
+        index = it->second;
+        owners_.erase(it);
+        load_[index]--;
+    }
+    loops_[index]->remove(handle);
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "ThreadTuning.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Event loop
+//
+//  Waits on many waitable handles at once and runs a callback for each one
+//  that fires. A handle is a Win32 event HANDLE on Windows and a file
+//  descriptor (eventfd, evdev node, ...) on Linux.
+//
+//  add() and remove() are safe from any thread while the loop is running,
+//  including from inside a callback. Once remove() returns the handle's
+//  callback is not running and will not be called again.
+//
+//  How the loop waits is its strategy: EVENT blocks in the kernel until a
+//  handle fires; BUSY_POLL never sleeps, polling the handles without a
+//  timeout so input is seen the moment it lands, at the cost of a core;
+//  HYBRID polls for a while before blocking. The hybrid spin adapts: it
+//  halves when input keeps arriving after the spin gave up and grows back
+//  toward the configured budget while the spin catches it.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using EventHandle = intptr_t;
+
+class EventLoop
+{
+public:
+    using Callback = std::function<void()>;
+
+    enum WaitMode : uint8_t
+    {
+        EVENT,
+        HYBRID,
+        BUSY_POLL,
+    };
+
+    struct Strategy
+    {
+        WaitMode mode { EVENT };
+        int64_t  spinNs { 200000 }; // HYBRID: longest spin before blocking
+    };
+
+    static const char* modeName(WaitMode mode);
+
+public:
+    virtual ~EventLoop();
+
+    // Platform backend (WaitForMultipleObjects or epoll); nullptr when the
+    // platform has none
+    static std::unique_ptr<EventLoop> create();
+
+    bool add(EventHandle handle, Callback callback);
+    void remove(EventHandle handle);
+
+    // Before run()
+    void setStrategy(const Strategy& strategy);
+
+    // Dispatches callbacks on the calling thread until stop()
+    void run();
+    void stop();
+
+    size_t size() const;
+    virtual size_t capacity() const = 0;
+
+protected:
+    EventLoop() = default;
+
+    virtual bool backendAdd(EventHandle handle) = 0;
+    virtual void backendRemove(EventHandle handle) = 0;
+    virtual void backendWake() = 0;
+
+    // Waits up to timeoutMs (-1 = forever, 0 = just poll) for a handle or
+    // the wake signal and appends the ready handles; woken is set when the
+    // wake signal fired. Returns false on a fatal error.
+    virtual bool backendWait(std::vector<EventHandle>& ready, int timeoutMs, bool& woken) = 0;
+
+private:
+    struct Command
+    {
+        bool        add;
+        EventHandle handle;
+        Callback    callback;
+        bool*       result;
+        bool*       done;
+    };
+
+    struct Entry
+    {
+        Callback callback;
+        bool     removed { false };
+    };
+
+    bool apply(Command& command);
+    bool wait(std::vector<EventHandle>& ready);
+    void applyPending();
+    bool onLoopThread() const;
+
+private:
+    mutable std::mutex      mutex_;
+    std::condition_variable commandsDone_;
+    std::vector<Command>    commands_;
+    bool                    running_ { false };
+    bool                    stopRequested_ { false };
+    std::thread::id         loopThread_;
+
+    // Only touched by the loop thread while running
+    std::unordered_map<EventHandle, Entry> entries_;
+    size_t                                 count_ { 0 };
+    Strategy                               strategy_;
+    int64_t                                spinNs_ { 0 }; // current adaptive HYBRID spin
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Reactor
+//
+//  A small pool of event loop threads. Handles go to the least loaded loop.
+//  Every loop waits with the same strategy; its thread applies the thread
+//  settings, loop i pinned to settings.cpu + i when a CPU is given.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class Reactor
+{
+public:
+    explicit Reactor(size_t threads, const EventLoop::Strategy& strategy = {}, const ThreadSettings& settings = {});
+    ~Reactor();
+
+    bool valid() const { return !loops_.empty(); }
+    const EventLoop::Strategy& strategy() const { return strategy_; }
+
+    bool add(EventHandle handle, EventLoop::Callback callback);
+
+    // On the same loop as `alongside`, so the two callbacks never run
+    // concurrently
+    bool addAlongside(EventHandle handle, EventHandle alongside, EventLoop::Callback callback);
+
+    void remove(EventHandle handle);
+
+private:
+    bool addTo(size_t index, EventHandle handle, EventLoop::Callback callback);
+
+private:
+    EventLoop::Strategy                      strategy_;
+    std::vector<std::unique_ptr<EventLoop>>  loops_;
+    std::vector<std::thread>                 threads_;
+    std::mutex                               mutex_;
+    std::unordered_map<EventHandle, size_t>  owners_;
+    std::vector<size_t>                      load_;
+};
@@ -0,0 +1,104 @@
+#include "EventLoop.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+
+namespace
+{
+
+// epoll + an eventfd for waking the loop. Registered descriptors are level
+// triggered, so callbacks must drain (read) their descriptor. One that hangs
+// up or errors (an unplugged evdev node) can't be drained and would be ready
+// on every wait: its callback runs once to see the error, then it leaves the
+// wait set until it is removed and added again.
+class EpollEventLoop : public EventLoop
+{
+public:
+    EpollEventLoop()
+    {
+        epoll_ = epoll_create1(EPOLL_CLOEXEC);
+        wake_  = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+        epoll_event event{};
+        event.events  = EPOLLIN;
+        event.data.fd = wake_;
+        epoll_ctl(epoll_, EPOLL_CTL_ADD, wake_, &event);
+    }
+
+    ~EpollEventLoop() override
+    {
+        close(wake_);
+        close(epoll_);
+    }
+
+    bool valid() const
+    {
+        return epoll_ >= 0 && wake_ >= 0;
+    }
+
+    size_t capacity() const override
+    {
+        return 4096;
+    }
+
+protected:
+    bool backendAdd(EventHandle handle) override
+    {
+        epoll_event event{};
+        event.events  = EPOLLIN;
+        event.data.fd = static_cast<int>(handle);
+        return epoll_ctl(epoll_, EPOLL_CTL_ADD, static_cast<int>(handle), &event) == 0;
+    }
+
+    void backendRemove(EventHandle handle) override
+    {
+        epoll_ctl(epoll_, EPOLL_CTL_DEL, static_cast<int>(handle), nullptr);
+    }
+
+    void backendWake() override
+    {
+        const uint64_t one = 1;
+        (void)!write(wake_, &one, sizeof(one));
+    }
+
+    bool backendWait(std::vector<EventHandle>& ready, int timeoutMs, bool& woken) override
+    {
+        epoll_event events[64];
+        int count = epoll_wait(epoll_, events, 64, timeoutMs);
+        if (count < 0)
+            return errno == EINTR;
+
+        for (int i = 0; i < count; i++)
+        {
+            if (events[i].data.fd == wake_)
+            {
+                uint64_t value;
+                (void)!read(wake_, &value, sizeof(value));
+                woken = true;
+                continue;
+            }
+            if (events[i].events & (EPOLLHUP | EPOLLERR))
+                epoll_ctl(epoll_, EPOLL_CTL_DEL, events[i].data.fd, nullptr);
+            ready.push_back(events[i].data.fd);
+        }
+        return true;
+    }
+
+private:
+    int epoll_ { -1 };
+    int wake_  { -1 };
+};
+
+}
+
+std::unique_ptr<EventLoop> EventLoop::create()
+{
+    auto loop = std::make_unique<EpollEventLoop>();
+    if (!loop->valid())
+        return nullptr;
+    return loop;
+}
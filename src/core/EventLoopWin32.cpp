@@ -0,0 +1,90 @@
+#include "EventLoop.h"
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <algorithm>
+
+namespace
+{
+
+// WaitForMultipleObjects over up to 63 handles plus a wake event. Registered
+// handles should be auto-reset events, which the wait resets for us.
+class Win32EventLoop : public EventLoop
+{
+public:
+    Win32EventLoop()
+    {
+        wake_ = CreateEvent(nullptr, false, false, nullptr);
+        handles_.push_back(wake_);
+    }
+
+    ~Win32EventLoop() override
+    {
+        CloseHandle(wake_);
+    }
+
+    bool valid() const
+    {
+        return wake_ != nullptr;
+    }
+
+    size_t capacity() const override
+    {
+        return MAXIMUM_WAIT_OBJECTS - 1;
+    }
+
+protected:
+    bool backendAdd(EventHandle handle) override
+    {
+        handles_.push_back(reinterpret_cast<HANDLE>(handle));
+        return true;
+    }
+
+    void backendRemove(EventHandle handle) override
+    {
+        handles_.erase(std::remove(handles_.begin() + 1, handles_.end(), reinterpret_cast<HANDLE>(handle)), handles_.end());
+    }
+
+    void backendWake() override
+    {
+        SetEvent(wake_);
+    }
+
+    bool backendWait(std::vector<EventHandle>& ready, int timeoutMs, bool& woken) override
+    {
+        const auto count  = static_cast<DWORD>(handles_.size());
+        const auto result = WaitForMultipleObjects(count, handles_.data(), false, timeoutMs < 0 ? INFINITE : static_cast<DWORD>(timeoutMs));
+        if (result == WAIT_TIMEOUT)
+            return true;
+        if (result >= WAIT_OBJECT_0 + count)
+            return false;
+
+        // WaitForMultipleObjects only reports the lowest signaled index;
+        // poll the ones after it so busy low slots can't starve the rest
+        for (DWORD i = result - WAIT_OBJECT_0; i < count; i++)
+        {
+            if (i != result - WAIT_OBJECT_0 && WaitForSingleObject(handles_[i], 0) != WAIT_OBJECT_0)
+                continue;
+            if (i != 0)
+                ready.push_back(reinterpret_cast<EventHandle>(handles_[i]));
+            else
+                woken = true;
+        }
+        return true;
+    }
+
+private:
+    HANDLE              wake_ { nullptr };
+    std::vector<HANDLE> handles_;
+};
+
+}
+
+std::unique_ptr<EventLoop> EventLoop::create()
+{
+    auto loop = std::make_unique<Win32EventLoop>();
+    if (!loop->valid())
+        return nullptr;
+    return loop;
+}
@@ -0,0 +1,95 @@
+#include "EventReplay.h"
+
+#include <cstddef>
+#include <cstring>
+
+namespace
+{
+
+constexpr uint32_t kButtonsBegin = offsetof(N64ControllerState, buttons);
+constexpr uint32_t kButtonsEnd   = kButtonsBegin + sizeof(N64ControllerState::buttons);
+
+bool isDigital(uint32_t offset)
+{
+    return offset == offsetof(N64ControllerState, dpad) || (offset >= kButtonsBegin && offset < kButtonsEnd);
+}
+
+int32_t* axis(N64ControllerState& state, uint32_t offset)
+{
+    switch (offset)
+    {
+    case offsetof(N64ControllerState, dpad):      return &state.dpad;
+    case offsetof(N64ControllerState, xAxis):     return &state.xAxis;
+    case offsetof(N64ControllerState, yAxis):     return &state.yAxis;
+    case offsetof(N64ControllerState, xRotation): return &state.xRotation;
+    case offsetof(N64ControllerState, yRotation): return &state.yRotation;
+    default:                                      return nullptr;
+    }
+}
+
+}
+
+void EventReplay::reset(const N64ControllerState& state)
+{
+    state_ = state;
+}
+
+bool EventReplay::apply(N64ControllerState& state, const InputEvent& event)
+{
+    if (event.offset >= kButtonsBegin && event.offset < kButtonsEnd)
+    {
+        const uint8_t value = (event.value & 0x80) ? 0x80 : 0;
+        uint8_t& button = state.buttons[event.offset - kButtonsBegin];
+        if (button == value)
+            return false;
+        button = value;
+        return true;
+    }
+
+    int32_t* field = axis(state, event.offset);
+    if (!field || *field == event.value)
+        return false;
+    *field = event.value;
+    return true;
+}
+
+bool EventReplay::digitalEqual(const N64ControllerState& a, const N64ControllerState& b)
+{
+    return a.dpad == b.dpad && memcmp(a.buttons, b.buttons, sizeof(a.buttons)) == 0;
+}
+
+size_t EventReplay::replay(const InputEvent* events, size_t count, N64ControllerState* out)
+{
+    size_t   emitted    = 0;
+    bool     dirty      = false;
+    bool     transition = false;  // a button / POV change is waiting to go out
+    uint32_t sequence   = 0;      // ...and the sequence it happened in
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const auto& event = events[i];
+        N64ControllerState next = state_;
+        if (!apply(next, event))
+            continue;
+
+        // A second transition from a later moment: the first one gets its own state
+        const bool digital = isDigital(event.offset);
+        if (digital && transition && event.sequence != sequence)
+        {
+            out[emitted++] = state_;
+            transition = false;
+        }
+
+        state_ = next;
+        dirty  = true;
+        if (digital)
+        {
+            transition = true;
+            sequence   = event.sequence;
+        }
+    }
+
+    if (dirty)
+        out[emitted++] = state_;
+    return emitted;
+}
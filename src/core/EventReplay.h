@@ -0,0 +1,55 @@
+#pragma once
+
+#include "N64ControllerState.h"
+
+#include <cstddef>
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Buffered input replay
+//
+//  Snapshot reads only see the latest state, so a button pressed and
+//  released between two wakeups is lost. Buffered sources instead hand over
+//  the device's event queue (DirectInput GetDeviceData, evdev frames), and
+//  EventReplay turns it back into the sequence of states the pad went
+//  through.
+//
+//  Every button and POV transition ends up in a state of its own. Axis
+//  events never start a new state; they are folded into the state that
+//  carries the next transition, or the final one. Axes are levels, not
+//  edges, so merging them can only move an axis update by a fraction of a
+//  millisecond and never loses one. Events sharing a sequence number
+//  happened together and go out in one state.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct InputEvent
+{
+    uint32_t offset;   // field offset in N64ControllerState, as DIDEVICEOBJECTDATA::dwOfs
+    int32_t  value;    // buttons 0x80 pressed / 0 released, axes and POV raw
+    uint32_t sequence; // equal for events that happened at the same time
+};
+
+class EventReplay
+{
+public:
+    // Where replay starts from: the device state when the queue was empty
+    void reset(const N64ControllerState& state);
+
+    const N64ControllerState& state() const { return state_; }
+
+    // Appends the states events lead through to out, which needs room for
+    // count states, and returns how many were appended
+    size_t replay(const InputEvent* events, size_t count, N64ControllerState* out);
+
+    // Applies one event to state. Returns false for offsets that aren't a
+    // field and for events that don't change anything.
+    static bool apply(N64ControllerState& state, const InputEvent& event);
+
+    // Buttons and POV equal, axes ignored
+    static bool digitalEqual(const N64ControllerState& a, const N64ControllerState& b);
+
+private:
+    N64ControllerState state_ {};
+};
@@ -0,0 +1,345 @@
+#include "FakeBackends.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Input
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct FakeInputBackend::Device
+{
+    std::mutex         mutex;
+    const DeviceType*  type { &DeviceTypes::n64() };
+    N64ControllerState state {};
+    bool               failReads { false };
+    int64_t            failedRecoveries { -1 };  // before recover() succeeds; -1 = not until reads are cleared
+    EventHandle        handle { -1 };
+
+    // Buffered mode: a bounded queue consumed from head
+    size_t                  bufferSize { 0 };
+    std::vector<InputEvent> queue;
+    size_t                  head { 0 };
+    bool                    overflowed { false };
+
+    Device()
+    {
+        state.dpad = -1;
+#if defined(_WIN32)
+        handle = reinterpret_cast<EventHandle>(CreateEvent(nullptr, FALSE, FALSE, nullptr));
+#else
+        handle = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#endif
+    }
+
+    ~Device()
+    {
+#if defined(_WIN32)
+        CloseHandle(reinterpret_cast<HANDLE>(handle));
+#else
+        close(static_cast<int>(handle));
+#endif
+    }
+
+    void signal()
+    {
+#if defined(_WIN32)
+        SetEvent(reinterpret_cast<HANDLE>(handle));
+#else
+        const uint64_t one = 1;
+        (void)!write(static_cast<int>(handle), &one, sizeof(one));
+#endif
+    }
+
+    // Auto-reset on Windows; the eventfd is level triggered and must be drained
+    void drain()
+    {
+#if !defined(_WIN32)
+        uint64_t count;
+        (void)!::read(static_cast<int>(handle), &count, sizeof(count));
+#endif
+    }
+};
+
+namespace
+{
+
+class FakeInputSource : public InputSource
+{
+public:
+    explicit FakeInputSource(std::shared_ptr<FakeInputBackend::Device> device)
+        : device_(std::move(device))
+    {   }
+
+    EventHandle handle() const override
+    {
+        return device_->handle;
+    }
+
+    const DeviceType& type() const override
+    {
+        std::lock_guard<std::mutex> lock(device_->mutex);
+        return *device_->type;
+    }
+
+    bool read(N64ControllerState& state) override
+    {
+        device_->drain();
+        std::lock_guard<std::mutex> lock(device_->mutex);
+        if (device_->failReads)
+            return false;
+        state = device_->state;
+        return true;
+    }
+
+    bool readBatch(InputBatch& batch) override
+    {
+        std::unique_lock<std::mutex> lock(device_->mutex);
+        if (device_->bufferSize == 0)
+        {
+            lock.unlock();
+            return InputSource::readBatch(batch);
+        }
+
+        device_->drain();
+        if (device_->failReads)
+            return false;
+
+        auto& queue = device_->queue;
+        auto& head  = device_->head;
+
+        // After an overflow the queue is no longer a complete history: replay
+        // what it holds, then resync from the current state like DirectInput
+        // callers do after DI_BUFFEROVERFLOW
+        batch.overflowed = device_->overflowed;
+        const size_t room  = batch.overflowed ? InputBatch::kCapacity - 1 : InputBatch::kCapacity;
+        const size_t count = (std::min)(queue.size() - head, room);
+        batch.count = replay_.replay(queue.data() + head, count, batch.states);
+        head += count;
+
+        if (batch.overflowed)
+        {
+            head = queue.size();
+            device_->overflowed = false;
+            replay_.reset(device_->state);
+            batch.states[batch.count++] = device_->state;
+        }
+
+        batch.more = head < queue.size();
+        if (!batch.more)
+        {
+            queue.clear();
+            head = 0;
+        }
+        else if (head >= device_->bufferSize)
+        {
+            // Keeps the queue within the capacity reserved up front
+            queue.erase(queue.begin(), queue.begin() + head);
+            head = 0;
+        }
+        return true;
+    }
+
+    bool recover() override
+    {
+        std::lock_guard<std::mutex> lock(device_->mutex);
+        if (device_->failReads && device_->failedRecoveries != 0)
+        {
+            if (device_->failedRecoveries > 0)
+                device_->failedRecoveries--;
+            return false;
+        }
+        device_->failReads        = false;
+        device_->failedRecoveries = -1;
+        replay_.reset(device_->state);
+        return true;
+    }
+
+    void seed()
+    {
+        std::lock_guard<std::mutex> lock(device_->mutex);
+        replay_.reset(device_->state);
+    }
+
+private:
+    std::shared_ptr<FakeInputBackend::Device> device_;
+    EventReplay                               replay_;
+};
+
+}
+
+FakeInputBackend::FakeInputBackend() = default;
+FakeInputBackend::~FakeInputBackend() = default;
+
+void FakeInputBackend::plug(const DeviceGuid& id, const DeviceType& type)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& pad = pads_[id];
+        if (!pad)
+            pad = std::make_shared<Device>();
+        std::lock_guard<std::mutex> padLock(pad->mutex);
+        pad->type = &type;
+    }
+    devices_.plug(id);
+}
+
+void FakeInputBackend::unplug(const DeviceGuid& id)
+{
+    devices_.unplug(id);
+}
+
+void FakeInputBackend::push(const DeviceGuid& id, const N64ControllerState& state)
+{
+    std::shared_ptr<Device> pad;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = pads_.find(id);
+        if (it == pads_.end())
+            return;
+        pad = it->second;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pad->mutex);
+        pad->state = state;
+    }
+    pad->signal();
+}
+
+void FakeInputBackend::pushEvents(const DeviceGuid& id, const InputEvent* events, size_t count)
+{
+    std::shared_ptr<Device> pad;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = pads_.find(id);
+        if (it == pads_.end())
+            return;
+        pad = it->second;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pad->mutex);
+        for (size_t i = 0; i < count; i++)
+        {
+            EventReplay::apply(pad->state, events[i]);
+            if (pad->bufferSize == 0)
+                continue;
+            if (pad->queue.size() - pad->head < pad->bufferSize)
+                pad->queue.push_back(events[i]);
+            else
+                pad->overflowed = true;
+        }
+    }
+    pad->signal();
+}
+
+void FakeInputBackend::setBufferSize(const DeviceGuid& id, size_t events)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pads_.find(id);
+    if (it == pads_.end())
+        return;
+    std::lock_guard<std::mutex> padLock(it->second->mutex);
+    auto& pad = *it->second;
+    pad.bufferSize = events;
+    pad.queue.clear();
+    pad.queue.reserve(events * 2);
+    pad.head       = 0;
+    pad.overflowed = false;
+}
+
+void FakeInputBackend::setReadFailure(const DeviceGuid& id, bool fail)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pads_.find(id);
+    if (it == pads_.end())
+        return;
+    std::lock_guard<std::mutex> padLock(it->second->mutex);
+    it->second->failReads        = fail;
+    it->second->failedRecoveries = -1;
+    if (fail)
+        it->second->signal();
+}
+
+void FakeInputBackend::loseDevice(const DeviceGuid& id, uint32_t failedRecoveries)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pads_.find(id);
+    if (it == pads_.end())
+        return;
+    std::lock_guard<std::mutex> padLock(it->second->mutex);
+    it->second->failReads        = true;
+    it->second->failedRecoveries = failedRecoveries;
+    it->second->signal();
+}
+
+DeviceSource& FakeInputBackend::devices()
+{
+    return devices_;
+}
+
+std::unique_ptr<InputSource> FakeInputBackend::open(const DeviceGuid& id)
+{
+    if (const auto delayMs = openDelayMs_.load())
+        std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pads_.find(id);
+    if (it == pads_.end())
+        return nullptr;
+    std::unique_ptr<FakeInputSource> source(new FakeInputSource(it->second));
+    source->seed();
+    return source;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Sink
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class FakeSinkBackend::Sink : public PadSink
+{
+public:
+    Sink(FakeSinkBackend& backend, uint32_t index)
+        : backend_(backend)
+        , index_(index)
+    {
+        backend_.live_++;
+    }
+
+    ~Sink() override
+    {
+        backend_.live_--;
+    }
+
+    void submit(const XusbReport& report) override
+    {
+        if (backend_.callback_)
+            backend_.callback_(index_, report);
+    }
+
+private:
+    FakeSinkBackend& backend_;
+    uint32_t         index_;
+};
+
+std::unique_ptr<PadSink> FakeSinkBackend::plug()
+{
+    if (const auto delayMs = plugDelayMs_.load())
+        std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+
+    return std::unique_ptr<PadSink>(new Sink(*this, created_++));
+}
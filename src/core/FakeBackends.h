@@ -0,0 +1,99 @@
+#pragma once
+
+#include "EventReplay.h"
+#include "FakeDeviceSource.h"
+#include "InputSource.h"
+#include "PadSink.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  In-memory input and sink backends
+//
+//  Drive the full Controller pipeline without hardware, DirectInput, ViGEm
+//  or /dev/uinput: plug() a pad, push() states into it and watch the
+//  reports arrive at the sink callback. The input handle is a real waitable
+//  (eventfd / Win32 event), so both thread and reactor servicing work.
+//
+//  With a buffer size set, a pad also behaves like a buffered DirectInput
+//  device: pushEvents() queues events the way the driver would, and a full
+//  queue drops the newest ones and reports an overflow on the next read.
+//
+//  Open and plug delays stand in for the time a real device open or plug
+//  in spends waiting on the driver; they sleep without holding a lock, so
+//  pads opened from several threads wait side by side.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class FakeInputBackend : public InputBackend
+{
+public:
+    FakeInputBackend();
+    ~FakeInputBackend() override;
+
+    // Makes the pad visible to devices() and openable, as a pad of `type`
+    void plug(const DeviceGuid& id, const DeviceType& type = DeviceTypes::n64());
+    void unplug(const DeviceGuid& id);
+
+    // Latest state of an open or closed pad; wakes whoever services it
+    void push(const DeviceGuid& id, const N64ControllerState& state);
+
+    // Queues events for buffered reads (and applies them to the snapshot
+    // state); wakes whoever services the pad once per call
+    void pushEvents(const DeviceGuid& id, const InputEvent* events, size_t count);
+
+    // Events the pad queues between reads; 0 (the default) = snapshot reads
+    void setBufferSize(const DeviceGuid& id, size_t events);
+
+    // Subsequent reads fail until cleared; recover() succeeds once cleared
+    void setReadFailure(const DeviceGuid& id, bool fail);
+
+    // Scripted device loss: reads fail, the next `failedRecoveries`
+    // recover() calls fail too, and the one after brings the pad back
+    void loseDevice(const DeviceGuid& id, uint32_t failedRecoveries);
+
+    // Every open() sleeps this long first
+    void setOpenDelayMs(uint32_t ms) { openDelayMs_ = ms; }
+
+    DeviceSource& devices() override;
+    std::unique_ptr<InputSource> open(const DeviceGuid& id) override;
+
+    struct Device;
+
+private:
+    std::mutex                                                        mutex_;
+    std::atomic<uint32_t>                                             openDelayMs_ { 0 };
+    FakeDeviceSource                                                  devices_;
+    std::unordered_map<DeviceGuid, std::shared_ptr<Device>, DeviceGuidHash> pads_;
+};
+
+class FakeSinkBackend : public SinkBackend
+{
+public:
+    // sink is a per sink sequence number starting at 0
+    using SubmitCallback = std::function<void(uint32_t sink, const XusbReport& report)>;
+
+public:
+    void setSubmitCallback(const SubmitCallback& callback) { callback_ = callback; }
+
+    // Every plug() sleeps this long first
+    void setPlugDelayMs(uint32_t ms) { plugDelayMs_ = ms; }
+
+    std::unique_ptr<PadSink> plug() override;
+
+    uint32_t plugged() const { return created_; }
+    uint32_t live() const    { return live_; }
+
+private:
+    class Sink;
+
+    SubmitCallback        callback_;
+    std::atomic<uint32_t> created_ { 0 };
+    std::atomic<uint32_t> live_ { 0 };
+    std::atomic<uint32_t> plugDelayMs_ { 0 };
+};
@@ -0,0 +1,80 @@
+#include "FakeDeviceSource.h"
+#include "Clock.h"
+
+#include <algorithm>
+#include <chrono>
+
+void FakeDeviceSource::plug(const DeviceGuid& id, bool notify)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(devices_.begin(), devices_.end(), [&](const Device& device){ return device.id == id; });
+    if (it != devices_.end())
+        return;
+
+    devices_.push_back({ id, Clock::nowNs() + visibilityDelayNs_ });
+    if (notify)
+    {
+        notified_ = true;
+        changed_.notify_all();
+    }
+}
+
+void FakeDeviceSource::unplug(const DeviceGuid& id, bool notify)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(devices_.begin(), devices_.end(), [&](const Device& device){ return device.id == id; });
+    if (it == devices_.end())
+        return;
+
+    devices_.erase(it);
+    if (notify)
+    {
+        notified_ = true;
+        changed_.notify_all();
+    }
+}
+
+void FakeDeviceSource::setVisibilityDelayNs(int64_t delayNs)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    visibilityDelayNs_ = delayNs;
+}
+
+uint64_t FakeDeviceSource::scans() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return scans_;
+}
+
+void FakeDeviceSource::enumerate(std::vector<DeviceGuid>& out)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    scans_++;
+
+    const auto nowNs = Clock::nowNs();
+    for (const auto& device : devices_)
+        if (device.visibleAtNs <= nowNs)
+            out.push_back(device.id);
+}
+
+bool FakeDeviceSource::waitForChange(uint32_t timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto ready = [this]{ return notified_ || woken_; };
+    if (timeoutMs == kWaitForever)
+        changed_.wait(lock, ready);
+    else
+        changed_.wait_for(lock, std::chrono::milliseconds(timeoutMs), ready);
+
+    const bool notified = notified_;
+    notified_ = false;
+    woken_    = false;
+    return notified;
+}
+
+void FakeDeviceSource::wake()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    woken_ = true;
+    changed_.notify_all();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "DeviceSource.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Scriptable in-memory device source for benchmarks and tests
+//
+//  plug() / unplug() change the attached set and, unless told otherwise,
+//  raise a change notification like a device arrival message would. A
+//  visibility delay makes plugged pads show up in enumerate() only some time
+//  after the notification, the way DirectInput lags the HID arrival.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class FakeDeviceSource : public DeviceSource
+{
+public:
+    void plug(const DeviceGuid& id, bool notify = true);
+    void unplug(const DeviceGuid& id, bool notify = true);
+
+    void setVisibilityDelayNs(int64_t delayNs);
+
+    // Number of enumerate() calls so far
+    uint64_t scans() const;
+
+    void enumerate(std::vector<DeviceGuid>& out) override;
+    bool waitForChange(uint32_t timeoutMs) override;
+    void wake() override;
+
+private:
+    struct Device
+    {
+        DeviceGuid id;
+        int64_t    visibleAtNs;
+    };
+
+    mutable std::mutex      mutex_;
+    std::condition_variable changed_;
+    std::vector<Device>     devices_;
+    int64_t                 visibilityDelayNs_ { 0 };
+    uint64_t                scans_ { 0 };
+    bool                    notified_ { false };
+    bool                    woken_ { false };
+};
@@ -0,0 +1,100 @@
+#include "HotplugDetector.h"
+#include "Clock.h"
+
+#include <algorithm>
+
+void HotplugDetector::scan(DeviceSource& source)
+{
+    const auto startNs = Clock::nowNs();
+    scan_.clear();
+    source.enumerate(scan_);
+    std::sort(scan_.begin(), scan_.end());
+    scan_.erase(std::unique(scan_.begin(), scan_.end()), scan_.end());
+    scanTimes_.record(Clock::nowNs() - startNs);
+    counters_.scans.fetch_add(1, std::memory_order_relaxed);
+
+    changed_ = false;
+    Hotplug::diffSorted(current_, scan_,
+        [this](const DeviceGuid& id)
+        {
+            changed_ = true;
+            counters_.added.fetch_add(1, std::memory_order_relaxed);
+            if (addedCallback_)
+                addedCallback_(id);
+        },
+        [this](const DeviceGuid& id)
+        {
+            changed_ = true;
+            counters_.removed.fetch_add(1, std::memory_order_relaxed);
+            if (removedCallback_)
+                removedCallback_(id);
+        });
+
+    current_.swap(scan_);
+}
+
+void HotplugDetector::run(DeviceSource& source, uint32_t fallbackPollMs)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopRequested_)
+        {
+            stopRequested_ = false;
+            return;
+        }
+        source_ = &source;
+    }
+
+    // Plenty for any realistic number of pads; grows once if not
+    current_.reserve(16);
+    scan_.reserve(16);
+
+    uint32_t settleRetries = 0;
+    for (;;)
+    {
+        scan(source);
+        if (changed_)
+            settleRetries = 0;
+
+        const uint32_t timeoutMs = settleRetries > 0 ? kSettleIntervalMs
+                                 : fallbackPollMs > 0 ? fallbackPollMs
+                                 : DeviceSource::kWaitForever;
+        const bool notified = source.waitForChange(timeoutMs);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopRequested_)
+                break;
+        }
+
+        if (notified)
+        {
+            counters_.notifications.fetch_add(1, std::memory_order_relaxed);
+            settleRetries = kSettleRetries;
+        }
+        else if (settleRetries > 0)
+            settleRetries--;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        source_        = nullptr;
+        stopRequested_ = false;
+    }
+
+    for (const auto& id : current_)
+    {
+        counters_.removed.fetch_add(1, std::memory_order_relaxed);
+        if (removedCallback_)
+            removedCallback_(id);
+    }
+    current_.clear();
+}
+
+void HotplugDetector::stop()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopRequested_ = true;
+    if (source_)
+        source_->wake();
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "DeviceSource.h"
+#include "LatencyHistogram.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Hotplug detector
+//
+//  Rescans a DeviceSource whenever it signals a change, and every
+//  `fallbackPollMs` otherwise, then reports the difference against the last
+//  scan. Scans are kept sorted and diffed with a merge walk into reused
+//  buffers, so steady state detection does not allocate.
+//
+//  Arrival notifications can beat the device showing up in the enumeration;
+//  when a signalled change turns up nothing new the source is rescanned a few
+//  more times at a short interval before going back to waiting.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Hotplug
+{
+
+// Calls added(id) for ids only in `after` and removed(id) for ids only in
+// `before`. Both ranges must be sorted and free of duplicates.
+template <typename Added, typename Removed>
+void diffSorted(const std::vector<DeviceGuid>& before, const std::vector<DeviceGuid>& after, Added&& added, Removed&& removed)
+{
+    size_t i = 0;
+    size_t j = 0;
+    while (i < before.size() && j < after.size())
+    {
+        if (before[i] < after[j])
+            removed(before[i++]);
+        else if (after[j] < before[i])
+            added(after[j++]);
+        else
+        {
+            i++;
+            j++;
+        }
+    }
+    for (; i < before.size(); i++)
+        removed(before[i]);
+    for (; j < after.size(); j++)
+        added(after[j]);
+}
+
+}
+
+class HotplugDetector
+{
+public:
+    using Callback = std::function<void(const DeviceGuid&)>;
+
+    static constexpr uint32_t kSettleIntervalMs = 20;
+    static constexpr uint32_t kSettleRetries    = 5;
+
+    // Written by the detector thread only, on a cache line of their own
+    struct alignas(64) Counters
+    {
+        std::atomic<uint64_t> scans { 0 };
+        std::atomic<uint64_t> notifications { 0 };
+        std::atomic<uint64_t> added { 0 };
+        std::atomic<uint64_t> removed { 0 };
+    };
+
+public:
+    void setAddedCallback(const Callback& callback)   { addedCallback_ = callback; }
+    void setRemovedCallback(const Callback& callback) { removedCallback_ = callback; }
+
+    // Runs on the calling thread until stop(). 0 disables the fallback poll.
+    // Every pad still present is reported removed on the way out.
+    void run(DeviceSource& source, uint32_t fallbackPollMs);
+
+    // Thread safe, also before run()
+    void stop();
+
+    const Counters& counters() const { return counters_; }
+
+    // Enumerate and sort time of every scan, without the callbacks
+    const LatencyHistogram& scanTimes() const { return scanTimes_; }
+
+private:
+    void scan(DeviceSource& source);
+
+private:
+    Callback                addedCallback_;
+    Callback                removedCallback_;
+    std::mutex              mutex_;
+    DeviceSource*           source_ { nullptr };
+    bool                    stopRequested_ { false };
+    bool                    changed_ { false };
+    std::vector<DeviceGuid> current_;
+    std::vector<DeviceGuid> scan_;
+    Counters                counters_;
+    LatencyHistogram        scanTimes_;
+};
@@ -0,0 +1,154 @@
+#include "InitPipeline.h"
+#include "Clock.h"
+#include "Log.h"
+
+#include <algorithm>
+
+InitPipeline::~InitPipeline()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        for (auto& job : jobs_)
+            job->cancelled = true;
+        wake_.notify_all();
+    }
+
+    // Workers empty the queue (as cancelled jobs) before they exit
+    for (auto& worker : workers_)
+        worker.join();
+}
+
+std::unique_ptr<InitPipeline> InitPipeline::create(uint32_t workers)
+{
+    std::unique_ptr<InitPipeline> pipeline(new InitPipeline());
+    if (!pipeline->init(workers))
+        return nullptr;
+    return pipeline;
+}
+
+bool InitPipeline::init(uint32_t workers)
+{
+    if (workers == 0)
+        return false;
+
+    workers_.reserve(workers);
+    for (uint32_t i = 0; i < workers; i++)
+        workers_.emplace_back([this]
+        {
+            Log::attachThread();
+            work();
+        });
+    return true;
+}
+
+void InitPipeline::start(const DeviceGuid& id, std::vector<Step> steps, const Done& done)
+{
+    auto job = std::make_shared<Job>();
+    job->id        = id;
+    job->steps     = std::move(steps);
+    job->done      = done;
+    job->startedNs = Clock::nowNs();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    counters_.started.fetch_add(1, std::memory_order_relaxed);
+    job->cancelled = stopping_;
+    jobs_.push_back(job);
+    queue_.push_back(job);
+    wake_.notify_one();
+}
+
+bool InitPipeline::cancel(const DeviceGuid& id)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool found = false;
+    for (auto& job : jobs_)
+    {
+        if (job->id == id && !job->cancelled)
+        {
+            job->cancelled = true;
+            found = true;
+        }
+    }
+
+    idle_.wait(lock, [&]
+    {
+        return std::none_of(jobs_.begin(), jobs_.end(), [&](const std::shared_ptr<Job>& job){ return job->id == id && job->running; });
+    });
+    return found;
+}
+
+void InitPipeline::drain()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [&]{ return jobs_.empty() && finishing_ == 0; });
+}
+
+void InitPipeline::work()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        wake_.wait(lock, [&]{ return stopping_ || !queue_.empty(); });
+        if (queue_.empty())
+            return;
+
+        auto job = std::move(queue_.front());
+        queue_.pop_front();
+        if (job->cancelled)
+        {
+            finish(lock, job, CANCELLED);
+            continue;
+        }
+
+        job->running = true;
+        lock.unlock();
+        const bool ok = job->steps[job->next]();
+        lock.lock();
+        job->running = false;
+        idle_.notify_all();
+
+        if (!ok)
+            finish(lock, job, FAILED);
+        else if (++job->next == job->steps.size())
+            finish(lock, job, READY);
+        else if (job->cancelled)
+            finish(lock, job, CANCELLED);
+        else
+        {
+            // Ahead of pads that haven't started, so the first pads are
+            // ready as early as they can be
+            queue_.push_front(std::move(job));
+            wake_.notify_one();
+        }
+    }
+}
+
+void InitPipeline::finish(std::unique_lock<std::mutex>& lock, const std::shared_ptr<Job>& job, Result result)
+{
+    jobs_.erase(std::find(jobs_.begin(), jobs_.end(), job));
+    finishing_++;
+
+    const auto elapsedNs = Clock::nowNs() - job->startedNs;
+    switch (result)
+    {
+    case READY:
+        counters_.ready.fetch_add(1, std::memory_order_relaxed);
+        readyTimes_.record(elapsedNs);
+        break;
+    case FAILED:
+        counters_.failed.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case CANCELLED:
+        counters_.cancelled.fetch_add(1, std::memory_order_relaxed);
+        break;
+    }
+
+    lock.unlock();
+    if (job->done)
+        job->done(result, elapsedNs);
+    lock.lock();
+
+    finishing_--;
+    idle_.notify_all();
+}
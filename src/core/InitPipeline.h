@@ -0,0 +1,108 @@
+#pragma once
+
+#include "DeviceGuid.h"
+#include "LatencyHistogram.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Controller init pipeline
+//
+//  Opens pads off the hotplug thread. Every pad is a job of steps (see
+//  Controller::OpenStep) that run in order, each step a task of its own on
+//  a small worker pool, so several pads' device opens and plug ins wait on
+//  their drivers side by side and a slow pad only holds up one worker. A
+//  job goes back to the front of the queue after each step: pads already
+//  opening finish before new ones start.
+//
+//  cancel() stops a job before its next step, for a pad that goes away
+//  while it's still opening. The job's done callback runs on a worker, once
+//  per job, with no pipeline lock held.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class InitPipeline
+{
+public:
+    enum Result : uint8_t
+    {
+        READY,      // every step succeeded
+        FAILED,     // a step returned false; later steps didn't run
+        CANCELLED,  // cancel() or shutdown; later steps didn't run
+    };
+
+    using Step = std::function<bool()>;
+    using Done = std::function<void(Result result, int64_t elapsedNs)>;
+
+    struct Counters
+    {
+        std::atomic<uint64_t> started { 0 };
+        std::atomic<uint64_t> ready { 0 };
+        std::atomic<uint64_t> failed { 0 };
+        std::atomic<uint64_t> cancelled { 0 };
+    };
+
+public:
+    // Cancels what's still queued, finishes the steps in progress and joins
+    ~InitPipeline();
+
+    InitPipeline(const InitPipeline&) = delete;
+    InitPipeline& operator=(const InitPipeline&) = delete;
+
+    // nullptr if the worker threads can't be started
+    static std::unique_ptr<InitPipeline> create(uint32_t workers);
+
+    void start(const DeviceGuid& id, std::vector<Step> steps, const Done& done);
+
+    // Cancels every unfinished job for id and waits for a step of theirs in
+    // progress to return, so id's steps are no longer running once it does.
+    // Their done callbacks still follow on a worker. False if id had no
+    // unfinished job. Not from a step.
+    bool cancel(const DeviceGuid& id);
+
+    // Waits until every job started so far is done, callbacks included
+    void drain();
+
+    const Counters& counters() const { return counters_; }
+
+    // start() to READY of every job that got there
+    const LatencyHistogram& readyTimes() const { return readyTimes_; }
+
+private:
+    struct Job
+    {
+        DeviceGuid        id;
+        std::vector<Step> steps;
+        Done              done;
+        size_t            next { 0 };
+        int64_t           startedNs { 0 };
+        bool              cancelled { false };
+        bool              running { false };
+    };
+
+    InitPipeline() = default;
+    bool init(uint32_t workers);
+    void work();
+    void finish(std::unique_lock<std::mutex>& lock, const std::shared_ptr<Job>& job, Result result);
+
+private:
+    std::mutex                        mutex_;
+    std::condition_variable           wake_;
+    std::condition_variable           idle_;
+    std::deque<std::shared_ptr<Job>>  queue_;   // jobs waiting for their next step, started ones first
+    std::vector<std::shared_ptr<Job>> jobs_;    // every unfinished job
+    size_t                            finishing_ { 0 };
+    bool                              stopping_ { false };
+    std::vector<std::thread>          workers_;
+    Counters                          counters_;
+    LatencyHistogram                  readyTimes_;
+};
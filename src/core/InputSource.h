@@ -0,0 +1,79 @@
+#pragma once
+
+#include "DeviceDescriptors.h"
+#include "DeviceGuid.h"
+#include "DeviceSource.h"
+#include "EventLoop.h"
+#include "N64ControllerState.h"
+
+#include <cstddef>
+#include <memory>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Input side of the bridge
+//
+//  An InputBackend is a platform's way of finding and opening physical pads
+//  (DirectInput on Windows, evdev on Linux, or the in-memory fake). Every
+//  backend produces N64ControllerState in the DirectInput layout and value
+//  ranges, whichever supported pad it reads, so everything after the read
+//  is shared.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// States from one buffered read, oldest first
+struct InputBatch
+{
+    static constexpr size_t kCapacity = 32;
+
+    N64ControllerState states[kCapacity];
+    size_t count { 0 };
+    bool   more { false };       // input is still queued; read again
+    bool   overflowed { false }; // the device dropped queued input, the last state is a resync
+    bool   reacquired { false }; // the source lost the device and took it back; set by sources, cleared by the caller
+};
+
+// One open physical pad
+class InputSource
+{
+public:
+    virtual ~InputSource() = default;
+
+    // Becomes ready (event signalled / descriptor readable) when input is
+    // pending; serviced by an EventLoop
+    virtual EventHandle handle() const = 0;
+
+    // Which pad this is (DeviceDescriptors.h), fixed once the source is open
+    virtual const DeviceType& type() const { return DeviceTypes::n64(); }
+
+    // Consumes pending input and returns the latest complete state. False on
+    // a device error; the source reports the details.
+    virtual bool read(N64ControllerState& state) = 0;
+
+    // Every state the pad went through since the last read, for sources in
+    // buffered mode (see EventReplay); by default the latest state only
+    virtual bool readBatch(InputBatch& batch)
+    {
+        batch.more       = false;
+        batch.overflowed = false;
+        batch.count      = read(batch.states[0]) ? 1 : 0;
+        return batch.count == 1;
+    }
+
+    // After a failed read: tries once to get the device back (reacquire,
+    // check it's still there) and resyncs; false while it's still lost.
+    // Quiet on failure, the caller retries on a backoff.
+    virtual bool recover() { return false; }
+};
+
+class InputBackend
+{
+public:
+    virtual ~InputBackend() = default;
+
+    // Hotplug source for the pads this backend can open
+    virtual DeviceSource& devices() = 0;
+
+    // nullptr when the pad can't be opened
+    virtual std::unique_ptr<InputSource> open(const DeviceGuid& id) = 0;
+};
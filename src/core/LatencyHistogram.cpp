@@ -0,0 +1,29 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+
+uint64_t LatencyHistogram::percentile(double quantile) const
+{
+    const uint64_t total = count();
+    if (total == 0)
+        return 0;
+
+    const auto target = static_cast<uint64_t>(quantile * total);
+    uint64_t seen = 0;
+    for (uint32_t bucket = 0; bucket < kBuckets; bucket++)
+    {
+        seen += buckets_[bucket].load(std::memory_order_relaxed);
+        if (seen > target)
+            return (std::min)(bucketUpperBound(bucket), maxValue());
+    }
+    return maxValue();
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto& bucket : buckets_)
+        bucket.store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Log-linear (HDR style) latency histogram
+//
+//  Fixed memory, no allocation and no locks. Each power of two range is split
+//  into 16 linear sub-buckets, so any recorded value is reported within ~6%.
+//  Values are nanoseconds up to ~18 minutes; larger values land in the last
+//  bucket. record() is meant for a single writer; readers may run
+//  concurrently and see a slightly stale but consistent-enough snapshot.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class LatencyHistogram
+{
+public:
+    static constexpr uint32_t kSubBucketBits = 4;
+    static constexpr uint32_t kSubBuckets    = 1u << kSubBucketBits;
+    static constexpr uint32_t kMaxBits       = 40;
+    static constexpr uint32_t kBuckets       = (kMaxBits - kSubBucketBits + 1) * kSubBuckets + kSubBuckets;
+
+    void record(int64_t valueNs)
+    {
+        const uint64_t value = valueNs < 0 ? 0 : static_cast<uint64_t>(valueNs);
+        auto& bucket = buckets_[bucketFor(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        count_.store(count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum_.store(sum_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        if (value > max_.load(std::memory_order_relaxed))
+            max_.store(value, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const    { return count_.load(std::memory_order_relaxed); }
+    uint64_t maxValue() const { return max_.load(std::memory_order_relaxed); }
+    uint64_t sum() const      { return sum_.load(std::memory_order_relaxed); }
+
+    // Upper bound of the bucket holding the given quantile (0..1)
+    uint64_t percentile(double quantile) const;
+
+    void reset();
+
+    static uint32_t bucketFor(uint64_t value)
+    {
+        if (value < 2 * kSubBuckets)
+            return static_cast<uint32_t>(value);
+
+        const uint32_t msb   = 63 - countLeadingZeros(value);
+        if (msb >= kMaxBits)
+            return kBuckets - 1;
+        const uint32_t shift = msb - kSubBucketBits;
+        return (shift + 1) * kSubBuckets + static_cast<uint32_t>((value >> shift) - kSubBuckets);
+    }
+
+    static uint64_t bucketUpperBound(uint32_t bucket)
+    {
+        if (bucket < 2 * kSubBuckets)
+            return bucket;
+        const uint32_t shift = bucket / kSubBuckets - 1;
+        const uint64_t sub   = bucket % kSubBuckets + kSubBuckets;
+        return ((sub + 1) << shift) - 1;
+    }
+
+private:
+    static uint32_t countLeadingZeros(uint64_t value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return 63 - index;
+#else
+        return static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+    }
+
+private:
+    std::atomic<uint64_t> buckets_[kBuckets] {};
+    std::atomic<uint64_t> count_ { 0 };
+    std::atomic<uint64_t> sum_ { 0 };
+    std::atomic<uint64_t> max_ { 0 };
+};
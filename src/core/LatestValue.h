@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Latest-value slot
+//
+//  Hands values from one thread to another without either ever waiting on
+//  the other: a triple buffer. The producer writes its own slot and swaps
+//  it into the middle, the consumer swaps the middle out, so post() and
+//  take() are a copy and a single atomic exchange each. A value not taken
+//  before the next post() is replaced.
+//
+//  One producer, one consumer.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+class LatestValue
+{
+public:
+    // Producer only
+    void post(const T& value)
+    {
+        slots_[back_] = value;
+        back_ = middle_.exchange(static_cast<uint8_t>(back_ | kFresh), std::memory_order_acq_rel) & kIndex;
+    }
+
+    // Consumer only: the newest value posted since the last take(); false
+    // if there is none
+    bool take(T& out)
+    {
+        if (!(middle_.load(std::memory_order_relaxed) & kFresh))
+            return false;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndex;
+        out = slots_[front_];
+        return true;
+    }
+
+private:
+    static constexpr uint8_t kIndex = 0x03;
+    static constexpr uint8_t kFresh = 0x04;
+
+    T slots_[3] {};
+
+    // Slot index in the middle, with kFresh until the consumer takes it
+    alignas(64) std::atomic<uint8_t> middle_ { 1 };
+
+    // Producer side
+    alignas(64) uint8_t back_ { 0 };
+
+    // Consumer side
+    alignas(64) uint8_t front_ { 2 };
+};
@@ -0,0 +1,486 @@
+#include "Log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+constexpr size_t   kTextSize = 232;
+constexpr uint32_t kRingSize = 256; // records per thread, power of two
+constexpr size_t   kSites    = 32;  // rate limited call sites tracked per thread
+constexpr int64_t  kSecondNs = 1000000000;
+
+// One cache line multiple; the text is formatted in place
+struct Record
+{
+    int64_t     wallNs;
+    const char* site;
+    uint32_t    thread;
+    Log::Level  level;
+    uint8_t     reserved;
+    uint16_t    length;
+    char        text[kTextSize];
+};
+
+static_assert(sizeof(Record) == 256, "Record should stay 256 bytes");
+
+struct SiteLimit
+{
+    const char* site;
+    int64_t     windowNs;
+    uint32_t    count;
+    uint32_t    suppressed;
+};
+
+// Single producer (the owning thread), single consumer (the writer)
+struct Ring
+{
+    alignas(64) std::atomic<uint32_t> head { 0 };
+    alignas(64) std::atomic<uint32_t> tail { 0 };
+    std::atomic<bool> orphaned { false };
+    uint32_t          thread { 0 };
+    SiteLimit         sites[kSites] {};
+    Record            records[kRingSize];
+};
+
+int64_t wallNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+const char* levelName(Log::Level level)
+{
+    switch (level)
+    {
+    case Log::Level::Error:   return "E";
+    case Log::Level::Warning: return "W";
+    default:                  return "I";
+    }
+}
+
+class Logger
+{
+public:
+    static Logger& instance()
+    {
+        static Logger logger;
+        return logger;
+    }
+
+    ~Logger()
+    {
+        stop();
+    }
+
+    bool start(const Log::Config& config);
+    void stop();
+    void flush();
+    Log::Counters counters() const;
+
+    void write(Log::Level level, const char* format, va_list args);
+    void attachThread() { threadRing(); }
+
+private:
+    Ring& threadRing();
+
+    // Returns false when the site is over its rate; emits the summary of
+    // what was held back when a new second starts
+    bool admit(Ring& ring, const char* site, int64_t nowNs);
+
+    void push(Ring& ring, Log::Level level, const char* site, int64_t nowNs, const char* format, va_list args);
+    void push(Ring& ring, Log::Level level, const char* site, int64_t nowNs, const char* format, ...);
+
+    void run();
+    void drain();
+    void output(const Record& record);
+    void rotate();
+
+private:
+    std::mutex                         ringsMutex_;
+    std::vector<std::unique_ptr<Ring>> rings_;
+    uint32_t                           nextThread_ { 1 };
+
+    Log::Config           config_;
+    std::atomic<bool>     running_ { false };
+    std::atomic<uint32_t> rate_ { 10 };
+    std::thread           writer_;
+
+    // Writer wake ups and flush() handshakes
+    std::mutex              wakeMutex_;
+    std::condition_variable wake_;
+    std::condition_variable drained_;
+    bool                    stop_ { false };
+    uint64_t                passes_ { 0 };
+
+    // Synchronous output before start() and the writer's output
+    std::mutex          outputMutex_;
+    std::ofstream       file_;
+    uint64_t            fileBytes_ { 0 };
+    std::vector<Record> batch_;
+
+    std::atomic<uint64_t> written_ { 0 };
+    std::atomic<uint64_t> dropped_ { 0 };
+    std::atomic<uint64_t> suppressed_ { 0 };
+};
+
+// Marks the ring for collection once its thread is gone
+struct ThreadRing
+{
+    Ring* ring { nullptr };
+
+    ~ThreadRing()
+    {
+        if (ring)
+            ring->orphaned = true;
+    }
+};
+
+thread_local ThreadRing tRing;
+
+Ring& Logger::threadRing()
+{
+    if (!tRing.ring)
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+
+        // Without a writer nothing else collects the rings of exited threads
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const std::unique_ptr<Ring>& ring)
+        {
+            return ring->orphaned.load(std::memory_order_acquire) &&
+                   ring->head.load(std::memory_order_relaxed) == ring->tail.load(std::memory_order_relaxed);
+        }), rings_.end());
+
+        rings_.push_back(std::make_unique<Ring>());
+        tRing.ring = rings_.back().get();
+        tRing.ring->thread = nextThread_++;
+    }
+    return *tRing.ring;
+}
+
+bool Logger::admit(Ring& ring, const char* site, int64_t nowNs)
+{
+    const uint32_t rate = rate_.load(std::memory_order_relaxed);
+    if (rate == 0)
+        return true;
+
+    auto& limit = ring.sites[(reinterpret_cast<uintptr_t>(site) >> 4) % kSites];
+    if (limit.site != site)
+        limit = { site, nowNs, 0, 0 };
+
+    if (nowNs - limit.windowNs >= kSecondNs)
+    {
+        if (limit.suppressed > 0)
+            push(ring, Log::Level::Warning, site, nowNs, "(%u similar messages suppressed)", limit.suppressed);
+        limit.windowNs   = nowNs;
+        limit.count      = 0;
+        limit.suppressed = 0;
+    }
+
+    if (limit.count < rate)
+    {
+        limit.count++;
+        return true;
+    }
+    limit.suppressed++;
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void Logger::write(Log::Level level, const char* format, va_list args)
+{
+    auto& ring = threadRing();
+    const auto nowNs = wallNowNs();
+    if (admit(ring, format, nowNs))
+        push(ring, level, format, nowNs, format, args);
+}
+
+void Logger::push(Ring& ring, Log::Level level, const char* site, int64_t nowNs, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    push(ring, level, site, nowNs, format, args);
+    va_end(args);
+}
+
+void Logger::push(Ring& ring, Log::Level level, const char* site, int64_t nowNs, const char* format, va_list args)
+{
+    if (!running_.load(std::memory_order_acquire))
+    {
+        Record record;
+        record.wallNs = nowNs;
+        record.site   = site;
+        record.thread = ring.thread;
+        record.level  = level;
+        const int length = vsnprintf(record.text, kTextSize, format, args);
+        record.length = static_cast<uint16_t>((std::min)(static_cast<size_t>((std::max)(length, 0)), kTextSize - 1));
+
+        std::lock_guard<std::mutex> lock(outputMutex_);
+        output(record);
+        return;
+    }
+
+    const uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+    if (tail - ring.head.load(std::memory_order_acquire) >= kRingSize)
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto& record = ring.records[tail & (kRingSize - 1)];
+    record.wallNs = nowNs;
+    record.site   = site;
+    record.thread = ring.thread;
+    record.level  = level;
+    const int length = vsnprintf(record.text, kTextSize, format, args);
+    record.length = static_cast<uint16_t>((std::min)(static_cast<size_t>((std::max)(length, 0)), kTextSize - 1));
+    ring.tail.store(tail + 1, std::memory_order_release);
+}
+
+bool Logger::start(const Log::Config& config)
+{
+    stop();
+
+    std::lock_guard<std::mutex> lock(outputMutex_);
+    config_ = config;
+    rate_   = config.ratePerSecond;
+    if (!config_.filePath.empty())
+    {
+        std::error_code error;
+        const auto size = std::filesystem::file_size(config_.filePath, error);
+        fileBytes_ = error ? 0 : size;
+        file_.open(config_.filePath, std::ios::binary | std::ios::app);
+        if (!file_)
+        {
+            std::cout << "Failed to open log file " << config_.filePath << std::endl;
+            return false;
+        }
+    }
+
+    stop_ = false;
+    running_.store(true, std::memory_order_release);
+    writer_ = std::thread([this]{ run(); });
+    return true;
+}
+
+void Logger::stop()
+{
+    if (!writer_.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    writer_.join();
+
+    std::lock_guard<std::mutex> lock(outputMutex_);
+    drain();
+    running_.store(false, std::memory_order_release);
+    file_.close();
+}
+
+void Logger::flush()
+{
+    std::unique_lock<std::mutex> lock(wakeMutex_);
+    if (!writer_.joinable())
+        return;
+
+    // A pass that starts after this point sees every record pushed so far
+    const uint64_t target = passes_ + 2;
+    wake_.notify_all();
+    drained_.wait(lock, [&]{ return passes_ >= target || stop_; });
+}
+
+Log::Counters Logger::counters() const
+{
+    return { written_.load(), dropped_.load(), suppressed_.load() };
+}
+
+void Logger::run()
+{
+    std::unique_lock<std::mutex> lock(wakeMutex_);
+    while (!stop_)
+    {
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> outputLock(outputMutex_);
+            drain();
+        }
+        lock.lock();
+
+        passes_++;
+        drained_.notify_all();
+        wake_.wait_for(lock, std::chrono::milliseconds(config_.flushIntervalMs));
+    }
+    drained_.notify_all();
+}
+
+void Logger::drain()
+{
+    batch_.clear();
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        for (auto it = rings_.begin(); it != rings_.end();)
+        {
+            auto& ring = **it;
+            const uint32_t tail = ring.tail.load(std::memory_order_acquire);
+            uint32_t head = ring.head.load(std::memory_order_relaxed);
+            for (; head != tail; head++)
+                batch_.push_back(ring.records[head & (kRingSize - 1)]);
+            ring.head.store(head, std::memory_order_release);
+
+            // Its thread has exited and nothing can be pushed any more
+            if (ring.orphaned.load(std::memory_order_acquire) && ring.tail.load(std::memory_order_acquire) == head)
+                it = rings_.erase(it);
+            else
+                ++it;
+        }
+    }
+    if (batch_.empty())
+        return;
+
+    // Rings are drained one after the other; put the threads back in order
+    std::stable_sort(batch_.begin(), batch_.end(), [](const Record& a, const Record& b) { return a.wallNs < b.wallNs; });
+    for (const auto& record : batch_)
+        output(record);
+
+    if (config_.console)
+        std::cout << std::flush;
+    if (file_.is_open())
+        file_.flush();
+}
+
+void Logger::output(const Record& record)
+{
+    written_.fetch_add(1, std::memory_order_relaxed);
+
+    if (config_.console || !running_.load(std::memory_order_relaxed))
+    {
+        std::cout.write(record.text, record.length);
+        std::cout.put('\n');
+        if (!running_.load(std::memory_order_relaxed))
+            std::cout << std::flush;
+    }
+
+    if (!file_.is_open())
+        return;
+
+    const time_t seconds = static_cast<time_t>(record.wallNs / kSecondNs);
+    struct tm local;
+#if defined(_WIN32)
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    char prefix[64];
+    const size_t stamp = strftime(prefix, sizeof(prefix), "%Y-%m-%d %H:%M:%S", &local);
+    const int length = snprintf(prefix + stamp, sizeof(prefix) - stamp, ".%03d %s [%u] ",
+                                static_cast<int>(record.wallNs % kSecondNs / 1000000), levelName(record.level), record.thread);
+
+    const uint64_t lineBytes = stamp + static_cast<uint64_t>(length) + record.length + 1;
+    if (config_.maxFileBytes > 0 && fileBytes_ > 0 && fileBytes_ + lineBytes > config_.maxFileBytes)
+        rotate();
+
+    file_.write(prefix, static_cast<std::streamsize>(stamp + length));
+    file_.write(record.text, record.length);
+    file_.put('\n');
+    fileBytes_ += lineBytes;
+}
+
+void Logger::rotate()
+{
+    namespace fs = std::filesystem;
+
+    file_.close();
+    std::error_code error;
+    const auto& path = config_.filePath;
+    if (config_.keepFiles == 0)
+        fs::remove(path, error);
+    else
+    {
+        fs::remove(path + "." + std::to_string(config_.keepFiles), error);
+        for (uint32_t i = config_.keepFiles; i > 1; i--)
+            fs::rename(path + "." + std::to_string(i - 1), path + "." + std::to_string(i), error);
+        fs::rename(path, path + ".1", error);
+    }
+
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    fileBytes_ = 0;
+}
+
+}
+
+bool Log::start(const Config& config)
+{
+    return Logger::instance().start(config);
+}
+
+void Log::stop()
+{
+    Logger::instance().stop();
+}
+
+void Log::flush()
+{
+    Logger::instance().flush();
+}
+
+Log::Counters Log::counters()
+{
+    return Logger::instance().counters();
+}
+
+void Log::attachThread()
+{
+    Logger::instance().attachThread();
+}
+
+void Log::writeV(Level level, const char* format, va_list args)
+{
+    Logger::instance().write(level, format, args);
+}
+
+void Log::write(Level level, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    writeV(level, format, args);
+    va_end(args);
+}
+
+void Log::info(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    writeV(Level::Info, format, args);
+    va_end(args);
+}
+
+void Log::warning(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    writeV(Level::Warning, format, args);
+    va_end(args);
+}
+
+void Log::error(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    writeV(Level::Error, format, args);
+    va_end(args);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdarg>
+#include <cstdint>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Asynchronous logging
+//
+//  Log::error() and friends format into a fixed size record on the calling
+//  thread and push it onto that thread's own lock free ring; a background
+//  writer drains every ring, orders the records by time and writes them to
+//  the console and / or a rotating log file. A thread's ring is created
+//  (under a lock, and allocated) the first time it logs, or up front with
+//  attachThread(); the pad, reactor and service threads attach as they
+//  start, so from then on their messages never take a lock or touch I/O:
+//  when the ring is full the record is dropped and counted.
+//
+//  Each thread rate limits per call site (format string): past
+//  Config::ratePerSecond messages in a second the rest are counted, and
+//  summed up in one line when the site logs again in a later second.
+//
+//  Until start() (and after stop()) messages are written synchronously to
+//  the console, so tools and early startup need no setup.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(__GNUC__) || defined(__clang__)
+#define N64_PRINTF_FORMAT(formatIndex, firstArg) __attribute__((format(printf, formatIndex, firstArg)))
+#else
+#define N64_PRINTF_FORMAT(formatIndex, firstArg)
+#endif
+
+namespace Log
+{
+
+enum class Level : uint8_t
+{
+    Info,
+    Warning,
+    Error,
+};
+
+struct Config
+{
+    bool        console { true };
+    std::string filePath;                  // empty = no log file
+    uint64_t    maxFileBytes { 1 << 20 };  // rotate to <file>.1 ... past this size
+    uint32_t    keepFiles { 3 };           // rotated files kept besides the live one
+    uint32_t    ratePerSecond { 10 };      // per thread and call site, 0 = unlimited
+    uint32_t    flushIntervalMs { 10 };    // how often the writer drains the rings
+};
+
+struct Counters
+{
+    uint64_t written;    // records the writer has output
+    uint64_t dropped;    // records lost to a full ring
+    uint64_t suppressed; // records held back by the rate limit
+};
+
+// Starts the writer thread. Returns false if the log file can't be opened.
+bool start(const Config& config);
+
+// Writes everything queued and stops the writer thread
+void stop();
+
+// Returns once everything logged before the call has been written
+void flush();
+
+Counters counters();
+
+// Sets up the calling thread's ring now rather than on its first message,
+// which for a pad thread tends to be a device error
+void attachThread();
+
+void write(Level level, const char* format, ...) N64_PRINTF_FORMAT(2, 3);
+void writeV(Level level, const char* format, va_list args);
+
+void info(const char* format, ...) N64_PRINTF_FORMAT(1, 2);
+void warning(const char* format, ...) N64_PRINTF_FORMAT(1, 2);
+void error(const char* format, ...) N64_PRINTF_FORMAT(1, 2);
+
+}
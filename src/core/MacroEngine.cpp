@@ -0,0 +1,315 @@
+#include "MacroEngine.h"
+#include "Clock.h"
+#include "Log.h"
+
+#include <algorithm>
+
+namespace
+{
+
+uint64_t packOutput(uint16_t held, uint16_t released, uint8_t triggers)
+{
+    return held | (static_cast<uint64_t>(released) << 16) | (static_cast<uint64_t>(triggers) << 32);
+}
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Pad
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Engine side of a pad, only touched under the engine mutex
+struct MacroEngine::Pad::State
+{
+    Pad*               pad { nullptr };
+    TimerWheel::Timer  turboTimer;
+    TimerWheel::Timer  macroTimer;
+
+    uint16_t           turboHeld { 0 };
+    bool               turboReleased { false }; // in the off half of the period
+    int64_t            turboHalfNs { 0 };
+
+    MacroSet::Sequence sequence;
+    uint8_t            step { 0 };
+    bool               playing { false };
+
+    uint64_t           published { 0 };
+
+    // What the pad last handed over
+    MacroSet::Sequence started;
+    uint16_t           turboRequested { 0 };
+};
+
+MacroEngine::Pad::Pad(MacroEngine& engine)
+    : engine_(engine)
+    , event_(WaitableEvent::create())
+    , state_(new State)
+{
+    state_->pad = this;
+}
+
+MacroEngine::Pad::~Pad()
+{
+    engine_.remove(*this);
+}
+
+void MacroEngine::Pad::merge(const MacroSet& macros, XusbReport& report)
+{
+    const uint16_t pressed = report.wButtons;
+    const uint16_t rising  = static_cast<uint16_t>(pressed & ~lastButtons_);
+    lastLive_    = report;
+    lastButtons_ = pressed;
+
+    // Nothing bound and nothing playing: live input goes straight through
+    if (macros.empty() && turboPressed_ == 0 && output_.load(std::memory_order_acquire) == 0)
+        return;
+
+    // Each new press of a slot (re)starts its macro; of several at once the
+    // highest slot wins, as it would have played last
+    bool changed = false;
+    const uint16_t started = rising & macros.slots;
+    if (started)
+    {
+        uint32_t bit = 15;
+        while (!(started & (1u << bit)))
+            bit--;
+        start_.post(macros.sequences[bit]);
+        changed = true;
+    }
+
+    // Releases go out for whatever the engine was told is held, so a
+    // profile reload mid press can't leave turbo running
+    const uint16_t turboDown = rising & macros.turbo;
+    const uint16_t turboUp   = static_cast<uint16_t>(turboPressed_ & ~pressed);
+    if (turboDown || turboUp)
+    {
+        turboPressed_ = static_cast<uint16_t>((turboPressed_ | turboDown) & ~turboUp);
+        turbo_.store(turboPressed_ | (static_cast<uint64_t>(macros.turboHalfPeriodNs) << 16), std::memory_order_release);
+        changed = true;
+    }
+
+    if (changed)
+        engine_.wake_->signal();
+
+    overlay(macros, report);
+}
+
+void MacroEngine::Pad::remerge(const MacroSet& macros, XusbReport& out)
+{
+    event_->acknowledge();
+    overlay(macros, out);
+}
+
+void MacroEngine::Pad::overlay(const MacroSet& macros, XusbReport& out) const
+{
+    const uint64_t output   = output_.load(std::memory_order_acquire);
+    const auto     held     = static_cast<uint16_t>(output);
+    const auto     released = static_cast<uint16_t>(output >> 16);
+    const auto     triggers = static_cast<uint8_t>(output >> 32);
+
+    out = lastLive_;
+    out.wButtons = static_cast<uint16_t>((lastLive_.wButtons & ~macros.slots & ~released) | held);
+    if (triggers & 1)
+        out.bLeftTrigger = 255;
+    if (triggers & 2)
+        out.bRightTrigger = 255;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  MacroEngine
+//
+///////////////////////////////////////////////////////////////////////////////
+
+MacroEngine::MacroEngine() = default;
+
+MacroEngine::~MacroEngine()
+{
+    if (loop_)
+    {
+        loop_->stop();
+        if (thread_.joinable())
+            thread_.join();
+        loop_.reset();
+    }
+}
+
+std::unique_ptr<MacroEngine> MacroEngine::create()
+{
+    std::unique_ptr<MacroEngine> engine(new MacroEngine());
+    if (!engine->init())
+        return nullptr;
+    return engine;
+}
+
+bool MacroEngine::init()
+{
+    loop_  = EventLoop::create();
+    timer_ = WaitableTimer::create();
+    wake_  = WaitableEvent::create();
+    if (!loop_ || !timer_ || !wake_)
+    {
+        Log::error("Failed to create the macro timer");
+        return false;
+    }
+
+    const bool added =
+        loop_->add(timer_->handle(), [this]
+        {
+            timer_->acknowledge();
+            armedNs_ = -1;
+            service();
+        }) &&
+        loop_->add(wake_->handle(), [this]
+        {
+            wake_->acknowledge();
+            service();
+        });
+    if (!added)
+    {
+        Log::error("Failed to set up the macro event loop");
+        return false;
+    }
+
+    thread_ = std::thread([this]
+    {
+        Log::attachThread();
+        loop_->run();
+    });
+    return true;
+}
+
+std::unique_ptr<MacroEngine::Pad> MacroEngine::addPad()
+{
+    std::unique_ptr<Pad> pad(new Pad(*this));
+    if (!pad->event_)
+        return nullptr;
+
+    auto& state = *pad->state_;
+    state.turboTimer.callback = [this, &state](int64_t deadlineNs)
+    {
+        counters_.fired.fetch_add(1, std::memory_order_relaxed);
+        lateness_.record(Clock::nowNs() - deadlineNs);
+
+        // Drift free: the next phase is a period after this deadline,
+        // however late this one ran
+        state.turboReleased = !state.turboReleased;
+        if (state.turboHeld)
+            wheel_.schedule(state.turboTimer, deadlineNs + state.turboHalfNs);
+        else
+            state.turboReleased = false;
+        publish(state);
+    };
+    state.macroTimer.callback = [this, &state](int64_t deadlineNs)
+    {
+        counters_.fired.fetch_add(1, std::memory_order_relaxed);
+        lateness_.record(Clock::nowNs() - deadlineNs);
+
+        if (++state.step < state.sequence.count)
+            wheel_.schedule(state.macroTimer, deadlineNs + state.sequence.steps[state.step].durationMs * 1000000ll);
+        else
+            state.playing = false;
+        publish(state);
+    };
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    pads_.push_back(&state);
+    return pad;
+}
+
+void MacroEngine::remove(Pad& pad)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    wheel_.cancel(pad.state_->turboTimer);
+    wheel_.cancel(pad.state_->macroTimer);
+    pads_.erase(std::remove(pads_.begin(), pads_.end(), pad.state_.get()), pads_.end());
+}
+
+void MacroEngine::service()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto nowNs = Clock::nowNs();
+    for (auto* state : pads_)
+        drain(*state, nowNs);
+
+    wheel_.advance(Clock::nowNs());
+
+    const auto nextNs = wheel_.nextDeadlineNs();
+    if (nextNs < 0)
+    {
+        if (armedNs_ >= 0)
+            timer_->disarm();
+        armedNs_ = -1;
+    }
+    else if (nextNs != armedNs_)
+    {
+        timer_->arm(nextNs - Clock::nowNs());
+        armedNs_ = nextNs;
+    }
+}
+
+void MacroEngine::drain(Pad::State& state, int64_t nowNs)
+{
+    auto& pad = *state.pad;
+
+    if (pad.start_.take(state.started) && state.started.count != 0)
+    {
+        state.sequence = state.started;
+        state.step     = 0;
+        state.playing  = true;
+        wheel_.schedule(state.macroTimer, nowNs + state.sequence.steps[0].durationMs * 1000000ll);
+        counters_.macros.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const uint64_t turbo   = pad.turbo_.load(std::memory_order_acquire);
+    const auto     held    = static_cast<uint16_t>(turbo);
+    const auto     pressed = static_cast<uint16_t>(held & ~state.turboRequested);
+    const auto     lifted  = static_cast<uint16_t>(state.turboRequested & ~held);
+    state.turboRequested = held;
+    if (pressed)
+    {
+        // The press itself goes out at once; the first release is half a
+        // period later
+        state.turboHeld  |= pressed;
+        state.turboHalfNs = (std::max)(kTickNs, static_cast<int64_t>(turbo >> 16));
+        if (!state.turboTimer.pending())
+        {
+            state.turboReleased = false;
+            wheel_.schedule(state.turboTimer, nowNs + state.turboHalfNs);
+        }
+    }
+    if (lifted)
+    {
+        state.turboHeld &= static_cast<uint16_t>(~lifted);
+        if (!state.turboHeld)
+        {
+            wheel_.cancel(state.turboTimer);
+            state.turboReleased = false;
+        }
+    }
+
+    publish(state);
+}
+
+void MacroEngine::publish(Pad::State& state)
+{
+    // A finished macro leaves step at count, past the last step
+    uint16_t buttons  = 0;
+    uint8_t  triggers = 0;
+    if (state.playing)
+    {
+        const auto& step = state.sequence.steps[state.step];
+        buttons  = step.buttons;
+        triggers = step.triggers;
+    }
+    const auto output = packOutput(buttons, state.turboReleased ? state.turboHeld : 0, triggers);
+    if (output == state.published)
+        return;
+
+    state.published = output;
+    state.pad->output_.store(output, std::memory_order_release);
+    state.pad->event_->signal();
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "EventLoop.h"
+#include "LatencyHistogram.h"
+#include "LatestValue.h"
+#include "MappingTables.h"
+#include "TimerWheel.h"
+#include "WaitableEvent.h"
+#include "WaitableTimer.h"
+#include "XusbReport.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Turbo and macro playback for every pad
+//
+//  One thread and one TimerWheel time every turbo phase and macro step of
+//  every pad; the thread sleeps on a high resolution WaitableTimer armed for
+//  the earliest deadline, so steps land within the OS timer's precision
+//  (well under a millisecond) with no thread per macro.
+//
+//  The engine never sends anything itself. Each pad has a Pad: its thread
+//  passes every live report through merge(), which starts and stops turbo
+//  and macros on button edges and lays the current macro output over the
+//  live report. When a step changes that output the engine signals the
+//  Pad's handle, and the pad's thread merges again and sends, so the
+//  virtual pad is only ever touched by the pad's own thread.
+//
+//  Macro output is held buttons (and fully pulled triggers) on top of live
+//  input; turbo releases its held buttons every other half period. A macro
+//  slot button itself is never sent.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class MacroEngine
+{
+public:
+    static constexpr int64_t  kTickNs = 250000;
+    static constexpr uint32_t kSlots  = 1024; // a quarter second per turn
+
+    struct Counters
+    {
+        std::atomic<uint64_t> fired { 0 };     // turbo phases and macro steps
+        std::atomic<uint64_t> macros { 0 };    // macros started
+    };
+
+    class Pad
+    {
+    public:
+        ~Pad();
+
+        Pad(const Pad&) = delete;
+        Pad& operator=(const Pad&) = delete;
+
+        // Signalled when the macro output changed; service on the pad's thread
+        EventHandle handle() const { return event_->handle(); }
+
+        // Pad thread: turns the live report into what to send
+        void merge(const MacroSet& macros, XusbReport& report);
+
+        // Pad thread, once handle() fired: the last live report with the
+        // current macro output
+        void remerge(const MacroSet& macros, XusbReport& out);
+
+    private:
+        friend class MacroEngine;
+        struct State;
+
+        explicit Pad(MacroEngine& engine);
+        void overlay(const MacroSet& macros, XusbReport& out) const;
+
+    private:
+        MacroEngine&                   engine_;
+        std::unique_ptr<WaitableEvent> event_;
+        std::unique_ptr<State>         state_;  // engine thread only
+
+        // Written by the engine thread: set buttons (0-15), released
+        // buttons (16-31) and pulled triggers (32-33)
+        std::atomic<uint64_t> output_ { 0 };
+
+        // Written by the pad thread, drained by the engine thread: the macro
+        // to (re)start, and the held turbo buttons (0-15) with their half
+        // period in ns (16-63)
+        LatestValue<MacroSet::Sequence> start_;
+        std::atomic<uint64_t>           turbo_ { 0 };
+
+        // Pad thread only
+        XusbReport lastLive_ {};
+        uint16_t   lastButtons_ { 0 };
+        uint16_t   turboPressed_ { 0 }; // turbo buttons the engine was told are held
+    };
+
+public:
+    ~MacroEngine();
+
+    MacroEngine(const MacroEngine&) = delete;
+    MacroEngine& operator=(const MacroEngine&) = delete;
+
+    // nullptr when the platform has no waitable timers
+    static std::unique_ptr<MacroEngine> create();
+
+    // nullptr if the pad's wake event can't be created. Pads must be gone
+    // before the engine.
+    std::unique_ptr<Pad> addPad();
+
+    const Counters& counters() const { return counters_; }
+
+    // How late turbo phases and macro steps fired
+    const LatencyHistogram& lateness() const { return lateness_; }
+
+private:
+    MacroEngine();
+    bool init();
+
+    void service();
+    void drain(Pad::State& state, int64_t nowNs);
+    void publish(Pad::State& pad);
+    void remove(Pad& pad);
+
+private:
+    std::unique_ptr<EventLoop>     loop_;
+    std::unique_ptr<WaitableTimer> timer_;
+    std::unique_ptr<WaitableEvent> wake_;
+    std::thread                    thread_;
+
+    // Pads hand over presses without locking and wake the engine; the
+    // engine thread holds the mutex while it drains them and fires timers,
+    // so only adding and removing a pad ever waits on it
+    std::mutex               mutex_;
+    std::vector<Pad::State*> pads_;
+    TimerWheel               wheel_ { kTickNs, kSlots };
+    int64_t                  armedNs_ { -1 };
+
+    Counters         counters_;
+    LatencyHistogram lateness_;
+};
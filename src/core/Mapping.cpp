@@ -0,0 +1,81 @@
+#include "Mapping.h"
+
+#include <algorithm>
+#include <cmath>
+
+void Mapping::applyDeadzones(N64ControllerState& state)
+{
+    if (state.xAxis > X_DEADZONE_START && state.xAxis < X_DEADZONE_END)
+        state.xAxis = (X_DEADZONE_START + X_DEADZONE_END) / 2;
+    if (state.yAxis > Y_DEADZONE_START && state.yAxis < Y_DEADZONE_END)
+        state.yAxis = (Y_DEADZONE_START + Y_DEADZONE_END) / 2;
+}
+
+int16_t Mapping::convertAnalog(int32_t value, int32_t min, int32_t max)
+{
+    // Subtract in 64 bits so values far below `min` clamp instead of overflowing
+    const auto offset = (std::max)(int64_t(0), int64_t(value) - min);
+    return static_cast<int16_t>((std::min)(65535.0f, offset / static_cast<float>(max - min) * 65535.0f) - 65535.0f/2.0f);
+}
+
+int16_t Mapping::convertCButtonToAnalog(bool negative, bool positive)
+{
+    if (negative && positive)
+        return 0;
+    if (!negative && !positive)
+        return 0;
+    return negative ? -1 : 1;
+}
+
+std::pair<int16_t, int16_t> Mapping::normalizedCButtonVector(int16_t x, int16_t y)
+{
+    auto mag = std::sqrt(static_cast<float>(x*x + y*y));
+    if (mag == 0)
+        return {0,0};
+    return {
+        static_cast<int16_t>(std::round(static_cast<float>(x) / mag * 32767)),
+        static_cast<int16_t>(std::round(static_cast<float>(y) / mag * 32767))
+    };
+}
+
+uint16_t Mapping::convertButtons(const N64ControllerState& state)
+{
+    // NOTE: the remaining unbound xbox controller buttons are:
+    // Xusb::LEFT_THUMB  = 0x0040,
+    // Xusb::RIGHT_THUMB = 0x0080,
+    // Xusb::Y           = 0x8000
+    return static_cast<uint16_t>(
+        (state.buttons[N64Button::A] ? Xusb::A : 0) |
+        (state.buttons[N64Button::B] ? Xusb::B : 0) |
+        (state.buttons[N64Button::ZR] ? Xusb::X : 0) |
+        (state.buttons[N64Button::LEFT_BUMPER] ? Xusb::LEFT_SHOULDER : 0) |
+        (state.buttons[N64Button::RIGHT_BUMPER] ? Xusb::RIGHT_SHOULDER : 0) |
+        (state.buttons[N64Button::START] ? Xusb::START : 0) |
+        (state.buttons[N64Button::HOME] ? Xusb::GUIDE : 0) |
+        (state.buttons[N64Button::CIRCLE] ? Xusb::BACK : 0) |
+        (state.dpad == 0     ? Xusb::DPAD_UP : 0) |
+        (state.dpad == 4500  ? Xusb::DPAD_UP | Xusb::DPAD_RIGHT : 0) |
+        (state.dpad == 9000  ? Xusb::DPAD_RIGHT : 0) |
+        (state.dpad == 13500 ? Xusb::DPAD_RIGHT | Xusb::DPAD_DOWN : 0) |
+        (state.dpad == 18000 ? Xusb::DPAD_DOWN : 0) |
+        (state.dpad == 22500 ? Xusb::DPAD_DOWN | Xusb::DPAD_LEFT : 0) |
+        (state.dpad == 27000 ? Xusb::DPAD_LEFT : 0) |
+        (state.dpad == 31500 ? Xusb::DPAD_LEFT | Xusb::DPAD_UP : 0)
+    );
+}
+
+void Mapping::convert(const N64ControllerState& state, XusbReport& report)
+{
+    auto cButtonVector = normalizedCButtonVector(
+        convertCButtonToAnalog(state.buttons[N64Button::C_LEFT], state.buttons[N64Button::C_RIGHT]),
+        convertCButtonToAnalog(state.buttons[N64Button::C_DOWN], state.buttons[N64Button::C_UP])
+    );
+
+    report.bLeftTrigger  = state.buttons[N64Button::Z] ? 255 : 0;
+    report.bRightTrigger = 0;
+    report.sThumbLX      = convertAnalog(state.xAxis, X_MIN, X_MAX);
+    report.sThumbLY      = -convertAnalog(state.yAxis, Y_MIN, Y_MAX);
+    report.sThumbRX      = cButtonVector.first;
+    report.sThumbRY      = cButtonVector.second;
+    report.wButtons      = convertButtons(state);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "N64ControllerState.h"
+#include "XusbReport.h"
+
+#include <cstdint>
+#include <utility>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  N64 -> XUSB mapping
+//
+//  Portable copy of the conversion that used to live in the Controller worker
+//  thread. No Win32, DirectInput or ViGEm dependencies so it can be built and
+//  measured anywhere.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Mapping
+{
+
+static constexpr int32_t X_DEADZONE_START = 31700;
+static constexpr int32_t X_DEADZONE_END   = 32000;
+static constexpr int32_t Y_DEADZONE_START = 29600;
+static constexpr int32_t Y_DEADZONE_END   = 29900;
+
+static constexpr int32_t X_MIN = 9800;
+static constexpr int32_t X_MAX = 54300;
+static constexpr int32_t Y_MIN = 6700;
+static constexpr int32_t Y_MAX = 51800;
+
+// Snaps stick values that fall inside the rest deadzone to its center
+void applyDeadzones(N64ControllerState& state);
+
+int16_t convertAnalog(int32_t value, int32_t min, int32_t max);
+int16_t convertCButtonToAnalog(bool negative, bool positive);
+std::pair<int16_t, int16_t> normalizedCButtonVector(int16_t x, int16_t y);
+uint16_t convertButtons(const N64ControllerState& state);
+
+// Converts a (deadzone snapped) state into a full report
+void convert(const N64ControllerState& state, XusbReport& report);
+
+}
@@ -0,0 +1,260 @@
+#include "MappingTables.h"
+#include "Mapping.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define N64_HAVE_SSE2 1
+#endif
+
+namespace
+{
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Compile time tables
+//
+///////////////////////////////////////////////////////////////////////////////
+
+constexpr float constexprSqrt(float value)
+{
+    if (value <= 0.0f)
+        return 0.0f;
+    double root = value;
+    for (int i = 0; i < 32; i++)
+        root = 0.5 * (root + value / root);
+    return static_cast<float>(root);
+}
+
+// std::round (half away from zero) for the small magnitudes used below
+constexpr int16_t constexprRound(float value)
+{
+    const float magnitude = value < 0 ? -value : value;
+    int32_t truncated = static_cast<int32_t>(magnitude);
+    if (magnitude - static_cast<float>(truncated) >= 0.5f)
+        truncated++;
+    return static_cast<int16_t>(value < 0 ? -truncated : truncated);
+}
+
+struct StickVector
+{
+    int16_t x;
+    int16_t y;
+
+    constexpr uint32_t packed() const
+    {
+        return static_cast<uint16_t>(x) | (static_cast<uint32_t>(static_cast<uint16_t>(y)) << 16);
+    }
+};
+
+// Same math as Mapping::normalizedCButtonVector, evaluated for each
+// combination of (C_LEFT, C_RIGHT, C_DOWN, C_UP)
+constexpr StickVector cButtonVector(uint32_t index)
+{
+    const bool left  = index & 1;
+    const bool right = index & 2;
+    const bool down  = index & 4;
+    const bool up    = index & 8;
+
+    const int x = left == right ? 0 : (left ? -1 : 1);
+    const int y = down == up ? 0 : (down ? -1 : 1);
+
+    const float mag = constexprSqrt(static_cast<float>(x*x + y*y));
+    if (mag == 0)
+        return { 0, 0 };
+    return {
+        constexprRound(static_cast<float>(x) / mag * 32767),
+        constexprRound(static_cast<float>(y) / mag * 32767)
+    };
+}
+
+struct CButtonTable
+{
+    uint32_t vectors[16];
+};
+
+constexpr CButtonTable makeCButtonTable()
+{
+    CButtonTable table{};
+    for (uint32_t i = 0; i < 16; i++)
+        table.vectors[i] = cButtonVector(i).packed();
+    return table;
+}
+
+constexpr CButtonTable kCButtonTable = makeCButtonTable();
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  AxisTable
+//
+///////////////////////////////////////////////////////////////////////////////
+
+AxisTable::AxisTable(const AxisProfile& axis)
+    : min_((std::min)(axis.min, axis.deadzoneStart))
+    , max_((std::max)(axis.max, axis.deadzoneEnd))
+{
+    const bool linear = axis.deadzone == DeadzoneShape::SNAP && axis.curve == 1.0f;
+
+    // One spare entry so 32 bit gathers of the last value stay in bounds
+    values_.resize(static_cast<size_t>(int64_t(max_) - min_ + 2));
+    for (int64_t value = min_; value <= max_; value++)
+    {
+        int16_t converted;
+        if (linear)
+        {
+            auto snapped = static_cast<int32_t>(value);
+            if (snapped > axis.deadzoneStart && snapped < axis.deadzoneEnd)
+                snapped = (axis.deadzoneStart + axis.deadzoneEnd) / 2;
+            converted = Mapping::convertAnalog(snapped, axis.min, axis.max);
+        }
+        else
+            converted = curvedValue(axis, static_cast<int32_t>(value));
+
+        values_[static_cast<size_t>(value - min_)] = axis.invert ? static_cast<int16_t>(-converted) : converted;
+    }
+}
+
+int16_t AxisTable::curvedValue(const AxisProfile& axis, int32_t value)
+{
+    // Deflection in [-1, 1] before the curve
+    double deflection;
+    if (axis.deadzone == DeadzoneShape::SCALED)
+    {
+        if (value > axis.deadzoneStart && value < axis.deadzoneEnd)
+            return 0;
+        if (value <= axis.deadzoneStart)
+            deflection = -static_cast<double>(axis.deadzoneStart - value) / (std::max)(1, axis.deadzoneStart - axis.min);
+        else
+            deflection = static_cast<double>(value - axis.deadzoneEnd) / (std::max)(1, axis.max - axis.deadzoneEnd);
+    }
+    else
+    {
+        if (value > axis.deadzoneStart && value < axis.deadzoneEnd)
+            value = (axis.deadzoneStart + axis.deadzoneEnd) / 2;
+        deflection = static_cast<double>(value - axis.min) / (axis.max - axis.min) * 2.0 - 1.0;
+    }
+    deflection = (std::min)(1.0, (std::max)(-1.0, deflection));
+
+    const double curved = std::copysign(std::pow(std::fabs(deflection), static_cast<double>(axis.curve)), deflection);
+    return static_cast<int16_t>(std::lround(curved * 32767.0));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  MappingTables
+//
+///////////////////////////////////////////////////////////////////////////////
+
+MappingTables::MappingTables()
+    : MappingTables(Profile::defaults())
+{   }
+
+MappingTables::MappingTables(const Profile& profile)
+    : xAxis_(profile.xAxis)
+    , yAxis_(profile.yAxis)
+    , leftTrigger_(profile.leftTrigger)
+    , rightTrigger_(profile.rightTrigger)
+{
+    for (uint32_t bits = 0; bits < 256; bits++)
+    {
+        for (uint32_t button = 0; button < 8; button++)
+        {
+            if (bits & (1u << button))
+            {
+                buttons_.lo[bits] |= profile.buttons[button];
+                buttons_.hi[bits] |= profile.buttons[button + 8];
+            }
+        }
+    }
+
+    // Without the C-stick the right stick rests and the C-buttons only
+    // press what they are bound to
+    if (profile.cStick)
+        memcpy(cStick_, kCButtonTable.vectors, sizeof(cStick_));
+
+    macros_.turbo             = profile.turbo;
+    macros_.turboHalfPeriodNs = 500000000ll / (std::max)(1u, profile.turboHz);
+    for (const auto& macro : profile.macros)
+    {
+        if (macro.slot == 0 || macro.steps.empty())
+            continue;
+        uint32_t bit = 0;
+        while (!(macro.slot & (1u << bit)))
+            bit++;
+
+        auto& sequence = macros_.sequences[bit];
+        sequence.count = static_cast<uint8_t>((std::min)(macro.steps.size(), Macro::kMaxSteps));
+        std::copy(macro.steps.begin(), macro.steps.begin() + sequence.count, sequence.steps);
+        macros_.slots |= static_cast<uint16_t>(1u << bit);
+    }
+}
+
+const MappingTables& MappingTables::defaults()
+{
+    static const MappingTables tables;
+    return tables;
+}
+
+uint16_t MappingTables::pressedMask(const N64ControllerState& state)
+{
+#if N64_HAVE_SSE2
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state.buttons));
+    return static_cast<uint16_t>(~_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_setzero_si128())));
+#else
+    uint16_t mask = 0;
+    for (uint32_t i = 0; i < 16; i++)
+        mask |= static_cast<uint16_t>((state.buttons[i] != 0) << i);
+    return mask;
+#endif
+}
+
+uint16_t MappingTables::dpadButtons(int32_t dpad)
+{
+    // Only exact multiples of 45 degrees map to a direction; centered (-1)
+    // and anything else falls through to the empty entry
+    const uint32_t angle  = static_cast<uint32_t>(dpad);
+    const uint32_t octant = angle / 4500;
+    return kDpadButtons[(octant < 8 && octant * 4500 == angle) ? octant : 8];
+}
+
+MappingTables::Layout MappingTables::layout() const
+{
+    return {
+        xAxis_.values(), xAxis_.lowest(), xAxis_.highest(),
+        yAxis_.values(), yAxis_.lowest(), yAxis_.highest(),
+        buttons_.lo,
+        buttons_.hi,
+        cStick_,
+        leftTrigger_,
+        rightTrigger_
+    };
+}
+
+void MappingTables::convert(int32_t xAxis, int32_t yAxis, int32_t dpad, uint16_t pressed, XusbReport& report) const
+{
+    const uint32_t cStick = cStick_[cButtonIndex(pressed)];
+
+    report.bLeftTrigger  = static_cast<uint8_t>(0u - ((pressed & leftTrigger_) != 0));
+    report.bRightTrigger = static_cast<uint8_t>(0u - ((pressed & rightTrigger_) != 0));
+    report.sThumbLX      = xAxis_.lookup(xAxis);
+    report.sThumbLY      = yAxis_.lookup(yAxis);
+    report.sThumbRX      = static_cast<int16_t>(cStick & 0xFFFF);
+    report.sThumbRY      = static_cast<int16_t>(cStick >> 16);
+    report.wButtons      = static_cast<uint16_t>(buttons_.lo[pressed & 0xFF] | buttons_.hi[pressed >> 8] | dpadButtons(dpad));
+}
+
+void MappingTables::convertButtons(int32_t dpad, uint16_t pressed, XusbReport& report) const
+{
+    report.bLeftTrigger  = static_cast<uint8_t>(0u - ((pressed & leftTrigger_) != 0));
+    report.bRightTrigger = static_cast<uint8_t>(0u - ((pressed & rightTrigger_) != 0));
+    report.sThumbLX      = 0;
+    report.sThumbLY      = 0;
+    report.sThumbRX      = 0;
+    report.sThumbRY      = 0;
+    report.wButtons      = static_cast<uint16_t>(buttons_.lo[pressed & 0xFF] | buttons_.hi[pressed >> 8] | dpadButtons(dpad));
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "N64ControllerState.h"
+#include "Profile.h"
+#include "XusbReport.h"
+
+#include <cstdint>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Table driven N64 -> XUSB conversion
+//
+//  A Profile compiled into flat tables, so a report costs no float math and
+//  the same handful of loads whatever the profile says: each stick axis is
+//  one clamp and one table load, the C-buttons, buttons and triggers are
+//  indexed or masked by a 16 bit pressed mask and the dpad by POV angle.
+//  The default profile produces bit-identical reports to Mapping::convert
+//  (including deadzone snapping).
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class AxisTable
+{
+public:
+    // Precomputes the output for every value in [min, max] with the axis'
+    // deadzone and curve applied. A linear snapping axis is exactly
+    // Mapping::convertAnalog after snapping (deadzoneStart, deadzoneEnd) to
+    // its center.
+    explicit AxisTable(const AxisProfile& axis);
+
+    int16_t lookup(int32_t value) const
+    {
+        // Everything outside the calibrated range saturates to the end points
+        const int32_t clamped = value < min_ ? min_ : (value > max_ ? max_ : value);
+        return values_[static_cast<uint32_t>(clamped - min_)];
+    }
+
+    int32_t        lowest() const  { return min_; }
+    int32_t        highest() const { return max_; }
+    const int16_t* values() const  { return values_.data(); }
+
+private:
+    // Any curve or scaled deadzone: float math, evaluated once per value
+    static int16_t curvedValue(const AxisProfile& axis, int32_t value);
+
+private:
+    int32_t              min_;
+    int32_t              max_;
+    std::vector<int16_t> values_;
+};
+
+// A profile's turbo and macros, in the form the macro engine plays them
+struct MacroSet
+{
+    struct Sequence
+    {
+        uint8_t   count { 0 };
+        MacroStep steps[Macro::kMaxSteps];
+    };
+
+    uint16_t slots { 0 };           // wButtons that play a macro instead of being sent
+    uint16_t turbo { 0 };           // wButtons that auto-fire while held
+    int64_t  turboHalfPeriodNs { 0 };
+    Sequence sequences[16];         // by wButtons bit index
+
+    bool empty() const { return slots == 0 && turbo == 0; }
+};
+
+class MappingTables
+{
+public:
+    // Raw view of the tables for the batch kernels. Every table is padded so
+    // a 32 bit gather at the last 16 bit entry stays in bounds.
+    struct Layout
+    {
+        const int16_t*  xAxis;
+        int32_t         xMin;
+        int32_t         xMax;
+        const int16_t*  yAxis;
+        int32_t         yMin;
+        int32_t         yMax;
+        const uint16_t* buttonsLo; // 256 entries, indexed by pressed & 0xFF
+        const uint16_t* buttonsHi; // 256 entries, indexed by pressed >> 8
+        const uint32_t* cStick;    // 16 entries, x in the low and y in the high half
+        uint16_t        leftTrigger;  // pressed mask bits that pull the trigger
+        uint16_t        rightTrigger;
+    };
+
+public:
+    // Profile::defaults()
+    MappingTables();
+    explicit MappingTables(const Profile& profile);
+
+    MappingTables(const MappingTables&) = delete;
+    MappingTables& operator=(const MappingTables&) = delete;
+
+    // Tables built from the calibration constants in Mapping.h
+    static const MappingTables& defaults();
+
+    void convert(const N64ControllerState& state, XusbReport& report) const
+    {
+        convert(state.xAxis, state.yAxis, state.dpad, pressedMask(state), report);
+    }
+
+    // Same conversion from already unpacked fields
+    void convert(int32_t xAxis, int32_t yAxis, int32_t dpad, uint16_t pressed, XusbReport& report) const;
+
+    // Same conversion for pads without sticks: both sticks rest
+    void convertButtons(int32_t dpad, uint16_t pressed, XusbReport& report) const;
+
+    Layout layout() const;
+
+    const MacroSet& macros() const { return macros_; }
+
+    // C-stick table index for a pressed mask
+    static uint32_t cButtonIndex(uint16_t pressed)
+    {
+        return ((pressed >> N64Button::C_LEFT)  & 1)        |
+               (((pressed >> N64Button::C_RIGHT) & 1) << 1) |
+               (((pressed >> N64Button::C_DOWN)  & 1) << 2) |
+               (((pressed >> N64Button::C_UP)    & 1) << 3);
+    }
+
+    // wButtons for each POV octant (0, 4500, ... 31500) plus a final empty entry
+    static constexpr uint16_t kDpadButtons[9] =
+    {
+        Xusb::DPAD_UP,
+        Xusb::DPAD_UP | Xusb::DPAD_RIGHT,
+        Xusb::DPAD_RIGHT,
+        Xusb::DPAD_RIGHT | Xusb::DPAD_DOWN,
+        Xusb::DPAD_DOWN,
+        Xusb::DPAD_DOWN | Xusb::DPAD_LEFT,
+        Xusb::DPAD_LEFT,
+        Xusb::DPAD_LEFT | Xusb::DPAD_UP,
+        0
+    };
+
+    // Bit i set when buttons[i] is non zero
+    static uint16_t pressedMask(const N64ControllerState& state);
+    static uint16_t dpadButtons(int32_t dpad);
+
+private:
+    // wButtons contribution of the low and high byte of the pressed mask
+    struct ButtonTable
+    {
+        uint16_t lo[256];
+        uint16_t hi[256];
+        uint16_t padding[2];
+    };
+
+    AxisTable   xAxis_;
+    AxisTable   yAxis_;
+    ButtonTable buttons_ {};
+    uint32_t    cStick_[16] {};
+    uint16_t    leftTrigger_;
+    uint16_t    rightTrigger_;
+    MacroSet    macros_;
+};
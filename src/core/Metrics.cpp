@@ -0,0 +1,238 @@
+#include "Metrics.h"
+#include "Log.h"
+
+#include <cstdio>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  MetricsText
+//
+///////////////////////////////////////////////////////////////////////////////
+
+void MetricsText::family(const char* name, const char* type, const char* help)
+{
+    text_ += "# HELP ";
+    text_ += name;
+    text_ += ' ';
+    text_ += help;
+    text_ += "\n# TYPE ";
+    text_ += name;
+    text_ += ' ';
+    text_ += type;
+    text_ += '\n';
+}
+
+void MetricsText::begin(const char* name, const std::string& labels, const char* extraLabel)
+{
+    text_ += name;
+    if (!labels.empty() || extraLabel)
+    {
+        text_ += '{';
+        text_ += labels;
+        if (extraLabel)
+        {
+            if (!labels.empty())
+                text_ += ',';
+            text_ += extraLabel;
+        }
+        text_ += '}';
+    }
+    text_ += ' ';
+}
+
+void MetricsText::sample(const char* name, const std::string& labels, uint64_t value)
+{
+    char number[24];
+    snprintf(number, sizeof(number), "%llu\n", static_cast<unsigned long long>(value));
+    begin(name, labels);
+    text_ += number;
+}
+
+void MetricsText::sample(const char* name, const std::string& labels, double value)
+{
+    char number[32];
+    snprintf(number, sizeof(number), "%.9g\n", value);
+    begin(name, labels);
+    text_ += number;
+}
+
+void MetricsText::summary(const char* name, const std::string& labels, const LatencyHistogram& histogram)
+{
+    static const struct { double q; const char* label; } kQuantiles[] =
+    {
+        { 0.50,  "quantile=\"0.5\"" },
+        { 0.99,  "quantile=\"0.99\"" },
+        { 0.999, "quantile=\"0.999\"" },
+    };
+
+    char number[32];
+    for (const auto& quantile : kQuantiles)
+    {
+        snprintf(number, sizeof(number), "%.9g\n", histogram.percentile(quantile.q) / 1e9);
+        begin(name, labels, quantile.label);
+        text_ += number;
+    }
+
+    const std::string base = name;
+    sample((base + "_sum").c_str(), labels, histogram.sum() / 1e9);
+    sample((base + "_count").c_str(), labels, histogram.count());
+}
+
+std::string MetricsText::labelValue(const std::string& value)
+{
+    std::string out;
+    out.reserve(value.size());
+    for (const char c : value)
+    {
+        if (c == '\\' || c == '"')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (c == '\n')
+            out += "\\n";
+        else
+            out += c;
+    }
+    return out;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Writers
+//
+///////////////////////////////////////////////////////////////////////////////
+
+double Metrics::PadRates::update(const std::string& labels, uint64_t reports, int64_t connectedNs, int64_t nowNs)
+{
+    auto it = last_.find(labels);
+    if (it == last_.end())
+        it = last_.emplace(labels, Last{ 0, connectedNs, false }).first;
+
+    // A pad reopened under the same labels starts over
+    auto& last = it->second;
+    if (reports < last.reports || connectedNs > last.ns)
+        last = Last{ 0, connectedNs, false };
+
+    const double seconds = static_cast<double>(nowNs - last.ns) / 1e9;
+    const double rate    = seconds > 0 ? static_cast<double>(reports - last.reports) / seconds : 0.0;
+    last = Last{ reports, nowNs, true };
+    return rate;
+}
+
+void Metrics::PadRates::sweep()
+{
+    for (auto it = last_.begin(); it != last_.end();)
+    {
+        if (!it->second.seen)
+        {
+            it = last_.erase(it);
+            continue;
+        }
+        it->second.seen = false;
+        ++it;
+    }
+}
+
+void Metrics::writePads(MetricsText& text, const std::vector<Pad>& pads, PadRates& rates, int64_t nowNs)
+{
+    auto load = [](const std::atomic<uint64_t>& counter)
+    {
+        return counter.load(std::memory_order_relaxed);
+    };
+
+    text.family("n64_pads_connected", "gauge", "Physical pads currently bridged.");
+    text.sample("n64_pads_connected", std::string(), static_cast<uint64_t>(pads.size()));
+
+    text.family("n64_pad_reports_per_second", "gauge", "Device states read per second since the previous scrape.");
+    for (const auto& pad : pads)
+    {
+        const auto& counters = pad.stats->counters;
+        text.sample("n64_pad_reports_per_second", pad.labels,
+                    rates.update(pad.labels, load(counters.reportsRead), counters.connectedNs.load(std::memory_order_relaxed), nowNs));
+    }
+    rates.sweep();
+
+    text.family("n64_pad_reports_read_total", "counter", "Device states read.");
+    for (const auto& pad : pads)
+        text.sample("n64_pad_reports_read_total", pad.labels, load(pad.stats->counters.reportsRead));
+
+    text.family("n64_pad_reports_submitted_total", "counter", "Virtual pad updates sent, fixed rate resends included.");
+    for (const auto& pad : pads)
+        text.sample("n64_pad_reports_submitted_total", pad.labels, load(pad.stats->counters.reportsSubmitted));
+
+    text.family("n64_pad_dedupe_skip_ratio", "gauge", "Share of device states dropped because the report didn't change.");
+    for (const auto& pad : pads)
+    {
+        const auto read = load(pad.stats->counters.reportsRead);
+        text.sample("n64_pad_dedupe_skip_ratio", pad.labels,
+                    read ? static_cast<double>(load(pad.stats->counters.reportsSkipped)) / read : 0.0);
+    }
+
+    text.family("n64_pad_read_errors_total", "counter", "Failed device reads.");
+    for (const auto& pad : pads)
+        text.sample("n64_pad_read_errors_total", pad.labels, load(pad.stats->counters.readErrors));
+
+    text.family("n64_pad_reacquires_total", "counter", "Times the device was lost to another app or a focus change and taken back.");
+    for (const auto& pad : pads)
+        text.sample("n64_pad_reacquires_total", pad.labels, load(pad.stats->counters.reacquires));
+
+    text.family("n64_pad_device_losses_total", "counter", "Times reads failed and the pad started recovering the device.");
+    for (const auto& pad : pads)
+        text.sample("n64_pad_device_losses_total", pad.labels, load(pad.stats->counters.deviceLosses));
+
+    text.family("n64_pad_recovery_attempts_total", "counter", "Attempts to get a lost device back.");
+    for (const auto& pad : pads)
+        text.sample("n64_pad_recovery_attempts_total", pad.labels, load(pad.stats->counters.recoveryAttempts));
+
+    text.family("n64_pad_recovery_seconds", "summary", "Time from losing the device to reading it again.");
+    for (const auto& pad : pads)
+        text.summary("n64_pad_recovery_seconds", pad.labels, pad.stats->recoveryTimes);
+
+    text.family("n64_pad_submit_latency_seconds", "summary", "Time for the virtual pad update (ViGEm IOCTL / uinput write).");
+    for (const auto& pad : pads)
+        text.summary("n64_pad_submit_latency_seconds", pad.labels, pad.stats->stages[ControllerStats::SUBMIT]);
+
+    text.family("n64_pad_reports_superseded_total", "counter", "Reports replaced in the submit thread's mailbox before it sent them.");
+    for (const auto& pad : pads)
+        text.sample("n64_pad_reports_superseded_total", pad.labels, load(pad.stats->submit.reportsSuperseded));
+
+    text.family("n64_pad_staleness_seconds", "summary", "Time from reading a state to its virtual pad update returning, with --submit-thread.");
+    for (const auto& pad : pads)
+        text.summary("n64_pad_staleness_seconds", pad.labels, pad.stats->submit.staleness);
+
+    text.family("n64_pad_connected_seconds", "gauge", "Time since the pad was connected.");
+    for (const auto& pad : pads)
+        text.sample("n64_pad_connected_seconds", pad.labels,
+                    static_cast<double>(nowNs - pad.stats->counters.connectedNs.load(std::memory_order_relaxed)) / 1e9);
+
+    text.family("n64_pad_first_report_seconds", "gauge", "Time from detecting the pad to its first virtual pad update.");
+    for (const auto& pad : pads)
+    {
+        const auto firstNs = pad.stats->timeToFirstReportNs();
+        if (firstNs >= 0)
+            text.sample("n64_pad_first_report_seconds", pad.labels, static_cast<double>(firstNs) / 1e9);
+    }
+}
+
+void Metrics::writeDetector(MetricsText& text, const HotplugDetector& detector)
+{
+    const auto& counters = detector.counters();
+
+    text.family("n64_detector_scan_seconds", "summary", "Time to enumerate and sort the connected pads.");
+    text.summary("n64_detector_scan_seconds", std::string(), detector.scanTimes());
+
+    text.family("n64_detector_notifications_total", "counter", "Device change notifications that triggered a scan.");
+    text.sample("n64_detector_notifications_total", std::string(), counters.notifications.load(std::memory_order_relaxed));
+}
+
+void Metrics::writeLog(MetricsText& text)
+{
+    const auto counters = Log::counters();
+
+    text.family("n64_log_messages_dropped_total", "counter", "Log messages lost to a full ring.");
+    text.sample("n64_log_messages_dropped_total", std::string(), counters.dropped);
+
+    text.family("n64_log_messages_suppressed_total", "counter", "Log messages held back by the rate limit.");
+    text.sample("n64_log_messages_suppressed_total", std::string(), counters.suppressed);
+}
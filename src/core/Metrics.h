@@ -0,0 +1,82 @@
+#pragma once
+
+#include "ControllerStats.h"
+#include "HotplugDetector.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Prometheus text exposition
+//
+//  Snapshots ControllerStats, the hotplug detector and the logger into the
+//  text format (version 0.0.4). Everything read here is written by a single
+//  thread into relaxed atomics on cache lines of its own, so a scrape never
+//  takes a lock a pad thread could be waiting on.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class MetricsText
+{
+public:
+    // Starts a family; its samples must follow before the next family
+    void family(const char* name, const char* type, const char* help);
+
+    // labels is the inside of the braces (`player="1",guid="..."`), or empty
+    void sample(const char* name, const std::string& labels, uint64_t value);
+    void sample(const char* name, const std::string& labels, double value);
+
+    // `{labels,quantile="q"}` samples plus _sum and _count, in seconds
+    void summary(const char* name, const std::string& labels, const LatencyHistogram& histogram);
+
+    // Escapes backslashes, quotes and newlines for a label value
+    static std::string labelValue(const std::string& value);
+
+    void clear() { text_.clear(); }
+    const std::string& text() const { return text_; }
+
+private:
+    void begin(const char* name, const std::string& labels, const char* extraLabel = nullptr);
+
+private:
+    std::string text_;
+};
+
+namespace Metrics
+{
+
+struct Pad
+{
+    std::string             labels; // e.g. player="1",guid="{...}"
+    const ControllerStats*  stats;
+};
+
+// reports/s between two scrapes, per pad; the first scrape of a pad
+// averages over its whole connection. Meant for a single scraper.
+class PadRates
+{
+public:
+    double update(const std::string& labels, uint64_t reports, int64_t connectedNs, int64_t nowNs);
+
+    // Forgets pads not updated since the previous sweep
+    void sweep();
+
+private:
+    struct Last
+    {
+        uint64_t reports;
+        int64_t  ns;
+        bool     seen;
+    };
+
+    std::unordered_map<std::string, Last> last_;
+};
+
+void writePads(MetricsText& text, const std::vector<Pad>& pads, PadRates& rates, int64_t nowNs);
+void writeDetector(MetricsText& text, const HotplugDetector& detector);
+void writeLog(MetricsText& text);
+
+}
@@ -0,0 +1,255 @@
+#include "MetricsServer.h"
+#include "Log.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <string>
+
+namespace
+{
+
+constexpr size_t   kMaxRequestBytes = 4096;
+constexpr uint32_t kIoTimeoutMs     = 1000;
+
+#if defined(_WIN32)
+using Socket = SOCKET;
+constexpr Socket kNoSocket  = INVALID_SOCKET;
+constexpr int    kSendFlags = 0;
+
+void closeSocket(Socket socket)
+{
+    closesocket(socket);
+}
+#else
+using Socket = int;
+constexpr Socket kNoSocket  = -1;
+constexpr int    kSendFlags = MSG_NOSIGNAL; // a client that hung up mustn't raise SIGPIPE
+
+void closeSocket(Socket socket)
+{
+    close(socket);
+}
+#endif
+
+Socket toSocket(intptr_t value)
+{
+    return static_cast<Socket>(value);
+}
+
+// A stalled client can hold the server for at most the timeout
+void setTimeouts(Socket socket)
+{
+#if defined(_WIN32)
+    const DWORD timeout = kIoTimeoutMs;
+#else
+    timeval timeout{};
+    timeout.tv_sec  = kIoTimeoutMs / 1000;
+    timeout.tv_usec = (kIoTimeoutMs % 1000) * 1000;
+#endif
+    setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+    setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+}
+
+bool sendAll(Socket socket, const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        const auto sent = send(socket, data, static_cast<int>(size), kSendFlags);
+        if (sent <= 0)
+            return false;
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool respond(Socket socket, const char* status, const char* contentType, const std::string& body)
+{
+    std::string header = "HTTP/1.1 ";
+    header += status;
+    header += "\r\nContent-Type: ";
+    header += contentType;
+    header += "\r\nContent-Length: ";
+    header += std::to_string(body.size());
+    header += "\r\nConnection: close\r\n\r\n";
+    return sendAll(socket, header.data(), header.size()) && sendAll(socket, body.data(), body.size());
+}
+
+}
+
+MetricsServer::~MetricsServer()
+{
+    if (loop_)
+    {
+        loop_->stop();
+        if (thread_.joinable())
+            thread_.join();
+        loop_.reset();
+    }
+
+    if (listen_ != -1)
+        closeSocket(toSocket(listen_));
+#if defined(_WIN32)
+    if (event_ != -1)
+        WSACloseEvent(reinterpret_cast<WSAEVENT>(event_));
+    if (winsock_)
+        WSACleanup();
+#endif
+}
+
+std::unique_ptr<MetricsServer> MetricsServer::create(uint16_t port, Render render)
+{
+    std::unique_ptr<MetricsServer> server(new MetricsServer());
+    if (!server->init(port, std::move(render)))
+        return nullptr;
+    return server;
+}
+
+bool MetricsServer::init(uint16_t port, Render render)
+{
+    render_ = std::move(render);
+
+#if defined(_WIN32)
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+    {
+        Log::error("Failed to start Winsock");
+        return false;
+    }
+    winsock_ = true;
+#endif
+
+    Socket socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (socket == kNoSocket)
+    {
+        Log::error("Failed to create the metrics socket");
+        return false;
+    }
+    listen_ = static_cast<intptr_t>(socket);
+
+    // Loopback only: the endpoint is never reachable from the network
+    sockaddr_in address{};
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port        = htons(port);
+    if (bind(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(socket, 8) != 0)
+    {
+        Log::error("Failed to listen for metrics on 127.0.0.1:%u", static_cast<unsigned>(port));
+        return false;
+    }
+
+    socklen_t length = sizeof(address);
+    getsockname(socket, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = ntohs(address.sin_port);
+
+    // The event loop waits on a Win32 event tied to the socket, or on the
+    // descriptor itself
+#if defined(_WIN32)
+    const WSAEVENT event = WSACreateEvent();
+    if (event == WSA_INVALID_EVENT || WSAEventSelect(socket, event, FD_ACCEPT) != 0)
+    {
+        Log::error("Failed to watch the metrics socket");
+        return false;
+    }
+    event_ = reinterpret_cast<EventHandle>(event);
+#else
+    fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+    fcntl(socket, F_SETFD, FD_CLOEXEC);
+    event_ = static_cast<EventHandle>(socket);
+#endif
+
+    loop_ = EventLoop::create();
+    if (!loop_ || !loop_->add(event_, [this]{ accept(); }))
+    {
+        Log::error("Failed to set up the metrics event loop");
+        loop_.reset();
+        return false;
+    }
+    thread_ = std::thread([this]
+    {
+        Log::attachThread();
+        loop_->run();
+    });
+    return true;
+}
+
+void MetricsServer::accept()
+{
+#if defined(_WIN32)
+    // Resets the event
+    WSANETWORKEVENTS events;
+    WSAEnumNetworkEvents(toSocket(listen_), reinterpret_cast<WSAEVENT>(event_), &events);
+#endif
+
+    for (;;)
+    {
+        const Socket client = ::accept(toSocket(listen_), nullptr, nullptr);
+        if (client == kNoSocket)
+            return;
+
+#if defined(_WIN32)
+        // Accepted sockets inherit the event selection and non-blocking mode
+        WSAEventSelect(client, nullptr, 0);
+        u_long blocking = 0;
+        ioctlsocket(client, FIONBIO, &blocking);
+#endif
+        setTimeouts(client);
+        serve(static_cast<intptr_t>(client));
+        closeSocket(client);
+    }
+}
+
+void MetricsServer::serve(intptr_t client)
+{
+    const Socket socket = toSocket(client);
+
+    // Only the request line matters; read until the end of the headers
+    char buffer[kMaxRequestBytes];
+    size_t size = 0;
+    while (size < sizeof(buffer) - 1)
+    {
+        const auto received = recv(socket, buffer + size, static_cast<int>(sizeof(buffer) - 1 - size), 0);
+        if (received <= 0)
+            break;
+        size += static_cast<size_t>(received);
+        buffer[size] = '\0';
+        if (strstr(buffer, "\r\n\r\n"))
+            break;
+    }
+    buffer[size] = '\0';
+
+    const char* method = buffer;
+    const char* path   = strchr(buffer, ' ');
+    if (!path)
+        return;
+    path++;
+    const char* pathEnd = strpbrk(path, " ?\r\n");
+    const std::string target(path, pathEnd ? pathEnd : path + strlen(path));
+
+    if (strncmp(method, "GET ", 4) != 0)
+    {
+        respond(socket, "405 Method Not Allowed", "text/plain", "Only GET is supported\n");
+        return;
+    }
+    if (target != "/metrics")
+    {
+        respond(socket, "404 Not Found", "text/plain", "Metrics are at /metrics\n");
+        return;
+    }
+
+    text_.clear();
+    render_(text_);
+    scrapes_.fetch_add(1, std::memory_order_relaxed);
+    respond(socket, "200 OK", "text/plain; version=0.0.4; charset=utf-8", text_.text());
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "EventLoop.h"
+#include "Metrics.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Loopback HTTP metrics endpoint
+//
+//  Answers GET /metrics on 127.0.0.1 with whatever the render callback
+//  writes, in the Prometheus text format. One request per connection,
+//  served on a thread of its own, so scraping never runs on a pad thread.
+//  Only the local machine can connect; point a local Prometheus agent (or
+//  curl) at it.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class MetricsServer
+{
+public:
+    using Render = std::function<void(MetricsText& text)>;
+
+public:
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // Port 0 picks a free port. nullptr if the port can't be bound.
+    static std::unique_ptr<MetricsServer> create(uint16_t port, Render render);
+
+    uint16_t port() const { return port_; }
+    uint64_t scrapes() const { return scrapes_.load(std::memory_order_relaxed); }
+
+private:
+    MetricsServer() = default;
+    bool init(uint16_t port, Render render);
+
+    void accept();
+    void serve(intptr_t client);
+
+private:
+    Render                     render_;
+    MetricsText                text_;     // reused between scrapes
+    intptr_t                   listen_ { -1 };
+    EventHandle                event_ { -1 };
+    uint16_t                   port_ { 0 };
+    bool                       winsock_ { false };
+    std::atomic<uint64_t>      scrapes_ { 0 };
+    std::unique_ptr<EventLoop> loop_;
+    std::thread                thread_;
+};
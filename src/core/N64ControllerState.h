@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Raw device state, laid out exactly as the DirectInput data format in
+//  DInputBackend.cpp fills it in (LONG is 32 bits on every Windows ABI).
+//  Other input backends produce the same layout and value ranges.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct N64ControllerState
+{
+    uint8_t data[20];
+    int32_t dpad;
+    int32_t yRotation;
+    int32_t xRotation;
+    int32_t yAxis;
+    int32_t xAxis;
+    uint8_t buttons[16];
+};
+
+static_assert(sizeof(N64ControllerState) == 56, "N64ControllerState must match the DirectInput data format");
+
+enum N64Button : uint32_t
+{
+    B            = 0,
+    A            = 1,
+    C_UP         = 2,
+    C_LEFT       = 3,
+    LEFT_BUMPER  = 4,
+    RIGHT_BUMPER = 5,
+    Z            = 6,
+    C_DOWN       = 7,
+    C_RIGHT      = 8,
+    START        = 9,
+    ZR           = 10,
+    HOME         = 12,
+    CIRCLE       = 13
+};
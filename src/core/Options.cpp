@@ -0,0 +1,307 @@
+#include "Options.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+
+bool parseUInt(const char* text, uint32_t min, uint32_t max, uint32_t& out)
+{
+    char* end = nullptr;
+    const unsigned long value = strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || value < min || value > max)
+        return false;
+    out = static_cast<uint32_t>(value);
+    return true;
+}
+
+}
+
+bool Options::parse(int argc, char** argv, std::string& error)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        auto requireUInt = [&](uint32_t min, uint32_t max, uint32_t& out) -> bool
+        {
+            if (!value || !parseUInt(value, min, max, out))
+            {
+                error = std::string("Invalid value for ") + arg;
+                return false;
+            }
+            i++;
+            return true;
+        };
+
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0)
+            help = true;
+        else if (strcmp(arg, "--stats") == 0)
+            stats = true;
+        else if (strcmp(arg, "--stats-interval") == 0)
+        {
+            if (!requireUInt(1, 86400, statsInterval))
+                return false;
+            stats = true;
+        }
+        else if (strcmp(arg, "--capture") == 0)
+        {
+            if (!value)
+            {
+                error = std::string("Missing file for ") + arg;
+                return false;
+            }
+            capturePath = value;
+            i++;
+        }
+        else if (strcmp(arg, "--profiles") == 0)
+        {
+            if (!value)
+            {
+                error = std::string("Missing file for ") + arg;
+                return false;
+            }
+            profilePath = value;
+            i++;
+        }
+        else if (strcmp(arg, "--profile") == 0)
+        {
+            if (!value)
+            {
+                error = std::string("Missing name for ") + arg;
+                return false;
+            }
+            profileName = value;
+            i++;
+        }
+        else if (strcmp(arg, "--log-file") == 0)
+        {
+            if (!value)
+            {
+                error = std::string("Missing file for ") + arg;
+                return false;
+            }
+            logPath = value;
+            i++;
+        }
+        else if (strcmp(arg, "--log-file-only") == 0)
+            logFileOnly = true;
+        else if (strcmp(arg, "--metrics-port") == 0)
+        {
+            if (!requireUInt(1, 65535, metricsPort))
+                return false;
+        }
+        else if (strcmp(arg, "--send") == 0)
+        {
+            if (!value || !strchr(value, ':'))
+            {
+                error = std::string("Expected host:port for ") + arg;
+                return false;
+            }
+            sendTarget = value;
+            i++;
+        }
+        else if (strcmp(arg, "--receive") == 0)
+        {
+            if (!requireUInt(1, 65535, receivePort))
+                return false;
+        }
+        else if (strcmp(arg, "--keyframe-ms") == 0)
+        {
+            if (!requireUInt(10, 60000, keyframeMs))
+                return false;
+        }
+        else if (strcmp(arg, "--shared-state") == 0)
+        {
+            if (!value || !*value || strchr(value, '/') || strchr(value, '\\'))
+            {
+                error = std::string("Invalid name for ") + arg;
+                return false;
+            }
+            sharedStateName = value;
+            i++;
+        }
+        else if (strcmp(arg, "--capture-delta") == 0)
+            captureDelta = true;
+        else if (strcmp(arg, "--submit-thread") == 0)
+            submitThread = true;
+        else if (strcmp(arg, "--warm-targets") == 0)
+        {
+            if (!requireUInt(0, 16, warmTargets))
+                return false;
+        }
+        else if (strcmp(arg, "--reconnect-grace") == 0)
+        {
+            if (!requireUInt(0, 3600000, reconnectGrace))
+                return false;
+        }
+        else if (strcmp(arg, "--input-buffer") == 0)
+        {
+            if (!requireUInt(0, 4096, inputBuffer))
+                return false;
+        }
+        else if (strcmp(arg, "--output-mode") == 0)
+        {
+            if (value && strcmp(value, "immediate") == 0)
+                outputMode = ReportScheduler::IMMEDIATE;
+            else if (value && strcmp(value, "coalesce") == 0)
+                outputMode = ReportScheduler::COALESCE;
+            else if (value && strcmp(value, "fixed") == 0)
+                outputMode = ReportScheduler::FIXED_RATE;
+            else
+            {
+                error = std::string("Invalid value for ") + arg;
+                return false;
+            }
+            i++;
+        }
+        else if (strcmp(arg, "--output-hz") == 0)
+        {
+            if (!requireUInt(1, 8000, outputHz))
+                return false;
+        }
+        else if (strcmp(arg, "--input-mode") == 0)
+        {
+            if (value && strcmp(value, "event") == 0)
+                inputMode = EventLoop::EVENT;
+            else if (value && strcmp(value, "hybrid") == 0)
+                inputMode = EventLoop::HYBRID;
+            else if (value && strcmp(value, "poll") == 0)
+                inputMode = EventLoop::BUSY_POLL;
+            else
+            {
+                error = std::string("Invalid value for ") + arg;
+                return false;
+            }
+            i++;
+        }
+        else if (strcmp(arg, "--spin-us") == 0)
+        {
+            if (!requireUInt(1, 100000, spinUs))
+                return false;
+        }
+        else if (strcmp(arg, "--input-priority") == 0)
+        {
+            if (value && strcmp(value, "normal") == 0)
+                inputPriority = ThreadSettings::NORMAL;
+            else if (value && strcmp(value, "high") == 0)
+                inputPriority = ThreadSettings::HIGH;
+            else if (value && strcmp(value, "realtime") == 0)
+                inputPriority = ThreadSettings::REALTIME;
+            else
+            {
+                error = std::string("Invalid value for ") + arg;
+                return false;
+            }
+            i++;
+        }
+        else if (strcmp(arg, "--input-cpu") == 0)
+        {
+            uint32_t cpu = 0;
+            if (!requireUInt(0, 1023, cpu))
+                return false;
+            inputCpu = static_cast<int32_t>(cpu);
+        }
+        else if (strcmp(arg, "--poll-interval") == 0)
+        {
+            if (!requireUInt(1, 60000, pollIntervalMs))
+                return false;
+        }
+        else if (strcmp(arg, "--vigem-clients") == 0)
+        {
+            if (!requireUInt(1, 16, vigemClients))
+                return false;
+        }
+        else if (strcmp(arg, "--reactor-threads") == 0)
+        {
+            if (!requireUInt(0, 64, reactorThreads))
+                return false;
+        }
+        else if (strcmp(arg, "--init-threads") == 0)
+        {
+            if (!requireUInt(1, 16, initThreads))
+                return false;
+        }
+        else
+        {
+            error = std::string("Unknown option ") + arg;
+            return false;
+        }
+    }
+
+    if (!profileName.empty() && profilePath.empty())
+    {
+        error = "--profile needs --profiles";
+        return false;
+    }
+    if (logFileOnly && logPath.empty())
+    {
+        error = "--log-file-only needs --log-file";
+        return false;
+    }
+    return true;
+}
+
+const char* Options::usage()
+{
+    return
+        "Usage: n64-controller [options]\n"
+        "  --poll-interval <ms>   fallback device rescan interval; arrivals and removals\n"
+        "                         are picked up from notifications (default 500)\n"
+        "  --vigem-clients <n>    ViGEm bus connections to spread pads over (default 1)\n"
+        "  --reactor-threads <n>  service all pads from n event loop threads instead of\n"
+        "                         one thread per pad (default 0 = thread per pad)\n"
+        "  --init-threads <n>     open up to n newly detected pads side by side (default 4)\n"
+        "  --stats                print per pad latency stats on disconnect and exit;\n"
+        "                         Ctrl+Break (SIGUSR1 on Linux) prints them on demand\n"
+        "  --stats-interval <s>   also print stats every s seconds (implies --stats)\n"
+        "  --capture <file>       record every raw device state to file (see n64-replay)\n"
+        "  --capture-delta        delta encode the capture against the previous state\n"
+        "  --profiles <file>      map with a profile from file instead of the built in\n"
+        "                         mapping; edits to the file apply while pads run\n"
+        "  --profile <name>       profile to use from --profiles (default: the first)\n"
+        "  --warm-targets <n>     keep n virtual pads plugged in ahead of time (default 0)\n"
+        "  --reconnect-grace <ms> keep a disconnected pad's virtual pad plugged in and\n"
+        "                         neutral this long, so a reconnect reuses it (default 0)\n"
+        "  --input-buffer <n>     queue up to n input events per pad and replay every\n"
+        "                         transition, so taps between reads aren't lost; on\n"
+        "                         Linux any n > 0 replays the kernel's queue\n"
+        "                         (default 0 = latest state only)\n"
+        "  --output-mode <mode>   when reports become virtual pad updates:\n"
+        "                           immediate  every change at once (default)\n"
+        "                           coalesce   at most --output-hz updates a second,\n"
+        "                                      the latest change wins\n"
+        "                           fixed      exactly --output-hz updates a second,\n"
+        "                                      resending unchanged reports\n"
+        "  --output-hz <n>        rate for coalesce and fixed (default 250)\n"
+        "  --submit-thread        update virtual pads from one thread that takes each\n"
+        "                         pad's latest report, so a slow update never delays\n"
+        "                         the next device read\n"
+        "  --input-mode <mode>    how pad threads wait for input:\n"
+        "                           event   sleep until the device signals (default)\n"
+        "                           hybrid  poll for up to --spin-us first, adapting\n"
+        "                                   the spin to how input arrives\n"
+        "                           poll    never sleep; one busy core per pad thread\n"
+        "  --spin-us <us>         longest hybrid spin before sleeping (default 200)\n"
+        "  --input-priority <p>   pad thread priority: normal (default), high (MMCSS /\n"
+        "                         nice -10) or realtime (time critical / SCHED_FIFO)\n"
+        "  --input-cpu <n>        pin pad threads to cores n, n+1, ... (per player, or\n"
+        "                         per reactor thread)\n"
+        "  --log-file <file>      also write log messages to file, rotated at 1 MB with\n"
+        "                         three old files kept (file.1 ... file.3)\n"
+        "  --log-file-only        keep log messages off the console\n"
+        "  --metrics-port <port>  serve Prometheus metrics at\n"
+        "                         http://127.0.0.1:<port>/metrics\n"
+        "  --send <host:port>     forward every pad to a bridge running --receive instead\n"
+        "                         of plugging in local virtual pads (UDP)\n"
+        "  --receive <port>       plug in a virtual pad for every pad forwarded to this\n"
+        "                         UDP port by a bridge running --send\n"
+        "  --keyframe-ms <ms>     how often --send resends whole reports so the\n"
+        "                         receiver recovers from lost datagrams (default 100);\n"
+        "                         --receive unplugs a pad silent for 5 of them\n"
+        "  --shared-state <name>  publish every pad's latest state in shared memory for\n"
+        "                         overlays (read it with n64-state <name>)\n"
+        "  --help                 show this message\n";
+}
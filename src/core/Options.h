@@ -0,0 +1,51 @@
+#pragma once
+
+#include "EventLoop.h"
+#include "ReportScheduler.h"
+#include "ThreadTuning.h"
+
+#include <cstdint>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Command line options
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct Options
+{
+    uint32_t pollIntervalMs { 500 };
+    uint32_t vigemClients   { 1 };   // virtual pads are spread round robin over this many bus connections
+    uint32_t reactorThreads { 0 };   // 0 = one thread per pad, otherwise event loop threads shared by all pads
+    uint32_t initThreads    { 4 };   // threads opening newly detected pads
+    bool     stats          { false }; // print per pad latency stats when a pad goes away and on exit
+    uint32_t statsInterval  { 0 };     // seconds between periodic stats dumps, 0 = off
+    bool     captureDelta   { false }; // delta encode the capture against each pad's previous state
+    uint32_t warmTargets    { 0 };     // virtual pads plugged in ahead of time
+    uint32_t reconnectGrace { 0 };     // ms a disconnected pad's virtual pad stays plugged in waiting for it
+    uint32_t inputBuffer    { 0 };     // events a pad queues between reads, 0 = snapshot reads
+    ReportScheduler::Mode outputMode { ReportScheduler::IMMEDIATE };
+    uint32_t outputHz       { 250 };   // COALESCE cap / FIXED_RATE rate
+    bool     submitThread   { false }; // update virtual pads from one thread, off the pads' read threads
+    EventLoop::WaitMode inputMode { EventLoop::EVENT };
+    uint32_t spinUs         { 200 };   // HYBRID: longest spin before blocking
+    ThreadSettings::Priority inputPriority { ThreadSettings::NORMAL };
+    int32_t  inputCpu       { -1 };    // first core pad threads are pinned to, -1 = unpinned
+    bool     help           { false };
+    std::string capturePath;           // append every raw device state to this file, empty = off
+    std::string profilePath;           // mapping profiles file, reloaded when it changes; empty = built in mapping
+    std::string profileName;           // profile to use from profilePath, empty = the first
+    std::string logPath;               // rotating log file, empty = console only
+    bool     logFileOnly    { false }; // keep log messages off the console
+    uint32_t metricsPort    { 0 };     // serve Prometheus metrics on 127.0.0.1:port, 0 = off
+    std::string sendTarget;            // host:port to forward pads to instead of local virtual pads, empty = off
+    uint32_t receivePort    { 0 };     // UDP port to take forwarded pads on, 0 = off
+    uint32_t keyframeMs     { 100 };   // --send keyframe interval
+    std::string sharedStateName;       // publish pad state in this shared memory region, empty = off
+
+    // Returns false and fills `error` on unknown flags or bad values
+    bool parse(int argc, char** argv, std::string& error);
+
+    static const char* usage();
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "XusbReport.h"
+
+#include <memory>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Output side of the bridge
+//
+//  A SinkBackend plugs in virtual X360 style pads (ViGEm on Windows, uinput
+//  on Linux, or the in-memory fake); a PadSink is one plugged in pad and
+//  unplugs it when destroyed.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class PadSink
+{
+public:
+    virtual ~PadSink() = default;
+
+    // Errors are reported by the sink
+    virtual void submit(const XusbReport& report) = 0;
+};
+
+class SinkBackend
+{
+public:
+    virtual ~SinkBackend() = default;
+
+    // nullptr when the virtual pad can't be plugged in
+    virtual std::unique_ptr<PadSink> plug() = 0;
+};
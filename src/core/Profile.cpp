@@ -0,0 +1,369 @@
+#include "Profile.h"
+#include "DeviceDescriptors.h"
+#include "Mapping.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+
+struct NamedValue
+{
+    const char* name;
+    uint32_t    value;
+};
+
+constexpr NamedValue kN64Buttons[] =
+{
+    { "A",       N64Button::A            },
+    { "B",       N64Button::B            },
+    { "Z",       N64Button::Z            },
+    { "ZR",      N64Button::ZR           },
+    { "L",       N64Button::LEFT_BUMPER  },
+    { "R",       N64Button::RIGHT_BUMPER },
+    { "START",   N64Button::START        },
+    { "HOME",    N64Button::HOME         },
+    { "CIRCLE",  N64Button::CIRCLE       },
+    { "C_UP",    N64Button::C_UP         },
+    { "C_DOWN",  N64Button::C_DOWN       },
+    { "C_LEFT",  N64Button::C_LEFT       },
+    { "C_RIGHT", N64Button::C_RIGHT      },
+};
+
+constexpr NamedValue kXusbButtons[] =
+{
+    { "A",          Xusb::A              },
+    { "B",          Xusb::B              },
+    { "X",          Xusb::X              },
+    { "Y",          Xusb::Y              },
+    { "LB",         Xusb::LEFT_SHOULDER  },
+    { "RB",         Xusb::RIGHT_SHOULDER },
+    { "LS",         Xusb::LEFT_THUMB     },
+    { "RS",         Xusb::RIGHT_THUMB    },
+    { "START",      Xusb::START          },
+    { "BACK",       Xusb::BACK           },
+    { "GUIDE",      Xusb::GUIDE          },
+    { "DPAD_UP",    Xusb::DPAD_UP        },
+    { "DPAD_DOWN",  Xusb::DPAD_DOWN      },
+    { "DPAD_LEFT",  Xusb::DPAD_LEFT      },
+    { "DPAD_RIGHT", Xusb::DPAD_RIGHT     },
+};
+
+template <size_t N>
+const NamedValue* find(const NamedValue (&table)[N], const std::string& name)
+{
+    for (const auto& entry : table)
+        if (name == entry.name)
+            return &entry;
+    return nullptr;
+}
+
+std::string trim(const std::string& text)
+{
+    const auto begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos)
+        return {};
+    const auto end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+bool parseInt(const std::string& text, int32_t& out)
+{
+    char* end = nullptr;
+    const long value = strtol(text.c_str(), &end, 10);
+    if (end == text.c_str() || *end != '\0' || value < -65536 || value > 131071)
+        return false;
+    out = static_cast<int32_t>(value);
+    return true;
+}
+
+bool parseRange(const std::string& text, int32_t& low, int32_t& high)
+{
+    std::istringstream words(text);
+    std::string first, second, extra;
+    if (!(words >> first >> second) || (words >> extra))
+        return false;
+    return parseInt(first, low) && parseInt(second, high) && low < high;
+}
+
+bool parseBool(const std::string& text, bool& out)
+{
+    if (text == "yes" || text == "true" || text == "1")
+        out = true;
+    else if (text == "no" || text == "false" || text == "0")
+        out = false;
+    else
+        return false;
+    return true;
+}
+
+// A button binding: any number of XUSB buttons and triggers, or "none"
+bool parseBinding(const std::string& text, uint32_t button, Profile& profile)
+{
+    const auto bit = static_cast<uint16_t>(1u << button);
+    uint16_t buttons = 0;
+    bool left  = false;
+    bool right = false;
+
+    std::istringstream words(text);
+    std::string word;
+    size_t count = 0;
+    while (words >> word)
+    {
+        count++;
+        if (word == "none")
+            continue;
+        if (word == "LT")
+            left = true;
+        else if (word == "RT")
+            right = true;
+        else if (const auto* target = find(kXusbButtons, word))
+            buttons |= static_cast<uint16_t>(target->value);
+        else
+            return false;
+    }
+    if (count == 0)
+        return false;
+
+    profile.buttons[button] = buttons;
+    profile.leftTrigger  = static_cast<uint16_t>(left  ? profile.leftTrigger  | bit : profile.leftTrigger  & ~bit);
+    profile.rightTrigger = static_cast<uint16_t>(right ? profile.rightTrigger | bit : profile.rightTrigger & ~bit);
+    return true;
+}
+
+// "A X": output buttons only
+bool parseButtons(const std::string& text, uint16_t& out)
+{
+    uint16_t buttons = 0;
+    std::istringstream words(text);
+    std::string word;
+    size_t count = 0;
+    while (words >> word)
+    {
+        count++;
+        if (word == "none")
+            continue;
+        const auto* target = find(kXusbButtons, word);
+        if (!target)
+            return false;
+        buttons |= static_cast<uint16_t>(target->value);
+    }
+    out = buttons;
+    return count > 0;
+}
+
+// "A 40, none 20, A+B+LT 60"
+bool parseMacro(const std::string& slotName, const std::string& text, Profile& profile)
+{
+    const auto* slot = find(kXusbButtons, slotName);
+    if (!slot)
+        return false;
+
+    Macro macro;
+    macro.slot = static_cast<uint16_t>(slot->value);
+
+    std::istringstream steps(text);
+    std::string step;
+    while (std::getline(steps, step, ','))
+    {
+        std::istringstream words(step);
+        std::string held, extra;
+        int32_t duration = 0;
+        std::string durationText;
+        if (!(words >> held >> durationText) || (words >> extra) || !parseInt(durationText, duration) ||
+            duration < 1 || duration > 10000 || macro.steps.size() == Macro::kMaxSteps)
+            return false;
+
+        MacroStep parsed{ 0, 0, static_cast<uint16_t>(duration) };
+        std::istringstream names(held);
+        std::string name;
+        while (std::getline(names, name, '+'))
+        {
+            if (name == "none")
+                continue;
+            if (name == "LT")
+                parsed.triggers |= 1;
+            else if (name == "RT")
+                parsed.triggers |= 2;
+            else if (const auto* target = find(kXusbButtons, name))
+                parsed.buttons |= static_cast<uint16_t>(target->value);
+            else
+                return false;
+        }
+        macro.steps.push_back(parsed);
+    }
+    if (macro.steps.empty())
+        return false;
+
+    // A later line for the same slot replaces the earlier one
+    for (auto& existing : profile.macros)
+    {
+        if (existing.slot == macro.slot)
+        {
+            existing = std::move(macro);
+            return true;
+        }
+    }
+    profile.macros.push_back(std::move(macro));
+    return true;
+}
+
+bool parseSetting(const std::string& key, const std::string& value, Profile& profile)
+{
+    if (const auto* button = find(kN64Buttons, key))
+        return parseBinding(value, button->value, profile);
+
+    if (key == "c-buttons")
+    {
+        if (value == "stick")
+            profile.cStick = true;
+        else if (value == "buttons")
+            profile.cStick = false;
+        else
+            return false;
+        return true;
+    }
+    if (key == "x-range")
+        return parseRange(value, profile.xAxis.min, profile.xAxis.max);
+    if (key == "y-range")
+        return parseRange(value, profile.yAxis.min, profile.yAxis.max);
+    if (key == "x-deadzone")
+        return parseRange(value, profile.xAxis.deadzoneStart, profile.xAxis.deadzoneEnd);
+    if (key == "y-deadzone")
+        return parseRange(value, profile.yAxis.deadzoneStart, profile.yAxis.deadzoneEnd);
+    if (key == "deadzone-shape")
+    {
+        DeadzoneShape shape;
+        if (value == "snap")
+            shape = DeadzoneShape::SNAP;
+        else if (value == "scaled")
+            shape = DeadzoneShape::SCALED;
+        else
+            return false;
+        profile.xAxis.deadzone = shape;
+        profile.yAxis.deadzone = shape;
+        return true;
+    }
+    if (key == "curve")
+    {
+        char* end = nullptr;
+        const float curve = strtof(value.c_str(), &end);
+        if (end == value.c_str() || *end != '\0' || !(curve >= 0.1f && curve <= 10.0f))
+            return false;
+        profile.xAxis.curve = curve;
+        profile.yAxis.curve = curve;
+        return true;
+    }
+    if (key == "turbo")
+        return parseButtons(value, profile.turbo);
+    if (key == "turbo-hz")
+    {
+        int32_t hz = 0;
+        if (!parseInt(value, hz) || hz < 1 || hz > 100)
+            return false;
+        profile.turboHz = static_cast<uint32_t>(hz);
+        return true;
+    }
+    static const char kMacro[] = "macro-";
+    if (key.compare(0, strlen(kMacro), kMacro) == 0)
+        return parseMacro(key.substr(strlen(kMacro)), value, profile);
+    if (key == "invert-x")
+        return parseBool(value, profile.xAxis.invert);
+    if (key == "invert-y")
+        return parseBool(value, profile.yAxis.invert);
+    return false;
+}
+
+}
+
+Profile Profile::defaults()
+{
+    return DeviceTypes::defaultProfile<N64Pad>();
+}
+
+bool Profile::parse(const std::string& text, std::vector<Profile>& profiles, std::string& error)
+{
+    profiles.clear();
+
+    std::istringstream lines(text);
+    std::string line;
+    uint32_t number = 0;
+    while (std::getline(lines, line))
+    {
+        number++;
+        const auto comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+        line = trim(line);
+        if (line.empty())
+            continue;
+
+        if (line.front() == '[')
+        {
+            static const char kSection[] = "[profile ";
+            if (line.back() != ']' || line.compare(0, strlen(kSection), kSection) != 0)
+            {
+                error = "line " + std::to_string(number) + ": expected [profile <name>]";
+                return false;
+            }
+            profiles.push_back(defaults());
+            profiles.back().name = trim(line.substr(strlen(kSection), line.size() - strlen(kSection) - 1));
+            if (profiles.back().name.empty())
+            {
+                error = "line " + std::to_string(number) + ": profile needs a name";
+                return false;
+            }
+            continue;
+        }
+
+        const auto equals = line.find('=');
+        if (equals == std::string::npos || profiles.empty())
+        {
+            error = "line " + std::to_string(number) + ": expected <key> = <value> inside a [profile] section";
+            return false;
+        }
+
+        const auto key   = trim(line.substr(0, equals));
+        const auto value = trim(line.substr(equals + 1));
+        if (!parseSetting(key, value, profiles.back()))
+        {
+            error = "line " + std::to_string(number) + ": invalid setting " + key;
+            return false;
+        }
+    }
+
+    for (const auto& profile : profiles)
+    {
+        for (const auto* axis : { &profile.xAxis, &profile.yAxis })
+        {
+            if (axis->deadzoneStart < axis->min || axis->deadzoneEnd > axis->max)
+            {
+                error = "profile " + profile.name + ": deadzone must lie inside the stick range";
+                return false;
+            }
+        }
+    }
+
+    if (profiles.empty())
+    {
+        error = "no [profile] sections";
+        return false;
+    }
+    return true;
+}
+
+bool Profile::load(const std::string& path, std::vector<Profile>& profiles, std::string& error)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        error = "can't open " + path;
+        return false;
+    }
+    std::ostringstream text;
+    text << file.rdbuf();
+    return parse(text.str(), profiles, error);
+}
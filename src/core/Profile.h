@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Mapping profiles
+//
+//  What a pad's report should look like: button remap, stick calibration,
+//  deadzone shape, response curve and whether the C-buttons drive the right
+//  stick. Profiles are plain data; MappingTables compiles one into the flat
+//  tables the hot path uses.
+//
+//  Profile files hold any number of sections:
+//
+//      # comments start with '#'
+//      [profile mario]
+//      A              = A
+//      Z              = LT            # several targets: "Z = LT RB"
+//      C_UP           = Y             # only reachable with c-buttons = buttons
+//      c-buttons      = stick         # stick | buttons
+//      x-range        = 9800 54300
+//      y-range        = 6700 51800
+//      x-deadzone     = 31700 32000   # raw values snapped to rest
+//      y-deadzone     = 29600 29900
+//      deadzone-shape = snap          # snap | scaled
+//      curve          = 1.0           # output = input ^ curve
+//      invert-y       = yes
+//      turbo          = A X           # output buttons that auto-fire while held
+//      turbo-hz       = 15
+//      macro-Y        = A 40, none 20, A+B 60
+//
+//  A macro takes over an output button (Y, LS and RS are free in the
+//  default mapping): pressing whatever maps to it plays the steps, each
+//  `<buttons or LT / RT joined by +> <ms>`, instead of sending the button.
+//
+//  Every section starts from defaults() and only lists what differs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+enum class DeadzoneShape : uint8_t
+{
+    SNAP,   // values inside the deadzone read as its center, the rest of the range is unchanged
+    SCALED, // the deadzone reads as zero and the range outside it is stretched to full deflection
+};
+
+struct AxisProfile
+{
+    int32_t       min;
+    int32_t       max;
+    int32_t       deadzoneStart;
+    int32_t       deadzoneEnd;
+    DeadzoneShape deadzone { DeadzoneShape::SNAP };
+    float         curve { 1.0f };
+    bool          invert { false };
+};
+
+// One step of a macro: what is held on top of live input, and how long
+struct MacroStep
+{
+    uint16_t buttons;    // wButtons
+    uint8_t  triggers;   // bit 0 pulls LT, bit 1 RT
+    uint16_t durationMs;
+};
+
+struct Macro
+{
+    static constexpr size_t kMaxSteps = 32;
+
+    uint16_t               slot;  // the wButtons bit that plays it
+    std::vector<MacroStep> steps;
+};
+
+struct Profile
+{
+    std::string name;
+
+    // wButtons bits each N64 button presses, indexed by N64Button
+    uint16_t buttons[16] {};
+
+    // N64 buttons (as a pressed mask) that pull each trigger fully
+    uint16_t leftTrigger { 0 };
+    uint16_t rightTrigger { 0 };
+
+    AxisProfile xAxis;
+    AxisProfile yAxis;
+
+    // C-buttons drive the right stick; otherwise they are plain buttons
+    bool cStick { true };
+
+    // wButtons that toggle at turboHz while held
+    uint16_t turbo { 0 };
+    uint32_t turboHz { 15 };
+
+    std::vector<Macro> macros;
+
+    // The built in mapping: the N64 pad's (DeviceDescriptors.h)
+    static Profile defaults();
+
+    // Parses every [profile <name>] section of `text`. Returns false and
+    // fills `error` on the first bad line.
+    static bool parse(const std::string& text, std::vector<Profile>& profiles, std::string& error);
+    static bool load(const std::string& path, std::vector<Profile>& profiles, std::string& error);
+};
@@ -0,0 +1,197 @@
+#include "ProfileStore.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Reader
+//
+///////////////////////////////////////////////////////////////////////////////
+
+ProfileStore::Reader::Reader(ProfileStore& store)
+    : store_(store)
+{
+    {
+        std::lock_guard<std::mutex> lock(store_.mutex_);
+        store_.hazards_.push_back(std::make_unique<std::atomic<const MappingTables*>>(nullptr));
+        hazard_ = store_.hazards_.back().get();
+    }
+    refresh();
+}
+
+ProfileStore::Reader::~Reader()
+{
+    std::lock_guard<std::mutex> lock(store_.mutex_);
+    auto& hazards = store_.hazards_;
+    hazards.erase(std::find_if(hazards.begin(), hazards.end(), [this](const auto& hazard) { return hazard.get() == hazard_; }));
+    store_.reclaim();
+}
+
+void ProfileStore::Reader::refresh()
+{
+    // Publish the hazard, then make sure the tables weren't retired in
+    // between; a publish() that already scanned would otherwise free them
+    const MappingTables* tables;
+    do
+    {
+        tables = store_.current_.load();
+        hazard_->store(tables);
+    } while (store_.current_.load() != tables);
+    cached_ = tables;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  ProfileStore
+//
+///////////////////////////////////////////////////////////////////////////////
+
+ProfileStore::~ProfileStore()
+{
+    if (watcher_.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        stopped_.notify_all();
+        watcher_.join();
+    }
+
+    // Readers are gone by now
+    for (const auto* tables : retired_)
+        delete tables;
+    delete current_.load();
+}
+
+std::unique_ptr<ProfileStore> ProfileStore::create(const std::string& path, const std::string& name)
+{
+    std::unique_ptr<ProfileStore> store(new ProfileStore());
+    if (!store->init(path, name))
+        return nullptr;
+    return store;
+}
+
+std::unique_ptr<ProfileStore> ProfileStore::create(std::unique_ptr<const MappingTables> tables)
+{
+    std::unique_ptr<ProfileStore> store(new ProfileStore());
+    store->publish(std::move(tables));
+    return store;
+}
+
+bool ProfileStore::init(const std::string& path, const std::string& name)
+{
+    path_ = path;
+    name_ = name;
+    return reload();
+}
+
+bool ProfileStore::reload()
+{
+    std::vector<Profile> profiles;
+    std::string error;
+    if (!Profile::load(path_, profiles, error))
+    {
+        Log::error("Failed to load profiles: %s", error.c_str());
+        return false;
+    }
+
+    auto it = name_.empty() ? profiles.begin() :
+        std::find_if(profiles.begin(), profiles.end(), [this](const Profile& profile) { return profile.name == name_; });
+    if (it == profiles.end())
+    {
+        Log::error("No profile named %s in %s", name_.c_str(), path_.c_str());
+        return false;
+    }
+
+    // Compiled here so pads never wait on it
+    publish(std::make_unique<MappingTables>(*it));
+    Log::info("Using profile %s", it->name.c_str());
+    return true;
+}
+
+void ProfileStore::publish(std::unique_ptr<const MappingTables> tables)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto* previous = current_.exchange(tables.release());
+    generation_++;
+    if (previous)
+        retired_.push_back(previous);
+    reclaim();
+}
+
+void ProfileStore::reclaim()
+{
+    auto held = [this](const MappingTables* tables)
+    {
+        for (const auto& hazard : hazards_)
+            if (hazard->load() == tables)
+                return true;
+        return false;
+    };
+
+    auto it = retired_.begin();
+    while (it != retired_.end())
+    {
+        if (held(*it))
+        {
+            ++it;
+            continue;
+        }
+        delete *it;
+        it = retired_.erase(it);
+    }
+}
+
+void ProfileStore::watch(uint32_t intervalMs)
+{
+    namespace fs = std::filesystem;
+
+    if (watcher_.joinable() || path_.empty())
+        return;
+
+    watcher_ = std::thread([this, intervalMs]
+    {
+        Log::attachThread();
+
+        // Size as well as time, for file systems with coarse timestamps
+        auto stamp = [this]
+        {
+            std::error_code error;
+            const auto time = fs::last_write_time(path_, error);
+            const auto size = fs::file_size(path_, error);
+            return std::make_pair(time, size);
+        };
+
+        auto last = stamp();
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopped_.wait_for(lock, std::chrono::milliseconds(intervalMs), [this]{ return stop_; }))
+        {
+            // Readers that moved on since the last publish can let go now
+            reclaim();
+
+            lock.unlock();
+            const auto now = stamp();
+            if (now != last)
+            {
+                last = now;
+                reload();
+            }
+            lock.lock();
+        }
+    });
+}
+
+uint64_t ProfileStore::generation() const
+{
+    return generation_.load();
+}
+
+size_t ProfileStore::retired() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return retired_.size();
+}
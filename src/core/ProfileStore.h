@@ -0,0 +1,103 @@
+#pragma once
+
+#include "MappingTables.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The compiled profile every pad converts with, swapped while pads run
+//
+//  publish() replaces the tables with one pointer exchange. Each pad reads
+//  through a Reader that keeps the tables it last saw; per report that costs
+//  one relaxed load and compare, no lock and no reference count. A Reader
+//  that sees a new pointer publishes it as its hazard pointer before using
+//  it, and retired tables are freed only once no Reader's hazard points at
+//  them, so a pad never converts with freed tables.
+//
+//  With a file, watch() polls its modification time and recompiles the named
+//  profile on every change; a file that fails to parse leaves the running
+//  tables in place.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class ProfileStore
+{
+public:
+    ~ProfileStore();
+
+    // Compiles the profile named `name` (the file's first one when empty)
+    static std::unique_ptr<ProfileStore> create(const std::string& path, const std::string& name);
+
+    // A store that starts from already compiled tables and has no file
+    static std::unique_ptr<ProfileStore> create(std::unique_ptr<const MappingTables> tables);
+
+    void publish(std::unique_ptr<const MappingTables> tables);
+
+    // Re-reads the file and publishes the profile on success
+    bool reload();
+
+    // Starts a thread that reloads whenever the file changes
+    void watch(uint32_t intervalMs);
+
+    // Tables published so far, including the first
+    uint64_t generation() const;
+
+    // Retired tables still waiting for a Reader to move on
+    size_t retired() const;
+
+    // One per pad; only ever used from one thread at a time
+    class Reader
+    {
+    public:
+        explicit Reader(ProfileStore& store);
+        ~Reader();
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        const MappingTables& tables()
+        {
+            if (store_.current_.load(std::memory_order_relaxed) != cached_)
+                refresh();
+            return *cached_;
+        }
+
+    private:
+        void refresh();
+
+    private:
+        ProfileStore&                      store_;
+        std::atomic<const MappingTables*>* hazard_;
+        const MappingTables*               cached_ { nullptr };
+    };
+
+private:
+    ProfileStore() = default;
+
+    bool init(const std::string& path, const std::string& name);
+
+    // Frees every retired table no hazard points at. Call with mutex_ held.
+    void reclaim();
+
+private:
+    std::atomic<const MappingTables*> current_ { nullptr };
+    std::atomic<uint64_t>             generation_ { 0 };
+
+    mutable std::mutex                                              mutex_;
+    std::vector<std::unique_ptr<std::atomic<const MappingTables*>>> hazards_;
+    std::vector<const MappingTables*>                               retired_;
+
+    std::string path_;
+    std::string name_;
+
+    std::thread             watcher_;
+    std::condition_variable stopped_;
+    bool                    stop_ { false };
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "LatestValue.h"
+#include "XusbReport.h"
+
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Latest-value mailbox
+//
+//  Hands a pad's converted reports from the thread that reads the device to
+//  the thread that submits them, without either ever waiting on the other
+//  (a LatestValue, so post() and take() are wait-free). A report not taken
+//  before the next post() is replaced; sequence numbers let the consumer
+//  count how many it never saw.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class ReportMailbox
+{
+public:
+    struct Entry
+    {
+        XusbReport report;
+        uint64_t   sequence;  // 1 for the first post(), +1 per post()
+        int64_t    readNs;    // Clock::nowNs() when the state it came from was read
+    };
+
+public:
+    // Producer only
+    void post(const XusbReport& report, int64_t readNs)
+    {
+        latest_.post({ report, ++sequence_, readNs });
+    }
+
+    // Consumer only: the newest report posted since the last take(); false
+    // if there is none
+    bool take(Entry& out)
+    {
+        return latest_.take(out);
+    }
+
+private:
+    LatestValue<Entry> latest_;
+    uint64_t           sequence_ { 0 };  // producer side
+};
@@ -0,0 +1,38 @@
+#include "ReportPipeline.h"
+
+#include <cstring>
+
+ReportPipeline::ReportPipeline(const MappingTables& tables)
+    : tables_(&tables)
+    , convert_(DeviceTypes::n64().convert)
+{   }
+
+bool ReportPipeline::process(N64ControllerState state, XusbReport& report)
+{
+    convert_(tables(), state, report);
+
+    if (hasLast_ && memcmp(&report, &lastReport_, sizeof(XusbReport)) == 0)
+        return false;
+
+    lastReport_ = report;
+    hasLast_    = true;
+    return true;
+}
+
+void ReportPipeline::reset()
+{
+    hasLast_ = false;
+}
+
+void ReportPipeline::setType(const DeviceType& type)
+{
+    tables_   = &type.defaultTables();
+    convert_  = type.convert;
+    profiles_ = type.profiles;
+    hasLast_  = false;
+}
+
+void ReportPipeline::attach(ProfileStore* store)
+{
+    reader_.reset(store ? new ProfileStore::Reader(*store) : nullptr);
+}
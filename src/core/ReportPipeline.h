@@ -0,0 +1,52 @@
+#pragma once
+
+#include "DeviceDescriptors.h"
+#include "MappingTables.h"
+#include "ProfileStore.h"
+
+#include <memory>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Raw state -> report step shared by the live controllers and the replay
+//  tool: conversion (deadzones included) and dedupe against the last report.
+//
+//  Dedupe compares the converted 12 byte report rather than the raw state,
+//  so the unused data[] bytes and axis noise that doesn't survive conversion
+//  never cost an update.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class ReportPipeline
+{
+public:
+    explicit ReportPipeline(const MappingTables& tables = MappingTables::defaults());
+
+    // Returns false when the report is unchanged and nothing should be sent
+    bool process(N64ControllerState state, XusbReport& report);
+
+    // What the next process() converts with
+    const MappingTables& tables()
+    {
+        return reader_ && profiles_ ? reader_->tables() : *tables_;
+    }
+
+    void reset();
+
+    // Converts as `type`: with its routine, and its default mapping instead
+    // of the tables given at construction. An attached store only applies
+    // to types that take profiles.
+    void setType(const DeviceType& type);
+
+    // Converts with whatever `store` currently holds instead of the tables
+    // given at construction; nullptr goes back to them
+    void attach(ProfileStore* store);
+
+private:
+    const MappingTables*                  tables_;
+    DeviceType::Convert                   convert_;
+    bool                                  profiles_ { true };
+    std::unique_ptr<ProfileStore::Reader> reader_;
+    XusbReport           lastReport_ {};
+    bool                 hasLast_ { false };
+};
@@ -0,0 +1,89 @@
+#include "ReportScheduler.h"
+
+#include <cstring>
+
+bool ReportScheduler::equal(const XusbReport& a, const XusbReport& b)
+{
+    return memcmp(&a, &b, sizeof(XusbReport)) == 0;
+}
+
+void ReportScheduler::configure(Mode mode, uint32_t hz)
+{
+    mode_       = hz == 0 ? IMMEDIATE : mode;
+    intervalNs_ = hz == 0 ? 0 : 1000000000ll / hz;
+}
+
+void ReportScheduler::reset(int64_t nowNs)
+{
+    hasLast_    = false;
+    hasHeld_    = false;
+    lastSentNs_ = nowNs - intervalNs_;
+    nextTickNs_ = nowNs + intervalNs_;
+}
+
+ReportScheduler::Result ReportScheduler::offer(const XusbReport& report, int64_t nowNs)
+{
+    const bool unchanged = hasLast_ && equal(report, last_);
+
+    if (mode_ == IMMEDIATE)
+        return unchanged ? DUPLICATE : SEND;
+
+    if (mode_ == COALESCE && !hasHeld_)
+    {
+        if (unchanged)
+            return DUPLICATE;
+        if (nowNs - lastSentNs_ >= intervalNs_)
+            return SEND;
+    }
+
+    // Held until the window closes / the next tick. Returning to what the
+    // pad already shows cancels a held change outright.
+    const bool replaced = hasHeld_;
+    hasHeld_ = !unchanged;
+    held_    = report;
+    if (replaced)
+        return SUPERSEDED;
+    return hasHeld_ ? HELD : DUPLICATE;
+}
+
+int64_t ReportScheduler::deadlineNs() const
+{
+    switch (mode_)
+    {
+    case COALESCE:   return hasHeld_ ? lastSentNs_ + intervalNs_ : -1;
+    case FIXED_RATE: return nextTickNs_;
+    default:         return -1;
+    }
+}
+
+ReportScheduler::Result ReportScheduler::expire(int64_t nowNs, XusbReport& out)
+{
+    const int64_t deadline = deadlineNs();
+    if (deadline < 0 || nowNs < deadline)
+        return NONE;
+
+    if (mode_ == FIXED_RATE)
+    {
+        // Skip ticks missed while the thread was held up rather than bursting
+        nextTickNs_ += intervalNs_;
+        if (nextTickNs_ <= nowNs)
+            nextTickNs_ = nowNs + intervalNs_;
+
+        if (!hasLast_ && !hasHeld_)
+            return NONE;
+        out = hasHeld_ ? held_ : last_;
+        hasHeld_ = false;
+        return hasLast_ && equal(out, last_) ? RESEND : SEND;
+    }
+
+    hasHeld_ = false;
+    out      = held_;
+    return SEND;
+}
+
+void ReportScheduler::sent(const XusbReport& report, int64_t nowNs)
+{
+    last_       = report;
+    hasLast_    = true;
+    lastSentNs_ = nowNs;
+}
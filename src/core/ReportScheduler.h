@@ -0,0 +1,82 @@
+#pragma once
+
+#include "XusbReport.h"
+
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Per pad output scheduler
+//
+//  Decides when a converted report becomes a virtual pad update (a kernel
+//  IOCTL on Windows, a write on Linux):
+//
+//    IMMEDIATE   every report that differs from the last one sent goes out
+//                right away. Lowest latency.
+//    COALESCE    at most one update per 1/hz. A change inside the window is
+//                held and only the latest held report goes out when the
+//                window closes. Bursts of input cost one update per window,
+//                for at most 1/hz of extra latency.
+//    FIXED_RATE  exactly one update per 1/hz tick, the latest report,
+//                resent even when unchanged. Constant update volume and a
+//                steadily refreshed virtual pad, for up to 1/hz of latency.
+//
+//  Not thread safe; the thread servicing the pad drives it, from the
+//  report path (offer) and from a timer armed for deadlineNs() (expire).
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class ReportScheduler
+{
+public:
+    enum Mode : uint32_t
+    {
+        IMMEDIATE,
+        COALESCE,
+        FIXED_RATE,
+    };
+
+    enum Result : uint32_t
+    {
+        NONE,       // nothing to do
+        SEND,       // submit the report now
+        DUPLICATE,  // identical to what the pad already shows, dropped
+        HELD,       // kept until the deadline
+        SUPERSEDED, // a held report was replaced or cancelled before it went out
+        RESEND,     // fixed rate tick without a change: submit the unchanged report
+    };
+
+public:
+    // hz is ignored for IMMEDIATE
+    void configure(Mode mode, uint32_t hz);
+
+    // Forgets everything sent; FIXED_RATE ticks start at nowNs
+    void reset(int64_t nowNs);
+
+    Mode mode() const { return mode_; }
+
+    // A new converted report. SEND leaves report as is to be submitted.
+    Result offer(const XusbReport& report, int64_t nowNs);
+
+    // When the timer should next fire, -1 when nothing is pending
+    int64_t deadlineNs() const;
+
+    // Timer fired; on SEND / RESEND out is the report to submit
+    Result expire(int64_t nowNs, XusbReport& out);
+
+    // Record that report went out at nowNs
+    void sent(const XusbReport& report, int64_t nowNs);
+
+private:
+    static bool equal(const XusbReport& a, const XusbReport& b);
+
+private:
+    Mode       mode_ { IMMEDIATE };
+    int64_t    intervalNs_ { 0 };
+    XusbReport last_ {};            // what the virtual pad shows
+    bool       hasLast_ { false };
+    XusbReport held_ {};
+    bool       hasHeld_ { false };
+    int64_t    lastSentNs_ { 0 };
+    int64_t    nextTickNs_ { 0 };   // FIXED_RATE
+};
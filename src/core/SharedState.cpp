@@ -0,0 +1,160 @@
+#include "SharedState.h"
+#include "Clock.h"
+#include "Log.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace SharedStateLayout;
+
+#if defined(_WIN32)
+
+SharedState::~SharedState()
+{
+    if (region_)
+        UnmapViewOfFile(region_);
+    if (mapping_)
+        CloseHandle(mapping_);
+}
+
+bool SharedState::init(const std::string& name)
+{
+    name_ = name;
+    const auto path = "Local\\" + name;
+    mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(Region), path.c_str());
+    if (mapping_ == nullptr)
+    {
+        Log::error("Failed to create shared memory %s: error %lu", path.c_str(), GetLastError());
+        return false;
+    }
+
+    region_ = static_cast<Region*>(MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(Region)));
+    if (region_ == nullptr)
+    {
+        Log::error("Failed to map shared memory %s: error %lu", path.c_str(), GetLastError());
+        return false;
+    }
+    return true;
+}
+
+#else
+
+SharedState::~SharedState()
+{
+    if (region_)
+    {
+        munmap(region_, sizeof(Region));
+        shm_unlink(("/" + name_).c_str());
+    }
+}
+
+bool SharedState::init(const std::string& name)
+{
+    name_ = name;
+    const auto path = "/" + name;
+
+    // A region left behind by a bridge that crashed is taken over
+    const int fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        Log::error("Failed to create shared memory %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+    if (ftruncate(fd, sizeof(Region)) != 0)
+    {
+        Log::error("Failed to size shared memory %s: %s", path.c_str(), strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, sizeof(Region), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        Log::error("Failed to map shared memory %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+    region_ = static_cast<Region*>(data);
+    return true;
+}
+
+#endif
+
+std::unique_ptr<SharedState> SharedState::create(const std::string& name)
+{
+    std::unique_ptr<SharedState> state(new SharedState());
+    if (!state->init(name))
+        return nullptr;
+
+    // Readers check the magic last, so they never see a half set up header
+    auto& region = *state->region_;
+    region.magic.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (auto& slot : region.slots)
+    {
+        const auto sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + (sequence & 1), std::memory_order_relaxed);
+        slot.flags   = 0;
+        slot.updates = 0;
+    }
+    region.version   = kVersion;
+    region.slotCount = kMaxPads;
+    region.slotSize  = sizeof(Slot);
+    region.startedNs = Clock::nowNs();
+    region.magic.store(kMagic, std::memory_order_release);
+    return state;
+}
+
+template <typename Update>
+void SharedState::write(uint32_t slot, Update&& update)
+{
+    if (slot >= kMaxPads)
+        return;
+
+    auto& target = region_->slots[slot];
+    const auto sequence = target.sequence.load(std::memory_order_relaxed);
+    target.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    update(target);
+    target.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void SharedState::connect(uint32_t slot, const DeviceGuid& id)
+{
+    write(slot, [&](Slot& target)
+    {
+        static_assert(sizeof(DeviceGuid) == sizeof(target.guid), "DeviceGuid is 16 bytes");
+        memcpy(target.guid, &id, sizeof(target.guid));
+        memset(&target.raw, 0, sizeof(target.raw));
+        memset(&target.report, 0, sizeof(target.report));
+        target.flags   = CONNECTED;
+        target.updates = 0;
+        target.timeNs  = Clock::nowNs();
+    });
+}
+
+void SharedState::disconnect(uint32_t slot)
+{
+    write(slot, [](Slot& target) { target.flags = 0; });
+}
+
+void SharedState::publish(uint32_t slot, const N64ControllerState& raw, const XusbReport& report, int64_t nowNs)
+{
+    write(slot, [&](Slot& target)
+    {
+        target.raw    = raw;
+        target.report = report;
+        target.timeNs = nowNs;
+        target.updates++;
+    });
+}
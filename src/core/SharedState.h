@@ -0,0 +1,59 @@
+#pragma once
+
+#include "DeviceGuid.h"
+#include "SharedStateLayout.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Shared state publisher
+//
+//  Publishes every pad's latest raw state and converted report into a named
+//  shared memory region (see SharedStateLayout.h), so overlays and input
+//  displays in other processes can read the pads directly instead of going
+//  through XInput. Readers use SharedStateReader.
+//
+//  publish() is a handful of stores into memory mapped at create(): it never
+//  blocks, allocates or makes a system call, and readers never slow it down.
+//  Each slot has one writer at a time: connect() and disconnect() while the
+//  pad isn't being serviced, publish() from the pad's thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class SharedState
+{
+public:
+    ~SharedState();
+
+    SharedState(const SharedState&) = delete;
+    SharedState& operator=(const SharedState&) = delete;
+
+    // nullptr if the region can't be created. On Linux the name is a POSIX
+    // shared memory object (/dev/shm/<name>), on Windows a Local\ mapping.
+    static std::unique_ptr<SharedState> create(const std::string& name);
+
+    void connect(uint32_t slot, const DeviceGuid& id);
+    void disconnect(uint32_t slot);
+
+    void publish(uint32_t slot, const N64ControllerState& raw, const XusbReport& report, int64_t nowNs);
+
+    const std::string& name() const { return name_; }
+
+private:
+    SharedState() = default;
+    bool init(const std::string& name);
+
+    // Seqlock write of one slot
+    template <typename Update>
+    void write(uint32_t slot, Update&& update);
+
+private:
+    std::string                name_;
+    SharedStateLayout::Region* region_ { nullptr };
+#if defined(_WIN32)
+    void*                      mapping_ { nullptr };
+#endif
+};
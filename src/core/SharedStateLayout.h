@@ -0,0 +1,62 @@
+#pragma once
+
+#include "N64ControllerState.h"
+#include "XusbReport.h"
+
+#include <atomic>
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Shared state layout
+//
+//  What SharedState publishes and SharedStateReader maps: a header and one
+//  cache line aligned slot per player. Every field is fixed size, so a
+//  reader built by another compiler (or another version of this one) agrees
+//  on the layout as long as the header's version matches.
+//
+//  Each slot is a seqlock. Its one writer bumps the sequence to odd, writes
+//  the fields and bumps it to even again; a reader copies the fields between
+//  two loads of an even, unchanged sequence and retries otherwise.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace SharedStateLayout
+{
+
+static constexpr uint32_t kMagic    = 0x5336344e; // "N64S"
+static constexpr uint32_t kVersion  = 1;
+static constexpr uint32_t kMaxPads  = 16;
+
+enum SlotFlags : uint32_t
+{
+    CONNECTED = 0x1,
+};
+
+struct alignas(64) Slot
+{
+    std::atomic<uint32_t> sequence;   // odd while the writer is mid update
+    uint32_t              flags;      // SlotFlags
+    uint64_t              updates;    // states published since the pad connected
+    int64_t               timeNs;     // Clock::nowNs() of the last update (CLOCK_MONOTONIC / QPC)
+    uint8_t               guid[16];   // DeviceGuid of the pad, as laid out in memory
+    N64ControllerState    raw;        // last state read from the device
+    XusbReport            report;     // raw converted for the virtual pad, turbo and macros merged
+};
+
+struct Region
+{
+    std::atomic<uint32_t> magic;  // kMagic once the rest of the header is valid
+    uint32_t              version;
+    uint32_t              slotCount;
+    uint32_t              slotSize;
+    int64_t               startedNs; // Clock::nowNs() when the bridge created the region
+    uint8_t               reserved[40];
+    Slot                  slots[kMaxPads];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "the seqlock sequence must be lock free to be shared between processes");
+static_assert(sizeof(Slot) == 128, "shared state slots are two cache lines");
+static_assert(sizeof(Region) == 64 + kMaxPads * sizeof(Slot), "shared state header is one cache line");
+
+}
@@ -0,0 +1,126 @@
+#include "SharedStateReader.h"
+
+#include <cstring>
+#include <thread>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace SharedStateLayout;
+
+#if defined(_WIN32)
+
+SharedStateReader::~SharedStateReader()
+{
+    if (region_)
+        UnmapViewOfFile(region_);
+    if (mapping_)
+        CloseHandle(mapping_);
+}
+
+bool SharedStateReader::init(const std::string& name)
+{
+    const auto path = "Local\\" + name;
+    mapping_ = OpenFileMappingA(FILE_MAP_READ, false, path.c_str());
+    if (mapping_ == nullptr)
+        return false;
+
+    region_ = static_cast<const Region*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, sizeof(Region)));
+    return region_ != nullptr;
+}
+
+#else
+
+SharedStateReader::~SharedStateReader()
+{
+    if (region_)
+        munmap(const_cast<Region*>(region_), sizeof(Region));
+}
+
+bool SharedStateReader::init(const std::string& name)
+{
+    const int fd = shm_open(("/" + name).c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Region))
+    {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, sizeof(Region), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+    region_ = static_cast<const Region*>(data);
+    return true;
+}
+
+#endif
+
+std::unique_ptr<SharedStateReader> SharedStateReader::open(const std::string& name)
+{
+    std::unique_ptr<SharedStateReader> reader(new SharedStateReader());
+    if (!reader->init(name))
+        return nullptr;
+
+    const auto& region = *reader->region_;
+    if (region.magic.load(std::memory_order_acquire) != kMagic || region.version != kVersion ||
+        region.slotSize != sizeof(Slot) || region.slotCount > kMaxPads)
+        return nullptr;
+    return reader;
+}
+
+uint32_t SharedStateReader::slotCount() const
+{
+    return region_->slotCount;
+}
+
+uint32_t SharedStateReader::sequence(uint32_t slot) const
+{
+    return slot < kMaxPads ? region_->slots[slot].sequence.load(std::memory_order_acquire) : 0;
+}
+
+bool SharedStateReader::read(uint32_t slot, Pad& out) const
+{
+    if (slot >= region_->slotCount)
+        return false;
+
+    const auto& source = region_->slots[slot];
+    for (uint32_t attempt = 0;; attempt++)
+    {
+        const auto before = source.sequence.load(std::memory_order_acquire);
+        if ((before & 1) == 0)
+        {
+            const uint32_t flags = source.flags;
+            out.updates = source.updates;
+            out.timeNs  = source.timeNs;
+            memcpy(out.guid, source.guid, sizeof(out.guid));
+            memcpy(&out.raw, &source.raw, sizeof(out.raw));
+            memcpy(&out.report, &source.report, sizeof(out.report));
+
+            // The copy is only good if no update started meanwhile
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (source.sequence.load(std::memory_order_relaxed) == before)
+                return (flags & CONNECTED) != 0;
+        }
+
+        retries_.fetch_add(1, std::memory_order_relaxed);
+        // An update is a few dozen stores; a writer that stays odd this long
+        // was preempted mid update, so let it run. One that never finishes
+        // died mid update.
+        if (attempt >= 64)
+            std::this_thread::yield();
+        if (attempt >= 100000)
+            return false;
+    }
+}
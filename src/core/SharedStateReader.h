@@ -0,0 +1,74 @@
+#pragma once
+
+#include "SharedStateLayout.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Shared state reader
+//
+//  Maps a region published by SharedState read only and reads pads out of
+//  it lock free. Any number of readers, in any number of processes, can
+//  read at once; a read never blocks the bridge, it only retries when it
+//  raced an update.
+//
+//  This and SharedStateLayout.h are all an overlay needs: link the
+//  n64-state-reader library, not the rest of the core.
+//
+//      auto reader = SharedStateReader::open("n64-controller");
+//      SharedStateReader::Pad pad;
+//      if (reader && reader->read(0, pad))
+//          drawButtons(pad.report.wButtons);
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class SharedStateReader
+{
+public:
+    struct Pad
+    {
+        uint64_t           updates;  // states published since the pad connected
+        int64_t            timeNs;   // steady clock of the last update
+        uint8_t            guid[16];
+        N64ControllerState raw;
+        XusbReport         report;
+    };
+
+public:
+    ~SharedStateReader();
+
+    SharedStateReader(const SharedStateReader&) = delete;
+    SharedStateReader& operator=(const SharedStateReader&) = delete;
+
+    // nullptr if no bridge publishes under that name, or it publishes an
+    // incompatible layout
+    static std::unique_ptr<SharedStateReader> open(const std::string& name);
+
+    uint32_t slotCount() const;
+
+    // Consistent copy of a slot; false while no pad is connected to it
+    bool read(uint32_t slot, Pad& out) const;
+
+    // Cheap change check: the slot's sequence moves on every update, so a
+    // reader polling faster than the pad can skip reads that would return
+    // the same state
+    uint32_t sequence(uint32_t slot) const;
+
+    // Reads that raced an update and had to go again
+    uint64_t retries() const { return retries_.load(std::memory_order_relaxed); }
+
+private:
+    SharedStateReader() = default;
+    bool init(const std::string& name);
+
+private:
+    const SharedStateLayout::Region* region_ { nullptr };
+    mutable std::atomic<uint64_t>    retries_ { 0 };
+#if defined(_WIN32)
+    void*                            mapping_ { nullptr };
+#endif
+};
@@ -0,0 +1,219 @@
+#pragma once
+
+#include "DeviceGuid.h"
+
+#include <cstddef>
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Slot registry
+//
+//  Fixed capacity map from device GUID to a pre-allocated T. Every value
+//  lives in a slot for the registry's whole lifetime, so adds and removes
+//  only claim and release slots. Nothing allocates after construction.
+//
+//  Handles carry the slot's generation, which changes whenever the slot is
+//  released, so a handle kept across a disconnect can't reach the next pad.
+//
+//  The slot index doubles as the player number. A reconnecting GUID gets
+//  its previous slot back unless another pad has used it since; new GUIDs
+//  take never used slots first, then the one released longest ago, which
+//  keeps recently departed pads' slots free for as long as possible.
+//
+//  Not thread safe; callers serialize access.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct SlotHandle
+{
+    uint16_t index { 0 };
+    uint16_t generation { 0 };  // 0 = invalid
+
+    bool valid() const { return generation != 0; }
+};
+
+template <typename T, size_t Capacity>
+class SlotRegistry
+{
+    static_assert(Capacity > 0 && Capacity < 0x8000, "slot index must fit the handle");
+
+public:
+    static constexpr size_t capacity() { return Capacity; }
+
+    SlotRegistry()
+    {
+        for (auto& entry : index_)
+            entry = kEmpty;
+    }
+
+    // Invalid handle when the registry is full or id is already present
+    SlotHandle add(const DeviceGuid& id)
+    {
+        if (size_ == Capacity || lookup(id) != kEmpty)
+            return {};
+
+        size_t chosen = Capacity;
+        for (size_t i = 0; i < Capacity; i++)
+        {
+            const auto& slot = slots_[i];
+            if (slot.used)
+                continue;
+            if (slot.hasOwner && slot.lastOwner == id)
+            {
+                chosen = i;
+                break;
+            }
+            if (chosen == Capacity || rank(slot) < rank(slots_[chosen]))
+                chosen = i;
+        }
+
+        auto& slot = slots_[chosen];
+        slot.used      = true;
+        slot.hasOwner  = true;
+        slot.lastOwner = id;
+        insert(id, static_cast<uint16_t>(chosen));
+        size_++;
+        return { static_cast<uint16_t>(chosen), slot.generation };
+    }
+
+    // False for stale handles
+    bool remove(SlotHandle handle)
+    {
+        if (!get(handle))
+            return false;
+
+        auto& slot = slots_[handle.index];
+        erase(slot.lastOwner);
+        slot.used       = false;
+        slot.releasedAt = ++releases_;
+        if (++slot.generation == 0)
+            slot.generation = 1;
+        size_--;
+        return true;
+    }
+
+    bool remove(const DeviceGuid& id)
+    {
+        return remove(find(id));
+    }
+
+    SlotHandle find(const DeviceGuid& id) const
+    {
+        const uint16_t index = lookup(id);
+        if (index == kEmpty)
+            return {};
+        return { index, slots_[index].generation };
+    }
+
+    // nullptr for stale or invalid handles
+    T* get(SlotHandle handle)
+    {
+        if (!handle.valid() || handle.index >= Capacity)
+            return nullptr;
+        auto& slot = slots_[handle.index];
+        return slot.used && slot.generation == handle.generation ? &slot.value : nullptr;
+    }
+
+    const DeviceGuid* guid(SlotHandle handle) const
+    {
+        if (!handle.valid() || handle.index >= Capacity)
+            return nullptr;
+        const auto& slot = slots_[handle.index];
+        return slot.used && slot.generation == handle.generation ? &slot.lastOwner : nullptr;
+    }
+
+    // fn(handle, guid, value) for every occupied slot, in player order
+    template <typename Fn>
+    void forEach(Fn&& fn)
+    {
+        for (size_t i = 0; i < Capacity; i++)
+        {
+            auto& slot = slots_[i];
+            if (slot.used)
+                fn(SlotHandle{ static_cast<uint16_t>(i), slot.generation }, slot.lastOwner, slot.value);
+        }
+    }
+
+    size_t size() const { return size_; }
+
+private:
+    // GUID -> slot lookup: open addressing with linear probing at <= 50% load
+    static constexpr size_t tableSize()
+    {
+        size_t size = 1;
+        while (size < Capacity * 2)
+            size <<= 1;
+        return size;
+    }
+
+    static constexpr size_t   kTableSize = tableSize();
+    static constexpr size_t   kTableMask = kTableSize - 1;
+    static constexpr uint16_t kEmpty     = 0xFFFF;
+
+    struct Slot
+    {
+        T          value {};
+        DeviceGuid lastOwner {};     // current owner while used
+        uint64_t   releasedAt { 0 };
+        uint16_t   generation { 1 };
+        bool       used { false };
+        bool       hasOwner { false };
+    };
+
+    // Lower is preferred: never used slots, then least recently released
+    static uint64_t rank(const Slot& slot)
+    {
+        return slot.hasOwner ? slot.releasedAt : 0;
+    }
+
+    static size_t home(const DeviceGuid& id)
+    {
+        return DeviceGuidHash()(id) & kTableMask;
+    }
+
+    uint16_t lookup(const DeviceGuid& id) const
+    {
+        for (size_t i = home(id);; i = (i + 1) & kTableMask)
+        {
+            const uint16_t index = index_[i];
+            if (index == kEmpty || slots_[index].lastOwner == id)
+                return index;
+        }
+    }
+
+    void insert(const DeviceGuid& id, uint16_t index)
+    {
+        size_t i = home(id);
+        while (index_[i] != kEmpty)
+            i = (i + 1) & kTableMask;
+        index_[i] = index;
+    }
+
+    // Backward shift deletion, so probes never need tombstones
+    void erase(const DeviceGuid& id)
+    {
+        size_t hole = home(id);
+        while (slots_[index_[hole]].lastOwner != id)
+            hole = (hole + 1) & kTableMask;
+
+        for (size_t i = (hole + 1) & kTableMask; index_[i] != kEmpty; i = (i + 1) & kTableMask)
+        {
+            const size_t wanted = home(slots_[index_[i]].lastOwner);
+            // Move entry i into the hole unless its home lies cyclically in (hole, i]
+            const bool between = hole <= i ? (wanted > hole && wanted <= i) : (wanted > hole || wanted <= i);
+            if (!between)
+            {
+                index_[hole] = index_[i];
+                hole = i;
+            }
+        }
+        index_[hole] = kEmpty;
+    }
+
+private:
+    Slot     slots_[Capacity];
+    uint16_t index_[kTableSize];
+    size_t   size_ { 0 };
+    uint64_t releases_ { 0 };
+};
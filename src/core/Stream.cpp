@@ -0,0 +1,465 @@
+#include "Stream.h"
+#include "Clock.h"
+#include "Log.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <type_traits>
+
+namespace
+{
+
+#if defined(_WIN32)
+using Socket = SOCKET;
+constexpr Socket kNoSocket = INVALID_SOCKET;
+
+void closeSocket(Socket socket)
+{
+    closesocket(socket);
+}
+#else
+using Socket = int;
+constexpr Socket kNoSocket = -1;
+
+void closeSocket(Socket socket)
+{
+    close(socket);
+}
+#endif
+
+Socket toSocket(intptr_t value)
+{
+    return static_cast<Socket>(value);
+}
+
+bool startWinsock()
+{
+#if defined(_WIN32)
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+    {
+        Log::error("Failed to start Winsock");
+        return false;
+    }
+#endif
+    return true;
+}
+
+void stopWinsock()
+{
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+}
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  StreamSender
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class StreamSender::Sink : public PadSink
+{
+public:
+    Sink(StreamSender& sender, uint16_t pad)
+        : sender_(sender)
+        , encoder_(sender.session_, pad, sender.keyframeNs_)
+    {
+        std::lock_guard<std::mutex> lock(sender_.mutex_);
+        sender_.sinks_.push_back(this);
+    }
+
+    ~Sink() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(sender_.mutex_);
+            sender_.sinks_.erase(std::find(sender_.sinks_.begin(), sender_.sinks_.end(), this));
+        }
+
+        uint8_t datagram[Stream::kMaxPacket];
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto size = encoder_.bye(Clock::nowNs(), datagram);
+        sender_.send(datagram, size, false);
+    }
+
+    void submit(const XusbReport& report) override
+    {
+        uint8_t datagram[Stream::kMaxPacket];
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto size = encoder_.encode(report, Clock::nowNs(), datagram);
+        sender_.send(datagram, size, encoder_.lastWasKeyframe());
+    }
+
+    // Sender thread
+    void refresh(int64_t nowNs)
+    {
+        uint8_t datagram[Stream::kMaxPacket];
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto size = encoder_.refresh(nowNs, datagram);
+        if (size > 0)
+            sender_.send(datagram, size, true);
+    }
+
+private:
+    StreamSender&   sender_;
+    Stream::Encoder encoder_;
+
+    // Taken by the pad's thread for every report and by the sender's
+    // thread for a refresh, so practically never contended
+    std::mutex mutex_;
+};
+
+StreamSender::~StreamSender()
+{
+    if (loop_)
+    {
+        loop_->stop();
+        if (thread_.joinable())
+            thread_.join();
+        loop_.reset();
+    }
+
+    if (socket_ != -1)
+        closeSocket(toSocket(socket_));
+    if (winsock_)
+        stopWinsock();
+}
+
+std::unique_ptr<StreamSender> StreamSender::create(const std::string& target, uint32_t keyframeMs)
+{
+    std::unique_ptr<StreamSender> sender(new StreamSender());
+    if (!sender->init(target, keyframeMs))
+        return nullptr;
+    return sender;
+}
+
+bool StreamSender::init(const std::string& target, uint32_t keyframeMs)
+{
+    const auto colon = target.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == target.size())
+    {
+        Log::error("Stream target %s isn't host:port", target.c_str());
+        return false;
+    }
+    const auto host = target.substr(0, colon);
+    const auto port = target.substr(colon + 1);
+
+    winsock_ = startWinsock();
+    if (!winsock_)
+        return false;
+
+    addrinfo hints{};
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_protocol = IPPROTO_UDP;
+    addrinfo* resolved = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &resolved) != 0 || !resolved)
+    {
+        Log::error("Failed to resolve stream target %s", target.c_str());
+        return false;
+    }
+
+    // Connected, so every datagram is a plain send() with no address
+    const Socket socket = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    const bool connected = socket != kNoSocket &&
+        connect(socket, resolved->ai_addr, static_cast<int>(resolved->ai_addrlen)) == 0;
+    freeaddrinfo(resolved);
+    if (socket != kNoSocket)
+        socket_ = static_cast<intptr_t>(socket);
+    if (!connected)
+    {
+        Log::error("Failed to open a stream socket to %s", target.c_str());
+        return false;
+    }
+
+    std::random_device random;
+    session_    = random();
+    keyframeNs_ = static_cast<int64_t>(keyframeMs) * 1000000;
+
+    loop_  = EventLoop::create();
+    timer_ = WaitableTimer::create();
+    if (!loop_ || !timer_ || !loop_->add(timer_->handle(), [this]{ refresh(); }))
+    {
+        Log::error("Failed to set up the stream keyframe timer");
+        loop_.reset();
+        return false;
+    }
+    timer_->arm(keyframeNs_ / 2);
+    thread_ = std::thread([this]
+    {
+        Log::attachThread();
+        loop_->run();
+    });
+    return true;
+}
+
+std::unique_ptr<PadSink> StreamSender::plug()
+{
+    return std::unique_ptr<PadSink>(new Sink(*this, nextPad_++));
+}
+
+void StreamSender::send(const uint8_t* data, size_t size, bool keyframe)
+{
+    // A full socket buffer or an unreachable receiver drops the datagram;
+    // the next keyframe makes up for it
+    const auto sent = ::send(toSocket(socket_), reinterpret_cast<const char*>(data), static_cast<int>(size), 0);
+    if (sent != static_cast<std::remove_const_t<decltype(sent)>>(size))
+    {
+        counters_.sendErrors.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    counters_.datagrams.fetch_add(1, std::memory_order_relaxed);
+    counters_.bytes.fetch_add(size, std::memory_order_relaxed);
+    if (keyframe)
+        counters_.keyframes.fetch_add(1, std::memory_order_relaxed);
+}
+
+void StreamSender::refresh()
+{
+    timer_->acknowledge();
+    const auto nowNs = Clock::nowNs();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto* sink : sinks_)
+            sink->refresh(nowNs);
+    }
+    timer_->arm(keyframeNs_ / 2);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  StreamReceiver
+//
+///////////////////////////////////////////////////////////////////////////////
+
+StreamReceiver::StreamReceiver(SinkBackend& sinks)
+    : sinks_(sinks)
+{
+}
+
+StreamReceiver::~StreamReceiver()
+{
+    if (loop_)
+    {
+        loop_->stop();
+        if (thread_.joinable())
+            thread_.join();
+        loop_.reset();
+    }
+
+    // Unplugs every remote pad's virtual pad
+    for (auto& pad : pads_)
+        pad.sink.reset();
+
+    if (socket_ != -1)
+        closeSocket(toSocket(socket_));
+#if defined(_WIN32)
+    if (event_ != -1)
+        WSACloseEvent(reinterpret_cast<WSAEVENT>(event_));
+#endif
+    if (winsock_)
+        stopWinsock();
+}
+
+std::unique_ptr<StreamReceiver> StreamReceiver::create(uint16_t port, SinkBackend& sinks, uint32_t keyframeMs)
+{
+    std::unique_ptr<StreamReceiver> receiver(new StreamReceiver(sinks));
+    if (!receiver->init(port, keyframeMs))
+        return nullptr;
+    return receiver;
+}
+
+bool StreamReceiver::init(uint16_t port, uint32_t keyframeMs)
+{
+    winsock_ = startWinsock();
+    if (!winsock_)
+        return false;
+
+    const Socket socket = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (socket == kNoSocket)
+    {
+        Log::error("Failed to create the stream socket");
+        return false;
+    }
+    socket_ = static_cast<intptr_t>(socket);
+
+    // Senders are elsewhere on the LAN
+    sockaddr_in address{};
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port        = htons(port);
+    if (bind(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        Log::error("Failed to listen for pad streams on port %u", static_cast<unsigned>(port));
+        return false;
+    }
+
+    socklen_t length = sizeof(address);
+    getsockname(socket, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = ntohs(address.sin_port);
+
+#if defined(_WIN32)
+    const WSAEVENT event = WSACreateEvent();
+    if (event == WSA_INVALID_EVENT || WSAEventSelect(socket, event, FD_READ) != 0)
+    {
+        Log::error("Failed to watch the stream socket");
+        return false;
+    }
+    event_ = reinterpret_cast<EventHandle>(event);
+#else
+    fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+    fcntl(socket, F_SETFD, FD_CLOEXEC);
+    event_ = static_cast<EventHandle>(socket);
+#endif
+
+    // Checks for silent pads once per keyframe interval
+    silentNs_ = static_cast<int64_t>(keyframeMs) * 1000000 * kSilentKeyframes;
+    loop_  = EventLoop::create();
+    timer_ = WaitableTimer::create();
+    if (!loop_ || !timer_ || !loop_->add(event_, [this]{ receive(); }) || !loop_->add(timer_->handle(), [this]{ expire(); }))
+    {
+        Log::error("Failed to set up the stream event loop");
+        loop_.reset();
+        return false;
+    }
+    timer_->arm(silentNs_ / kSilentKeyframes);
+    thread_ = std::thread([this]
+    {
+        Log::attachThread();
+        loop_->run();
+    });
+    return true;
+}
+
+void StreamReceiver::receive()
+{
+#if defined(_WIN32)
+    // Resets the event; the next recv re-arms FD_READ
+    WSANETWORKEVENTS events;
+    WSAEnumNetworkEvents(toSocket(socket_), reinterpret_cast<WSAEVENT>(event_), &events);
+#endif
+
+    for (;;)
+    {
+        const auto received = recv(toSocket(socket_), reinterpret_cast<char*>(buffer_), sizeof(buffer_), 0);
+        if (received < 0)
+            return;
+        const auto nowNs = Clock::nowNs();
+        counters_.datagrams.fetch_add(1, std::memory_order_relaxed);
+
+        Stream::Packet packet;
+        if (!Stream::parse(buffer_, static_cast<size_t>(received), packet))
+        {
+            counters_.malformed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        handle(packet, nowNs);
+    }
+}
+
+StreamReceiver::Pad* StreamReceiver::find(const Stream::Packet& packet)
+{
+    Pad* free = nullptr;
+    for (auto& pad : pads_)
+    {
+        if (pad.used && pad.session == packet.session && pad.pad == packet.pad)
+            return &pad;
+        if (!pad.used && !free)
+            free = &pad;
+    }
+
+    // Only a keyframe starts a pad, so a stray datagram from a pad that
+    // already said goodbye doesn't plug it in again
+    if (!free || !(packet.flags & Stream::KEYFRAME))
+        return nullptr;
+
+    free->sink = sinks_.plug();
+    if (!free->sink)
+        return nullptr;
+    free->used    = true;
+    free->session = packet.session;
+    free->pad     = packet.pad;
+    free->lastNs  = 0;
+    free->decoder = Stream::Decoder();
+    counters_.pads.fetch_add(1, std::memory_order_relaxed);
+    Log::info("stream: remote pad %08x/%u connected", packet.session, static_cast<unsigned>(packet.pad));
+    return free;
+}
+
+void StreamReceiver::handle(const Stream::Packet& packet, int64_t nowNs)
+{
+    Pad* pad = find(packet);
+    if (!pad)
+    {
+        if (packet.flags & Stream::KEYFRAME)
+            counters_.refused.fetch_add(1, std::memory_order_relaxed);
+        else
+            counters_.noBase.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    pad->lastNs = nowNs;
+
+    const auto lostBefore = pad->decoder.lost();
+    XusbReport report;
+    const auto result = pad->decoder.apply(packet, report);
+    counters_.lost.fetch_add(pad->decoder.lost() - lostBefore, std::memory_order_relaxed);
+
+    switch (result)
+    {
+    case Stream::Decoder::APPLIED:
+        pad->sink->submit(report);
+        latency_.record(nowNs - packet.sentNs);
+        counters_.applied.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case Stream::Decoder::STALE:
+        counters_.stale.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case Stream::Decoder::NO_BASE:
+        counters_.noBase.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case Stream::Decoder::CLOSED:
+        Log::info("stream: remote pad %08x/%u disconnected", packet.session, static_cast<unsigned>(packet.pad));
+        unplug(*pad);
+        break;
+    }
+}
+
+void StreamReceiver::expire()
+{
+    timer_->acknowledge();
+    const auto nowNs = Clock::nowNs();
+    for (auto& pad : pads_)
+    {
+        if (!pad.used || nowNs - pad.lastNs < silentNs_)
+            continue;
+        Log::warning("stream: remote pad %08x/%u went silent, unplugging it", pad.session, static_cast<unsigned>(pad.pad));
+        unplug(pad);
+        counters_.timedOut.fetch_add(1, std::memory_order_relaxed);
+    }
+    timer_->arm(silentNs_ / kSilentKeyframes);
+}
+
+void StreamReceiver::unplug(Pad& pad)
+{
+    // Nothing stays held on the virtual pad, whatever the last report was
+    pad.sink->submit(XusbReport {});
+    pad.sink.reset();
+    pad.used = false;
+    counters_.pads.fetch_sub(1, std::memory_order_relaxed);
+}
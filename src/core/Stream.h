@@ -0,0 +1,162 @@
+#pragma once
+
+#include "EventLoop.h"
+#include "LatencyHistogram.h"
+#include "PadSink.h"
+#include "StreamProtocol.h"
+#include "WaitableTimer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Pad streaming over UDP
+//
+//  StreamSender is a SinkBackend: a bridge started with --send plugs its
+//  pads into it instead of local virtual pads, and every report the
+//  pipeline submits goes out as one datagram (see StreamProtocol.h). A
+//  bridge started with --receive runs a StreamReceiver, which plugs a
+//  virtual pad of its own for every remote pad and submits what arrives.
+//  A remote pad goes away with a BYE datagram, or once it has been silent
+//  for kSilentKeyframes keyframe intervals (its sender crashed, lost the
+//  network, or the BYE was lost): the receiver neutralises its virtual pad
+//  and unplugs it, freeing the slot.
+//
+//  Reports only go out when a pad submits one, so the sender's own thread
+//  wakes every half keyframe interval and resends the last report of any
+//  pad whose keyframe is older than the interval: an idle pad still resyncs
+//  a receiver that lost its last datagram (a button release, say).
+//
+//  Neither side allocates per datagram: the sender encodes on the pad's
+//  thread into a stack buffer and sends on a shared connected socket; the
+//  receiver reads into one buffer on its own thread and keeps a fixed table
+//  of remote pads. Only a new remote pad plugs a virtual pad.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class StreamSender : public SinkBackend
+{
+public:
+    struct Counters
+    {
+        std::atomic<uint64_t> datagrams { 0 };
+        std::atomic<uint64_t> keyframes { 0 };
+        std::atomic<uint64_t> bytes { 0 };
+        std::atomic<uint64_t> sendErrors { 0 };
+    };
+
+public:
+    ~StreamSender() override;
+
+    // target is host:port. nullptr if it doesn't resolve or the socket
+    // can't be created.
+    static std::unique_ptr<StreamSender> create(const std::string& target, uint32_t keyframeMs);
+
+    std::unique_ptr<PadSink> plug() override;
+
+    const Counters& counters() const { return counters_; }
+
+private:
+    class Sink;
+
+    StreamSender() = default;
+    bool init(const std::string& target, uint32_t keyframeMs);
+    void send(const uint8_t* data, size_t size, bool keyframe);
+    void refresh();
+
+private:
+    intptr_t              socket_ { -1 };
+    bool                  winsock_ { false };
+    uint32_t              session_ { 0 };
+    int64_t               keyframeNs_ { 0 };
+    std::atomic<uint16_t> nextPad_ { 0 };
+    Counters              counters_;
+
+    // Plugged sinks, for the keyframe refresh
+    std::mutex         mutex_;
+    std::vector<Sink*> sinks_;
+
+    std::unique_ptr<EventLoop>     loop_;
+    std::unique_ptr<WaitableTimer> timer_;
+    std::thread                    thread_;
+};
+
+class StreamReceiver
+{
+public:
+    static constexpr size_t   kMaxPads         = 16;
+    static constexpr uint32_t kSilentKeyframes = 5;
+
+    struct Counters
+    {
+        std::atomic<uint64_t> datagrams { 0 };
+        std::atomic<uint64_t> applied { 0 };
+        std::atomic<uint64_t> stale { 0 };      // out of order or repeated
+        std::atomic<uint64_t> noBase { 0 };     // waiting for a keyframe
+        std::atomic<uint64_t> lost { 0 };       // sequence gaps
+        std::atomic<uint64_t> malformed { 0 };
+        std::atomic<uint64_t> refused { 0 };    // pads past kMaxPads, or no virtual pad
+        std::atomic<uint64_t> timedOut { 0 };   // pads unplugged after going silent
+        std::atomic<uint32_t> pads { 0 };
+    };
+
+public:
+    ~StreamReceiver();
+
+    StreamReceiver(const StreamReceiver&) = delete;
+    StreamReceiver& operator=(const StreamReceiver&) = delete;
+
+    // Listens on every interface; port 0 picks a free port. Remote pads are
+    // plugged into sinks, which must outlive the receiver. keyframeMs is the
+    // senders' keyframe interval.
+    static std::unique_ptr<StreamReceiver> create(uint16_t port, SinkBackend& sinks, uint32_t keyframeMs);
+
+    uint16_t port() const { return port_; }
+
+    const Counters& counters() const { return counters_; }
+
+    // Arrival minus send time of every applied datagram; only meaningful
+    // when sender and receiver share a clock (loopback)
+    const LatencyHistogram& latency() const { return latency_; }
+
+private:
+    struct Pad
+    {
+        bool                     used { false };
+        uint32_t                 session { 0 };
+        uint16_t                 pad { 0 };
+        int64_t                  lastNs { 0 };   // last datagram from the pad
+        Stream::Decoder          decoder;
+        std::unique_ptr<PadSink> sink;
+    };
+
+    explicit StreamReceiver(SinkBackend& sinks);
+    bool init(uint16_t port, uint32_t keyframeMs);
+
+    void receive();
+    void handle(const Stream::Packet& packet, int64_t nowNs);
+    Pad* find(const Stream::Packet& packet);
+    void expire();
+    void unplug(Pad& pad);
+
+private:
+    SinkBackend&                   sinks_;
+    Pad                            pads_[kMaxPads];
+    uint8_t                        buffer_[512];
+    intptr_t                       socket_ { -1 };
+    EventHandle                    event_ { -1 };
+    uint16_t                       port_ { 0 };
+    bool                           winsock_ { false };
+    int64_t                        silentNs_ { 0 };
+    Counters                       counters_;
+    LatencyHistogram               latency_;
+    std::unique_ptr<EventLoop>     loop_;
+    std::unique_ptr<WaitableTimer> timer_;
+    std::thread                    thread_;
+};
@@ -0,0 +1,186 @@
+#include "StreamProtocol.h"
+
+#include <cstring>
+
+namespace
+{
+
+static_assert(sizeof(XusbReport) % sizeof(uint16_t) == 0, "reports are whole 16 bit words");
+
+template <typename T>
+void put(uint8_t* out, size_t offset, T value)
+{
+    memcpy(out + offset, &value, sizeof(value));
+}
+
+template <typename T>
+T get(const uint8_t* data, size_t offset)
+{
+    T value;
+    memcpy(&value, data + offset, sizeof(value));
+    return value;
+}
+
+void toWords(const XusbReport& report, uint16_t (&words)[Stream::kWords])
+{
+    memcpy(words, &report, sizeof(report));
+}
+
+uint32_t countBits(uint32_t mask)
+{
+    uint32_t count = 0;
+    for (; mask; mask &= mask - 1)
+        count++;
+    return count;
+}
+
+}
+
+namespace Stream
+{
+
+bool parse(const uint8_t* data, size_t size, Packet& out)
+{
+    if (size < kHeaderBytes || get<uint16_t>(data, 0) != kMagic || data[2] != kVersion)
+        return false;
+
+    out.flags    = data[3];
+    out.session  = get<uint32_t>(data, 4);
+    out.pad      = get<uint16_t>(data, 8);
+    out.mask     = data[10];
+    out.sequence = get<uint32_t>(data, 12);
+    out.base     = get<uint32_t>(data, 16);
+    out.sentNs   = get<int64_t>(data, 20);
+
+    if ((out.mask & ~kAllWords) || ((out.flags & KEYFRAME) && out.mask != kAllWords) || ((out.flags & BYE) && out.mask != 0))
+        return false;
+    if (size != kHeaderBytes + countBits(out.mask) * sizeof(uint16_t))
+        return false;
+
+    size_t offset = kHeaderBytes;
+    for (size_t word = 0; word < kWords; word++)
+    {
+        if (out.mask & (1u << word))
+        {
+            out.words[word] = get<uint16_t>(data, offset);
+            offset += sizeof(uint16_t);
+        }
+    }
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Encoder
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Encoder::Encoder(uint32_t session, uint16_t pad, int64_t keyframeIntervalNs)
+    : session_(session)
+    , pad_(pad)
+    , keyframeIntervalNs_(keyframeIntervalNs)
+{
+}
+
+size_t Encoder::header(uint8_t flags, uint8_t mask, int64_t nowNs, uint8_t (&out)[kMaxPacket])
+{
+    sequence_++;
+    put<uint16_t>(out, 0, kMagic);
+    out[2] = kVersion;
+    out[3] = flags;
+    put<uint32_t>(out, 4, session_);
+    put<uint16_t>(out, 8, pad_);
+    out[10] = mask;
+    out[11] = 0;
+    put<uint32_t>(out, 12, sequence_);
+    put<uint32_t>(out, 16, (flags & KEYFRAME) ? sequence_ : keySequence_);
+    put<int64_t>(out, 20, nowNs);
+    return kHeaderBytes;
+}
+
+size_t Encoder::encode(const XusbReport& report, int64_t nowNs, uint8_t (&out)[kMaxPacket])
+{
+    uint16_t words[kWords];
+    toWords(report, words);
+    last_ = report;
+
+    uint8_t mask = 0;
+    for (size_t word = 0; word < kWords; word++)
+        if (!hasKey_ || words[word] != key_[word])
+            mask |= static_cast<uint8_t>(1u << word);
+
+    // A delta as big as a keyframe might as well be one
+    lastKeyframe_ = !hasKey_ || mask == kAllWords || nowNs - keyNs_ >= keyframeIntervalNs_;
+    if (lastKeyframe_)
+        mask = kAllWords;
+
+    size_t size = header(lastKeyframe_ ? KEYFRAME : 0, mask, nowNs, out);
+    for (size_t word = 0; word < kWords; word++)
+    {
+        if (mask & (1u << word))
+        {
+            put<uint16_t>(out, size, words[word]);
+            size += sizeof(uint16_t);
+        }
+    }
+
+    if (lastKeyframe_)
+    {
+        memcpy(key_, words, sizeof(key_));
+        keySequence_ = sequence_;
+        keyNs_       = nowNs;
+        hasKey_      = true;
+    }
+    return size;
+}
+
+size_t Encoder::refresh(int64_t nowNs, uint8_t (&out)[kMaxPacket])
+{
+    if (!hasKey_ || nowNs - keyNs_ < keyframeIntervalNs_)
+        return 0;
+    return encode(last_, nowNs, out);
+}
+
+size_t Encoder::bye(int64_t nowNs, uint8_t (&out)[kMaxPacket])
+{
+    lastKeyframe_ = false;
+    return header(BYE, 0, nowNs, out);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Decoder
+//
+///////////////////////////////////////////////////////////////////////////////
+
+Decoder::Result Decoder::apply(const Packet& packet, XusbReport& out)
+{
+    // Wrap safe: anything up to 2^31 behind counts as old
+    const auto ahead = static_cast<int32_t>(packet.sequence - last_);
+    if (hasLast_ && ahead <= 0)
+        return STALE;
+    if (hasLast_)
+        lost_ += static_cast<uint32_t>(ahead - 1);
+    last_    = packet.sequence;
+    hasLast_ = true;
+
+    if (packet.flags & BYE)
+        return CLOSED;
+
+    if (packet.flags & KEYFRAME)
+    {
+        memcpy(key_, packet.words, sizeof(key_));
+        keySequence_ = packet.sequence;
+        hasKey_      = true;
+    }
+    else if (!hasKey_ || packet.base != keySequence_)
+        return NO_BASE;
+
+    uint16_t words[kWords];
+    for (size_t word = 0; word < kWords; word++)
+        words[word] = (packet.mask & (1u << word)) ? packet.words[word] : key_[word];
+    memcpy(&out, words, sizeof(out));
+    return APPLIED;
+}
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "XusbReport.h"
+
+#include <cstddef>
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Pad streaming protocol
+//
+//  One UDP datagram per report a forwarded pad sends. Every datagram carries
+//  a fixed header and the report's changed 16 bit words:
+//
+//    [u16 magic][u8 version][u8 flags][u32 session][u16 pad][u8 mask][u8 0]
+//    [u32 sequence][u32 base][i64 sentNs]  (28 bytes)
+//    one u16 for every bit set in mask, lowest bit first
+//
+//  A KEYFRAME carries all six words of the report and becomes the base of
+//  the datagrams after it; the others carry the words that differ from
+//  their base keyframe, so a lost datagram never corrupts the next one.
+//  Senders send a fresh keyframe every keyframe interval, repeating the last
+//  report when the pad sent nothing new, so an idle pad resyncs too (and a
+//  receiver can tell a quiet pad from a gone one). Receivers drop
+//  anything not newer than what they already applied, and deltas whose
+//  keyframe they never saw.
+//
+//  `session` is random per sender run and `pad` per virtual pad, so a
+//  restarted sender never collides with its previous run. `sentNs` is the
+//  sender's Clock::nowNs(), only comparable on the same machine (loopback
+//  latency measurements). All integers are little endian.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Stream
+{
+
+static constexpr uint16_t kMagic       = 0x3436; // "64"
+static constexpr uint8_t  kVersion     = 1;
+static constexpr size_t   kHeaderBytes = 28;
+static constexpr size_t   kWords       = sizeof(XusbReport) / sizeof(uint16_t);
+static constexpr size_t   kMaxPacket   = kHeaderBytes + sizeof(XusbReport);
+static constexpr uint8_t  kAllWords    = (1u << kWords) - 1;
+
+enum Flags : uint8_t
+{
+    KEYFRAME = 0x1,
+    BYE      = 0x2,  // the virtual pad is gone; no words
+};
+
+struct Packet
+{
+    uint8_t  flags;
+    uint32_t session;
+    uint16_t pad;
+    uint8_t  mask;
+    uint32_t sequence;
+    uint32_t base;              // sequence of the keyframe the words are relative to
+    int64_t  sentNs;
+    uint16_t words[kWords];     // only the masked ones are meaningful
+};
+
+// false for anything that isn't a well formed datagram of this version
+bool parse(const uint8_t* data, size_t size, Packet& out);
+
+// Sender side of one pad
+class Encoder
+{
+public:
+    Encoder(uint32_t session, uint16_t pad, int64_t keyframeIntervalNs);
+
+    // Datagram for the report, returns its size
+    size_t encode(const XusbReport& report, int64_t nowNs, uint8_t (&out)[kMaxPacket]);
+    size_t bye(int64_t nowNs, uint8_t (&out)[kMaxPacket]);
+
+    // The last report again as a keyframe when the last keyframe is a
+    // keyframe interval old; 0 (nothing to send) otherwise, or before the
+    // first report
+    size_t refresh(int64_t nowNs, uint8_t (&out)[kMaxPacket]);
+
+    bool lastWasKeyframe() const { return lastKeyframe_; }
+
+private:
+    size_t header(uint8_t flags, uint8_t mask, int64_t nowNs, uint8_t (&out)[kMaxPacket]);
+
+private:
+    uint32_t   session_;
+    uint16_t   pad_;
+    int64_t    keyframeIntervalNs_;
+    uint32_t   sequence_ { 0 };
+    uint32_t   keySequence_ { 0 };
+    int64_t    keyNs_ { 0 };
+    bool       hasKey_ { false };
+    bool       lastKeyframe_ { false };
+    uint16_t   key_[kWords] {};
+    XusbReport last_ {};          // the report behind the last datagram
+};
+
+// Receiver side of one pad
+class Decoder
+{
+public:
+    enum Result : uint8_t
+    {
+        APPLIED,   // out holds the report
+        STALE,     // not newer than the last datagram taken; dropped
+        NO_BASE,   // delta on a keyframe that never arrived; dropped
+        CLOSED,    // the sender's pad went away
+    };
+
+    Result apply(const Packet& packet, XusbReport& out);
+
+    // Datagrams that never arrived (or arrived too late), from sequence gaps
+    uint64_t lost() const { return lost_; }
+
+private:
+    uint32_t last_ { 0 };
+    bool     hasLast_ { false };
+    uint32_t keySequence_ { 0 };
+    bool     hasKey_ { false };
+    uint16_t key_[kWords] {};
+    uint64_t lost_ { 0 };
+};
+
+}
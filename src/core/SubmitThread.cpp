@@ -0,0 +1,146 @@
+#include "SubmitThread.h"
+#include "Clock.h"
+#include "Log.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Pad
+//
+///////////////////////////////////////////////////////////////////////////////
+
+SubmitThread::Pad::Pad(SubmitThread& owner, uint32_t index, PadSink& sink, ControllerStats& stats)
+    : owner_(owner)
+    , index_(index)
+    , sink_(sink)
+    , stats_(stats)
+{   }
+
+SubmitThread::Pad::~Pad()
+{
+    owner_.remove(*this);
+}
+
+void SubmitThread::Pad::post(const XusbReport& report, int64_t readNs)
+{
+    mailbox_.post(report, readNs);
+
+    // Only the first post since the last drain needs to wake the thread
+    const uint64_t bit = 1ull << index_;
+    if (!(owner_.dirty_.fetch_or(bit, std::memory_order_release) & bit))
+        owner_.wake_->signal();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  SubmitThread
+//
+///////////////////////////////////////////////////////////////////////////////
+
+SubmitThread::~SubmitThread()
+{
+    if (loop_)
+    {
+        loop_->stop();
+        if (thread_.joinable())
+            thread_.join();
+        loop_.reset();
+    }
+}
+
+std::unique_ptr<SubmitThread> SubmitThread::create()
+{
+    std::unique_ptr<SubmitThread> submitter(new SubmitThread());
+    if (!submitter->init())
+        return nullptr;
+    return submitter;
+}
+
+bool SubmitThread::init()
+{
+    loop_ = EventLoop::create();
+    wake_ = WaitableEvent::create();
+    if (!loop_ || !wake_)
+    {
+        Log::error("Failed to create the submit thread's wake event");
+        return false;
+    }
+
+    const bool added = loop_->add(wake_->handle(), [this]
+    {
+        wake_->acknowledge();
+        drain();
+    });
+    if (!added)
+    {
+        Log::error("Failed to set up the submit event loop");
+        return false;
+    }
+
+    thread_ = std::thread([this]
+    {
+        Log::attachThread();
+        loop_->run();
+    });
+    return true;
+}
+
+std::unique_ptr<SubmitThread::Pad> SubmitThread::addPad(PadSink& sink, ControllerStats& stats)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint32_t index = 0; index < kMaxPads; index++)
+    {
+        if (!pads_[index])
+        {
+            std::unique_ptr<Pad> pad(new Pad(*this, index, sink, stats));
+            pads_[index] = pad.get();
+            return pad;
+        }
+    }
+    return nullptr;
+}
+
+void SubmitThread::remove(Pad& pad)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    pads_[pad.index_] = nullptr;
+    dirty_.fetch_and(~(1ull << pad.index_), std::memory_order_relaxed);
+}
+
+void SubmitThread::drain()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    uint64_t dirty     = dirty_.exchange(0, std::memory_order_acquire);
+    uint64_t submitted = 0;
+    uint64_t skipped   = 0;
+    for (uint32_t index = 0; dirty; index++, dirty >>= 1)
+    {
+        // A pad posts again after the drain took its report: its bit comes
+        // back with nothing fresh behind it
+        auto* pad = pads_[index];
+        ReportMailbox::Entry entry;
+        if (!(dirty & 1) || !pad || !pad->mailbox_.take(entry))
+            continue;
+
+        pad->sink_.submit(entry.report);
+        const auto submittedNs = Clock::nowNs();
+
+        // Posted after the last report taken and replaced before this one
+        const auto superseded = entry.sequence - pad->taken_ - 1;
+        pad->taken_ = entry.sequence;
+
+        auto& stats = pad->stats_;
+        stats.submit.reportsSuperseded.store(stats.submit.reportsSuperseded.load(std::memory_order_relaxed) + superseded,
+                                             std::memory_order_relaxed);
+        stats.submit.staleness.record(submittedNs - entry.readNs);
+        skipped += superseded;
+        submitted++;
+    }
+
+    if (submitted == 0)
+        return;
+    counters_.batches.fetch_add(1, std::memory_order_relaxed);
+    counters_.submitted.fetch_add(submitted, std::memory_order_relaxed);
+    counters_.superseded.fetch_add(skipped, std::memory_order_relaxed);
+    batchSizes_.record(static_cast<int64_t>(submitted));
+}
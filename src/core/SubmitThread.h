@@ -0,0 +1,114 @@
+#pragma once
+
+#include "ControllerStats.h"
+#include "EventLoop.h"
+#include "LatencyHistogram.h"
+#include "PadSink.h"
+#include "ReportMailbox.h"
+#include "WaitableEvent.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Virtual pad submission off the read path
+//
+//  A virtual pad update can block (ViGEm's IOCTL, behind its own lock), and
+//  the pad's thread normally waits it out before reading again. With a
+//  SubmitThread, a pad's thread posts each report to the pad's
+//  ReportMailbox instead and goes straight back to the device; one thread
+//  wakes on any posted report and submits every pad with a fresh one in a
+//  single batch. A pad posting faster than its updates go through only ever
+//  has its newest report submitted: the ones replaced in the mailbox are
+//  counted as superseded, and every submission records its staleness, the
+//  time from the read it came from to the update returning.
+//
+//  The per pad counters and staleness histogram live in the pad's
+//  ControllerStats, in a block of their own, and are written by this thread
+//  only.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class SubmitThread
+{
+public:
+    static constexpr uint32_t kMaxPads = 64;
+
+    struct Counters
+    {
+        std::atomic<uint64_t> batches { 0 };      // wake ups that submitted something
+        std::atomic<uint64_t> submitted { 0 };
+        std::atomic<uint64_t> superseded { 0 };
+    };
+
+    class Pad
+    {
+    public:
+        // No submission for the pad is in progress once this returns
+        ~Pad();
+
+        Pad(const Pad&) = delete;
+        Pad& operator=(const Pad&) = delete;
+
+        // Pad thread: hands the report over; wait-free apart from waking the
+        // submit thread when the pad had nothing pending
+        void post(const XusbReport& report, int64_t readNs);
+
+    private:
+        friend class SubmitThread;
+
+        Pad(SubmitThread& owner, uint32_t index, PadSink& sink, ControllerStats& stats);
+
+    private:
+        SubmitThread&    owner_;
+        uint32_t         index_;
+        PadSink&         sink_;
+        ControllerStats& stats_;
+        ReportMailbox    mailbox_;
+        uint64_t         taken_ { 0 };    // submit thread: sequence of the last report taken
+    };
+
+public:
+    ~SubmitThread();
+
+    SubmitThread(const SubmitThread&) = delete;
+    SubmitThread& operator=(const SubmitThread&) = delete;
+
+    // nullptr when the thread or its wake event can't be set up
+    static std::unique_ptr<SubmitThread> create();
+
+    // nullptr when kMaxPads pads are registered. Pads must be gone before
+    // the thread, and the sink and stats must outlive the Pad.
+    std::unique_ptr<Pad> addPad(PadSink& sink, ControllerStats& stats);
+
+    const Counters& counters() const { return counters_; }
+
+    // Pads with a fresh report per batch
+    const LatencyHistogram& batchSizes() const { return batchSizes_; }
+
+private:
+    SubmitThread() = default;
+    bool init();
+    void drain();
+    void remove(Pad& pad);
+
+private:
+    std::unique_ptr<EventLoop>     loop_;
+    std::unique_ptr<WaitableEvent> wake_;
+    std::thread                    thread_;
+
+    // Bit i: pads_[i] posted since the last drain. Set by pad threads,
+    // swapped out by this thread.
+    std::atomic<uint64_t> dirty_ { 0 };
+
+    // Held while a batch is submitted, and to add or remove a pad
+    std::mutex mutex_;
+    Pad*       pads_[kMaxPads] {};
+
+    Counters         counters_;
+    LatencyHistogram batchSizes_;
+};
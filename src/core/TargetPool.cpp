@@ -0,0 +1,153 @@
+#include "TargetPool.h"
+#include "Clock.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <chrono>
+
+TargetPool::TargetPool(const Callbacks& callbacks, size_t prewarm, uint32_t graceMs)
+    : callbacks_(callbacks)
+    , prewarm_(prewarm)
+    , graceNs_(static_cast<int64_t>(graceMs) * 1000000)
+{
+    expireThread_ = std::thread([this]
+    {
+        Log::attachThread();
+        expireLoop();
+    });
+}
+
+TargetPool::~TargetPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        changed_.notify_all();
+    }
+    expireThread_.join();
+
+    for (auto target : idle_)
+        callbacks_.destroy(target);
+    for (const auto& parked : parked_)
+        callbacks_.destroy(parked.target);
+}
+
+size_t TargetPool::prewarm()
+{
+    for (;;)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (idle_.size() >= prewarm_)
+                return idle_.size();
+        }
+
+        void* target = callbacks_.create();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!target)
+            return idle_.size();
+        counters_.created++;
+        idle_.push_back(target);
+    }
+}
+
+void* TargetPool::acquire(const DeviceGuid& id)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find_if(parked_.begin(), parked_.end(), [&](const Parked& parked){ return parked.id == id; });
+        if (it != parked_.end())
+        {
+            void* target = it->target;
+            parked_.erase(it);
+            counters_.rebound++;
+            return target;
+        }
+
+        if (!idle_.empty())
+        {
+            void* target = idle_.back();
+            idle_.pop_back();
+            counters_.reused++;
+            return target;
+        }
+    }
+
+    void* target = callbacks_.create();
+    if (target)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        counters_.created++;
+    }
+    return target;
+}
+
+void TargetPool::release(const DeviceGuid& id, void* target)
+{
+    if (!target)
+        return;
+
+    // The game keeps seeing a connected pad, so let go of every input
+    callbacks_.neutral(target);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    parked_.push_back({ id, target, Clock::nowNs() + graceNs_ });
+    changed_.notify_all();
+}
+
+TargetPool::Counters TargetPool::counters() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto counters   = counters_;
+    counters.idle   = idle_.size();
+    counters.parked = parked_.size();
+    return counters;
+}
+
+void TargetPool::expireLoop()
+{
+    std::vector<void*> expired;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_)
+    {
+        if (parked_.empty())
+        {
+            changed_.wait(lock);
+            continue;
+        }
+
+        const auto nowNs = Clock::nowNs();
+        int64_t nextNs = INT64_MAX;
+        for (size_t i = 0; i < parked_.size();)
+        {
+            if (parked_[i].expiresNs > nowNs)
+            {
+                nextNs = (std::min)(nextNs, parked_[i].expiresNs);
+                i++;
+                continue;
+            }
+
+            // Already neutral, so it can serve as a warm spare as is
+            if (idle_.size() < prewarm_)
+                idle_.push_back(parked_[i].target);
+            else
+                expired.push_back(parked_[i].target);
+            parked_[i] = parked_.back();
+            parked_.pop_back();
+        }
+
+        if (!expired.empty())
+        {
+            counters_.destroyed += expired.size();
+            lock.unlock();
+            for (auto target : expired)
+                callbacks_.destroy(target);
+            expired.clear();
+            lock.lock();
+            continue;
+        }
+
+        if (nextNs != INT64_MAX)
+            changed_.wait_for(lock, std::chrono::nanoseconds(nextNs - nowNs));
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "DeviceGuid.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Warm pool of virtual pad targets
+//
+//  Plugging a virtual pad in is a slow round trip and games see every
+//  unplug. The pool keeps targets plugged in instead:
+//
+//   - release() resets a target to neutral and parks it for the grace
+//     period; acquire() for the same GUID within that time gets the same
+//     target back, so the game never sees the pad leave
+//   - parked targets whose grace period runs out go back to the idle set
+//     while it is below the pre-warm size, otherwise they are destroyed
+//   - acquire() for any other GUID takes an idle target before creating one
+//
+//  Targets are opaque pointers made and destroyed by the callbacks, which
+//  are never called with the pool's lock held. A background thread expires
+//  parked targets.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class TargetPool
+{
+public:
+    struct Callbacks
+    {
+        std::function<void*()>      create;   // plugged in target, nullptr on failure
+        std::function<void(void*)>  neutral;  // submit a neutral report
+        std::function<void(void*)>  destroy;  // unplug and free
+    };
+
+    struct Counters
+    {
+        uint64_t created { 0 };
+        uint64_t destroyed { 0 };
+        uint64_t rebound { 0 };   // same GUID back within the grace period
+        uint64_t reused { 0 };    // idle target handed to a pad
+        size_t   idle { 0 };
+        size_t   parked { 0 };
+    };
+
+public:
+    TargetPool(const Callbacks& callbacks, size_t prewarm, uint32_t graceMs);
+    ~TargetPool();
+
+    TargetPool(const TargetPool&) = delete;
+    TargetPool& operator=(const TargetPool&) = delete;
+
+    // Creates targets until `prewarm` are idle; returns how many are
+    size_t prewarm();
+
+    // nullptr when no target was available and creating one failed
+    void* acquire(const DeviceGuid& id);
+    void  release(const DeviceGuid& id, void* target);
+
+    Counters counters() const;
+
+private:
+    struct Parked
+    {
+        DeviceGuid id;
+        void*      target;
+        int64_t    expiresNs;
+    };
+
+    void expireLoop();
+
+private:
+    Callbacks               callbacks_;
+    size_t                  prewarm_;
+    int64_t                 graceNs_;
+
+    mutable std::mutex      mutex_;
+    std::condition_variable changed_;
+    std::vector<void*>      idle_;
+    std::vector<Parked>     parked_;
+    Counters                counters_;
+    bool                    stopping_ { false };
+    std::thread             expireThread_;
+};
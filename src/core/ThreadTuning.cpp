@@ -0,0 +1,133 @@
+#include "ThreadTuning.h"
+#include "Log.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+
+const char* ThreadTuning::priorityName(ThreadSettings::Priority priority)
+{
+    switch (priority)
+    {
+    case ThreadSettings::NORMAL:   return "normal";
+    case ThreadSettings::HIGH:     return "high";
+    case ThreadSettings::REALTIME: return "realtime";
+    default:                       return "?";
+    }
+}
+
+#if defined(_WIN32)
+
+namespace
+{
+
+// avrt.dll is loaded on demand so the core library links without it
+bool joinMmcss()
+{
+    using AvSetMmThreadCharacteristicsFn = HANDLE (WINAPI*)(LPCWSTR, LPDWORD);
+
+    static const auto setCharacteristics = []() -> AvSetMmThreadCharacteristicsFn
+    {
+        const auto avrt = LoadLibraryW(L"avrt.dll");
+        if (!avrt)
+            return nullptr;
+        return reinterpret_cast<AvSetMmThreadCharacteristicsFn>(GetProcAddress(avrt, "AvSetMmThreadCharacteristicsW"));
+    }();
+
+    // The registration ends with the thread
+    DWORD taskIndex = 0;
+    return setCharacteristics && setCharacteristics(L"Games", &taskIndex) != nullptr;
+}
+
+}
+
+bool ThreadTuning::apply(const ThreadSettings& settings)
+{
+    bool applied = true;
+
+    if (settings.priority != ThreadSettings::NORMAL)
+    {
+        if (!joinMmcss())
+            Log::warning("Failed to register the input thread with MMCSS (error %lu)", GetLastError());
+
+        const int priority = settings.priority == ThreadSettings::REALTIME ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST;
+        if (!SetThreadPriority(GetCurrentThread(), priority))
+        {
+            Log::warning("Failed to raise the input thread priority (error %lu)", GetLastError());
+            applied = false;
+        }
+    }
+
+    if (settings.cpu >= 0)
+    {
+        if (settings.cpu >= 64 || !SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << settings.cpu))
+        {
+            Log::warning("Failed to pin the input thread to CPU %d (error %lu)", settings.cpu, GetLastError());
+            applied = false;
+        }
+    }
+
+    return applied;
+}
+
+#else
+
+bool ThreadTuning::apply(const ThreadSettings& settings)
+{
+    bool applied = true;
+
+    if (settings.priority == ThreadSettings::HIGH)
+    {
+        // Linux nice values are per thread
+        const auto tid = static_cast<id_t>(syscall(SYS_gettid));
+        if (setpriority(PRIO_PROCESS, tid, -10) != 0)
+        {
+            Log::warning("Failed to raise the input thread priority: %s", strerror(errno));
+            applied = false;
+        }
+    }
+    else if (settings.priority == ThreadSettings::REALTIME)
+    {
+        // Low in the FIFO range: above every normal thread, below the
+        // kernel's own realtime work
+        sched_param param{};
+        param.sched_priority = 10;
+        const int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (error != 0)
+        {
+            Log::warning("Failed to make the input thread SCHED_FIFO: %s", strerror(error));
+            applied = false;
+        }
+    }
+
+    if (settings.cpu >= 0)
+    {
+        int error = EINVAL;
+        if (settings.cpu < CPU_SETSIZE)
+        {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(settings.cpu, &cpus);
+            error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        }
+        if (error != 0)
+        {
+            Log::warning("Failed to pin the input thread to CPU %d: %s", settings.cpu, strerror(error));
+            applied = false;
+        }
+    }
+
+    return applied;
+}
+
+#endif
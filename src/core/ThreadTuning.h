@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Scheduling of the threads that service pads
+//
+//  HIGH raises the thread above normal work (THREAD_PRIORITY_HIGHEST plus
+//  the MMCSS "Games" task on Windows, nice -10 on Linux). REALTIME goes
+//  further (THREAD_PRIORITY_TIME_CRITICAL, SCHED_FIFO); on Linux it needs
+//  CAP_SYS_NICE or an rtprio limit. A CPU pins the thread to that core.
+//
+//  Settings the system refuses are logged and skipped: a pad on a normal
+//  priority thread still works.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct ThreadSettings
+{
+    enum Priority : uint8_t
+    {
+        NORMAL,
+        HIGH,
+        REALTIME,
+    };
+
+    Priority priority { NORMAL };
+    int32_t  cpu { -1 }; // -1 = let the scheduler pick
+};
+
+namespace ThreadTuning
+{
+
+const char* priorityName(ThreadSettings::Priority priority);
+
+// Applies to the calling thread. Returns false if anything was refused.
+bool apply(const ThreadSettings& settings);
+
+}
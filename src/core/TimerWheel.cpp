@@ -0,0 +1,127 @@
+#include "TimerWheel.h"
+
+#include <algorithm>
+
+namespace
+{
+
+constexpr int64_t kIdle = -1;
+constexpr int64_t kDue  = -2;
+
+}
+
+TimerWheel::TimerWheel(int64_t tickNs, uint32_t slots)
+    : tickNs_((std::max)(int64_t(1), tickNs))
+{
+    uint32_t size = 1;
+    while (size < slots)
+        size <<= 1;
+    mask_ = size - 1;
+    slots_.assign(size, nullptr);
+}
+
+int64_t TimerWheel::tickOf(int64_t deadlineNs) const
+{
+    // Overdue timers go in the current bucket rather than a full turn ahead
+    return (std::max)(deadlineNs / tickNs_, currentTick_);
+}
+
+void TimerWheel::unlink(Timer& timer)
+{
+    if (timer.prev_)
+        timer.prev_->next_ = timer.next_;
+    else
+        slots_[timer.slot_] = timer.next_;
+    if (timer.next_)
+        timer.next_->prev_ = timer.prev_;
+
+    timer.prev_       = nullptr;
+    timer.next_       = nullptr;
+    timer.deadlineNs_ = kIdle;
+    size_--;
+}
+
+void TimerWheel::schedule(Timer& timer, int64_t deadlineNs)
+{
+    if (timer.pending())
+        unlink(timer);
+
+    deadlineNs = (std::max)(int64_t(0), deadlineNs);
+    timer.slot_       = static_cast<uint64_t>(tickOf(deadlineNs)) & mask_;
+    timer.deadlineNs_ = deadlineNs;
+    timer.prev_       = nullptr;
+    timer.next_       = slots_[timer.slot_];
+    if (timer.next_)
+        timer.next_->prev_ = &timer;
+    slots_[timer.slot_] = &timer;
+    size_++;
+}
+
+void TimerWheel::cancel(Timer& timer)
+{
+    if (timer.pending())
+        unlink(timer);
+    else
+        timer.deadlineNs_ = kIdle;
+}
+
+void TimerWheel::advance(int64_t nowNs)
+{
+    // A gap longer than a turn visits every bucket once
+    const int64_t nowTick = nowNs / tickNs_;
+    const int64_t last    = (std::min)(nowTick, currentTick_ + static_cast<int64_t>(mask_));
+    due_.clear();
+    for (int64_t tick = currentTick_; size_ > 0 && tick <= last; tick++)
+    {
+        for (Timer* timer = slots_[static_cast<uint64_t>(tick) & mask_]; timer; timer = timer->next_)
+            if (timer->deadlineNs_ <= nowNs)
+                due_.emplace_back(timer, timer->deadlineNs_);
+    }
+    currentTick_ = (std::max)(currentTick_, nowTick);
+
+    // Unlinked before any callback runs, so callbacks can reschedule or
+    // cancel any timer, due ones included
+    std::stable_sort(due_.begin(), due_.end(), [](const auto& a, const auto& b) { return a.second < b.second; });
+    for (auto& due : due_)
+    {
+        unlink(*due.first);
+        due.first->deadlineNs_ = kDue;
+    }
+
+    for (const auto& due : due_)
+    {
+        Timer* timer = due.first;
+        if (timer->deadlineNs_ != kDue)
+            continue;
+        timer->deadlineNs_ = kIdle;
+        if (timer->callback)
+            timer->callback(due.second);
+    }
+}
+
+int64_t TimerWheel::nextDeadlineNs() const
+{
+    if (size_ == 0)
+        return -1;
+
+    // The first bucket, in tick order, holding a timer due within its tick
+    for (int64_t tick = currentTick_; tick <= currentTick_ + static_cast<int64_t>(mask_); tick++)
+    {
+        int64_t earliest = -1;
+        for (const Timer* timer = slots_[static_cast<uint64_t>(tick) & mask_]; timer; timer = timer->next_)
+        {
+            if (tickOf(timer->deadlineNs_) == tick && (earliest < 0 || timer->deadlineNs_ < earliest))
+                earliest = timer->deadlineNs_;
+        }
+        if (earliest >= 0)
+            return earliest;
+    }
+
+    // Everything is more than a turn away
+    int64_t earliest = -1;
+    for (const Timer* head : slots_)
+        for (const Timer* timer = head; timer; timer = timer->next_)
+            if (earliest < 0 || timer->deadlineNs_ < earliest)
+                earliest = timer->deadlineNs_;
+    return earliest;
+}
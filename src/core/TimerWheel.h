@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Hashed timer wheel
+//
+//  Timers hash into `slots` buckets by deadline / tickNs, so scheduling and
+//  cancelling are O(1) whatever the number of timers, and advancing only
+//  looks at the buckets of the ticks that passed. Timers are intrusive: the
+//  owner keeps the Timer (and its callback) alive for as long as it is
+//  scheduled, and rescheduling never allocates.
+//
+//  The tick only decides which bucket a timer sits in; timers fire at their
+//  exact deadline as long as the caller sleeps until nextDeadlineNs(), so
+//  precision is whatever the caller's clock and sleep give.
+//
+//  Not thread safe: one thread schedules, cancels and advances.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class TimerWheel
+{
+public:
+    struct Timer
+    {
+        // Runs from advance() with the deadline it was due at; may
+        // reschedule its own timer (e.g. deadline + period, drift free)
+        std::function<void(int64_t deadlineNs)> callback;
+
+        bool pending() const { return deadlineNs_ >= 0; }
+
+    private:
+        friend class TimerWheel;
+
+        int64_t  deadlineNs_ { -1 }; // -1 idle, -2 due and about to fire
+        uint64_t slot_ { 0 };
+        Timer*   prev_ { nullptr };
+        Timer*   next_ { nullptr };
+    };
+
+public:
+    // slots is rounded up to a power of two
+    TimerWheel(int64_t tickNs, uint32_t slots);
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // Replaces the deadline of a pending timer. Deadlines already passed
+    // fire on the next advance().
+    void schedule(Timer& timer, int64_t deadlineNs);
+    void cancel(Timer& timer);
+
+    // Fires every timer whose deadline is <= nowNs, earliest tick first
+    void advance(int64_t nowNs);
+
+    // Earliest pending deadline, -1 when nothing is scheduled
+    int64_t nextDeadlineNs() const;
+
+    size_t size() const { return size_; }
+
+private:
+    int64_t tickOf(int64_t deadlineNs) const;
+    void    unlink(Timer& timer);
+
+private:
+    int64_t             tickNs_;
+    uint64_t            mask_;
+    std::vector<Timer*> slots_;
+    int64_t             currentTick_ { 0 }; // lowest tick that may hold due timers; only grows
+    size_t              size_ { 0 };
+
+    // Reused by advance(): due timers and the deadlines they fire with
+    std::vector<std::pair<Timer*, int64_t>> due_;
+};
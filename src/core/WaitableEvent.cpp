@@ -0,0 +1,74 @@
+#include "WaitableEvent.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+
+#if defined(_WIN32)
+
+WaitableEvent::~WaitableEvent()
+{
+    if (handle_ != -1)
+        CloseHandle(reinterpret_cast<HANDLE>(handle_));
+}
+
+std::unique_ptr<WaitableEvent> WaitableEvent::create()
+{
+    HANDLE event = CreateEvent(nullptr, false, false, nullptr);
+    if (!event)
+        return nullptr;
+
+    std::unique_ptr<WaitableEvent> result(new WaitableEvent());
+    result->handle_ = reinterpret_cast<EventHandle>(event);
+    return result;
+}
+
+void WaitableEvent::signal()
+{
+    SetEvent(reinterpret_cast<HANDLE>(handle_));
+}
+
+void WaitableEvent::acknowledge()
+{
+    // Auto-reset when the wait completes
+}
+
+#else
+
+WaitableEvent::~WaitableEvent()
+{
+    if (handle_ >= 0)
+        close(static_cast<int>(handle_));
+}
+
+std::unique_ptr<WaitableEvent> WaitableEvent::create()
+{
+    const int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (fd < 0)
+        return nullptr;
+
+    std::unique_ptr<WaitableEvent> result(new WaitableEvent());
+    result->handle_ = fd;
+    return result;
+}
+
+void WaitableEvent::signal()
+{
+    const uint64_t one = 1;
+    (void)!write(static_cast<int>(handle_), &one, sizeof(one));
+}
+
+void WaitableEvent::acknowledge()
+{
+    // Level triggered until the count is read
+    uint64_t count;
+    (void)!read(static_cast<int>(handle_), &count, sizeof(count));
+}
+
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "EventLoop.h"
+
+#include <memory>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Auto-reset event with a waitable handle (eventfd on Linux, an event on
+//  Windows), so one thread can wake another thread's EventLoop. Signals
+//  before the waiter acknowledges collapse into one wake up.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class WaitableEvent
+{
+public:
+    ~WaitableEvent();
+
+    WaitableEvent(const WaitableEvent&) = delete;
+    WaitableEvent& operator=(const WaitableEvent&) = delete;
+
+    // nullptr when the platform has no waitable events
+    static std::unique_ptr<WaitableEvent> create();
+
+    EventHandle handle() const { return handle_; }
+
+    // Any thread
+    void signal();
+
+    // Call from the handle's callback
+    void acknowledge();
+
+private:
+    WaitableEvent() = default;
+
+private:
+    EventHandle handle_ { -1 };
+};
@@ -0,0 +1,100 @@
+#include "WaitableTimer.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
+#if defined(_WIN32)
+
+#if !defined(CREATE_WAITABLE_TIMER_HIGH_RESOLUTION)
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+WaitableTimer::~WaitableTimer()
+{
+    if (handle_ != -1)
+        CloseHandle(reinterpret_cast<HANDLE>(handle_));
+}
+
+std::unique_ptr<WaitableTimer> WaitableTimer::create()
+{
+    // High resolution timers (Windows 10 1803+) aren't rounded up to the
+    // system tick; older systems get a regular one
+    HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!timer)
+        timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+    if (!timer)
+        return nullptr;
+
+    std::unique_ptr<WaitableTimer> result(new WaitableTimer());
+    result->handle_ = reinterpret_cast<EventHandle>(timer);
+    return result;
+}
+
+void WaitableTimer::arm(int64_t delayNs)
+{
+    // Relative due times are negative, in 100ns units; zero wouldn't fire
+    LARGE_INTEGER due;
+    due.QuadPart = -(std::max)(int64_t(1), delayNs / 100);
+    SetWaitableTimer(reinterpret_cast<HANDLE>(handle_), &due, 0, nullptr, nullptr, false);
+}
+
+void WaitableTimer::disarm()
+{
+    CancelWaitableTimer(reinterpret_cast<HANDLE>(handle_));
+}
+
+void WaitableTimer::acknowledge()
+{
+    // Synchronization timers reset when the wait completes
+}
+
+#else
+
+WaitableTimer::~WaitableTimer()
+{
+    if (handle_ >= 0)
+        close(static_cast<int>(handle_));
+}
+
+std::unique_ptr<WaitableTimer> WaitableTimer::create()
+{
+    const int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0)
+        return nullptr;
+
+    std::unique_ptr<WaitableTimer> result(new WaitableTimer());
+    result->handle_ = fd;
+    return result;
+}
+
+void WaitableTimer::arm(int64_t delayNs)
+{
+    // An all zero it_value would disarm instead
+    delayNs = (std::max)(int64_t(1), delayNs);
+    itimerspec spec {};
+    spec.it_value.tv_sec  = static_cast<time_t>(delayNs / 1000000000);
+    spec.it_value.tv_nsec = static_cast<long>(delayNs % 1000000000);
+    timerfd_settime(static_cast<int>(handle_), 0, &spec, nullptr);
+}
+
+void WaitableTimer::disarm()
+{
+    itimerspec spec {};
+    timerfd_settime(static_cast<int>(handle_), 0, &spec, nullptr);
+}
+
+void WaitableTimer::acknowledge()
+{
+    // The descriptor stays readable until the expiry count is read
+    uint64_t expirations;
+    (void)!read(static_cast<int>(handle_), &expirations, sizeof(expirations));
+}
+
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "EventLoop.h"
+
+#include <cstdint>
+#include <memory>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  One shot timer with a waitable handle (timerfd on Linux, a high
+//  resolution waitable timer on Windows), so deadlines can be serviced by
+//  the same EventLoop as the device handles.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class WaitableTimer
+{
+public:
+    ~WaitableTimer();
+
+    WaitableTimer(const WaitableTimer&) = delete;
+    WaitableTimer& operator=(const WaitableTimer&) = delete;
+
+    // nullptr when the platform has no waitable timers
+    static std::unique_ptr<WaitableTimer> create();
+
+    EventHandle handle() const { return handle_; }
+
+    // Fires once, delayNs from now; replaces any pending expiry
+    void arm(int64_t delayNs);
+    void disarm();
+
+    // Call from the handle's callback before re-arming
+    void acknowledge();
+
+private:
+    WaitableTimer() = default;
+
+private:
+    EventHandle handle_ { -1 };
+};
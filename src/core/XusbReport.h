@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Plain mirror of ViGEm's XUSB_REPORT so the mapping code does not need
+//  the ViGEm headers. Field order and size are identical.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct XusbReport
+{
+    uint16_t wButtons;
+    uint8_t  bLeftTrigger;
+    uint8_t  bRightTrigger;
+    int16_t  sThumbLX;
+    int16_t  sThumbLY;
+    int16_t  sThumbRX;
+    int16_t  sThumbRY;
+};
+
+static_assert(sizeof(XusbReport) == 12, "XusbReport must match XUSB_REPORT");
+
+namespace Xusb
+{
+
+enum Button : uint16_t
+{
+    DPAD_UP        = 0x0001,
+    DPAD_DOWN      = 0x0002,
+    DPAD_LEFT      = 0x0004,
+    DPAD_RIGHT     = 0x0008,
+    START          = 0x0010,
+    BACK           = 0x0020,
+    LEFT_THUMB     = 0x0040,
+    RIGHT_THUMB    = 0x0080,
+    LEFT_SHOULDER  = 0x0100,
+    RIGHT_SHOULDER = 0x0200,
+    GUIDE          = 0x0400,
+    A              = 0x1000,
+    B              = 0x2000,
+    X              = 0x4000,
+    Y              = 0x8000
+};
+
+inline void initReport(XusbReport& report)
+{
+    report = XusbReport{};
+}
+
+}
@@ -0,0 +1,514 @@
+#include "EvdevBackend.h"
+#include "core/DeviceDescriptors.h"
+#include "core/EventReplay.h"
+#include "core/Log.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+constexpr char kInputDir[] = "/dev/input";
+
+constexpr int32_t kAxisRange = 65535;
+
+// Stable across reconnects: the Bluetooth address (uniq) when the driver
+// reports one, otherwise the physical path
+DeviceGuid instanceGuid(int fd, const input_id& id)
+{
+    char name[256] = {};
+    if (ioctl(fd, EVIOCGUNIQ(sizeof(name) - 1), name) <= 0 || name[0] == '\0')
+    {
+        memset(name, 0, sizeof(name));
+        ioctl(fd, EVIOCGPHYS(sizeof(name) - 1), name);
+    }
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const char* c = name; *c; c++)
+    {
+        hash ^= static_cast<uint8_t>(*c);
+        hash *= 0x100000001b3ull;
+    }
+
+    DeviceGuid guid;
+    guid.data1 = static_cast<uint32_t>(hash);
+    guid.data2 = static_cast<uint16_t>(hash >> 32);
+    guid.data3 = static_cast<uint16_t>(hash >> 48);
+    const uint8_t tail[8] = { 0, 0, 'E', 'V',
+                              static_cast<uint8_t>(id.vendor), static_cast<uint8_t>(id.vendor >> 8),
+                              static_cast<uint8_t>(id.product), static_cast<uint8_t>(id.product >> 8) };
+    memcpy(guid.data4, tail, sizeof(tail));
+    return guid;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Device source
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class EvdevDeviceSource : public DeviceSource
+{
+public:
+    ~EvdevDeviceSource() override
+    {
+        if (inotify_ >= 0)
+            close(inotify_);
+        if (wake_ >= 0)
+            close(wake_);
+    }
+
+    bool init()
+    {
+        inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        wake_    = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (inotify_ < 0 || wake_ < 0)
+            return false;
+
+        // udev creates the node and then fixes up its permissions, so
+        // attribute changes count as arrivals too
+        return inotify_add_watch(inotify_, kInputDir, IN_CREATE | IN_DELETE | IN_ATTRIB) >= 0;
+    }
+
+    // Rescans fill scratch_ and swap it with paths_, so once both have seen
+    // as many pads (and path lengths) as the system has, a rescan reuses its
+    // path tables instead of rebuilding them (opendir() still allocates)
+    void enumerate(std::vector<DeviceGuid>& out) override
+    {
+        size_t found = 0;
+
+        DIR* dir = opendir(kInputDir);
+        if (!dir)
+            return;
+        while (const dirent* entry = readdir(dir))
+        {
+            if (strncmp(entry->d_name, "event", 5) != 0)
+                continue;
+
+            char path[sizeof(kInputDir) + sizeof(entry->d_name)];
+            snprintf(path, sizeof(path), "%s/%s", kInputDir, entry->d_name);
+            const int fd = ::open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+            if (fd < 0)
+                continue;
+
+            input_id id {};
+            if (ioctl(fd, EVIOCGID, &id) == 0 && DeviceTypes::find(id.vendor, id.product))
+            {
+                const auto guid = instanceGuid(fd, id);
+                out.push_back(guid);
+                if (found == scratch_.size())
+                    scratch_.emplace_back();
+                scratch_[found].id = guid;
+                scratch_[found].path.assign(path);
+                found++;
+            }
+            close(fd);
+        }
+        closedir(dir);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        paths_.swap(scratch_);
+        std::swap(pathCount_, found);
+    }
+
+    bool waitForChange(uint32_t timeoutMs) override
+    {
+        pollfd fds[2] = { { inotify_, POLLIN, 0 }, { wake_, POLLIN, 0 } };
+        if (poll(fds, 2, timeoutMs == kWaitForever ? -1 : static_cast<int>(timeoutMs)) <= 0)
+            return false;
+
+        if (fds[1].revents & POLLIN)
+        {
+            uint64_t count;
+            (void)!::read(wake_, &count, sizeof(count));
+        }
+        if (!(fds[0].revents & POLLIN))
+            return false;
+
+        char events[4096];
+        while (::read(inotify_, events, sizeof(events)) > 0)
+            ;
+        return true;
+    }
+
+    void wake() override
+    {
+        const uint64_t one = 1;
+        (void)!write(wake_, &one, sizeof(one));
+    }
+
+    bool path(const DeviceGuid& id, std::string& out) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < pathCount_; i++)
+        {
+            if (paths_[i].id == id)
+            {
+                out = paths_[i].path;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Node
+    {
+        DeviceGuid  id;
+        std::string path;
+    };
+
+private:
+    int                inotify_ { -1 };
+    int                wake_ { -1 };
+    mutable std::mutex mutex_;
+    std::vector<Node>  paths_;           // the first pathCount_ are the last scan's
+    size_t             pathCount_ { 0 };
+    std::vector<Node>  scratch_;         // enumerate() only; entries kept for reuse
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Source
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class EvdevSource : public InputSource
+{
+public:
+    ~EvdevSource() override
+    {
+        if (fd_ >= 0)
+            close(fd_);
+    }
+
+    bool init(const std::string& path, bool buffered)
+    {
+        buffered_ = buffered;
+        fd_ = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd_ < 0)
+        {
+            Log::error("Failed to open %s: %s", path.c_str(), strerror(errno));
+            return false;
+        }
+
+        // Best effort; another process may already hold the grab
+        ioctl(fd_, EVIOCGRAB, 1);
+
+        input_id id {};
+        if (ioctl(fd_, EVIOCGID, &id) == 0)
+        {
+            if (const auto type = DeviceTypes::find(id.vendor, id.product))
+                type_ = type;
+        }
+
+        for (auto& axis : axes_)
+        {
+            input_absinfo info {};
+            if (ioctl(fd_, EVIOCGABS(axis.code), &info) == 0)
+            {
+                axis.min = info.minimum;
+                axis.max = info.maximum;
+            }
+        }
+
+        memset(&pending_, 0, sizeof(pending_));
+        pending_.dpad = -1;
+        resync();
+        return true;
+    }
+
+    EventHandle handle() const override
+    {
+        return fd_;
+    }
+
+    const DeviceType& type() const override
+    {
+        return *type_;
+    }
+
+    bool read(N64ControllerState& state) override
+    {
+        for (;;)
+        {
+            if (!fill())
+                return false;
+            if (next_ == count_)
+                break;
+            while (next_ < count_)
+                apply(events_[next_++]);
+        }
+
+        state = committed_;
+        return true;
+    }
+
+    // Every frame the kernel queued, not just the last one. Frames that only
+    // move axes are merged into the state before them (see EventReplay).
+    bool readBatch(InputBatch& batch) override
+    {
+        if (!buffered_)
+            return InputSource::readBatch(batch);
+
+        batch.count      = 0;
+        batch.more       = false;
+        batch.overflowed = false;
+        bool canMerge    = false;   // the last state was appended by this read
+        for (;;)
+        {
+            if (!fill())
+                return false;
+            if (next_ == count_)
+                return true;
+
+            while (next_ < count_)
+            {
+                if (batch.count == InputBatch::kCapacity)
+                {
+                    batch.more = true;
+                    return true;
+                }
+
+                const bool wasDropped = dropped_;
+                if (!apply(events_[next_++]))
+                    continue;
+                batch.overflowed |= wasDropped;
+
+                if (canMerge && !wasDropped && EventReplay::digitalEqual(batch.states[batch.count - 1], committed_))
+                    batch.states[batch.count - 1] = committed_;
+                else
+                    batch.states[batch.count++] = committed_;
+                canMerge = true;
+            }
+        }
+    }
+
+    // A node that went away (ENODEV) doesn't come back: the pad reconnects
+    // as a new node and the detector takes it from there
+    bool recover() override
+    {
+        int version = 0;
+        if (ioctl(fd_, EVIOCGVERSION, &version) < 0)
+            return false;
+        next_    = 0;
+        count_   = 0;
+        dropped_ = false;
+        resync();
+        return true;
+    }
+
+private:
+    struct Axis
+    {
+        uint16_t code;
+        int32_t  min;
+        int32_t  max;
+    };
+
+    enum AxisIndex { X, Y, RX, RY, AXIS_COUNT };
+
+    static int32_t scale(int32_t value, const Axis& axis)
+    {
+        if (axis.max <= axis.min)
+            return kAxisRange / 2;
+        const int64_t scaled = (static_cast<int64_t>(value) - axis.min) * kAxisRange / (static_cast<int64_t>(axis.max) - axis.min);
+        return static_cast<int32_t>(scaled < 0 ? 0 : scaled > kAxisRange ? kAxisRange : scaled);
+    }
+
+    // Hat as a DirectInput POV angle in hundredths of a degree, -1 centered
+    static int32_t pov(int32_t x, int32_t y)
+    {
+        static constexpr int32_t kAngles[3][3] =
+        {
+            { 31500,     0,  4500 },  // up
+            { 27000,    -1,  9000 },  // centered
+            { 22500, 18000, 13500 },  // down
+        };
+        const int32_t row = y < 0 ? 0 : y > 0 ? 2 : 1;
+        const int32_t col = x < 0 ? 0 : x > 0 ? 2 : 1;
+        return kAngles[row][col];
+    }
+
+    // hid-generic reports HID Button n as BTN_TRIGGER + n - 1
+    static int buttonIndex(uint16_t code)
+    {
+        if (code >= BTN_TRIGGER && code < BTN_TRIGGER + 16)
+            return code - BTN_TRIGGER;
+        return -1;
+    }
+
+    void setAbs(uint16_t code, int32_t value)
+    {
+        switch (code)
+        {
+        case ABS_X:     pending_.xAxis     = scale(value, axes_[X]);  break;
+        case ABS_Y:     pending_.yAxis     = scale(value, axes_[Y]);  break;
+        case ABS_RX:    pending_.xRotation = scale(value, axes_[RX]); break;
+        case ABS_RY:    pending_.yRotation = scale(value, axes_[RY]); break;
+        case ABS_HAT0X: hatX_ = value; pending_.dpad = pov(hatX_, hatY_); break;
+        case ABS_HAT0Y: hatY_ = value; pending_.dpad = pov(hatX_, hatY_); break;
+        }
+    }
+
+    // Refills the event buffer once it's consumed; leaves it empty when the
+    // kernel has nothing queued
+    bool fill()
+    {
+        if (next_ < count_)
+            return true;
+        next_  = 0;
+        count_ = 0;
+
+        const ssize_t bytes = ::read(fd_, events_, sizeof(events_));
+        if (bytes < 0)
+        {
+            if (errno == EAGAIN || errno == EINTR)
+                return true;
+            Log::error("Failed to read device state: %s", strerror(errno));
+            return false;
+        }
+        count_ = static_cast<size_t>(bytes) / sizeof(input_event);
+        return true;
+    }
+
+    // True when the event committed a new frame
+    bool apply(const input_event& event)
+    {
+        if (event.type == EV_SYN)
+        {
+            if (event.code == SYN_DROPPED)
+                dropped_ = true;
+            else if (event.code == SYN_REPORT)
+            {
+                // After a drop the queued deltas are unreliable; read the
+                // device's current state instead
+                if (dropped_)
+                    resync();
+                else
+                    committed_ = pending_;
+                dropped_ = false;
+                return true;
+            }
+            return false;
+        }
+        if (dropped_)
+            return false;
+
+        if (event.type == EV_KEY)
+        {
+            const int index = buttonIndex(event.code);
+            if (index >= 0)
+                pending_.buttons[index] = event.value ? 0x80 : 0;
+        }
+        else if (event.type == EV_ABS)
+            setAbs(event.code, event.value);
+        return false;
+    }
+
+    void resync()
+    {
+        uint8_t keys[KEY_MAX / 8 + 1] = {};
+        if (ioctl(fd_, EVIOCGKEY(sizeof(keys)), keys) >= 0)
+        {
+            for (int i = 0; i < 16; i++)
+            {
+                const int code = BTN_TRIGGER + i;
+                pending_.buttons[i] = (keys[code / 8] & (1 << (code % 8))) ? 0x80 : 0;
+            }
+        }
+
+        for (const uint16_t code : { ABS_X, ABS_Y, ABS_RX, ABS_RY, ABS_HAT0X, ABS_HAT0Y })
+        {
+            input_absinfo info {};
+            if (ioctl(fd_, EVIOCGABS(code), &info) == 0)
+                setAbs(code, info.value);
+        }
+        committed_ = pending_;
+    }
+
+private:
+    int                fd_ { -1 };
+    const DeviceType*  type_ { &DeviceTypes::n64() };
+    Axis               axes_[AXIS_COUNT] = { { ABS_X, 0, 0 }, { ABS_Y, 0, 0 }, { ABS_RX, 0, 0 }, { ABS_RY, 0, 0 } };
+    int32_t            hatX_ { 0 };
+    int32_t            hatY_ { 0 };
+    bool               dropped_ { false };
+    bool               buffered_ { false };
+    input_event        events_[64];
+    size_t             next_ { 0 };
+    size_t             count_ { 0 };
+    N64ControllerState pending_ {};    // being assembled from the current frame
+    N64ControllerState committed_ {};  // as of the last SYN_REPORT
+};
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Backend
+//
+///////////////////////////////////////////////////////////////////////////////
+
+struct EvdevBackend::Impl
+{
+    EvdevDeviceSource devices;
+    bool              buffered { false };
+};
+
+EvdevBackend::EvdevBackend()
+    : impl_(new Impl)
+{   }
+
+EvdevBackend::~EvdevBackend() = default;
+
+std::unique_ptr<EvdevBackend> EvdevBackend::create(bool buffered)
+{
+    std::unique_ptr<EvdevBackend> backend(new EvdevBackend());
+    backend->impl_->buffered = buffered;
+    if (!backend->init())
+        return nullptr;
+    return backend;
+}
+
+bool EvdevBackend::init()
+{
+    if (!impl_->devices.init())
+    {
+        Log::warning("Failed to watch %s: %s", kInputDir, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+DeviceSource& EvdevBackend::devices()
+{
+    return impl_->devices;
+}
+
+std::unique_ptr<InputSource> EvdevBackend::open(const DeviceGuid& id)
+{
+    std::string path;
+    if (!impl_->devices.path(id, path))
+        return nullptr;
+
+    std::unique_ptr<EvdevSource> source(new EvdevSource());
+    if (!source->init(path, impl_->buffered))
+        return nullptr;
+    return source;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "core/InputSource.h"
+
+#include <memory>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  evdev input backend (Linux)
+//
+//  Wireless N64 pads as /dev/input/event* nodes, hotplug from inotify on
+//  /dev/input. Sources consume the kernel's event stream and commit a new
+//  state at every EV_SYN/SYN_REPORT, so a report goes out as soon as the
+//  kernel finishes a frame instead of on the next poll.
+//
+//  Events are translated into the DirectInput layout and ranges: buttons
+//  in HID usage order (hid-generic reports Button 1..16 as BTN_TRIGGER..
+//  BTN_DEAD), axes rescaled to 0..65535 and the hat as a POV angle.
+//
+//  In buffered mode every queued frame is handed over instead of only the
+//  latest, so taps shorter than a wakeup still reach the virtual pad.
+//
+//  Opened pads are grabbed (EVIOCGRAB), which keeps other readers from
+//  seeing the raw pad the way HidHide does on Windows.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class EvdevBackend : public InputBackend
+{
+public:
+    ~EvdevBackend() override;
+
+    // nullptr when /dev/input can't be watched
+    static std::unique_ptr<EvdevBackend> create(bool buffered = false);
+
+    DeviceSource& devices() override;
+    std::unique_ptr<InputSource> open(const DeviceGuid& id) override;
+
+private:
+    EvdevBackend();
+    bool init();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
@@ -0,0 +1,187 @@
+#include "UinputSink.h"
+#include "core/Log.h"
+
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace
+{
+
+constexpr char kUinputPath[] = "/dev/uinput";
+
+// Wired Xbox 360 pad, as xpad exposes it
+constexpr uint16_t kVendor  = 0x045e;
+constexpr uint16_t kProduct = 0x028e;
+constexpr uint16_t kVersion = 0x0114;
+
+struct ButtonBinding
+{
+    uint16_t xusb;
+    uint16_t code;
+};
+
+constexpr ButtonBinding kButtons[] =
+{
+    { Xusb::A,              BTN_A      },
+    { Xusb::B,              BTN_B      },
+    { Xusb::X,              BTN_X      },
+    { Xusb::Y,              BTN_Y      },
+    { Xusb::LEFT_SHOULDER,  BTN_TL     },
+    { Xusb::RIGHT_SHOULDER, BTN_TR     },
+    { Xusb::BACK,           BTN_SELECT },
+    { Xusb::START,          BTN_START  },
+    { Xusb::GUIDE,          BTN_MODE   },
+    { Xusb::LEFT_THUMB,     BTN_THUMBL },
+    { Xusb::RIGHT_THUMB,    BTN_THUMBR },
+};
+
+struct AxisSetup
+{
+    uint16_t code;
+    int32_t  min;
+    int32_t  max;
+    int32_t  fuzz;
+    int32_t  flat;
+};
+
+constexpr AxisSetup kAxes[] =
+{
+    { ABS_X,     -32768, 32767, 16, 128 },
+    { ABS_Y,     -32768, 32767, 16, 128 },
+    { ABS_RX,    -32768, 32767, 16, 128 },
+    { ABS_RY,    -32768, 32767, 16, 128 },
+    { ABS_Z,          0,   255,  0,   0 },
+    { ABS_RZ,         0,   255,  0,   0 },
+    { ABS_HAT0X,     -1,     1,  0,   0 },
+    { ABS_HAT0Y,     -1,     1,  0,   0 },
+};
+
+int32_t hat(uint16_t buttons, uint16_t negative, uint16_t positive)
+{
+    return (buttons & positive ? 1 : 0) - (buttons & negative ? 1 : 0);
+}
+
+class UinputPadSink : public PadSink
+{
+public:
+    ~UinputPadSink() override
+    {
+        if (fd_ >= 0)
+        {
+            ioctl(fd_, UI_DEV_DESTROY);
+            close(fd_);
+        }
+    }
+
+    bool init()
+    {
+        fd_ = ::open(kUinputPath, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd_ < 0)
+        {
+            Log::error("Failed to open %s: %s", kUinputPath, strerror(errno));
+            return false;
+        }
+
+        bool ok = ioctl(fd_, UI_SET_EVBIT, EV_KEY) == 0 && ioctl(fd_, UI_SET_EVBIT, EV_ABS) == 0;
+        for (const auto& button : kButtons)
+            ok = ok && ioctl(fd_, UI_SET_KEYBIT, button.code) == 0;
+        for (const auto& axis : kAxes)
+        {
+            uinput_abs_setup setup {};
+            setup.code               = axis.code;
+            setup.absinfo.minimum    = axis.min;
+            setup.absinfo.maximum    = axis.max;
+            setup.absinfo.fuzz       = axis.fuzz;
+            setup.absinfo.flat       = axis.flat;
+            ok = ok && ioctl(fd_, UI_SET_ABSBIT, axis.code) == 0 && ioctl(fd_, UI_ABS_SETUP, &setup) == 0;
+        }
+
+        uinput_setup device {};
+        device.id.bustype = BUS_USB;
+        device.id.vendor  = kVendor;
+        device.id.product = kProduct;
+        device.id.version = kVersion;
+        strncpy(device.name, "Microsoft X-Box 360 pad (N64)", UINPUT_MAX_NAME_SIZE - 1);
+        ok = ok && ioctl(fd_, UI_DEV_SETUP, &device) == 0 && ioctl(fd_, UI_DEV_CREATE) == 0;
+        if (!ok)
+        {
+            Log::error("Failed to create uinput pad: %s", strerror(errno));
+            return false;
+        }
+
+        Xusb::initReport(last_);
+        return true;
+    }
+
+    void submit(const XusbReport& report) override
+    {
+        // Keys and axes plus SYN_REPORT
+        input_event events[sizeof(kButtons) / sizeof(kButtons[0]) + sizeof(kAxes) / sizeof(kAxes[0]) + 1];
+        size_t count = 0;
+        auto emit = [&](uint16_t type, uint16_t code, int32_t value)
+        {
+            auto& event = events[count++];
+            memset(&event, 0, sizeof(event));
+            event.type  = type;
+            event.code  = code;
+            event.value = value;
+        };
+
+        const uint16_t changed = report.wButtons ^ last_.wButtons;
+        for (const auto& button : kButtons)
+            if (changed & button.xusb)
+                emit(EV_KEY, button.code, report.wButtons & button.xusb ? 1 : 0);
+
+        // Stick Y is inverted the way xpad reports it (down is positive)
+        if (report.sThumbLX != last_.sThumbLX)           emit(EV_ABS, ABS_X, report.sThumbLX);
+        if (report.sThumbLY != last_.sThumbLY)           emit(EV_ABS, ABS_Y, ~report.sThumbLY);
+        if (report.sThumbRX != last_.sThumbRX)           emit(EV_ABS, ABS_RX, report.sThumbRX);
+        if (report.sThumbRY != last_.sThumbRY)           emit(EV_ABS, ABS_RY, ~report.sThumbRY);
+        if (report.bLeftTrigger != last_.bLeftTrigger)   emit(EV_ABS, ABS_Z, report.bLeftTrigger);
+        if (report.bRightTrigger != last_.bRightTrigger) emit(EV_ABS, ABS_RZ, report.bRightTrigger);
+        if (changed & (Xusb::DPAD_LEFT | Xusb::DPAD_RIGHT))
+            emit(EV_ABS, ABS_HAT0X, hat(report.wButtons, Xusb::DPAD_LEFT, Xusb::DPAD_RIGHT));
+        if (changed & (Xusb::DPAD_UP | Xusb::DPAD_DOWN))
+            emit(EV_ABS, ABS_HAT0Y, hat(report.wButtons, Xusb::DPAD_UP, Xusb::DPAD_DOWN));
+
+        last_ = report;
+        if (count == 0)
+            return;
+        emit(EV_SYN, SYN_REPORT, 0);
+
+        const ssize_t bytes = write(fd_, events, count * sizeof(input_event));
+        if (bytes != static_cast<ssize_t>(count * sizeof(input_event)))
+            Log::error("Failed to submit uinput report: %s", strerror(errno));
+    }
+
+private:
+    int        fd_ { -1 };
+    XusbReport last_ {};
+};
+
+}
+
+std::unique_ptr<UinputSinkBackend> UinputSinkBackend::create()
+{
+    const int fd = ::open(kUinputPath, O_WRONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        Log::error("Failed to open %s: %s", kUinputPath, strerror(errno));
+        return nullptr;
+    }
+    close(fd);
+    return std::unique_ptr<UinputSinkBackend>(new UinputSinkBackend());
+}
+
+std::unique_ptr<PadSink> UinputSinkBackend::plug()
+{
+    std::unique_ptr<UinputPadSink> sink(new UinputPadSink());
+    if (!sink->init())
+        return nullptr;
+    return sink;
+}
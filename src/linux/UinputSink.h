@@ -0,0 +1,28 @@
+#pragma once
+
+#include "core/PadSink.h"
+
+#include <memory>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  uinput sink backend (Linux)
+//
+//  Each virtual pad is a uinput device that looks like a wired Xbox 360
+//  pad to the xpad-aware userspace (SDL, Steam, Wine): same ids, buttons,
+//  axes and ranges, stick Y inverted like xpad reports it. Only the fields
+//  that changed are written, followed by SYN_REPORT, in a single write().
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class UinputSinkBackend : public SinkBackend
+{
+public:
+    // nullptr when /dev/uinput isn't writable
+    static std::unique_ptr<UinputSinkBackend> create();
+
+    std::unique_ptr<PadSink> plug() override;
+
+private:
+    UinputSinkBackend() = default;
+};
@@ -1,77 +1,434 @@
-#include "ControllerDetector.h"
-#include "Utils.h"
-#include "VigemWrapper.h"
-#include "DInputWrapper.h"
+#include "core/Clock.h"
+#include "core/Controller.h"
+#include "core/HotplugDetector.h"
+#include "core/InitPipeline.h"
+#include "core/Log.h"
+#include "core/MetricsServer.h"
+#include "core/Options.h"
+#include "core/SlotRegistry.h"
+#include "core/Stream.h"
 
+#if defined(_WIN32)
+#include "DInputBackend.h"
+#include "VigemSink.h"
+#else
+#include "linux/EvdevBackend.h"
+#include "linux/UinputSink.h"
+
+#include <pthread.h>
+#endif
+
+#include <atomic>
+#include <chrono>
 #include <csignal>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <iostream>
-#include <unordered_map>
+#include <vector>
+
+// Virtual pads the bus and most games handle comfortably
+static constexpr size_t kMaxControllers = 16;
+static constexpr uint32_t kProfilePollMs = 250;
 
-ControllerDetector detector;
+HotplugDetector  detector;
+std::atomic_bool statsRequested{ false };
 
+#if defined(_WIN32)
 void signalHandler(int)
 {
     detector.stop();
 }
 
+void statsSignalHandler(int signal)
+{
+    statsRequested = true;
+    ::signal(signal, statsSignalHandler);
+}
+#else
+// Takes SIGINT / SIGTERM (stop) and SIGUSR1 (stats) with sigwait, where
+// stopping the detector is safe; SIGUSR2 ends the thread
+class SignalThread
+{
+public:
+    SignalThread()
+    {
+        sigemptyset(&signals_);
+        sigaddset(&signals_, SIGINT);
+        sigaddset(&signals_, SIGTERM);
+        sigaddset(&signals_, SIGUSR1);
+        sigaddset(&signals_, SIGUSR2);
+
+        // Threads started later inherit the blocked mask
+        pthread_sigmask(SIG_BLOCK, &signals_, nullptr);
+        thread_ = std::thread(
+            [this]()
+            {
+                for (;;)
+                {
+                    int signal = 0;
+                    if (sigwait(&signals_, &signal) != 0 || signal == SIGUSR2)
+                        return;
+                    if (signal == SIGUSR1)
+                        statsRequested = true;
+                    else
+                        detector.stop();
+                }
+            }
+        );
+    }
+
+    ~SignalThread()
+    {
+        pthread_kill(thread_.native_handle(), SIGUSR2);
+        thread_.join();
+    }
+
+private:
+    sigset_t    signals_;
+    std::thread thread_;
+};
+#endif
+
 int main(int argc, char** argv)
 {
+    Options options;
+    std::string optionsError;
+    if (!options.parse(argc, argv, optionsError) || options.help)
+    {
+        if (!optionsError.empty())
+            std::cout << optionsError << std::endl;
+        std::cout << Options::usage();
+        return options.help ? 0 : -1;
+    }
+
+    // Pad threads hand messages to the log writer and never wait on output
+    Log::Config logConfig;
+    logConfig.console  = !options.logFileOnly;
+    logConfig.filePath = options.logPath;
+    if (!Log::start(logConfig))
+        return -1;
+
+#if defined(_WIN32)
     signal(SIGINT, signalHandler);
+    if (options.stats)
+        signal(SIGBREAK, statsSignalHandler);
+#else
+    SignalThread signalThread;
+#endif
 
-    const auto client = Vigem::alloc();
-    if (client == nullptr)
+    // DirectInput and ViGEm on Windows, evdev and uinput on Linux. With
+    // --send the pads go out over the network instead.
+    std::unique_ptr<SinkBackend> sinks;
+    if (!options.sendTarget.empty())
+    {
+        sinks = StreamSender::create(options.sendTarget, options.keyframeMs);
+        if (sinks)
+            Log::info("Forwarding pads to %s", options.sendTarget.c_str());
+    }
+    else
     {
-        std::cout << "Unable to allocate vigem client" << std::endl;
+#if defined(_WIN32)
+        sinks = VigemSinkBackend::create(options.vigemClients);
+#else
+        sinks = UinputSinkBackend::create();
+#endif
+    }
+#if defined(_WIN32)
+    std::unique_ptr<InputBackend> inputs = sinks ? DInputBackend::create(options.inputBuffer) : nullptr;
+#else
+    std::unique_ptr<InputBackend> inputs = sinks ? EvdevBackend::create(options.inputBuffer > 0) : nullptr;
+#endif
+    if (!sinks || !inputs)
         return -1;
+
+    // Pads forwarded from another bridge get virtual pads here
+    std::unique_ptr<StreamReceiver> receiver;
+    if (options.receivePort > 0)
+    {
+        receiver = StreamReceiver::create(static_cast<uint16_t>(options.receivePort), *sinks, options.keyframeMs);
+        if (!receiver)
+            return -1;
+        Log::info("Receiving forwarded pads on UDP port %u", static_cast<unsigned>(receiver->port()));
     }
 
-    const auto connectResult = Vigem::connect(client);
-    if (!VIGEM_SUCCESS(connectResult))
+    // How pad threads wait for input and where they run
+    EventLoop::Strategy inputStrategy;
+    inputStrategy.mode   = options.inputMode;
+    inputStrategy.spinNs = static_cast<int64_t>(options.spinUs) * 1000;
+    ThreadSettings inputThread;
+    inputThread.priority = options.inputPriority;
+    inputThread.cpu      = options.inputCpu;
+
+    std::unique_ptr<Reactor> reactor;
+    if (options.reactorThreads > 0)
     {
-        std::cout << "ViGEm Bus connection failed with error code: 0x" << std::hex << connectResult << std::endl;
-        return -1;
+        reactor = std::make_unique<Reactor>(options.reactorThreads, inputStrategy, inputThread);
+        if (!reactor->valid())
+        {
+            Log::error("Failed to start reactor threads");
+            return -1;
+        }
     }
 
-    LPDIRECTINPUT8 dinput;
-    if (DInput::Create(GetModuleHandle(0), DIRECTINPUT_VERSION, IID_IDirectInput8A, reinterpret_cast<LPVOID*>(&dinput), nullptr) != DI_OK)
+    CaptureWriter capture;
+    if (!options.capturePath.empty() && !capture.open(options.capturePath, options.captureDelta))
     {
-        std::cout << "Failed to create direct input interface" << std::endl;
+        Log::error("Failed to open capture file %s", options.capturePath.c_str());
         return -1;
     }
 
-    std::unordered_map<std::string, ControllerPtr> controllers;
+    // Virtual pads that outlive a physical disconnect
+    std::unique_ptr<TargetPool> targets;
+    if (options.warmTargets > 0 || options.reconnectGrace > 0)
+    {
+        TargetPool::Callbacks callbacks;
+        callbacks.create = [&]() -> void*
+        {
+            return sinks->plug().release();
+        };
+        callbacks.neutral = [](void* target)
+        {
+            XusbReport report;
+            Xusb::initReport(report);
+            static_cast<PadSink*>(target)->submit(report);
+        };
+        callbacks.destroy = [](void* target)
+        {
+            delete static_cast<PadSink*>(target);
+        };
+
+        targets = std::make_unique<TargetPool>(callbacks, options.warmTargets, options.reconnectGrace);
+        if (targets->prewarm() < options.warmTargets)
+            Log::warning("Only %zu of %u virtual pads could be pre-plugged", targets->counters().idle, options.warmTargets);
+    }
+
+    // Mapping profile, recompiled and swapped in whenever the file changes
+    std::unique_ptr<ProfileStore> profiles;
+    if (!options.profilePath.empty())
+    {
+        profiles = ProfileStore::create(options.profilePath, options.profileName);
+        if (!profiles)
+            return -1;
+        profiles->watch(kProfilePollMs);
+    }
+
+    // Turbo and macros come from the profile; one thread times them for
+    // every pad
+    std::unique_ptr<MacroEngine> macros;
+    if (profiles)
+    {
+        macros = MacroEngine::create();
+        if (!macros)
+            return -1;
+    }
+
+    // Virtual pad updates off the read threads
+    std::unique_ptr<SubmitThread> submitter;
+    if (options.submitThread)
+    {
+        submitter = SubmitThread::create();
+        if (!submitter)
+            return -1;
+    }
+
+    // Live pad state for overlays in other processes
+    std::unique_ptr<SharedState> shared;
+    if (!options.sharedStateName.empty())
+    {
+        shared = SharedState::create(options.sharedStateName);
+        if (!shared)
+            return -1;
+        Log::info("Publishing pad state as %s", options.sharedStateName.c_str());
+    }
+
+    ControllerContext context;
+    context.reactor    = reactor.get();
+    context.capture    = capture.isOpen() ? &capture : nullptr;
+    context.targets    = targets.get();
+    context.outputMode = options.outputMode;
+    context.outputHz   = options.outputHz;
+    context.profiles   = profiles.get();
+    context.macros     = macros.get();
+    context.shared     = shared.get();
+    context.submitter  = submitter.get();
+    context.input      = inputStrategy;
+    context.thread     = inputThread;
+
+    // Pads open off the detector thread, several at a time; their slot is
+    // taken right away so player numbers follow detection order
+    auto initPipeline = InitPipeline::create(options.initThreads);
+    if (!initPipeline)
+        return -1;
+
+    // Every Controller is allocated up front; connects and disconnects only
+    // open and close them. Slot index + 1 is the player number.
+    auto controllers = std::make_unique<SlotRegistry<Controller, kMaxControllers>>();
+    std::mutex controllersMutex;
+
+    // Pads still opening have no stats yet
+    auto printStats = [&](SlotHandle slot, const DeviceGuid& id, const Controller& controller)
+    {
+        if (!controller.isReady())
+            return;
+        controller.stats().print(std::cout, "player " + std::to_string(slot.index + 1) + " " + id.toString());
+        std::cout << std::flush;
+    };
+
+    // Periodic and on demand (Ctrl+Break / SIGUSR1) stats dumps
+    std::atomic_bool statsRunning{ options.stats };
+    std::thread statsThread;
+    if (options.stats)
+    {
+        statsThread = std::thread(
+            [&]()
+            {
+                using namespace std::chrono;
+                auto nextDump = steady_clock::now() + seconds(options.statsInterval);
+                while (statsRunning)
+                {
+                    std::this_thread::sleep_for(milliseconds(100));
+
+                    const bool due = options.statsInterval > 0 && steady_clock::now() >= nextDump;
+                    if (!statsRequested.exchange(false) && !due)
+                        continue;
+                    if (due)
+                        nextDump += seconds(options.statsInterval);
+
+                    std::lock_guard<std::mutex> lock(controllersMutex);
+                    controllers->forEach(printStats);
+                }
+            }
+        );
+    }
 
-    detector.setControllerAddedCallback(
-        [&](const std::string& id)
+    detector.setAddedCallback(
+        [&](const DeviceGuid& id)
         {
-            auto controller = Controller::create(client, dinput, Utils::StringToGuid(id));
-            if (!controller)
+            std::lock_guard<std::mutex> lock(controllersMutex);
+            const auto slot = controllers->add(id);
+            if (!slot.valid())
             {
-                std::cout << "Failed to create controller instance for " << id << std::endl;
+                Log::error("No free controller slot for %s", id.toString().c_str());
                 return;
             }
-            controllers.insert({ id, controller });
-            std::cout << "added:   " << id << std::endl;
+
+            // A dedicated pad thread gets a core of its own
+            auto padContext = context;
+            padContext.sharedSlot = slot.index;
+            padContext.detectedNs = Clock::nowNs();
+            if (inputThread.cpu >= 0)
+                padContext.thread.cpu = inputThread.cpu + static_cast<int32_t>(slot.index);
+
+            auto* controller = controllers->get(slot);
+            std::vector<InitPipeline::Step> steps;
+            for (uint8_t step = Controller::BEGIN; step < Controller::OPEN_STEPS; step++)
+            {
+                steps.push_back([&, controller, id, padContext, step]
+                {
+                    return controller->openStep(static_cast<Controller::OpenStep>(step), *inputs, *sinks, id, padContext);
+                });
+            }
+
+            initPipeline->start(id, std::move(steps), [&, id, slot](InitPipeline::Result result, int64_t elapsedNs)
+            {
+                // A pad removed while opening has already been closed and its
+                // slot released
+                std::lock_guard<std::mutex> lock(controllersMutex);
+                auto controller = controllers->get(slot);
+                if (!controller)
+                    return;
+
+                if (result == InitPipeline::READY)
+                {
+                    Log::info("added:   %s (%s pad, player %u, ready in %.1f ms)", id.toString().c_str(),
+                              controller->deviceType().name, static_cast<unsigned>(slot.index + 1), elapsedNs / 1e6);
+                    return;
+                }
+                controller->close();
+                controllers->remove(slot);
+                if (result == InitPipeline::FAILED)
+                    Log::error("Failed to create controller instance for %s", id.toString().c_str());
+            });
         }
     );
-    detector.setControllerRemovedCallback(
-        [&](const std::string& id)
+    detector.setRemovedCallback(
+        [&](const DeviceGuid& id)
         {
-            controllers.erase(id);
-            std::cout << "removed: " << id << std::endl;
+            std::lock_guard<std::mutex> lock(controllersMutex);
+            const auto slot = controllers->find(id);
+            auto controller = controllers->get(slot);
+            if (!controller)
+                return;
+
+            // A pad still opening stops before its next step
+            initPipeline->cancel(id);
+
+            if (options.stats)
+                printStats(slot, id, *controller);
+            controller->close();
+            controllers->remove(slot);
+            Log::info("removed: %s (player %u)", id.toString().c_str(), static_cast<unsigned>(slot.index + 1));
         }
     );
 
-    detector.run(dinput, 500);
+    // Scrapes read the pads' stats without stopping them; the mutex only
+    // keeps pads from being opened or closed mid scrape
+    Metrics::PadRates padRates;
+    std::unique_ptr<MetricsServer> metrics;
+    if (options.metricsPort > 0)
+    {
+        metrics = MetricsServer::create(static_cast<uint16_t>(options.metricsPort), [&](MetricsText& text)
+        {
+            const auto nowNs = Clock::nowNs();
+            {
+                std::lock_guard<std::mutex> lock(controllersMutex);
+                std::vector<Metrics::Pad> pads;
+                controllers->forEach([&](SlotHandle slot, const DeviceGuid& id, const Controller& controller)
+                {
+                    if (!controller.isReady())
+                        return;
+                    const auto player = std::to_string(slot.index + 1);
+                    const auto guid   = MetricsText::labelValue(id.toString());
+                    pads.push_back({ "player=\"" + player + "\",guid=\"" + guid + "\"", &controller.stats() });
+                });
+                Metrics::writePads(text, pads, padRates, nowNs);
+            }
+            Metrics::writeDetector(text, detector);
+            Metrics::writeLog(text);
+        });
+        if (!metrics)
+            return -1;
+        Log::info("Serving metrics at http://127.0.0.1:%u/metrics", static_cast<unsigned>(metrics->port()));
+    }
+
+    detector.run(inputs->devices(), options.pollIntervalMs);
+    metrics.reset();
+    initPipeline.reset();
+
+    statsRunning = false;
+    if (statsThread.joinable())
+        statsThread.join();
 
-    // Cleanup DirectInput
-    DInput::Release(dinput);
-    dinput = nullptr;
+    // Controllers unregister from the reactor and hand their pads back to
+    // the pool, so release them first; the backends go last
+    controllers.reset();
+    receiver.reset();
+    submitter.reset();
+    macros.reset();
+    shared.reset();
+    targets.reset();
+    reactor.reset();
+    capture.close();
+    inputs.reset();
+    sinks.reset();
 
-    // Cleanup ViGEm
-    Vigem::disconnect(client);
-    Vigem::free(client);
+    const auto logCounters = Log::counters();
+    if (logCounters.dropped > 0 || logCounters.suppressed > 0)
+        Log::warning("Log: %llu messages dropped, %llu suppressed",
+                     static_cast<unsigned long long>(logCounters.dropped), static_cast<unsigned long long>(logCounters.suppressed));
+    Log::stop();
 
     return 0;
 }
@@ -0,0 +1,152 @@
+#include "core/Capture.h"
+#include "core/Clock.h"
+#include "core/ReportPipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  n64-replay
+//
+//  Streams a capture written with --capture through the same pipeline the
+//  live controllers use and prints a digest of every report that would have
+//  been sent. The digest makes captures usable as regression fixtures.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+void usage()
+{
+    printf(
+        "Usage: n64-replay <capture> [options]\n"
+        "  --realtime    replay with the original timing (default: as fast as possible)\n"
+        "  --dump        print every submitted report\n"
+        "  --repeat <n>  replay the capture n times (throughput runs)\n");
+}
+
+// FNV-1a over (controller id, report) of every submitted report
+struct Digest
+{
+    uint64_t value { 0xcbf29ce484222325ull };
+
+    void add(const void* data, size_t size)
+    {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            value ^= bytes[i];
+            value *= 0x100000001b3ull;
+        }
+    }
+};
+
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        usage();
+        return -1;
+    }
+
+    bool     realtime = false;
+    bool     dump     = false;
+    uint32_t repeat   = 1;
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--realtime") == 0)
+            realtime = true;
+        else if (strcmp(argv[i], "--dump") == 0)
+            dump = true;
+        else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+            repeat = static_cast<uint32_t>((std::max)(1, atoi(argv[++i])));
+        else
+        {
+            usage();
+            return -1;
+        }
+    }
+
+    CaptureReader reader;
+    if (!reader.open(argv[1]))
+    {
+        printf("Failed to open capture %s\n", argv[1]);
+        return -1;
+    }
+
+    auto pipelines = std::make_unique<ReportPipeline[]>(Capture::kMaxDevices);
+
+    uint64_t records = 0;
+    uint64_t reports = 0;
+    Digest   digest;
+
+    const auto startNs = Clock::nowNs();
+    for (uint32_t pass = 0; pass < repeat; pass++)
+    {
+        reader.rewind();
+        for (size_t i = 0; i < Capture::kMaxDevices; i++)
+            pipelines[i].reset();
+
+        const auto passStartNs = Clock::nowNs();
+        CaptureRecord record;
+        while (reader.next(record))
+        {
+            if (record.type == Capture::DEVICE)
+            {
+                if (dump)
+                {
+                    printf("device %u:", record.controllerId);
+                    for (auto byte : record.guid)
+                        printf(" %02x", byte);
+                    printf("\n");
+                }
+                continue;
+            }
+
+            records++;
+            if (realtime)
+            {
+                const auto due = passStartNs + (record.timestampNs - reader.header().startNs);
+                const auto wait = due - Clock::nowNs();
+                if (wait > 0)
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+            }
+
+            XusbReport report;
+            if (!pipelines[record.controllerId].process(record.state, report))
+                continue;
+
+            reports++;
+            digest.add(&record.controllerId, sizeof(record.controllerId));
+            digest.add(&report, sizeof(report));
+
+            if (dump)
+                printf("%12.3f ms pad %u: buttons %04x lt %3u lx %6d ly %6d rx %6d ry %6d\n",
+                       (record.timestampNs - reader.header().startNs) / 1e6, record.controllerId,
+                       report.wButtons, report.bLeftTrigger,
+                       report.sThumbLX, report.sThumbLY, report.sThumbRX, report.sThumbRY);
+        }
+    }
+    const auto elapsedNs = Clock::nowNs() - startNs;
+
+    if (reader.truncated())
+        printf("warning: capture ends with an incomplete record\n");
+
+    printf("records %llu, reports %llu, %.3f ms, %.1f ns/record, digest %016llx\n",
+           static_cast<unsigned long long>(records),
+           static_cast<unsigned long long>(reports),
+           elapsedNs / 1e6,
+           records ? static_cast<double>(elapsedNs) / records : 0.0,
+           static_cast<unsigned long long>(digest.value));
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "core/Clock.h"
+#include "core/SharedStateReader.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  n64-state
+//
+//  Prints the pads a bridge started with --shared-state publishes, straight
+//  from shared memory. Doubles as the smallest example of an overlay built
+//  on the n64-state-reader library.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+void usage()
+{
+    printf(
+        "Usage: n64-state <name> [options]\n"
+        "  --watch    print every pad again whenever it changes (Ctrl+C to stop)\n");
+}
+
+void print(uint32_t slot, const SharedStateReader::Pad& pad)
+{
+    const auto& report = pad.report;
+    const double ageMs = static_cast<double>(Clock::nowNs() - pad.timeNs) / 1e6;
+    printf("player %u  buttons %04x  LT %3u RT %3u  LX %6d LY %6d  RX %6d RY %6d  raw x %5d y %5d  #%llu  %.1f ms ago\n",
+           slot + 1, report.wButtons, report.bLeftTrigger, report.bRightTrigger,
+           report.sThumbLX, report.sThumbLY, report.sThumbRX, report.sThumbRY,
+           static_cast<int>(pad.raw.xAxis), static_cast<int>(pad.raw.yAxis),
+           static_cast<unsigned long long>(pad.updates), ageMs);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        usage();
+        return -1;
+    }
+
+    bool watch = false;
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--watch") == 0)
+            watch = true;
+        else
+        {
+            usage();
+            return -1;
+        }
+    }
+
+    auto reader = SharedStateReader::open(argv[1]);
+    if (!reader)
+    {
+        printf("No bridge is publishing %s\n", argv[1]);
+        return -1;
+    }
+
+    SharedStateReader::Pad pad;
+    uint32_t seen[SharedStateLayout::kMaxPads] = {};
+    do
+    {
+        for (uint32_t slot = 0; slot < reader->slotCount(); slot++)
+        {
+            // Skip the copy when nothing changed since the last look
+            const auto sequence = reader->sequence(slot);
+            if (watch && sequence == seen[slot])
+                continue;
+            seen[slot] = sequence;
+            if (reader->read(slot, pad))
+                print(slot, pad);
+        }
+        if (watch)
+            std::this_thread::sleep_for(std::chrono::milliseconds(16));
+    } while (watch);
+
+    return 0;
+}